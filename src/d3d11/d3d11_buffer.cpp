@@ -12,9 +12,12 @@ namespace dxvk {
   : m_device      (pDevice),
     m_desc        (*pDesc),
     m_buffer      (CreateBuffer(pDesc)),
-    m_mappedSlice (m_buffer->slice()),
     m_d3d10       (this) {
-    
+    // Device-local buffers cannot be mapped, and keeping a
+    // reference to their memory would prevent it from being
+    // freed if the buffer gets moved by the defragmenter
+    if (m_buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+      m_mappedSlice = m_buffer->slice();
   }
   
   
@@ -49,27 +49,51 @@ namespace dxvk {
   void D3D11CommandList::EmitToCommandList(ID3D11CommandList* pCommandList) {
     auto cmdList = static_cast<D3D11CommandList*>(pCommandList);
     
-    for (const auto& chunk : m_chunks)
-      cmdList->m_chunks.push_back(chunk);
+    cmdList->m_chunks.insert(
+      cmdList->m_chunks.end(),
+      m_chunks.begin(),
+      m_chunks.end());
     
-    MarkSubmitted();
+    if (m_volatile)
+      cmdList->MarkVolatile();
   }
   
   
   void D3D11CommandList::EmitToCsThread(DxvkCsThread* CsThread) {
     for (const auto& chunk : m_chunks)
       CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
+  }
+  
+  
+  void D3D11CommandList::RecordCommands() {
+    Rc<DxvkDevice> device = m_device->GetDXVKDevice();
+    
+    // Use a fresh context so that no state from previously
+    // recorded command lists can leak into this one. The
+    // chunks themselves set up all required state.
+    Rc<DxvkContext> context = device->createContext();
+    context->beginRecording(device->createCommandList());
+    
+    // The CS thread does not discard or move any buffers
+    // while we resolve their slices. Buffers may still
+    // get discarded after recording, so we need to know
+    // whether that happened before execution.
+    sync::RwSpinlock& renameLock = device->bufferRenameLock();
+    renameLock.lock_shared();
     
-    MarkSubmitted();
+    m_discardCount = device->getBufferDiscardCount();
+    
+    for (const auto& chunk : m_chunks)
+      chunk->executeAll(context.ptr());
+    
+    m_commands = context->endRecording();
+    
+    renameLock.unlock_shared();
   }
   
   
-  void D3D11CommandList::MarkSubmitted() {
-    if (m_submitted.exchange(true) && !m_warned.exchange(true)) {
-      Logger::warn(
-        "D3D11: Command list submitted multiple times.\n"
-        "       This is currently not supported.");
-    }
+  Rc<DxvkCommandList> D3D11CommandList::TakeCommands() {
+    return std::exchange(m_commands, nullptr);
   }
   
 }
\ No newline at end of file
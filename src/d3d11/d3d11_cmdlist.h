@@ -32,17 +32,82 @@ namespace dxvk {
     void EmitToCsThread(
             DxvkCsThread*       CsThread);
     
+    /**
+     * \brief Records Vulkan commands ahead of time
+     * 
+     * Executes all chunks on a dedicated context on the
+     * calling thread, so that the resulting command list
+     * can be submitted as-is when the D3D11 command list
+     * gets executed on the immediate context. Must only
+     * be used if the command list is not volatile.
+     */
+    void RecordCommands();
+    
+    /**
+     * \brief Takes pre-recorded Vulkan commands
+     * 
+     * Vulkan command lists can only be submitted once,
+     * so subsequent executions of the same D3D11 command
+     * list will fall back to dispatching the CS chunks.
+     * \returns The command list, or \c nullptr if no
+     *    commands have been recorded ahead of time
+     */
+    Rc<DxvkCommandList> TakeCommands();
+    
+    /**
+     * \brief Buffer discard count at recording time
+     * 
+     * If the device's buffer discard count differs from
+     * this value when the pre-recorded commands are about
+     * to be submitted, they may reference buffer memory
+     * that is no longer valid and must not be used.
+     * \returns Device buffer discard count
+     */
+    uint64_t GetDiscardCount() const {
+      return m_discardCount;
+    }
+    
+    /**
+     * \brief Retrieves the command list's chunks
+     * \returns All chunks recorded to the list
+     */
+    std::vector<DxvkCsChunkRef> GetChunks() const {
+      return m_chunks;
+    }
+    
+    /**
+     * \brief Marks command list as volatile
+     * 
+     * Volatile command lists rename buffers, use queries, or
+     * read from dynamic buffers which may get renamed by the
+     * immediate context before the command list is executed.
+     * Their commands can therefore not be recorded ahead of time.
+     */
+    void MarkVolatile() {
+      m_volatile = true;
+    }
+    
+    /**
+     * \brief Checks whether the command list is volatile
+     * \returns \c true if the command list is volatile
+     */
+    bool IsVolatile() const {
+      return m_volatile;
+    }
+    
   private:
     
     D3D11Device* const m_device;
     UINT         const m_contextFlags;
     
+    // Chunks are never modified once recorded, so they
+    // can be shared with other command lists and be
+    // dispatched any number of times without copying.
     std::vector<DxvkCsChunkRef> m_chunks;
-
-    std::atomic<bool> m_submitted = { false };
-    std::atomic<bool> m_warned    = { false };
-
-    void MarkSubmitted();
+    
+    Rc<DxvkCommandList> m_commands;
+    uint64_t            m_discardCount = 0;
+    bool                m_volatile = false;
     
   };
   
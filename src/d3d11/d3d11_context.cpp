@@ -232,6 +232,8 @@ namespace dxvk {
         EmitCs([revision, queryPtr] (DxvkContext* ctx) {
           queryPtr->Begin(ctx, revision);
         });
+        
+        m_csVolatile = true;
       }
     }
   }
@@ -257,6 +259,8 @@ namespace dxvk {
           queryPtr->Signal(ctx, revision);
         });
       }
+      
+      m_csVolatile = true;
     }
   }
   
@@ -334,6 +338,8 @@ namespace dxvk {
       auto dstBuffer = static_cast<D3D11Buffer*>(pDstResource)->GetBufferSlice();
       auto srcBuffer = static_cast<D3D11Buffer*>(pSrcResource)->GetBufferSlice();
 
+      TrackDynamicBuffer(static_cast<D3D11Buffer*>(pSrcResource));
+
       if (CopyFlags & D3D11_COPY_DISCARD)
         DiscardBuffer(static_cast<D3D11Buffer*>(pDstResource));
       
@@ -550,6 +556,8 @@ namespace dxvk {
       auto dstBuffer = static_cast<D3D11Buffer*>(pDstResource)->GetBufferSlice();
       auto srcBuffer = static_cast<D3D11Buffer*>(pSrcResource)->GetBufferSlice();
       
+      TrackDynamicBuffer(static_cast<D3D11Buffer*>(pSrcResource));
+      
       if (dstBuffer.length() != srcBuffer.length()) {
         Logger::err(str::format(
           "D3D11: CopyResource: Mismatched buffer size",
@@ -1067,19 +1075,7 @@ namespace dxvk {
         std::memcpy(mappedSr.pData, pSrcData, size);
         Unmap(pDstResource, 0);
       } else {
-        DxvkDataSlice dataSlice = AllocUpdateBufferSlice(size);
-        std::memcpy(dataSlice.ptr(), pSrcData, size);
-        
-        EmitCs([
-          cDataBuffer   = std::move(dataSlice),
-          cBufferSlice  = bufferSlice.subSlice(offset, size)
-        ] (DxvkContext* ctx) {
-          ctx->updateBuffer(
-            cBufferSlice.buffer(),
-            cBufferSlice.offset(),
-            cBufferSlice.length(),
-            cDataBuffer.ptr());
-        });
+        UploadBufferData(bufferSlice.subSlice(offset, size), pSrcData);
       }
     } else {
       const D3D11CommonTexture* textureInfo = GetCommonTexture(pDstResource);
@@ -1111,36 +1107,9 @@ namespace dxvk {
         subresource.mipLevel,
         subresource.arrayLayer, 1 };
       
-      auto formatInfo = imageFormatInfo(
-        textureInfo->GetImage()->info().format);
-      
-      const VkExtent3D regionExtent = util::computeBlockCount(extent, formatInfo->blockSize);
-      
-      const VkDeviceSize bytesPerRow   = regionExtent.width  * formatInfo->elementSize;
-      const VkDeviceSize bytesPerLayer = regionExtent.height * bytesPerRow;
-      const VkDeviceSize bytesTotal    = regionExtent.depth  * bytesPerLayer;
-      
-      DxvkDataSlice imageDataBuffer = AllocUpdateBufferSlice(bytesTotal);
-      
-      util::packImageData(
-        reinterpret_cast<char*>(imageDataBuffer.ptr()),
-        reinterpret_cast<const char*>(pSrcData),
-        regionExtent, formatInfo->elementSize,
+      UploadImageData(textureInfo->GetImage(),
+        layers, offset, extent, pSrcData,
         SrcRowPitch, SrcDepthPitch);
-      
-      EmitCs([
-        cDstImage         = textureInfo->GetImage(),
-        cDstLayers        = layers,
-        cDstOffset        = offset,
-        cDstExtent        = extent,
-        cSrcData          = std::move(imageDataBuffer),
-        cSrcBytesPerRow   = bytesPerRow,
-        cSrcBytesPerLayer = bytesPerLayer
-      ] (DxvkContext* ctx) {
-        ctx->updateImage(cDstImage, cDstLayers,
-          cDstOffset, cDstExtent, cSrcData.ptr(),
-          cSrcBytesPerRow, cSrcBytesPerLayer);
-      });
     }
   }
   
@@ -1326,6 +1295,7 @@ namespace dxvk {
           ID3D11Buffer*   pBufferForArgs,
           UINT            AlignedByteOffsetForArgs) {
     D3D11Buffer* buffer = static_cast<D3D11Buffer*>(pBufferForArgs);
+    TrackDynamicBuffer(buffer);
     
     EmitCs([bufferSlice = buffer->GetBufferSlice(AlignedByteOffsetForArgs)]
     (DxvkContext* ctx) {
@@ -1339,6 +1309,7 @@ namespace dxvk {
           ID3D11Buffer*   pBufferForArgs,
           UINT            AlignedByteOffsetForArgs) {
     D3D11Buffer* buffer = static_cast<D3D11Buffer*>(pBufferForArgs);
+    TrackDynamicBuffer(buffer);
     
     EmitCs([bufferSlice = buffer->GetBufferSlice(AlignedByteOffsetForArgs)]
     (DxvkContext* ctx) {
@@ -1364,6 +1335,7 @@ namespace dxvk {
           ID3D11Buffer*   pBufferForArgs,
           UINT            AlignedByteOffsetForArgs) {
     D3D11Buffer* buffer = static_cast<D3D11Buffer*>(pBufferForArgs);
+    TrackDynamicBuffer(buffer);
     
     EmitCs([bufferSlice = buffer->GetBufferSlice(AlignedByteOffsetForArgs)]
     (DxvkContext* ctx) {
@@ -2753,7 +2725,8 @@ namespace dxvk {
   void D3D11DeviceContext::BindShader(
           DxbcProgramType       ShaderStage,
     const D3D11CommonShader*    pShaderModule) {
-    // Bind the shader and the ICB at once
+    // Bind the shader and the ICB at once. The shader may still be
+    // compiling, so only wait for it on the CS thread if necessary.
     const uint32_t slotId = computeResourceSlotId(
       ShaderStage, DxbcBindingType::ConstantBuffer,
       D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
@@ -2761,16 +2734,16 @@ namespace dxvk {
     EmitCs([
       cSlotId = slotId,
       cStage  = GetShaderStage(ShaderStage),
-      cSlice  = pShaderModule           != nullptr
-             && pShaderModule->GetIcb() != nullptr
-        ? DxvkBufferSlice(pShaderModule->GetIcb())
-        : DxvkBufferSlice(),
-      cShader = pShaderModule != nullptr
-        ? pShaderModule->GetShader()
-        : nullptr
+      cModule = pShaderModule != nullptr
+        ? *pShaderModule
+        : D3D11CommonShader()
     ] (DxvkContext* ctx) {
-      ctx->bindShader        (cStage, cShader);
-      ctx->bindResourceBuffer(cSlotId, cSlice);
+      Rc<DxvkBuffer> icb = cModule.GetIcb();
+      
+      ctx->bindShader        (cStage, cModule.GetShader());
+      ctx->bindResourceBuffer(cSlotId, icb != nullptr
+        ? DxvkBufferSlice(icb)
+        : DxvkBufferSlice());
     });
   }
 
@@ -2814,6 +2787,8 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Stride) {
+    TrackDynamicBuffer(pBuffer);
+    
     EmitCs([
       cSlotId       = Slot,
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
@@ -2828,6 +2803,8 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           DXGI_FORMAT                       Format) {
+    TrackDynamicBuffer(pBuffer);
+    
     // As in Vulkan, the index format can be either a 32-bit
     // or 16-bit unsigned integer, no other formats are allowed.
     VkIndexType indexType = VK_INDEX_TYPE_UINT32;
@@ -2849,44 +2826,67 @@ namespace dxvk {
   }
   
   
-  void D3D11DeviceContext::BindConstantBuffer(
-          UINT                              Slot,
-    const D3D11ConstantBufferBinding*       pBufferBinding) {
-    EmitCs([
-      cSlotId      = Slot,
-      cBufferSlice = pBufferBinding->buffer != nullptr
-        ? pBufferBinding->buffer->GetBufferSlice(
-            pBufferBinding->constantOffset * 16,
-            pBufferBinding->constantCount  * 16)
-        : DxvkBufferSlice()
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceBuffer(cSlotId, cBufferSlice);
-    });
+  void D3D11DeviceContext::BindConstantBuffers(
+          UINT                              FirstSlot,
+          UINT                              SlotCount,
+    const D3D11ConstantBufferBinding*       pBufferBindings) {
+    DxvkBufferSlice* slices = EmitCsData<DxvkBufferSlice>([
+      cSlotId = FirstSlot
+    ] (DxvkContext* ctx, const DxvkBufferSlice* pSlices, size_t Count) {
+      ctx->bindResourceBuffers(cSlotId, Count, pSlices);
+    }, SlotCount);
+    
+    for (uint32_t i = 0; i < SlotCount; i++) {
+      const D3D11ConstantBufferBinding& binding = pBufferBindings[i];
+      
+      if (binding.buffer != nullptr) {
+        slices[i] = binding.buffer->GetBufferSlice(
+          binding.constantOffset * 16,
+          binding.constantCount  * 16);
+        
+        TrackDynamicBuffer(binding.buffer.ptr());
+      }
+    }
   }
   
   
-  void D3D11DeviceContext::BindSampler(
-          UINT                              Slot,
-          D3D11SamplerState*                pSampler) {
-    EmitCs([
-      cSlotId   = Slot,
-      cSampler  = pSampler != nullptr ? pSampler->GetDXVKSampler() : nullptr
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceSampler(cSlotId, cSampler);
-    });
+  void D3D11DeviceContext::BindSamplers(
+          UINT                              FirstSlot,
+          UINT                              SlotCount,
+    const Com<D3D11SamplerState>*           ppSamplers) {
+    Rc<DxvkSampler>* samplers = EmitCsData<Rc<DxvkSampler>>([
+      cSlotId = FirstSlot
+    ] (DxvkContext* ctx, const Rc<DxvkSampler>* pSamplers, size_t Count) {
+      ctx->bindResourceSamplers(cSlotId, Count, pSamplers);
+    }, SlotCount);
+    
+    for (uint32_t i = 0; i < SlotCount; i++) {
+      if (ppSamplers[i] != nullptr)
+        samplers[i] = ppSamplers[i]->GetDXVKSampler();
+    }
   }
   
   
-  void D3D11DeviceContext::BindShaderResource(
-          UINT                              Slot,
-          D3D11ShaderResourceView*          pResource) {
-    EmitCs([
-      cSlotId     = Slot,
-      cImageView  = pResource != nullptr ? pResource->GetImageView()  : nullptr,
-      cBufferView = pResource != nullptr ? pResource->GetBufferView() : nullptr
-    ] (DxvkContext* ctx) {
-      ctx->bindResourceView(cSlotId, cImageView, cBufferView);
-    });
+  void D3D11DeviceContext::BindShaderResources(
+          UINT                              FirstSlot,
+          UINT                              SlotCount,
+    const Com<D3D11ShaderResourceView>*     ppResources) {
+    D3D11ShaderResourceViewBinding* views = EmitCsData<D3D11ShaderResourceViewBinding>([
+      cSlotId = FirstSlot
+    ] (DxvkContext* ctx, const D3D11ShaderResourceViewBinding* pViews, size_t Count) {
+      for (uint32_t i = 0; i < Count; i++)
+        ctx->bindResourceView(cSlotId + i, pViews[i].imageView, pViews[i].bufferView);
+    }, SlotCount);
+    
+    for (uint32_t i = 0; i < SlotCount; i++) {
+      if (ppResources[i] != nullptr) {
+        views[i].imageView  = ppResources[i]->GetImageView();
+        views[i].bufferView = ppResources[i]->GetBufferView();
+        
+        if (ppResources[i]->IsDynamicBuffer())
+          m_csVolatile = true;
+      }
+    }
   }
   
   
@@ -2922,6 +2922,8 @@ namespace dxvk {
     EmitCs([cBuffer = pBuffer->GetBuffer()] (DxvkContext* ctx) {
       ctx->discardBuffer(cBuffer);
     });
+    
+    m_csVolatile = true;
   }
 
 
@@ -2949,6 +2951,11 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ConstantBuffer,
       StartSlot);
     
+    // Rebind all slots between the first and the last
+    // changed slot at once, rather than one at a time
+    uint32_t firstChanged = NumBuffers;
+    uint32_t lastChanged  = 0;
+    
     for (uint32_t i = 0; i < NumBuffers; i++) {
       auto newBuffer = static_cast<D3D11Buffer*>(ppConstantBuffers[i]);
       
@@ -2969,9 +2976,16 @@ namespace dxvk {
         Bindings[StartSlot + i].constantOffset = constantOffset;
         Bindings[StartSlot + i].constantCount  = constantCount;
         
-        BindConstantBuffer(slotId + i, &Bindings[StartSlot + i]);
+        firstChanged = std::min(firstChanged, i);
+        lastChanged  = i;
       }
     }
+    
+    if (firstChanged <= lastChanged) {
+      BindConstantBuffers(slotId + firstChanged,
+        lastChanged - firstChanged + 1,
+        &Bindings[StartSlot + firstChanged]);
+    }
   }
   
   
@@ -2985,14 +2999,25 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ImageSampler,
       StartSlot);
     
+    uint32_t firstChanged = NumSamplers;
+    uint32_t lastChanged  = 0;
+    
     for (uint32_t i = 0; i < NumSamplers; i++) {
       auto sampler = static_cast<D3D11SamplerState*>(ppSamplers[i]);
       
       if (Bindings[StartSlot + i] != sampler) {
         Bindings[StartSlot + i] = sampler;
-        BindSampler(slotId + i, sampler);
+        
+        firstChanged = std::min(firstChanged, i);
+        lastChanged  = i;
       }
     }
+    
+    if (firstChanged <= lastChanged) {
+      BindSamplers(slotId + firstChanged,
+        lastChanged - firstChanged + 1,
+        &Bindings[StartSlot + firstChanged]);
+    }
   }
   
   
@@ -3006,14 +3031,25 @@ namespace dxvk {
       ShaderStage, DxbcBindingType::ShaderResource,
       StartSlot);
     
+    uint32_t firstChanged = NumResources;
+    uint32_t lastChanged  = 0;
+    
     for (uint32_t i = 0; i < NumResources; i++) {
       auto resView = static_cast<D3D11ShaderResourceView*>(ppResources[i]);
       
       if (Bindings[StartSlot + i] != resView) {
         Bindings[StartSlot + i] = resView;
-        BindShaderResource(slotId + i, resView);
+        
+        firstChanged = std::min(firstChanged, i);
+        lastChanged  = i;
       }
     }
+    
+    if (firstChanged <= lastChanged) {
+      BindShaderResources(slotId + firstChanged,
+        lastChanged - firstChanged + 1,
+        &Bindings[StartSlot + firstChanged]);
+    }
   }
   
   
@@ -3146,8 +3182,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ConstantBuffer, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindConstantBuffer(slotId + i, &Bindings[i]);
+    BindConstantBuffers(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -3157,8 +3192,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ImageSampler, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindSampler(slotId + i, Bindings[i].ptr());
+    BindSamplers(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -3168,8 +3202,7 @@ namespace dxvk {
     const uint32_t slotId = computeResourceSlotId(
       Stage, DxbcBindingType::ShaderResource, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindShaderResource(slotId + i, Bindings[i].ptr());
+    BindShaderResources(slotId, Bindings.size(), Bindings.data());
   }
   
   
@@ -3228,6 +3261,65 @@ namespace dxvk {
   }
   
   
+  void D3D11DeviceContext::UploadBufferData(
+    const DxvkBufferSlice&                  DstSlice,
+    const void*                             pSrcData) {
+    DxvkDataSlice dataSlice = AllocUpdateBufferSlice(DstSlice.length());
+    std::memcpy(dataSlice.ptr(), pSrcData, DstSlice.length());
+    
+    EmitCs([
+      cDataBuffer   = std::move(dataSlice),
+      cBufferSlice  = DstSlice
+    ] (DxvkContext* ctx) {
+      ctx->updateBuffer(
+        cBufferSlice.buffer(),
+        cBufferSlice.offset(),
+        cBufferSlice.length(),
+        cDataBuffer.ptr());
+    });
+  }
+  
+  
+  void D3D11DeviceContext::UploadImageData(
+    const Rc<DxvkImage>&                    DstImage,
+    const VkImageSubresourceLayers&         DstLayers,
+          VkOffset3D                        DstOffset,
+          VkExtent3D                        DstExtent,
+    const void*                             pSrcData,
+          UINT                              SrcRowPitch,
+          UINT                              SrcDepthPitch) {
+    auto formatInfo = imageFormatInfo(DstImage->info().format);
+    
+    const VkExtent3D regionExtent = util::computeBlockCount(DstExtent, formatInfo->blockSize);
+    
+    const VkDeviceSize bytesPerRow   = regionExtent.width  * formatInfo->elementSize;
+    const VkDeviceSize bytesPerLayer = regionExtent.height * bytesPerRow;
+    const VkDeviceSize bytesTotal    = regionExtent.depth  * bytesPerLayer;
+    
+    DxvkDataSlice imageDataBuffer = AllocUpdateBufferSlice(bytesTotal);
+    
+    util::packImageData(
+      reinterpret_cast<char*>(imageDataBuffer.ptr()),
+      reinterpret_cast<const char*>(pSrcData),
+      regionExtent, formatInfo->elementSize,
+      SrcRowPitch, SrcDepthPitch);
+    
+    EmitCs([
+      cDstImage         = DstImage,
+      cDstLayers        = DstLayers,
+      cDstOffset        = DstOffset,
+      cDstExtent        = DstExtent,
+      cSrcData          = std::move(imageDataBuffer),
+      cSrcBytesPerRow   = bytesPerRow,
+      cSrcBytesPerLayer = bytesPerLayer
+    ] (DxvkContext* ctx) {
+      ctx->updateImage(cDstImage, cDstLayers,
+        cDstOffset, cDstExtent, cSrcData.ptr(),
+        cSrcBytesPerRow, cSrcBytesPerLayer);
+    });
+  }
+  
+  
   DxvkDataSlice D3D11DeviceContext::AllocUpdateBufferSlice(size_t Size) {
     constexpr size_t UpdateBufferSize = 16 * 1024 * 1024;
     
@@ -13,6 +13,17 @@ namespace dxvk {
   
   class D3D11Device;
   
+  /**
+   * \brief Shader resource view binding
+   * 
+   * Stores the DXVK views of a shader resource
+   * view for a single slot in a CS command.
+   */
+  struct D3D11ShaderResourceViewBinding {
+    Rc<DxvkImageView>   imageView;
+    Rc<DxvkBufferView>  bufferView;
+  };
+  
   class D3D11DeviceContext : public D3D11DeviceChild<ID3D11DeviceContext1> {
     
   public:
@@ -647,6 +658,12 @@ namespace dxvk {
     
     DxvkCsChunkRef              m_csChunk;
     
+    // Set if any of the commands recorded so far rename
+    // buffers, use queries or read from dynamic buffers.
+    // Only relevant for deferred contexts, see
+    // \ref D3D11CommandList::MarkVolatile.
+    bool                        m_csVolatile = false;
+    
     Com<D3D11BlendState>        m_defaultBlendState;
     Com<D3D11DepthStencilState> m_defaultDepthStencilState;
     Com<D3D11RasterizerState>   m_defaultRasterizerState;
@@ -687,17 +704,20 @@ namespace dxvk {
             UINT                              Offset,
             DXGI_FORMAT                       Format);
     
-    void BindConstantBuffer(
-            UINT                              Slot,
-      const D3D11ConstantBufferBinding*       pBufferBinding);
+    void BindConstantBuffers(
+            UINT                              FirstSlot,
+            UINT                              SlotCount,
+      const D3D11ConstantBufferBinding*       pBufferBindings);
     
-    void BindSampler(
-            UINT                              Slot,
-            D3D11SamplerState*                pSampler);
+    void BindSamplers(
+            UINT                              FirstSlot,
+            UINT                              SlotCount,
+      const Com<D3D11SamplerState>*           ppSamplers);
     
-    void BindShaderResource(
-            UINT                              Slot,
-            D3D11ShaderResourceView*          pResource);
+    void BindShaderResources(
+            UINT                              FirstSlot,
+            UINT                              SlotCount,
+      const Com<D3D11ShaderResourceView>*     ppResources);
     
     void BindUnorderedAccessView(
             UINT                              UavSlot,
@@ -778,6 +798,42 @@ namespace dxvk {
             ID3D11RenderTargetView* const*    ppRenderTargetViews,
             ID3D11DepthStencilView*           pDepthStencilView);
     
+    /**
+     * \brief Uploads data to a buffer
+     * 
+     * Used by \c UpdateSubresource for buffers that cannot
+     * be mapped directly. The default implementation copies
+     * the data to the CS thread, which then copies it to a
+     * staging buffer. The data is copied before returning.
+     * \param [in] DstSlice Destination buffer slice
+     * \param [in] pSrcData Source data
+     */
+    virtual void UploadBufferData(
+      const DxvkBufferSlice&                  DstSlice,
+      const void*                             pSrcData);
+    
+    /**
+     * \brief Uploads data to an image subresource
+     * 
+     * Used by \c UpdateSubresource for images. Same
+     * as \ref UploadBufferData otherwise.
+     * \param [in] DstImage Destination image
+     * \param [in] DstLayers Destination subresource
+     * \param [in] DstOffset Destination area offset
+     * \param [in] DstExtent Destination area size
+     * \param [in] pSrcData Source data
+     * \param [in] SrcRowPitch Source row pitch
+     * \param [in] SrcDepthPitch Source layer pitch
+     */
+    virtual void UploadImageData(
+      const Rc<DxvkImage>&                    DstImage,
+      const VkImageSubresourceLayers&         DstLayers,
+            VkOffset3D                        DstOffset,
+            VkExtent3D                        DstExtent,
+      const void*                             pSrcData,
+            UINT                              SrcRowPitch,
+            UINT                              SrcDepthPitch);
+    
     DxvkDataSlice AllocUpdateBufferSlice(size_t Size);
     
     DxvkCsChunkRef AllocCsChunk();
@@ -786,6 +842,11 @@ namespace dxvk {
     const D3D11CommonShader* GetCommonShader(T* pShader) const {
       return pShader != nullptr ? pShader->GetCommonShader() : nullptr;
     }
+    
+    void TrackDynamicBuffer(const D3D11Buffer* pBuffer) {
+      if (pBuffer != nullptr && pBuffer->Desc()->Usage == D3D11_USAGE_DYNAMIC)
+        m_csVolatile = true;
+    }
 
     template<typename Cmd>
     void EmitCs(Cmd&& command) {
@@ -797,6 +858,20 @@ namespace dxvk {
       }
     }
     
+    template<typename M, typename Cmd>
+    M* EmitCsData(Cmd&& command, size_t count) {
+      M* data = m_csChunk->pushData<M>(command, count);
+      
+      if (data == nullptr) {
+        EmitCsChunk(std::move(m_csChunk));
+        
+        m_csChunk = AllocCsChunk();
+        data = m_csChunk->pushData<M>(command, count);
+      }
+      
+      return data;
+    }
+    
     void FlushCsChunk() {
       if (m_csChunk->commandCount() != 0) {
         EmitCsChunk(std::move(m_csChunk));
@@ -57,9 +57,20 @@ namespace dxvk {
           ID3D11CommandList   **ppCommandList) {
     FlushCsChunk();
     
+    if (m_csVolatile)
+      m_commandList->MarkVolatile();
+    
+    // Translate the command list to Vulkan commands on the
+    // calling thread, so that applications recording command
+    // lists on multiple threads don't bottleneck the CS thread
+    if (m_parent->GetOptions()->prerecordCommandLists
+     && !m_commandList->IsVolatile())
+      m_commandList->RecordCommands();
+    
     if (ppCommandList != nullptr)
       *ppCommandList = m_commandList.ref();
     m_commandList = CreateCommandList();
+    m_csVolatile  = false;
     
     if (RestoreDeferredContextState)
       RestoreState();
@@ -158,9 +169,6 @@ namespace dxvk {
     D3D11Buffer* pBuffer = static_cast<D3D11Buffer*>(pResource);
     const Rc<DxvkBuffer> buffer = pBuffer->GetBuffer();
     
-    D3D11_BUFFER_DESC bufferDesc;
-    pBuffer->GetDesc(&bufferDesc);
-    
     if (!(buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
       Logger::err("D3D11: Cannot map a device-local buffer");
       return E_INVALIDARG;
@@ -172,18 +180,12 @@ namespace dxvk {
     pMapEntry->RowPitch     = pBuffer->GetSize();
     pMapEntry->DepthPitch   = pBuffer->GetSize();
     
-    if (bufferDesc.Usage == D3D11_USAGE_DYNAMIC) {
-      // For resources that cannot be written by the GPU,
-      // we may write to the buffer resource directly and
-      // just swap in the physical buffer slice as needed.
-      pMapEntry->BufferSlice = buffer->allocPhysicalSlice();
-      pMapEntry->MapPointer  = pMapEntry->BufferSlice.mapPtr(0);
-    } else {
-      // For GPU-writable resources, we need a data slice
-      // to perform the update operation at execution time.
-      pMapEntry->DataSlice   = AllocUpdateBufferSlice(pBuffer->GetSize());
-      pMapEntry->MapPointer  = pMapEntry->DataSlice.ptr();
-    }
+    // Command lists may be executed more than once, so we
+    // cannot write to a physical buffer slice directly since
+    // the slice may get reused once the buffer is renamed.
+    // Instead, copy the data at execution time.
+    pMapEntry->DataSlice    = AllocUpdateBufferSlice(pBuffer->GetSize());
+    pMapEntry->MapPointer   = pMapEntry->DataSlice.ptr();
     
     return S_OK;
   }
@@ -239,26 +241,17 @@ namespace dxvk {
     const D3D11DeferredContextMapEntry* pMapEntry) {
     D3D11Buffer* pBuffer = static_cast<D3D11Buffer*>(pResource);
     
-    D3D11_BUFFER_DESC bufferDesc;
-    pBuffer->GetDesc(&bufferDesc);
+    // Renames the buffer at execution time
+    m_csVolatile = true;
     
-    if (bufferDesc.Usage == D3D11_USAGE_DYNAMIC) {
-      EmitCs([
-        cDstBuffer = pBuffer->GetBuffer(),
-        cPhysSlice = pMapEntry->BufferSlice
-      ] (DxvkContext* ctx) {
-        ctx->invalidateBuffer(cDstBuffer, cPhysSlice);
-      });
-    } else {
-      EmitCs([
-        cDstBuffer = pBuffer->GetBuffer(),
-        cDataSlice = pMapEntry->DataSlice
-      ] (DxvkContext* ctx) {
-        DxvkPhysicalBufferSlice slice = cDstBuffer->allocPhysicalSlice();
-        std::memcpy(slice.mapPtr(0), cDataSlice.ptr(), cDataSlice.length());
-        ctx->invalidateBuffer(cDstBuffer, slice);
-      });
-    }
+    EmitCs([
+      cDstBuffer = pBuffer->GetBuffer(),
+      cDataSlice = pMapEntry->DataSlice
+    ] (DxvkContext* ctx) {
+      DxvkPhysicalBufferSlice slice = cDstBuffer->allocPhysicalSlice();
+      std::memcpy(slice.mapPtr(0), cDataSlice.ptr(), cDataSlice.length());
+      ctx->invalidateBuffer(cDstBuffer, slice);
+    });
   }
   
   
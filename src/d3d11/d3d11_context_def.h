@@ -17,7 +17,6 @@ namespace dxvk {
     UINT                    RowPitch;
     UINT                    DepthPitch;
     DxvkDataSlice           DataSlice;
-    DxvkPhysicalBufferSlice BufferSlice;
     void*                   MapPointer;
   };
   
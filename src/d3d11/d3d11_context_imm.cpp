@@ -8,11 +8,24 @@ constexpr static uint32_t MaxPendingSubmits  = 3;
 
 namespace dxvk {
   
+  static uint32_t GetUploadThreadCount(const D3D11Options* pOptions) {
+    if (pOptions->uploadThreads >= 0)
+      return uint32_t(pOptions->uploadThreads);
+    
+    // The application thread also takes part in
+    // the copy, so we don't need many workers
+    return std::min(4u, dxvk::thread::hardware_concurrency() / 4);
+  }
+  
+  
   D3D11ImmediateContext::D3D11ImmediateContext(
           D3D11Device*    pParent,
     const Rc<DxvkDevice>& Device)
   : D3D11DeviceContext(pParent, Device),
-    m_csThread(Device->createContext()) {
+    m_csThread(Device->createContext(), Device->timings()),
+    m_uploadWorkers(
+      GetUploadThreadCount(pParent->GetOptions()),
+      pParent->GetOptions()->uploadNonTemporal) {
     EmitCs([cDevice = m_device] (DxvkContext* ctx) {
       ctx->beginRecording(cDevice->createCommandList());
     });
@@ -126,10 +139,45 @@ namespace dxvk {
     // number of pending draw calls is high enough.
     FlushImplicit();
     
-    // Dispatch command list to the CS thread and
-    // restore the immediate context's state
-    commandList->EmitToCsThread(&m_csThread);
+    // If the Vulkan commands have been recorded ahead of time,
+    // submit them in order with the commands recorded by the
+    // CS thread. Otherwise, dispatch the command list's chunks.
+    Rc<DxvkCommandList> commands = commandList->TakeCommands();
+    
+    if (commands != nullptr) {
+      m_parent->FlushInitContext();
+      
+      // If any buffer was discarded since the commands were
+      // recorded, they may access stale buffer memory. This
+      // must be checked on the CS thread, since discards that
+      // precede this call may not have been executed yet.
+      EmitCs([
+        cDevice       = m_device,
+        cCommands     = std::move(commands),
+        cChunks       = commandList->GetChunks(),
+        cDiscardCount = commandList->GetDiscardCount()
+      ] (DxvkContext* ctx) {
+        if (cDevice->getBufferDiscardCount() != cDiscardCount) {
+          for (const auto& chunk : cChunks)
+            chunk->executeAll(ctx);
+          return;
+        }
+        
+        cDevice->submitCommandList(
+          ctx->endRecording(),
+          nullptr, nullptr);
+        
+        cDevice->submitCommandList(
+          cCommands, nullptr, nullptr);
+        
+        ctx->beginRecording(
+          cDevice->createCommandList());
+      });
+    } else {
+      commandList->EmitToCsThread(&m_csThread);
+    }
     
+    // Restore the immediate context's state
     if (RestoreContextState)
       RestoreState();
     else
@@ -504,6 +552,17 @@ namespace dxvk {
   }
   
   
+  void D3D11ImmediateContext::DefragmentMemory() {
+    // Copies for relocated buffers must be recorded in
+    // order with all other commands, so run on the CS thread
+    EmitCs([
+      cDefrag = m_device->defragmenter()
+    ] (DxvkContext* ctx) {
+      cDefrag->run(ctx);
+    });
+  }
+  
+  
   void D3D11ImmediateContext::SynchronizeDevice() {
     m_device->waitForIdle();
   }
@@ -544,6 +603,137 @@ namespace dxvk {
   }
   
   
+  void D3D11ImmediateContext::UploadBufferData(
+    const DxvkBufferSlice&                  DstSlice,
+    const void*                             pSrcData) {
+    if (DstSlice.length() <= MinStagingBufferUpdate) {
+      D3D11DeviceContext::UploadBufferData(DstSlice, pSrcData);
+      return;
+    }
+    
+    // Write the data directly to a staging buffer so that
+    // the CS thread does not have to copy it a second time
+    void* mapPtr = nullptr;
+    
+    DxvkBufferSlice stagingSlice = AllocStagingBuffer(
+      DstSlice.length(), 16, &mapPtr);
+    
+    m_uploadWorkers.CopyData(mapPtr, pSrcData, DstSlice.length());
+    
+    EmitCs([
+      cDstSlice = DstSlice,
+      cSrcSlice = std::move(stagingSlice)
+    ] (DxvkContext* ctx) {
+      ctx->copyBuffer(
+        cDstSlice.buffer(),
+        cDstSlice.offset(),
+        cSrcSlice.buffer(),
+        cSrcSlice.offset(),
+        cSrcSlice.length());
+    });
+  }
+  
+  
+  void D3D11ImmediateContext::UploadImageData(
+    const Rc<DxvkImage>&                    DstImage,
+    const VkImageSubresourceLayers&         DstLayers,
+          VkOffset3D                        DstOffset,
+          VkExtent3D                        DstExtent,
+    const void*                             pSrcData,
+          UINT                              SrcRowPitch,
+          UINT                              SrcDepthPitch) {
+    auto formatInfo = imageFormatInfo(DstImage->info().format);
+    
+    const VkExtent3D regionExtent = util::computeBlockCount(DstExtent, formatInfo->blockSize);
+    const VkDeviceSize bytesTotal = formatInfo->elementSize * util::flattenImageExtent(regionExtent);
+    
+    // Buffer offsets for image copies must be a multiple
+    // of the texel block size, and we want them to be at
+    // least 16-byte aligned for non-temporal stores
+    VkDeviceSize alignment = formatInfo->elementSize;
+    
+    while (alignment % 16)
+      alignment += formatInfo->elementSize;
+    
+    void* mapPtr = nullptr;
+    
+    DxvkBufferSlice stagingSlice = AllocStagingBuffer(
+      bytesTotal, alignment, &mapPtr);
+    
+    m_uploadWorkers.PackImageData(mapPtr, pSrcData,
+      regionExtent, formatInfo->elementSize,
+      SrcRowPitch, SrcDepthPitch);
+    
+    EmitCs([
+      cDstImage   = DstImage,
+      cDstLayers  = DstLayers,
+      cDstOffset  = DstOffset,
+      cDstExtent  = DstExtent,
+      cSrcSlice   = std::move(stagingSlice)
+    ] (DxvkContext* ctx) {
+      ctx->copyBufferToImage(
+        cDstImage, cDstLayers,
+        cDstOffset, cDstExtent,
+        cSrcSlice.buffer(),
+        cSrcSlice.offset(),
+        VkExtent2D { 0u, 0u });
+    });
+  }
+  
+  
+  DxvkBufferSlice D3D11ImmediateContext::AllocStagingBuffer(
+          VkDeviceSize                      Size,
+          VkDeviceSize                      Alignment,
+          void**                            ppMapPtr) {
+    DxvkBufferCreateInfo info;
+    info.size   = StagingBufferSize;
+    info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    info.access = VK_ACCESS_TRANSFER_READ_BIT;
+    
+    const VkMemoryPropertyFlags memFlags
+      = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    
+    // Large uploads get a dedicated buffer, which is
+    // destroyed as soon as the GPU is done with it
+    if (Size > StagingBufferSize) {
+      info.size = Size;
+      
+      Rc<DxvkBuffer> buffer = m_device->createBuffer(info, memFlags);
+      *ppMapPtr = buffer->mapPtr(0);
+      return DxvkBufferSlice(buffer);
+    }
+    
+    VkDeviceSize offset = ((m_stagingOffset + Alignment - 1) / Alignment) * Alignment;
+    
+    if (m_stagingBuffer == nullptr) {
+      m_stagingBuffer = m_device->createBuffer(info, memFlags);
+      m_stagingSlice  = m_stagingBuffer->slice();
+      offset = 0;
+    } else if (offset + Size > StagingBufferSize) {
+      // Rename the staging buffer. The CS thread will return
+      // the old slice to the buffer once the GPU is done with
+      // it, and all copies that read from it are recorded
+      // before the buffer gets invalidated.
+      m_stagingSlice = m_stagingBuffer->allocPhysicalSlice();
+      offset = 0;
+      
+      EmitCs([
+        cBuffer = m_stagingBuffer,
+        cSlice  = m_stagingSlice
+      ] (DxvkContext* ctx) {
+        ctx->invalidateBuffer(cBuffer, cSlice);
+      });
+    }
+    
+    m_stagingOffset = offset + Size;
+    
+    *ppMapPtr = m_stagingSlice.mapPtr(offset);
+    return DxvkBufferSlice(m_stagingBuffer, offset, Size);
+  }
+  
+  
   void D3D11ImmediateContext::EmitCsChunk(DxvkCsChunkRef&& chunk) {
     m_csThread.dispatchChunk(std::move(chunk));
     m_csIsBusy = true;
@@ -3,6 +3,7 @@
 #include <chrono>
 
 #include "d3d11_context.h"
+#include "d3d11_upload.h"
 
 namespace dxvk {
   
@@ -10,6 +11,13 @@ namespace dxvk {
   class D3D11CommonTexture;
   
   class D3D11ImmediateContext : public D3D11DeviceContext {
+    /// Size of the staging buffer used for uploads. Larger
+    /// uploads will get their own staging buffer.
+    constexpr static VkDeviceSize StagingBufferSize = 4 << 20;
+    
+    /// Buffer updates up to this size are written to
+    /// the command buffer directly by the CS thread.
+    constexpr static VkDeviceSize MinStagingBufferUpdate = 4096;
   public:
     
     D3D11ImmediateContext(
@@ -120,10 +128,18 @@ namespace dxvk {
     
     void SynchronizeCsThread();
     
+    void DefragmentMemory();
+    
   private:
     
     DxvkCsThread m_csThread;
     bool         m_csIsBusy = false;
+    
+    D3D11UploadWorkers      m_uploadWorkers;
+    
+    Rc<DxvkBuffer>          m_stagingBuffer;
+    DxvkPhysicalBufferSlice m_stagingSlice;
+    VkDeviceSize            m_stagingOffset = 0;
 
     std::chrono::high_resolution_clock::time_point m_lastFlush
       = std::chrono::high_resolution_clock::now();
@@ -151,6 +167,24 @@ namespace dxvk {
       const Rc<DxvkResource>&                 Resource,
             UINT                              MapFlags);
     
+    void UploadBufferData(
+      const DxvkBufferSlice&                  DstSlice,
+      const void*                             pSrcData) final;
+    
+    void UploadImageData(
+      const Rc<DxvkImage>&                    DstImage,
+      const VkImageSubresourceLayers&         DstLayers,
+            VkOffset3D                        DstOffset,
+            VkExtent3D                        DstExtent,
+      const void*                             pSrcData,
+            UINT                              SrcRowPitch,
+            UINT                              SrcDepthPitch) final;
+    
+    DxvkBufferSlice AllocStagingBuffer(
+            VkDeviceSize                      Size,
+            VkDeviceSize                      Alignment,
+            void**                            ppMapPtr);
+    
     void EmitCsChunk(DxvkCsChunkRef&& chunk) final;
 
     void FlushImplicit();
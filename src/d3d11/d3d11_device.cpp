@@ -112,6 +112,11 @@ namespace dxvk {
           reinterpret_cast<void**>(&m_dxgiAdapter))))
       throw DxvkError("D3D11Device: Failed to query adapter");
     
+    // Pre-recorded command lists resolve buffer slices on
+    // application threads, which may race with relocation
+    if (m_d3d11Options.prerecordCommandLists)
+      m_dxvkDevice->defragmenter()->disableRelocation();
+    
     m_initializer = new D3D11Initializer(m_dxvkDevice);
     m_context     = new D3D11ImmediateContext(this, m_dxvkDevice);
     m_d3d10Device = new D3D10Device(this, m_context);
@@ -72,6 +72,10 @@ namespace dxvk {
         0u);
     }
 
+    // The buffer must not be relocated before the commands
+    // above are submitted, since they use its current slice
+    m_pendingBuffers.push_back(bufferSlice.buffer());
+
     FlushImplicit();
   }
 
@@ -200,6 +204,11 @@ namespace dxvk {
     m_context->beginRecording(
       m_device->createCommandList());
     
+    for (const auto& buffer : m_pendingBuffers)
+      m_device->defragmenter()->registerBuffer(buffer.ptr());
+    
+    m_pendingBuffers.clear();
+
     m_transferCommands = 0;
     m_transferMemory   = 0;
   }
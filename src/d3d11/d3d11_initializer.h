@@ -43,6 +43,8 @@ namespace dxvk {
     size_t            m_transferCommands  = 0;
     size_t            m_transferMemory    = 0;
 
+    std::vector<Rc<DxvkBuffer>> m_pendingBuffers;
+
     void InitDeviceLocalBuffer(
             D3D11Buffer*                pBuffer,
       const D3D11_SUBRESOURCE_DATA*     pInitialData);
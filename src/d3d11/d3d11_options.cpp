@@ -9,6 +9,10 @@ namespace dxvk {
     this->fakeStreamOutSupport  = config.getOption<bool>("d3d11.fakeStreamOutSupport",  false);
     this->maxTessFactor         = config.getOption<int32_t>("d3d11.maxTessFactor",      0);
     this->samplerAnisotropy     = config.getOption<int32_t>("d3d11.samplerAnisotropy",  -1);
+    this->asyncShaderCompile    = config.getOption<bool>("d3d11.asyncShaderCompile",    false);
+    this->prerecordCommandLists = config.getOption<bool>("d3d11.prerecordCommandLists", false);
+    this->uploadThreads         = config.getOption<int32_t>("d3d11.uploadThreads",      -1);
+    this->uploadNonTemporal     = config.getOption<bool>("d3d11.uploadNonTemporal",     false);
   }
   
 }
\ No newline at end of file
@@ -36,6 +36,38 @@ namespace dxvk {
     /// Enforces anisotropic filtering with the
     /// given anisotropy value for all samplers.
     int32_t samplerAnisotropy;
+
+    /// Compile shaders asynchronously
+    ///
+    /// Shader creation returns immediately, and shaders
+    /// get compiled on a pool of worker threads. Shaders
+    /// that are still compiling are waited for on the CS
+    /// thread when used. Compilation errors are only logged.
+    bool asyncShaderCompile;
+
+    /// Record command lists ahead of time
+    ///
+    /// Translates deferred command lists to Vulkan command
+    /// buffers on the thread calling FinishCommandList, so
+    /// that executing them only requires a queue submission.
+    /// Command lists that map buffers, use queries or read
+    /// from dynamic buffers are executed on the CS thread.
+    bool prerecordCommandLists;
+
+    /// Number of upload worker threads
+    ///
+    /// Large UpdateSubresource calls on the immediate
+    /// context are split across this many additional
+    /// threads. A negative value picks a number based
+    /// on the CPU core count, zero disables threading.
+    int32_t uploadThreads;
+
+    /// Use non-temporal stores for uploads
+    ///
+    /// Bypasses the CPU cache when copying data to
+    /// staging memory. May improve upload throughput
+    /// on systems where staging memory is uncached.
+    bool uploadNonTemporal;
   };
   
 }
\ No newline at end of file
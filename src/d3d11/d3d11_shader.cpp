@@ -3,12 +3,12 @@
 
 namespace dxvk {
   
-  D3D11CommonShader:: D3D11CommonShader() { }
-  D3D11CommonShader::~D3D11CommonShader() { }
+  D3D11ShaderModule:: D3D11ShaderModule() { }
+  D3D11ShaderModule::~D3D11ShaderModule() { }
   
   
-  D3D11CommonShader::D3D11CommonShader(
-          D3D11Device*    pDevice,
+  D3D11ShaderModule::D3D11ShaderModule(
+    const Rc<DxvkDevice>& Device,
     const DxvkShaderKey*  pShaderKey,
     const DxbcModuleInfo* pDxbcModuleInfo,
     const void*           pShaderBytecode,
@@ -20,8 +20,6 @@ namespace dxvk {
       reinterpret_cast<const char*>(pShaderBytecode),
       BytecodeLength);
     
-    DxbcModule module(reader);
-    
     // If requested by the user, dump both the raw DXBC
     // shader and the compiled SPIR-V module to a file.
     const std::string dumpPath = env::getEnvVar(L"DXVK_SHADER_DUMP_PATH");
@@ -31,7 +29,21 @@ namespace dxvk {
         std::ios_base::binary | std::ios_base::trunc));
     }
     
-    m_shader = module.compile(*pDxbcModuleInfo, name);
+    // Look up the shader in the shader cache before
+    // running the compiler, since this is a lot faster
+    DxvkShaderCacheKey cacheKey;
+    cacheKey.shader  = *pShaderKey;
+    cacheKey.options = hashDxbcModuleInfo(*pDxbcModuleInfo);
+    
+    m_shader = Device->lookupCachedShader(cacheKey);
+    
+    if (m_shader == nullptr) {
+      DxbcModule module(reader);
+      
+      m_shader = module.compile(*pDxbcModuleInfo, name);
+      Device->storeCachedShader(cacheKey, m_shader);
+    }
+    
     m_shader->setShaderKey(*pShaderKey);
     
     if (dumpPath.size() != 0) {
@@ -57,16 +69,97 @@ namespace dxvk {
         | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
         | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
       
-      m_buffer = pDevice->GetDXVKDevice()->createBuffer(info, memFlags);
+      m_buffer = Device->createBuffer(info, memFlags);
 
       std::memcpy(m_buffer->mapPtr(0),
         m_shader->shaderConstants().data(),
         m_shader->shaderConstants().sizeInBytes());
     }
 
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
+    Device->registerShader(m_shader);
   }
-
+  
+  
+  D3D11CommonShader:: D3D11CommonShader() { }
+  D3D11CommonShader::~D3D11CommonShader() { }
+  
+  
+  D3D11CommonShader::D3D11CommonShader(
+          D3D11ShaderModule&&                     Module) {
+    std::promise<D3D11ShaderModule> promise;
+    promise.set_value(std::move(Module));
+    m_module = promise.get_future().share();
+  }
+  
+  
+  D3D11CommonShader::D3D11CommonShader(
+          std::shared_future<D3D11ShaderModule>&& Module)
+  : m_module(std::move(Module)) { }
+  
+  
+  D3D11ShaderCompiler::D3D11ShaderCompiler() {
+    // Shader compilation is mostly done while loading,
+    // so we can use all available CPU cores for it
+    uint32_t numWorkers = std::max(1u, dxvk::thread::hardware_concurrency());
+    
+    Logger::info(str::format("D3D11: Using ", numWorkers, " shader compiler threads"));
+    
+    for (uint32_t i = 0; i < numWorkers; i++)
+      m_threads.emplace_back([this] () { RunWorker(); });
+  }
+  
+  
+  D3D11ShaderCompiler::~D3D11ShaderCompiler() {
+    // Workers finish all queued tasks before exiting, so
+    // that nobody waits on a future that never completes
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+    
+    m_cond.notify_all();
+    
+    for (auto& thread : m_threads)
+      thread.join();
+  }
+  
+  
+  std::shared_future<D3D11ShaderModule> D3D11ShaderCompiler::QueueCompilation(
+          std::function<D3D11ShaderModule ()>&& Fn) {
+    Task task(std::move(Fn));
+    auto future = task.get_future().share();
+    
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push(std::move(task));
+    }
+    
+    m_cond.notify_one();
+    return future;
+  }
+  
+  
+  void D3D11ShaderCompiler::RunWorker() {
+    env::setThreadName(L"dxvk-dxbc");
+    
+    while (true) {
+      Task task;
+      
+      { std::unique_lock<std::mutex> lock(m_mutex);
+        
+        m_cond.wait(lock, [this] {
+          return m_stopped || !m_tasks.empty();
+        });
+        
+        if (m_tasks.empty())
+          return;
+        
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+      }
+      
+      task();
+    }
+  }
+  
   
   D3D11ShaderModuleSet:: D3D11ShaderModuleSet() { }
   D3D11ShaderModuleSet::~D3D11ShaderModuleSet() { }
@@ -86,12 +179,22 @@ namespace dxvk {
       auto entry = m_modules.find(key);
       if (entry != m_modules.end())
         return entry->second;
+      
+      // Queuing the shader is cheap, so we can do it while
+      // holding the lock and avoid compiling it twice
+      if (pDevice->GetOptions()->asyncShaderCompile) {
+        D3D11CommonShader module = QueueShaderModule(pDevice,
+          key, pDxbcModuleInfo, pShaderBytecode, BytecodeLength);
+        
+        m_modules.insert({ key, module });
+        return module;
+      }
     }
     
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
-    D3D11CommonShader module(pDevice, &key,
-      pDxbcModuleInfo, pShaderBytecode, BytecodeLength);
+    D3D11CommonShader module(D3D11ShaderModule(pDevice->GetDXVKDevice(), &key,
+      pDxbcModuleInfo, pShaderBytecode, BytecodeLength));
     
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
@@ -106,4 +209,49 @@ namespace dxvk {
     return module;
   }
   
+  
+  
+  D3D11CommonShader D3D11ShaderModuleSet::QueueShaderModule(
+          D3D11Device*    pDevice,
+    const DxvkShaderKey&  ShaderKey,
+    const DxbcModuleInfo* pDxbcModuleInfo,
+    const void*           pShaderBytecode,
+          size_t          BytecodeLength) {
+    if (m_compiler == nullptr)
+      m_compiler = std::make_unique<D3D11ShaderCompiler>();
+    
+    // The bytecode is owned by the application and the
+    // module info may point to data on the stack, so we
+    // need to copy everything that the compiler needs.
+    // Only hold on to the DXVK device, since the D3D11
+    // device may be destroyed before the task runs.
+    Rc<DxvkDevice> device = pDevice->GetDXVKDevice();
+    
+    auto bytecode = reinterpret_cast<const char*>(pShaderBytecode);
+    
+    std::vector<char> code(bytecode, bytecode + BytecodeLength);
+    
+    DxbcModuleInfo moduleInfo = *pDxbcModuleInfo;
+    DxbcTessInfo   tessInfo   = { 0.0f };
+    
+    if (moduleInfo.tess != nullptr)
+      tessInfo = *moduleInfo.tess;
+    
+    return D3D11CommonShader(m_compiler->QueueCompilation(
+      [device, ShaderKey, moduleInfo, tessInfo, code = std::move(code)] () mutable {
+        if (moduleInfo.tess != nullptr)
+          moduleInfo.tess = &tessInfo;
+        
+        // Errors can no longer be reported to the application,
+        // so log them and leave the shader stage unbound.
+        try {
+          return D3D11ShaderModule(device, &ShaderKey,
+            &moduleInfo, code.data(), code.size());
+        } catch (const DxvkError& e) {
+          Logger::err(e.message());
+          return D3D11ShaderModule();
+        }
+      }));
+  }
+  
 }
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <queue>
 #include <unordered_map>
+#include <vector>
 
 #include "../dxbc/dxbc_module.h"
 #include "../dxvk/dxvk_device.h"
@@ -19,12 +25,49 @@ namespace dxvk {
   
   class D3D11Device;
   
+  /**
+   * \brief Shader module
+   * 
+   * Stores the compiled SPIR-V shader and the
+   * shader's immediate constant buffer, if any.
+   */
+  class D3D11ShaderModule {
+    
+  public:
+    
+    D3D11ShaderModule();
+    D3D11ShaderModule(
+      const Rc<DxvkDevice>& Device,
+      const DxvkShaderKey*  pShaderKey,
+      const DxbcModuleInfo* pDxbcModuleInfo,
+      const void*           pShaderBytecode,
+            size_t          BytecodeLength);
+    ~D3D11ShaderModule();
+    
+    Rc<DxvkShader> GetShader() const {
+      return m_shader;
+    }
+    
+    Rc<DxvkBuffer> GetIcb() const {
+      return m_buffer;
+    }
+    
+  private:
+    
+    Rc<DxvkShader> m_shader;
+    Rc<DxvkBuffer> m_buffer;
+    
+  };
+  
+  
   /**
    * \brief Common shader object
    * 
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
-   * used to identify the shader.
+   * used to identify the shader. The shader module
+   * may still be compiling on a worker thread, in
+   * which case the first access will wait for it.
    */
   class D3D11CommonShader {
     
@@ -32,29 +75,30 @@ namespace dxvk {
     
     D3D11CommonShader();
     D3D11CommonShader(
-            D3D11Device*    pDevice,
-      const DxvkShaderKey*  pShaderKey,
-      const DxbcModuleInfo* pDxbcModuleInfo,
-      const void*           pShaderBytecode,
-            size_t          BytecodeLength);
+            D3D11ShaderModule&&                     Module);
+    D3D11CommonShader(
+            std::shared_future<D3D11ShaderModule>&& Module);
     ~D3D11CommonShader();
 
     Rc<DxvkShader> GetShader() const {
-      return m_shader;
+      return m_module.valid()
+        ? m_module.get().GetShader()
+        : nullptr;
     }
 
     Rc<DxvkBuffer> GetIcb() const {
-      return m_buffer;
+      return m_module.valid()
+        ? m_module.get().GetIcb()
+        : nullptr;
     }
     
     std::string GetName() const {
-      return m_shader->debugName();
+      return GetShader()->debugName();
     }
     
   private:
     
-    Rc<DxvkShader> m_shader;
-    Rc<DxvkBuffer> m_buffer;
+    std::shared_future<D3D11ShaderModule> m_module;
     
   };
   
@@ -125,6 +169,47 @@ namespace dxvk {
   using D3D11ComputeShader  = D3D11Shader<ID3D11ComputeShader,  ID3D10DeviceChild>;
   
   
+  /**
+   * \brief Shader compiler
+   * 
+   * Compiles shader modules on a pool of worker
+   * threads, so that shader creation does not
+   * block the calling thread. Used when the
+   * \c d3d11.asyncShaderCompile option is set.
+   * 
+   * Tasks that are still queued when the compiler
+   * is destroyed are run before the workers exit,
+   * so tasks must not reference the D3D11 device.
+   */
+  class D3D11ShaderCompiler {
+    using Task = std::packaged_task<D3D11ShaderModule ()>;
+  public:
+    
+    D3D11ShaderCompiler();
+    ~D3D11ShaderCompiler();
+    
+    /**
+     * \brief Queues a shader for compilation
+     * 
+     * \param [in] Fn Function that compiles the shader
+     * \returns Future for the compiled shader module
+     */
+    std::shared_future<D3D11ShaderModule> QueueCompilation(
+            std::function<D3D11ShaderModule ()>&& Fn);
+    
+  private:
+    
+    bool                      m_stopped = false;
+    std::mutex                m_mutex;
+    std::condition_variable   m_cond;
+    std::queue<Task>          m_tasks;
+    std::vector<dxvk::thread> m_threads;
+    
+    void RunWorker();
+    
+  };
+  
+  
   /**
    * \brief Shader module set
    * 
@@ -156,6 +241,15 @@ namespace dxvk {
       D3D11CommonShader,
       DxvkHash, DxvkEq> m_modules;
     
+    std::unique_ptr<D3D11ShaderCompiler> m_compiler;
+    
+    D3D11CommonShader QueueShaderModule(
+            D3D11Device*    pDevice,
+      const DxvkShaderKey&  ShaderKey,
+      const DxbcModuleInfo* pDxbcModuleInfo,
+      const void*           pShaderBytecode,
+            size_t          BytecodeLength);
+    
   };
   
 }
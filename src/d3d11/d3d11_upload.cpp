@@ -0,0 +1,244 @@
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define DXVK_UPLOAD_USE_SSE2
+#endif
+
+#include "d3d11_upload.h"
+
+namespace dxvk {
+
+  D3D11UploadWorkers::D3D11UploadWorkers(
+          uint32_t                  NumWorkers,
+          bool                      NonTemporal)
+  : m_nonTemporal(NonTemporal) {
+    if (NumWorkers != 0)
+      Logger::info(str::format("D3D11: Using ", NumWorkers, " upload threads"));
+
+    for (uint32_t i = 0; i < NumWorkers; i++)
+      m_threads.emplace_back([this] () { RunWorker(); });
+  }
+
+
+  D3D11UploadWorkers::~D3D11UploadWorkers() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+
+    m_condOnJob.notify_all();
+
+    for (auto& thread : m_threads)
+      thread.join();
+  }
+
+
+  void D3D11UploadWorkers::PackImageData(
+          void*                     pDstData,
+    const void*                     pSrcData,
+          VkExtent3D                BlockCount,
+          VkDeviceSize              BlockSize,
+          VkDeviceSize              SrcRowPitch,
+          VkDeviceSize              SrcDepthPitch) {
+    const VkDeviceSize bytesPerRow   = BlockCount.width  * BlockSize;
+    const VkDeviceSize bytesPerLayer = BlockCount.height * bytesPerRow;
+    const VkDeviceSize bytesTotal    = BlockCount.depth  * bytesPerLayer;
+
+    const bool directCopy = ((bytesPerRow   == SrcRowPitch  ) || (BlockCount.height == 1))
+                         && ((bytesPerLayer == SrcDepthPitch) || (BlockCount.depth  == 1));
+
+    Job job;
+    job.pDstData      = reinterpret_cast<char*>(pDstData);
+    job.pSrcData      = reinterpret_cast<const char*>(pSrcData);
+
+    if (directCopy) {
+      job.RowSize       = bytesTotal;
+      job.RowsPerLayer  = 1;
+      job.RowCount      = 1;
+      job.SrcRowPitch   = bytesTotal;
+      job.SrcDepthPitch = bytesTotal;
+    } else {
+      job.RowSize       = bytesPerRow;
+      job.RowsPerLayer  = BlockCount.height;
+      job.RowCount      = BlockCount.height * BlockCount.depth;
+      job.SrcRowPitch   = SrcRowPitch;
+      job.SrcDepthPitch = SrcDepthPitch;
+    }
+
+    ExecuteJob(job);
+  }
+
+
+  void D3D11UploadWorkers::CopyData(
+          void*                     pDstData,
+    const void*                     pSrcData,
+          VkDeviceSize              Size) {
+    Job job;
+    job.pDstData      = reinterpret_cast<char*>(pDstData);
+    job.pSrcData      = reinterpret_cast<const char*>(pSrcData);
+    job.RowSize       = Size;
+    job.RowsPerLayer  = 1;
+    job.RowCount      = 1;
+    job.SrcRowPitch   = Size;
+    job.SrcDepthPitch = Size;
+
+    ExecuteJob(job);
+  }
+
+
+  void D3D11UploadWorkers::ExecuteJob(
+    const Job&                      JobInfo) {
+    const VkDeviceSize bytesTotal = JobInfo.RowSize * JobInfo.RowCount;
+
+    uint32_t partCount = std::min<VkDeviceSize>(
+      m_threads.size() + 1, bytesTotal / MinBytesPerPart);
+
+    if (partCount <= 1) {
+      m_job = JobInfo;
+      CopyRows(0, bytesTotal);
+      return;
+    }
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_job        = JobInfo;
+      m_partCount  = partCount;
+      m_partsTaken = 0;
+      m_partsDone  = 0;
+    }
+
+    m_condOnJob.notify_all();
+
+    // Help out with the copy rather than
+    // just waiting for the workers
+    while (true) {
+      uint32_t part;
+
+      { std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_partsTaken == m_partCount)
+          break;
+
+        part = m_partsTaken++;
+      }
+
+      ExecutePart(part);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condOnDone.wait(lock, [this] {
+      return m_partsDone == m_partCount;
+    });
+  }
+
+
+  void D3D11UploadWorkers::ExecutePart(
+          uint32_t                  Part) {
+    // Split the destination range into parts, aligned
+    // to cache lines so that no two threads write to
+    // the same cache line
+    const VkDeviceSize bytesTotal = m_job.RowSize * m_job.RowCount;
+    const VkDeviceSize partSize   = align(bytesTotal / m_partCount, 64);
+
+    VkDeviceSize begin = std::min(bytesTotal, partSize * Part);
+    VkDeviceSize end   = std::min(bytesTotal, partSize * (Part + 1));
+
+    if (Part + 1 == m_partCount)
+      end = bytesTotal;
+
+    CopyRows(begin, end);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (++m_partsDone == m_partCount)
+      m_condOnDone.notify_one();
+  }
+
+
+  void D3D11UploadWorkers::CopyRows(
+          VkDeviceSize              Begin,
+          VkDeviceSize              End) const {
+    // Begin and end are byte offsets into the tightly
+    // packed destination data, which may not line up
+    // with row boundaries.
+    while (Begin < End) {
+      VkDeviceSize row    = Begin / m_job.RowSize;
+      VkDeviceSize offset = Begin % m_job.RowSize;
+      VkDeviceSize size   = std::min(m_job.RowSize - offset, End - Begin);
+
+      const char* srcData = m_job.pSrcData
+        + (row / m_job.RowsPerLayer) * m_job.SrcDepthPitch
+        + (row % m_job.RowsPerLayer) * m_job.SrcRowPitch
+        + offset;
+
+      CopyMemory(m_job.pDstData + Begin, srcData, size);
+      Begin += size;
+    }
+
+    #ifdef DXVK_UPLOAD_USE_SSE2
+    // Non-temporal stores are weakly ordered, make sure
+    // they are visible before the copy is considered done
+    if (m_nonTemporal)
+      _mm_sfence();
+    #endif
+  }
+
+
+  void D3D11UploadWorkers::CopyMemory(
+          char*                     pDstData,
+    const char*                     pSrcData,
+          VkDeviceSize              Size) const {
+    #ifdef DXVK_UPLOAD_USE_SSE2
+    if (m_nonTemporal && Size >= 256) {
+      VkDeviceSize head = (16 - (reinterpret_cast<uintptr_t>(pDstData) & 0xF)) & 0xF;
+      std::memcpy(pDstData, pSrcData, head);
+
+      pDstData += head;
+      pSrcData += head;
+      Size     -= head;
+
+      while (Size >= 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcData +  0));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcData + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcData + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcData + 48));
+
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDstData +  0), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDstData + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDstData + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDstData + 48), d);
+
+        pDstData += 64;
+        pSrcData += 64;
+        Size     -= 64;
+      }
+    }
+    #endif
+
+    std::memcpy(pDstData, pSrcData, Size);
+  }
+
+
+  void D3D11UploadWorkers::RunWorker() {
+    env::setThreadName(L"dxvk-upload");
+
+    while (true) {
+      uint32_t part;
+
+      { std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condOnJob.wait(lock, [this] {
+          return m_stopped || m_partsTaken < m_partCount;
+        });
+
+        if (m_stopped)
+          return;
+
+        part = m_partsTaken++;
+      }
+
+      ExecutePart(part);
+    }
+  }
+
+}
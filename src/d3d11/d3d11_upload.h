@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "d3d11_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Upload worker threads
+   *
+   * Copies application data into mapped staging memory.
+   * Large copies are split into parts that are processed
+   * by the worker threads and the calling thread at the
+   * same time. Can optionally use non-temporal stores,
+   * which avoid polluting the CPU cache with data that
+   * will only be read by the GPU.
+   *
+   * Only one thread may submit copies at a time.
+   */
+  class D3D11UploadWorkers {
+    /// Minimum number of bytes per part. Smaller
+    /// copies are done on the calling thread.
+    constexpr static size_t MinBytesPerPart = 256 * 1024;
+  public:
+
+    D3D11UploadWorkers(
+            uint32_t                  NumWorkers,
+            bool                      NonTemporal);
+
+    ~D3D11UploadWorkers();
+
+    /**
+     * \brief Packs image data into a buffer
+     *
+     * Equivalent to \ref util::packImageData, but
+     * may use multiple threads for large images.
+     * Returns once all data has been written.
+     * \param [in] pDstData Destination pointer
+     * \param [in] pSrcData Source pointer
+     * \param [in] BlockCount Number of blocks to copy
+     * \param [in] BlockSize Size of each block, in bytes
+     * \param [in] SrcRowPitch Source row pitch
+     * \param [in] SrcDepthPitch Source layer pitch
+     */
+    void PackImageData(
+            void*                     pDstData,
+      const void*                     pSrcData,
+            VkExtent3D                BlockCount,
+            VkDeviceSize              BlockSize,
+            VkDeviceSize              SrcRowPitch,
+            VkDeviceSize              SrcDepthPitch);
+
+    /**
+     * \brief Copies linear data
+     *
+     * \param [in] pDstData Destination pointer
+     * \param [in] pSrcData Source pointer
+     * \param [in] Size Number of bytes to copy
+     */
+    void CopyData(
+            void*                     pDstData,
+      const void*                     pSrcData,
+            VkDeviceSize              Size);
+
+  private:
+
+    struct Job {
+      char*         pDstData;
+      const char*   pSrcData;
+      VkDeviceSize  RowSize;
+      VkDeviceSize  RowsPerLayer;
+      VkDeviceSize  RowCount;
+      VkDeviceSize  SrcRowPitch;
+      VkDeviceSize  SrcDepthPitch;
+    };
+
+    bool                      m_nonTemporal;
+
+    bool                      m_stopped = false;
+    std::mutex                m_mutex;
+    std::condition_variable   m_condOnJob;
+    std::condition_variable   m_condOnDone;
+    std::vector<dxvk::thread> m_threads;
+
+    Job                       m_job;
+    uint32_t                  m_partCount = 0;
+    uint32_t                  m_partsTaken = 0;
+    uint32_t                  m_partsDone = 0;
+
+    void ExecuteJob(
+      const Job&                      JobInfo);
+
+    void ExecutePart(
+            uint32_t                  Part);
+
+    void CopyRows(
+            VkDeviceSize              Begin,
+            VkDeviceSize              End) const;
+
+    void CopyMemory(
+            char*                     pDstData,
+      const char*                     pSrcData,
+            VkDeviceSize              Size) const;
+
+    void RunWorker();
+
+  };
+
+}
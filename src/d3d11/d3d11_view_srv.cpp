@@ -60,6 +60,8 @@ namespace dxvk {
       // Create underlying buffer view object
       m_bufferView = pDevice->GetDXVKDevice()->createBufferView(
         buffer->GetBuffer(), viewInfo);
+      
+      m_dynamicBuffer = buffer->Desc()->Usage == D3D11_USAGE_DYNAMIC;
     } else {
       const DXGI_VK_FORMAT_INFO formatInfo = pDevice->LookupFormat(
         pDesc->Format, GetCommonTexture(pResource)->GetFormatMode());
@@ -45,6 +45,10 @@ namespace dxvk {
     Rc<DxvkImageView> GetImageView() const {
       return m_imageView;
     }
+    
+    bool IsDynamicBuffer() const {
+      return m_dynamicBuffer;
+    }
 
     D3D10ShaderResourceView* GetD3D10Iface() {
       return &m_d3d10;
@@ -65,6 +69,7 @@ namespace dxvk {
     D3D11_SHADER_RESOURCE_VIEW_DESC   m_desc;
     Rc<DxvkBufferView>                m_bufferView;
     Rc<DxvkImageView>                 m_imageView;
+    bool                              m_dynamicBuffer = false;
     D3D10ShaderResourceView           m_d3d10;
 
   };
@@ -200,13 +200,19 @@ namespace dxvk {
       m_entryPointInterfaces.data());
     m_module.setDebugName(m_entryPointId, "main");
     
+    // Run optional optimization passes on the final code
+    SpirvCodeBuffer code = m_module.compile();
+    
+    if (m_moduleInfo.options.test(DxbcOption::OptimizeSpirv))
+      code = SpirvOptimizer().optimize(std::move(code));
+    
     // Create the shader module object
     return new DxvkShader(
       m_version.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
+      code,
       std::move(m_immConstData));
   }
   
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "../spirv/spirv_module.h"
+#include "../spirv/spirv_optimizer.h"
 
 #include "dxbc_analysis.h"
 #include "dxbc_chunk_isgn.h"
@@ -0,0 +1,83 @@
+#include "dxbc_instructions.h"
+
+namespace dxvk {
+
+  DxbcInstructionList::DxbcInstructionList(const Rc<DxbcShex>& shex)
+  : m_shex(shex) {
+    DxbcCodeSlice     slice = shex->slice();
+    DxbcDecodeContext decoder;
+
+    while (!slice.atEnd()) {
+      decoder.decodeInstruction(slice);
+
+      m_instructions.push_back(
+        this->copyInstruction(decoder.getInstruction()));
+    }
+  }
+
+
+  DxbcInstructionList::~DxbcInstructionList() {
+
+  }
+
+
+  void* DxbcInstructionList::allocate(
+          size_t                  size,
+          size_t                  align) {
+    // Allocations that do not fit into a regular block get
+    // their own block, which is inserted in front so that
+    // the current block can still be used afterwards.
+    if (size > ArenaBlockSize) {
+      m_arenaBlocks.emplace(m_arenaBlocks.begin(), new char[size]);
+      return m_arenaBlocks.front().get();
+    }
+
+    size_t offset = dxvk::align(m_arenaOffset, align);
+
+    if (offset + size > ArenaBlockSize) {
+      m_arenaBlocks.emplace_back(new char[ArenaBlockSize]);
+      offset = 0;
+    }
+
+    m_arenaOffset = offset + size;
+    return m_arenaBlocks.back().get() + offset;
+  }
+
+
+  DxbcShaderInstruction DxbcInstructionList::copyInstruction(
+    const DxbcShaderInstruction&  ins) {
+    DxbcShaderInstruction result = ins;
+    result.dst = this->copyRegisters(ins.dstCount, ins.dst);
+    result.src = this->copyRegisters(ins.srcCount, ins.src);
+
+    DxbcImmediate* imm = this->allocate<DxbcImmediate>(ins.immCount);
+
+    for (uint32_t i = 0; i < ins.immCount; i++)
+      imm[i] = ins.imm[i];
+
+    result.imm = imm;
+    return result;
+  }
+
+
+  const DxbcRegister* DxbcInstructionList::copyRegisters(
+          uint32_t                count,
+    const DxbcRegister*           regs) {
+    DxbcRegister* result = this->allocate<DxbcRegister>(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+      result[i] = regs[i];
+
+      // Relative indices point into the decoder's
+      // scratch memory, so they need to be copied
+      for (uint32_t j = 0; j < regs[i].idxDim; j++) {
+        if (regs[i].idx[j].relReg != nullptr)
+          result[i].idx[j].relReg = const_cast<DxbcRegister*>(
+            this->copyRegisters(1, regs[i].idx[j].relReg));
+      }
+    }
+
+    return result;
+  }
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "dxbc_chunk_shex.h"
+#include "dxbc_decoder.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Decoded instruction stream
+   *
+   * Decodes the entire instruction stream of a shader
+   * once, so that the analyzer and the compiler, as
+   * well as any later compilation of the same shader
+   * with different options, can iterate over it without
+   * running the decoder again.
+   *
+   * Operands are stored in an arena owned by the list.
+   * Custom data blocks point into the code chunk, which
+   * is kept alive by the list.
+   */
+  class DxbcInstructionList : public RcObject {
+    /// Default size of an arena block, in bytes
+    constexpr static size_t ArenaBlockSize = 16384;
+  public:
+
+    DxbcInstructionList(const Rc<DxbcShex>& shex);
+    ~DxbcInstructionList();
+
+    DxbcInstructionList             (const DxbcInstructionList&) = delete;
+    DxbcInstructionList& operator = (const DxbcInstructionList&) = delete;
+
+    /**
+     * \brief Number of instructions
+     * \returns Instruction count
+     */
+    size_t size() const {
+      return m_instructions.size();
+    }
+
+    /**
+     * \brief Retrieves an instruction
+     *
+     * \param [in] id Instruction index
+     * \returns The decoded instruction
+     */
+    const DxbcShaderInstruction& operator [] (size_t id) const {
+      return m_instructions[id];
+    }
+
+    auto begin() const { return m_instructions.begin(); }
+    auto end  () const { return m_instructions.end(); }
+
+  private:
+
+    Rc<DxbcShex> m_shex;
+
+    std::vector<DxbcShaderInstruction>    m_instructions;
+
+    std::vector<std::unique_ptr<char[]>>  m_arenaBlocks;
+    size_t                                m_arenaOffset = ArenaBlockSize;
+
+    void* allocate(
+            size_t                  size,
+            size_t                  align);
+
+    template<typename T>
+    T* allocate(size_t count) {
+      return count != 0
+        ? static_cast<T*>(this->allocate(sizeof(T) * count, alignof(T)))
+        : nullptr;
+    }
+
+    DxbcShaderInstruction copyInstruction(
+      const DxbcShaderInstruction&  ins);
+
+    const DxbcRegister* copyRegisters(
+            uint32_t                count,
+      const DxbcRegister*           regs);
+
+  };
+
+}
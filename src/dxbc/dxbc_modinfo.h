@@ -26,4 +26,42 @@ namespace dxvk {
     DxbcTessInfo* tess;
   };
 
+
+
+  /**
+   * \brief DXBC compiler version
+   * 
+   * Must be incremented whenever the compiler changes
+   * in a way that affects the generated SPIR-V code,
+   * in order to invalidate cached shaders.
+   */
+  constexpr uint32_t DxbcCompilerVersion = 1;
+
+
+  /**
+   * \brief Computes module info hash
+   * 
+   * Hashes the compiler version and all module info
+   * that may affect the generated code. Can be used
+   * together with the shader key to look up cached
+   * shaders.
+   * \param [in] moduleInfo Module info
+   * \returns Hash of the module info
+   */
+  inline Sha1Hash hashDxbcModuleInfo(const DxbcModuleInfo& moduleInfo) {
+    struct {
+      uint32_t version;
+      uint32_t options;
+      float    maxTessFactor;
+    } data;
+    
+    data.version       = DxbcCompilerVersion;
+    data.options       = moduleInfo.options.raw();
+    data.maxTessFactor = moduleInfo.tess != nullptr
+      ? moduleInfo.tess->maxTessFactor
+      : 0.0f;
+    
+    return Sha1Hash::compute(data);
+  }
+
 }
\ No newline at end of file
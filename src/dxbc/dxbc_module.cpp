@@ -43,6 +43,8 @@ namespace dxvk {
     if (m_shexChunk == nullptr)
       throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
     
+    Rc<DxbcInstructionList> instructions = this->getInstructions();
+    
     DxbcAnalysisInfo analysisInfo;
     
     DxbcAnalyzer analyzer(moduleInfo,
@@ -50,7 +52,7 @@ namespace dxvk {
       m_isgnChunk, m_osgnChunk,
       analysisInfo);
     
-    this->runAnalyzer(analyzer, m_shexChunk->slice());
+    this->runAnalyzer(analyzer, *instructions);
     
     DxbcCompiler compiler(
       fileName, moduleInfo,
@@ -58,37 +60,37 @@ namespace dxvk {
       m_isgnChunk, m_osgnChunk,
       analysisInfo);
     
-    this->runCompiler(compiler, m_shexChunk->slice());
+    this->runCompiler(compiler, *instructions);
     
     return compiler.finalize();
   }
   
   
-  void DxbcModule::runAnalyzer(
-          DxbcAnalyzer&       analyzer,
-          DxbcCodeSlice       slice) const {
-    DxbcDecodeContext decoder;
+  Rc<DxbcInstructionList> DxbcModule::getInstructions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
     
-    while (!slice.atEnd()) {
-      decoder.decodeInstruction(slice);
-      
-      analyzer.processInstruction(
-        decoder.getInstruction());
-    }
+    // Modules that are only used to query signatures
+    // never get here, so decode the code lazily
+    if (m_instructions == nullptr)
+      m_instructions = new DxbcInstructionList(m_shexChunk);
+    
+    return m_instructions;
+  }
+  
+  
+  void DxbcModule::runAnalyzer(
+          DxbcAnalyzer&         analyzer,
+    const DxbcInstructionList&  instructions) const {
+    for (const auto& ins : instructions)
+      analyzer.processInstruction(ins);
   }
   
   
   void DxbcModule::runCompiler(
-          DxbcCompiler&       compiler,
-          DxbcCodeSlice       slice) const {
-    DxbcDecodeContext decoder;
-    
-    while (!slice.atEnd()) {
-      decoder.decodeInstruction(slice);
-      
-      compiler.processInstruction(
-        decoder.getInstruction());
-    }
+          DxbcCompiler&         compiler,
+    const DxbcInstructionList&  instructions) const {
+    for (const auto& ins : instructions)
+      compiler.processInstruction(ins);
   }
   
 }
\ No newline at end of file
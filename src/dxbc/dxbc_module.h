@@ -1,10 +1,13 @@
 #pragma once
 
+#include <mutex>
+
 #include "../dxvk/dxvk_shader.h"
 
 #include "dxbc_chunk_isgn.h"
 #include "dxbc_chunk_shex.h"
 #include "dxbc_header.h"
+#include "dxbc_instructions.h"
 #include "dxbc_modinfo.h"
 #include "dxbc_reader.h"
 
@@ -51,6 +54,10 @@ namespace dxvk {
     /**
      * \brief Compiles DXBC shader to SPIR-V module
      * 
+     * The instruction stream is decoded on the first call
+     * and reused for subsequent calls, so that the shader
+     * can be compiled with different options cheaply.
+     * May be called from multiple threads concurrently.
      * \param [in] moduleInfo DXBC module info
      * \param [in] fileName File name, will be added to
      *        the compiled SPIR-V for debugging purposes.
@@ -68,13 +75,18 @@ namespace dxvk {
     Rc<DxbcIsgn> m_osgnChunk;
     Rc<DxbcShex> m_shexChunk;
     
+    mutable std::mutex              m_mutex;
+    mutable Rc<DxbcInstructionList> m_instructions;
+    
+    Rc<DxbcInstructionList> getInstructions() const;
+    
     void runAnalyzer(
-            DxbcAnalyzer&       analyzer,
-            DxbcCodeSlice       slice) const;
+            DxbcAnalyzer&         analyzer,
+      const DxbcInstructionList&  instructions) const;
     
     void runCompiler(
-            DxbcCompiler&       compiler,
-            DxbcCodeSlice       slice) const;
+            DxbcCompiler&         compiler,
+      const DxbcInstructionList&  instructions) const;
     
   };
   
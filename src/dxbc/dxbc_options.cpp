@@ -27,6 +27,10 @@ namespace dxvk {
       flags.set(DxbcOption::UseStorageImageReadWithoutFormat);
     
     flags.set(DxbcOption::DeferKill);
+    
+    if (device->config().optimizeSpirv)
+      flags.set(DxbcOption::OptimizeSpirv);
+    
     return flags;
   }
   
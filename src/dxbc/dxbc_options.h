@@ -13,6 +13,10 @@ namespace dxvk {
     /// Fixes derivatives that are undefined due to
     /// non-uniform control flow in fragment shaders.
     DeferKill,
+    
+    /// Run optimization passes on the generated
+    /// SPIR-V code before creating the shader.
+    OptimizeSpirv,
   };
   
   using DxbcOptions = Flags<DxbcOption>;
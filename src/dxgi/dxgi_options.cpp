@@ -43,6 +43,9 @@ namespace dxvk {
     this->syncInterval   = config.getOption<int32_t>("dxgi.syncInterval", -1);
     this->syncMode       = DxgiSyncMode(config.getOption<int32_t>("dxgi.syncMode", 0));
 
+    this->maxFrameRate = std::max(config.getOption<int32_t>("dxgi.maxFrameRate", 0), 0);
+    this->lowLatency   = config.getOption<bool>("dxgi.lowLatency", false);
+
     this->d3d10Enable = config.getOption<bool>("d3d10.enable", true);
   }
   
@@ -57,6 +57,15 @@ namespace dxvk {
     /// Vsync mode
     DxgiSyncMode syncMode;
 
+    /// Frame rate limit. The presenter will not present
+    /// more frames per second than this. 0 disables it.
+    int32_t maxFrameRate;
+
+    /// Low-latency frame pacing. Delays the application
+    /// so that frames do not queue up on the GPU, which
+    /// reduces input latency at the cost of throughput.
+    bool lowLatency;
+
     /// Enables D3D10 support
     bool d3d10Enable;
   };
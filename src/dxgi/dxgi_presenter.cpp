@@ -94,7 +94,15 @@ namespace dxvk {
     m_vertShader = CreateVertexShader();
     m_fragShader = CreateFragmentShader();
     
-    m_hud = hud::Hud::createHud(m_device);
+    DxvkFramePacerOptions pacerOptions;
+    pacerOptions.maxFrameRate = pOptions->maxFrameRate;
+    pacerOptions.lowLatency   = pOptions->lowLatency;
+    
+    m_pacer = new DxvkFramePacer(pacerOptions);
+    m_hud   = hud::Hud::createHud(m_device);
+    
+    if (m_hud != nullptr)
+      m_hud->setFramePacer(m_pacer);
   }
   
   
@@ -123,12 +131,15 @@ namespace dxvk {
   
   
   void DxgiVkPresenter::PresentImage(UINT SyncInterval, const Rc<DxvkEvent>& SyncEvent) {
+    auto presentStart = DxvkTimingTracker::Clock::now();
+    
     if (m_hud != nullptr)
       m_hud->update();
     
     // Wait for frame event to be signaled. This is used
     // to enforce the device's frame latency requirement.
-    SyncEvent->wait();
+    // The frame pacer also applies the frame rate limit.
+    m_pacer->beginPresent(SyncEvent);
     
     // Check whether the back buffer size is the same
     // as the window size, in which case we should use
@@ -203,7 +214,7 @@ namespace dxvk {
       if (m_hud != nullptr)
         m_hud->render(m_context, m_options.preferredBufferSize);
       
-      if (i == SyncInterval - 1) {
+      if (i + 1 >= SyncInterval) {
         DxvkEventRevision eventRev;
         eventRev.event    = SyncEvent;
         eventRev.revision = SyncEvent->reset();
@@ -218,6 +229,12 @@ namespace dxvk {
       m_swapchain->present(
         swapSemas.presentSync);
     }
+    
+    m_pacer->endPresent(SyncEvent);
+    
+    DxvkTimingTracker* timings = m_device->timings();
+    timings->addTime(DxvkTimingStage::Present, DxvkTimingTracker::Clock::now() - presentStart);
+    timings->endFrame();
   }
   
   
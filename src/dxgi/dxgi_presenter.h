@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../dxvk/dxvk_device.h"
+#include "../dxvk/dxvk_frame_pacer.h"
 #include "../dxvk/dxvk_surface.h"
 #include "../dxvk/dxvk_swapchain.h"
 
@@ -154,6 +155,7 @@ namespace dxvk {
     Rc<DxvkImage>           m_gammaTexture;
     Rc<DxvkImageView>       m_gammaTextureView;
     
+    Rc<DxvkFramePacer>      m_pacer;
     Rc<hud::Hud>            m_hud;
 
     DxvkInputAssemblyState  m_iaState;
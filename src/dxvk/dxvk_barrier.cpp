@@ -2,6 +2,101 @@
 
 namespace dxvk {
   
+  DxvkHazardTracker:: DxvkHazardTracker() { }
+  DxvkHazardTracker::~DxvkHazardTracker() { }
+  
+  
+  void DxvkHazardTracker::insert(
+    const void*                     resource,
+          VkDeviceSize              begin,
+          VkDeviceSize              end,
+          DxvkAccessFlags           access) {
+    auto result = m_resources.insert({ resource, m_entryCount });
+    
+    if (result.second) {
+      if (m_entryCount == m_entries.size())
+        m_entries.emplace_back();
+      
+      m_entryCount += 1;
+    }
+    
+    Entry& entry = m_entries[result.first->second];
+    insertRange(entry.accessed, begin, end);
+    
+    if (access.test(DxvkAccess::Write))
+      insertRange(entry.written, begin, end);
+  }
+  
+  
+  bool DxvkHazardTracker::hasHazard(
+    const void*                     resource,
+          VkDeviceSize              begin,
+          VkDeviceSize              end,
+          DxvkAccessFlags           access) const {
+    auto result = m_resources.find(resource);
+    
+    if (result == m_resources.end())
+      return false;
+    
+    // Writes conflict with any previous access,
+    // reads only conflict with previous writes
+    const Entry& entry = m_entries[result->second];
+    
+    return access.test(DxvkAccess::Write)
+      ? overlapsRange(entry.accessed, begin, end)
+      : overlapsRange(entry.written,  begin, end);
+  }
+  
+  
+  void DxvkHazardTracker::reset() {
+    for (uint32_t i = 0; i < m_entryCount; i++) {
+      m_entries[i].accessed.clear();
+      m_entries[i].written.clear();
+    }
+    
+    m_resources.clear();
+    m_entryCount = 0;
+  }
+  
+  
+  void DxvkHazardTracker::insertRange(
+          std::vector<Range>&       ranges,
+          VkDeviceSize              begin,
+          VkDeviceSize              end) {
+    // Find the first range that ends at or after the new
+    // one begins, and merge all ranges that touch the new
+    // range into a single one, so that ranges stay disjoint
+    auto first = std::lower_bound(ranges.begin(), ranges.end(), begin,
+      [] (const Range& range, VkDeviceSize value) { return range.end < value; });
+    
+    auto last = first;
+    
+    while (last != ranges.end() && last->begin <= end) {
+      begin = std::min(begin, last->begin);
+      end   = std::max(end,   last->end);
+      last++;
+    }
+    
+    if (first == last) {
+      ranges.insert(first, { begin, end });
+    } else {
+      *first = { begin, end };
+      ranges.erase(first + 1, last);
+    }
+  }
+  
+  
+  bool DxvkHazardTracker::overlapsRange(
+    const std::vector<Range>&       ranges,
+          VkDeviceSize              begin,
+          VkDeviceSize              end) {
+    auto range = std::upper_bound(ranges.begin(), ranges.end(), begin,
+      [] (VkDeviceSize value, const Range& range) { return value < range.end; });
+    
+    return range != ranges.end() && range->begin < end;
+  }
+  
+  
   DxvkBarrierSet:: DxvkBarrierSet() { }
   DxvkBarrierSet::~DxvkBarrierSet() { }
   
@@ -30,7 +125,8 @@ namespace dxvk {
       m_bufBarriers.push_back(barrier);
     }
 
-    m_bufSlices.push_back({ bufSlice, access });
+    m_hazards.insert(bufSlice.physicalBuffer().ptr(),
+      bufSlice.offset(), bufSlice.offset() + bufSlice.length(), access);
   }
   
   
@@ -67,21 +163,18 @@ namespace dxvk {
       m_imgBarriers.push_back(barrier);
     }
 
-    m_imgSlices.push_back({ image.ptr(), subresources, access });
+    this->forEachImageRange(image.ptr(), subresources,
+      [this, &image, access] (VkDeviceSize begin, VkDeviceSize end) {
+        m_hazards.insert(image.ptr(), begin, end, access);
+      });
   }
   
   
   bool DxvkBarrierSet::isBufferDirty(
     const DxvkPhysicalBufferSlice&  bufSlice,
           DxvkAccessFlags           bufAccess) {
-    bool result = false;
-
-    for (uint32_t i = 0; i < m_bufSlices.size() && !result; i++) {
-      result = (bufSlice.overlaps(m_bufSlices[i].slice))
-            && (bufAccess | m_bufSlices[i].access).test(DxvkAccess::Write);
-    }
-
-    return result;
+    return m_hazards.hasHazard(bufSlice.physicalBuffer().ptr(),
+      bufSlice.offset(), bufSlice.offset() + bufSlice.length(), bufAccess);
   }
 
 
@@ -91,15 +184,10 @@ namespace dxvk {
           DxvkAccessFlags           imgAccess) {
     bool result = false;
 
-    for (uint32_t i = 0; i < m_imgSlices.size() && !result; i++) {
-      const VkImageSubresourceRange& dstSubres = m_imgSlices[i].subres;
-
-      result = (image == m_imgSlices[i].image) && (imgAccess | m_imgSlices[i].access).test(DxvkAccess::Write)
-            && imgSubres.baseArrayLayer < dstSubres.baseArrayLayer + dstSubres.layerCount
-            && imgSubres.baseArrayLayer + imgSubres.layerCount     > dstSubres.baseArrayLayer
-            && imgSubres.baseMipLevel   < dstSubres.baseMipLevel   + dstSubres.levelCount
-            && imgSubres.baseMipLevel   + imgSubres.levelCount     > dstSubres.baseMipLevel;
-    }
+    this->forEachImageRange(image.ptr(), imgSubres,
+      [this, &image, &result, imgAccess] (VkDeviceSize begin, VkDeviceSize end) {
+        result |= m_hazards.hasHazard(image.ptr(), begin, end, imgAccess);
+      });
 
     return result;
   }
@@ -113,6 +201,12 @@ namespace dxvk {
       if (srcFlags == 0) srcFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
       if (dstFlags == 0) dstFlags = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
       
+      this->mergeBufferBarriers();
+      this->mergeImageBarriers();
+      
+      commandList->addStatCtr(DxvkStatCounter::CmdBarrierCount,
+        m_memBarriers.size() + m_bufBarriers.size() + m_imgBarriers.size());
+      
       commandList->cmdPipelineBarrier(
         srcFlags, dstFlags, 0,
         m_memBarriers.size(), m_memBarriers.data(),
@@ -132,8 +226,7 @@ namespace dxvk {
     m_bufBarriers.resize(0);
     m_imgBarriers.resize(0);
 
-    m_bufSlices.resize(0);
-    m_imgSlices.resize(0);
+    m_hazards.reset();
   }
   
   
@@ -165,4 +258,142 @@ namespace dxvk {
     return result;
   }
   
+  
+  template<typename Fn>
+  void DxvkBarrierSet::forEachImageRange(
+    const DxvkImage*                image,
+    const VkImageSubresourceRange&  subres,
+    const Fn&                       fn) const {
+    // Subresources are numbered mip by mip, so that a
+    // subresource range maps to one index range per mip
+    // level, or a single index range if it covers all
+    // array layers of the image.
+    const VkDeviceSize numLayers = image->info().numLayers;
+    
+    const uint32_t levelCount = subres.levelCount == VK_REMAINING_MIP_LEVELS
+      ? image->info().mipLevels - subres.baseMipLevel
+      : subres.levelCount;
+    
+    const uint32_t layerCount = subres.layerCount == VK_REMAINING_ARRAY_LAYERS
+      ? image->info().numLayers - subres.baseArrayLayer
+      : subres.layerCount;
+    
+    if (subres.baseArrayLayer == 0 && layerCount == numLayers) {
+      fn(numLayers * subres.baseMipLevel,
+         numLayers * (subres.baseMipLevel + levelCount));
+    } else {
+      for (uint32_t i = 0; i < levelCount; i++) {
+        const VkDeviceSize base = numLayers * (subres.baseMipLevel + i) + subres.baseArrayLayer;
+        fn(base, base + layerCount);
+      }
+    }
+  }
+  
+  
+  void DxvkBarrierSet::mergeBufferBarriers() {
+    if (m_bufBarriers.size() < 2)
+      return;
+    
+    // Group barriers by buffer, but keep the order of
+    // barriers on the same buffer intact, and merge
+    // consecutive barriers with touching ranges
+    std::stable_sort(m_bufBarriers.begin(), m_bufBarriers.end(),
+      [] (const VkBufferMemoryBarrier& a, const VkBufferMemoryBarrier& b) {
+        return a.buffer < b.buffer;
+      });
+    
+    size_t count = 0;
+    
+    for (size_t i = 1; i < m_bufBarriers.size(); i++) {
+      VkBufferMemoryBarrier&       dst = m_bufBarriers[count];
+      const VkBufferMemoryBarrier& src = m_bufBarriers[i];
+      
+      const bool canMerge = dst.buffer        == src.buffer
+                         && dst.srcAccessMask == src.srcAccessMask
+                         && dst.dstAccessMask == src.dstAccessMask
+                         && dst.offset              <= src.offset + src.size
+                         && dst.offset + dst.size   >= src.offset;
+      
+      if (canMerge) {
+        VkDeviceSize end = std::max(dst.offset + dst.size, src.offset + src.size);
+        dst.offset = std::min(dst.offset, src.offset);
+        dst.size   = end - dst.offset;
+      } else {
+        m_bufBarriers[++count] = src;
+      }
+    }
+    
+    m_bufBarriers.resize(count + 1);
+  }
+  
+  
+  void DxvkBarrierSet::mergeImageBarriers() {
+    if (m_imgBarriers.size() < 2)
+      return;
+    
+    // Same as for buffers. Two barriers can be merged if
+    // one covers the same mip levels as the other and the
+    // layer ranges touch, or vice versa. Barriers that are
+    // fully covered by the previous one are dropped.
+    std::stable_sort(m_imgBarriers.begin(), m_imgBarriers.end(),
+      [] (const VkImageMemoryBarrier& a, const VkImageMemoryBarrier& b) {
+        return a.image < b.image;
+      });
+    
+    size_t count = 0;
+    
+    for (size_t i = 1; i < m_imgBarriers.size(); i++) {
+      VkImageMemoryBarrier&       dst = m_imgBarriers[count];
+      const VkImageMemoryBarrier& src = m_imgBarriers[i];
+      
+      VkImageSubresourceRange&       dstSubres = dst.subresourceRange;
+      const VkImageSubresourceRange& srcSubres = src.subresourceRange;
+      
+      bool canMerge = dst.image         == src.image
+                   && dst.srcAccessMask == src.srcAccessMask
+                   && dst.dstAccessMask == src.dstAccessMask
+                   && dst.oldLayout     == src.oldLayout
+                   && dst.newLayout     == src.newLayout
+                   && dstSubres.aspectMask == srcSubres.aspectMask;
+      
+      if (canMerge) {
+        const bool sameMips = dstSubres.baseMipLevel == srcSubres.baseMipLevel
+                           && dstSubres.levelCount   == srcSubres.levelCount;
+        
+        const bool sameLayers = dstSubres.baseArrayLayer == srcSubres.baseArrayLayer
+                             && dstSubres.layerCount     == srcSubres.layerCount;
+        
+        const bool touchingMips = dstSubres.baseMipLevel <= srcSubres.baseMipLevel + srcSubres.levelCount
+                               && dstSubres.baseMipLevel + dstSubres.levelCount >= srcSubres.baseMipLevel;
+        
+        const bool touchingLayers = dstSubres.baseArrayLayer <= srcSubres.baseArrayLayer + srcSubres.layerCount
+                                 && dstSubres.baseArrayLayer + dstSubres.layerCount >= srcSubres.baseArrayLayer;
+        
+        if (sameMips && touchingLayers) {
+          uint32_t end = std::max(
+            dstSubres.baseArrayLayer + dstSubres.layerCount,
+            srcSubres.baseArrayLayer + srcSubres.layerCount);
+          dstSubres.baseArrayLayer = std::min(dstSubres.baseArrayLayer, srcSubres.baseArrayLayer);
+          dstSubres.layerCount     = end - dstSubres.baseArrayLayer;
+        } else if (sameLayers && touchingMips) {
+          uint32_t end = std::max(
+            dstSubres.baseMipLevel + dstSubres.levelCount,
+            srcSubres.baseMipLevel + srcSubres.levelCount);
+          dstSubres.baseMipLevel = std::min(dstSubres.baseMipLevel, srcSubres.baseMipLevel);
+          dstSubres.levelCount   = end - dstSubres.baseMipLevel;
+        } else {
+          canMerge = dstSubres.baseMipLevel   <= srcSubres.baseMipLevel
+                  && dstSubres.baseArrayLayer <= srcSubres.baseArrayLayer
+                  && dstSubres.baseMipLevel   + dstSubres.levelCount >= srcSubres.baseMipLevel   + srcSubres.levelCount
+                  && dstSubres.baseArrayLayer + dstSubres.layerCount >= srcSubres.baseArrayLayer + srcSubres.layerCount;
+        }
+      }
+      
+      if (!canMerge)
+        m_imgBarriers[++count] = src;
+    }
+    
+    m_imgBarriers.resize(count + 1);
+  }
+  
 }
\ No newline at end of file
@@ -1,17 +1,107 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "dxvk_buffer.h"
 #include "dxvk_cmdlist.h"
 #include "dxvk_image.h"
 
 namespace dxvk {
   
+  /**
+   * \brief Hazard tracker
+   * 
+   * Stores the ranges of each resource that are accessed
+   * by pending barriers, so that overlap queries can be
+   * answered without looking at every single barrier.
+   * For each resource, accessed and written ranges are
+   * kept in sorted lists of disjoint intervals, which
+   * can be searched in logarithmic time.
+   */
+  class DxvkHazardTracker {
+    
+  public:
+    
+    DxvkHazardTracker();
+    ~DxvkHazardTracker();
+    
+    /**
+     * \brief Records an access
+     * 
+     * \param [in] resource The resource
+     * \param [in] begin First index of the range
+     * \param [in] end End of the range, exclusive
+     * \param [in] access Access types
+     */
+    void insert(
+      const void*                     resource,
+            VkDeviceSize              begin,
+            VkDeviceSize              end,
+            DxvkAccessFlags           access);
+    
+    /**
+     * \brief Checks for a hazard
+     * 
+     * A hazard exists if the range overlaps with a
+     * recorded range and either of the two accesses
+     * is a write.
+     * \param [in] resource The resource
+     * \param [in] begin First index of the range
+     * \param [in] end End of the range, exclusive
+     * \param [in] access Access types
+     * \returns \c true if there is a hazard
+     */
+    bool hasHazard(
+      const void*                     resource,
+            VkDeviceSize              begin,
+            VkDeviceSize              end,
+            DxvkAccessFlags           access) const;
+    
+    /**
+     * \brief Resets the tracker
+     * 
+     * Removes all ranges, but keeps
+     * allocated memory for reuse.
+     */
+    void reset();
+    
+  private:
+    
+    struct Range {
+      VkDeviceSize begin;
+      VkDeviceSize end;
+    };
+    
+    struct Entry {
+      std::vector<Range> accessed;
+      std::vector<Range> written;
+    };
+    
+    std::unordered_map<const void*, uint32_t> m_resources;
+    
+    std::vector<Entry>  m_entries;
+    uint32_t            m_entryCount = 0;
+    
+    static void insertRange(
+            std::vector<Range>&       ranges,
+            VkDeviceSize              begin,
+            VkDeviceSize              end);
+    
+    static bool overlapsRange(
+      const std::vector<Range>&       ranges,
+            VkDeviceSize              begin,
+            VkDeviceSize              end);
+    
+  };
+  
+  
   /**
    * \brief Barrier set
    * 
    * Accumulates memory barriers and provides a
    * method to record all those barriers into a
-   * command buffer at once.
+   * command buffer at once. Adjacent barriers on
+   * the same resource are merged before recording.
    */
   class DxvkBarrierSet {
     
@@ -52,17 +142,6 @@ namespace dxvk {
     void reset();
     
   private:
-
-    struct BufSlice {
-      DxvkPhysicalBufferSlice slice;
-      DxvkAccessFlags         access;
-    };
-
-    struct ImgSlice {
-      DxvkImage*              image;
-      VkImageSubresourceRange subres;
-      DxvkAccessFlags         access;
-    };
     
     VkPipelineStageFlags m_srcStages = 0;
     VkPipelineStageFlags m_dstStages = 0;
@@ -71,11 +150,19 @@ namespace dxvk {
     std::vector<VkBufferMemoryBarrier>  m_bufBarriers;
     std::vector<VkImageMemoryBarrier>   m_imgBarriers;
 
-    std::vector<BufSlice> m_bufSlices;
-    std::vector<ImgSlice> m_imgSlices;
+    DxvkHazardTracker m_hazards;
     
     DxvkAccessFlags getAccessTypes(VkAccessFlags flags) const;
     
+    template<typename Fn>
+    void forEachImageRange(
+      const DxvkImage*                image,
+      const VkImageSubresourceRange&  subres,
+      const Fn&                       fn) const;
+    
+    void mergeBufferBarriers();
+    void mergeImageBarriers();
+    
   };
   
 }
\ No newline at end of file
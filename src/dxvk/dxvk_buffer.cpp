@@ -22,7 +22,7 @@ namespace dxvk {
 
 
   DxvkBuffer::~DxvkBuffer() {
-    
+    m_device->defragmenter()->unregisterBuffer(this);
   }
   
   
@@ -57,13 +57,28 @@ namespace dxvk {
   }
   
   
+  DxvkPhysicalBufferSlice DxvkBuffer::allocRelocationSlice() {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+    std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+    
+    // Slices that are still in use will be discarded
+    // by freePhysicalSlice once the GPU is done with them
+    m_physBuffer = nullptr;
+    m_freeSlices.clear();
+    m_nextSlices.clear();
+    
+    return this->allocPhysicalBuffer(1)
+      ->slice(0, m_physSliceStride);
+  }
+  
+  
   void DxvkBuffer::freePhysicalSlice(const DxvkPhysicalBufferSlice& slice) {
     // Add slice to a separate free list to reduce lock contention.
     std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
 
     // Discard slices allocated from other physical buffers.
     // This may make descriptor set binding more efficient.
-    if (m_physBuffer->handle() == slice.handle())
+    if (m_physBuffer != nullptr && m_physBuffer->handle() == slice.handle())
       m_nextSlices.push_back(slice);
   }
   
@@ -93,6 +108,8 @@ namespace dxvk {
   
   
   void DxvkBufferView::updateView() {
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+    
     if (m_revision != m_buffer->m_revision) {
       m_physView = this->createView();
       m_revision = m_buffer->m_revision;
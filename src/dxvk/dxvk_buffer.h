@@ -16,6 +16,7 @@ namespace dxvk {
    */
   class DxvkBuffer : public RcObject {
     friend class DxvkBufferView;
+    friend class DxvkMemoryDefragmenter;
   public:
     
     DxvkBuffer(
@@ -69,6 +70,17 @@ namespace dxvk {
     bool isInUse() const {
       return m_physSlice.resource()->isInUse();
     }
+    
+    /**
+     * \brief Checks whether the buffer should be moved
+     * 
+     * If this returns \c true, the buffer's memory should be
+     * moved to a new allocation in order to free up memory.
+     * \returns \c true if the buffer memory is evacuating
+     */
+    bool isEvacuating() const {
+      return m_physSlice.physicalBuffer()->isEvacuating();
+    }
 
     /**
      * \brief Retrieves descriptor info
@@ -152,6 +164,20 @@ namespace dxvk {
      */
     DxvkPhysicalBufferSlice allocPhysicalSlice();
     
+    /**
+     * \brief Allocates new physical resource for relocation
+     * 
+     * Unlike \ref allocPhysicalSlice, this allocates a
+     * single slice that is not managed by the buffer's
+     * free lists. Used to move the buffer to new memory.
+     * 
+     * Drops the buffer's current physical buffer and any
+     * free slices, so that no references to the memory
+     * the buffer is being moved out of are retained.
+     * \returns The new backing buffer slice
+     */
+    DxvkPhysicalBufferSlice allocRelocationSlice();
+    
     /**
      * \brief Frees a physical buffer slice
      * 
@@ -184,6 +210,8 @@ namespace dxvk {
 
     Rc<DxvkPhysicalBuffer>  m_physBuffer;
     
+    uint32_t                m_defragIndex = ~0u;
+    
     Rc<DxvkPhysicalBuffer> allocPhysicalBuffer(
             VkDeviceSize    sliceCount) const;
     
@@ -358,6 +386,7 @@ namespace dxvk {
      * \returns Buffer view handle
      */
     VkBufferView handle() const {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
       return m_physView->handle();
     }
     
@@ -403,6 +432,7 @@ namespace dxvk {
      * \returns Backing resource
      */
     Rc<DxvkResource> viewResource() const {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
       return m_physView;
     }
     
@@ -411,6 +441,7 @@ namespace dxvk {
      * \returns Backing buffer resource
      */
     Rc<DxvkResource> bufferResource() const {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
       return m_physView->bufferResource();
     }
     
@@ -429,6 +460,7 @@ namespace dxvk {
      * \returns Slice backing the view
      */
     DxvkPhysicalBufferSlice physicalSlice() const {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
       return m_physView->slice();
     }
     
@@ -439,6 +471,11 @@ namespace dxvk {
      * the view was created, the view is invalid as
      * well and needs to be re-created. Call this
      * prior to using the buffer view handle.
+     * 
+     * Views may be used by command lists that are
+     * recorded on other threads, so the backing view
+     * is protected by a lock. Once all threads have
+     * called this, they will all use the same view.
      */
     void updateView();
     
@@ -448,6 +485,8 @@ namespace dxvk {
     DxvkBufferViewCreateInfo   m_info;
     
     Rc<DxvkBuffer>             m_buffer;
+    
+    mutable sync::Spinlock     m_mutex;
     Rc<DxvkPhysicalBufferView> m_physView;
     
     uint32_t                   m_revision = 0;
@@ -101,6 +101,16 @@ namespace dxvk {
             VkDeviceSize        offset,
             VkDeviceSize        length);
     
+    /**
+     * \brief Checks whether the buffer should be moved
+     * 
+     * See \ref DxvkMemory::isEvacuating.
+     * \returns \c true if the buffer memory is evacuating
+     */
+    bool isEvacuating() const {
+      return m_memory.isEvacuating();
+    }
+    
   private:
     
     Rc<vk::DeviceFn>  m_vkd;
@@ -190,6 +200,14 @@ namespace dxvk {
       return m_buffer;
     }
     
+    /**
+     * \brief The physical buffer
+     * \returns Physical buffer
+     */
+    const Rc<DxvkPhysicalBuffer>& physicalBuffer() const {
+      return m_buffer;
+    }
+    
     /**
      * \brief Checks whether this slice overlaps with another
      * 
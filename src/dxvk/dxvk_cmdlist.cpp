@@ -128,10 +128,36 @@ namespace dxvk {
     m_queryTracker.reset();
     m_stagingAlloc.reset();
     m_descAlloc.reset();
+    m_descCache.reset();
     m_resources.reset();
   }
   
   
+  VkDescriptorSet DxvkCommandList::getDescriptorSet(
+          VkDescriptorSetLayout         descriptorLayout,
+          VkDescriptorUpdateTemplateKHR descriptorTemplate,
+          uint32_t                      descriptorCount,
+    const DxvkDescriptorInfo*           descriptorInfos) {
+    size_t hash = DxvkDescriptorSetCache::hash(
+      descriptorLayout, descriptorCount, descriptorInfos);
+    
+    VkDescriptorSet set = m_descCache.find(
+      descriptorLayout, descriptorCount, descriptorInfos, hash);
+    
+    if (set == VK_NULL_HANDLE) {
+      set = m_descAlloc.alloc(descriptorLayout);
+      
+      this->updateDescriptorSetWithTemplate(
+        set, descriptorTemplate, descriptorInfos);
+      
+      m_descCache.insert(descriptorLayout,
+        descriptorCount, descriptorInfos, hash, set);
+    }
+    
+    return set;
+  }
+  
+  
   DxvkStagingBufferSlice DxvkCommandList::stagedAlloc(VkDeviceSize size) {
     return m_stagingAlloc.alloc(size);
   }
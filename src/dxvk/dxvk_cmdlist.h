@@ -131,8 +131,9 @@ namespace dxvk {
      * the device can guarantee that the submission has
      * completed.
      */
-    void trackResource(Rc<DxvkResource> rc) {
-      m_resources.trackResource(std::move(rc));
+    template<typename T>
+    void trackResource(const Rc<T>& rc) {
+      m_resources.trackResource(rc.ptr());
     }
     
     /**
@@ -193,6 +194,25 @@ namespace dxvk {
       return m_descAlloc.alloc(descriptorLayout);
     }
     
+    /**
+     * \brief Retrieves a descriptor set
+     * 
+     * Returns a descriptor set that has previously been
+     * written with the exact same descriptors within this
+     * command list if possible. Otherwise, allocates a new
+     * descriptor set and writes the descriptors to it.
+     * \param [in] descriptorLayout Descriptor set layout
+     * \param [in] descriptorTemplate Update template
+     * \param [in] descriptorCount Number of descriptors
+     * \param [in] descriptorInfos Descriptor infos
+     * \returns The descriptor set
+     */
+    VkDescriptorSet getDescriptorSet(
+            VkDescriptorSetLayout         descriptorLayout,
+            VkDescriptorUpdateTemplateKHR descriptorTemplate,
+            uint32_t                      descriptorCount,
+      const DxvkDescriptorInfo*           descriptorInfos);
+    
     
     void updateDescriptorSets(
             uint32_t                      descriptorWriteCount,
@@ -583,22 +603,23 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>    m_vkd;
+    Rc<vk::DeviceFn>       m_vkd;
     
-    VkFence             m_fence;
+    VkFence                m_fence;
     
-    VkCommandPool       m_pool;
-    VkCommandBuffer     m_execBuffer;
-    VkCommandBuffer     m_initBuffer;
+    VkCommandPool          m_pool;
+    VkCommandBuffer        m_execBuffer;
+    VkCommandBuffer        m_initBuffer;
     
-    DxvkCmdBufferFlags  m_cmdBuffersUsed;
-    DxvkLifetimeTracker m_resources;
-    DxvkDescriptorAlloc m_descAlloc;
-    DxvkStagingAlloc    m_stagingAlloc;
-    DxvkQueryTracker    m_queryTracker;
-    DxvkEventTracker    m_eventTracker;
-    DxvkBufferTracker   m_bufferTracker;
-    DxvkStatCounters    m_statCounters;
+    DxvkCmdBufferFlags     m_cmdBuffersUsed;
+    DxvkLifetimeTracker    m_resources;
+    DxvkDescriptorAlloc    m_descAlloc;
+    DxvkDescriptorSetCache m_descCache;
+    DxvkStagingAlloc       m_stagingAlloc;
+    DxvkQueryTracker       m_queryTracker;
+    DxvkEventTracker       m_eventTracker;
+    DxvkBufferTracker      m_bufferTracker;
+    DxvkStatCounters       m_statCounters;
     
   };
   
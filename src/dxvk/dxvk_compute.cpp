@@ -137,6 +137,9 @@ namespace dxvk {
     auto t1 = std::chrono::high_resolution_clock::now();
     auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
     Logger::debug(str::format("DxvkComputePipeline: Finished in ", td.count(), " ms"));
+    
+    m_pipeMgr->m_device->timings()->addTime(
+      DxvkTimingStage::PipelineCompile, t1 - t0);
     return pipeline;
   }
 
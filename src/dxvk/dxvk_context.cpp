@@ -129,6 +129,29 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::bindResourceBuffers(
+          uint32_t              firstSlot,
+          uint32_t              slotCount,
+    const DxvkBufferSlice*      buffers) {
+    bool dirty = false;
+    
+    for (uint32_t i = 0; i < slotCount; i++) {
+      auto& binding = m_rc[firstSlot + i];
+      
+      if (!binding.bufferSlice.matches(buffers[i])) {
+        binding.bufferSlice = buffers[i];
+        dirty = true;
+      }
+    }
+    
+    if (dirty) {
+      m_flags.set(
+        DxvkContextFlag::CpDirtyResources,
+        DxvkContextFlag::GpDirtyResources);
+    }
+  }
+  
+  
   void DxvkContext::bindResourceView(
           uint32_t              slot,
     const Rc<DxvkImageView>&    imageView,
@@ -158,6 +181,29 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::bindResourceSamplers(
+          uint32_t              firstSlot,
+          uint32_t              slotCount,
+    const Rc<DxvkSampler>*      samplers) {
+    bool dirty = false;
+    
+    for (uint32_t i = 0; i < slotCount; i++) {
+      auto& binding = m_rc[firstSlot + i];
+      
+      if (binding.sampler != samplers[i]) {
+        binding.sampler = samplers[i];
+        dirty = true;
+      }
+    }
+    
+    if (dirty) {
+      m_flags.set(
+        DxvkContextFlag::CpDirtyResources,
+        DxvkContextFlag::GpDirtyResources);
+    }
+  }
+  
+  
   void DxvkContext::bindShader(
           VkShaderStageFlagBits stage,
     const Rc<DxvkShader>&       shader) {
@@ -245,6 +291,10 @@ namespace dxvk {
           VkClearColorValue     value) {
     this->spillRenderPass();
     this->unbindComputePipeline();
+    
+    // The buffer may have been renamed since
+    // the view was last used for rendering
+    bufferView->updateView();
 
     auto bufferSlice = bufferView->physicalSlice();
     
@@ -831,8 +881,19 @@ namespace dxvk {
   
   void DxvkContext::discardBuffer(
     const Rc<DxvkBuffer>&       buffer) {
-    if (m_barriers.isBufferDirty(buffer->slice(), DxvkAccess::Write))
+    if (!m_barriers.isBufferDirty(buffer->slice(), DxvkAccess::Write))
+      return;
+    
+    // Discarding is optional, so rather than waiting for
+    // command lists being recorded on other threads that
+    // may read the buffer's slice, just skip it
+    std::unique_lock<sync::RwSpinlock> lock(
+      m_device->bufferRenameLock(), std::try_to_lock);
+    
+    if (lock) {
       this->invalidateBuffer(buffer, buffer->allocPhysicalSlice());
+      m_device->notifyBufferDiscard();
+    }
   }
 
 
@@ -1132,6 +1193,55 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::relocateBuffer(
+    const Rc<DxvkBuffer>&           buffer) {
+    // Command lists being recorded on other threads may read
+    // the buffer's slice. The defragmenter will try again if
+    // the buffer cannot be moved right now.
+    std::unique_lock<sync::RwSpinlock> lock(
+      m_device->bufferRenameLock(), std::try_to_lock);
+    
+    if (!lock)
+      return;
+    
+    this->spillRenderPass();
+    
+    DxvkPhysicalBufferSlice srcSlice = buffer->slice();
+    DxvkPhysicalBufferSlice dstSlice = buffer->allocRelocationSlice();
+    
+    if (m_barriers.isBufferDirty(srcSlice, DxvkAccess::Read))
+      m_barriers.recordCommands(m_cmd);
+    
+    VkBufferCopy bufferRegion;
+    bufferRegion.srcOffset = srcSlice.offset();
+    bufferRegion.dstOffset = dstSlice.offset();
+    bufferRegion.size      = buffer->info().size;
+    
+    m_cmd->cmdCopyBuffer(
+      srcSlice.handle(),
+      dstSlice.handle(),
+      1, &bufferRegion);
+    
+    m_barriers.accessBuffer(srcSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_READ_BIT,
+      buffer->info().stages,
+      buffer->info().access);
+    
+    m_barriers.accessBuffer(dstSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      buffer->info().stages,
+      buffer->info().access);
+    
+    m_cmd->trackResource(srcSlice.resource());
+    m_cmd->trackResource(dstSlice.resource());
+    
+    this->invalidateBuffer(buffer, dstSlice);
+    m_device->notifyBufferDiscard();
+  }
+  
+  
   void DxvkContext::resolveImage(
     const Rc<DxvkImage>&            dstImage,
     const VkImageSubresourceLayers& dstSubresources,
@@ -1319,8 +1429,17 @@ namespace dxvk {
           uint32_t            viewportCount,
     const VkViewport*         viewports,
     const VkRect2D*           scissorRects) {
-    if (m_state.gp.state.rsViewportCount != viewportCount) {
-      m_state.gp.state.rsViewportCount = viewportCount;
+    const DxvkRsInfo& rs = m_state.gp.state.rs;
+    
+    if (rs.viewportCount() != viewportCount) {
+      m_state.gp.state.setRs(DxvkRsInfo(
+        rs.depthClampEnable(),
+        rs.depthBiasEnable(),
+        rs.polygonMode(),
+        rs.cullMode(),
+        rs.frontFace(),
+        viewportCount,
+        rs.sampleCount()));
       m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
     }
     
@@ -1355,9 +1474,10 @@ namespace dxvk {
   
   
   void DxvkContext::setInputAssemblyState(const DxvkInputAssemblyState& ia) {
-    m_state.gp.state.iaPrimitiveTopology = ia.primitiveTopology;
-    m_state.gp.state.iaPrimitiveRestart  = ia.primitiveRestart;
-    m_state.gp.state.iaPatchVertexCount  = ia.patchVertexCount;
+    m_state.gp.state.setIa(DxvkIaInfo(
+      ia.primitiveTopology,
+      ia.primitiveRestart,
+      ia.patchVertexCount));
     
     m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
   }
@@ -1373,36 +1493,41 @@ namespace dxvk {
       DxvkContextFlag::GpDirtyVertexBuffers);
     
     for (uint32_t i = 0; i < attributeCount; i++) {
-      m_state.gp.state.ilAttributes[i].location = attributes[i].location;
-      m_state.gp.state.ilAttributes[i].binding  = attributes[i].binding;
-      m_state.gp.state.ilAttributes[i].format   = attributes[i].format;
-      m_state.gp.state.ilAttributes[i].offset   = attributes[i].offset;
+      m_state.gp.state.setIlAttribute(i, DxvkIlAttribute(
+        attributes[i].location,
+        attributes[i].binding,
+        attributes[i].format,
+        attributes[i].offset));
     }
     
-    for (uint32_t i = attributeCount; i < m_state.gp.state.ilAttributeCount; i++)
-      m_state.gp.state.ilAttributes[i] = VkVertexInputAttributeDescription();
+    for (uint32_t i = attributeCount; i < m_state.gp.state.il.attributeCount(); i++)
+      m_state.gp.state.setIlAttribute(i, DxvkIlAttribute());
     
+    // Strides are taken from the bound vertex buffers and written
+    // into the state vector by updateGraphicsPipelineState
     for (uint32_t i = 0; i < bindingCount; i++) {
-      m_state.gp.state.ilBindings[i].binding    = bindings[i].binding;
-      m_state.gp.state.ilBindings[i].inputRate  = bindings[i].inputRate;
-      m_state.gp.state.ilDivisors[i]            = bindings[i].fetchRate;
+      m_state.gp.state.setIlBinding(i, DxvkIlBinding(
+        bindings[i].binding, 0,
+        bindings[i].inputRate,
+        bindings[i].fetchRate));
     }
     
-    for (uint32_t i = bindingCount; i < m_state.gp.state.ilBindingCount; i++)
-      m_state.gp.state.ilBindings[i] = VkVertexInputBindingDescription();
+    for (uint32_t i = bindingCount; i < m_state.gp.state.il.bindingCount(); i++)
+      m_state.gp.state.setIlBinding(i, DxvkIlBinding());
     
-    m_state.gp.state.ilAttributeCount = attributeCount;
-    m_state.gp.state.ilBindingCount   = bindingCount;
+    m_state.gp.state.setIl(DxvkIlInfo(attributeCount, bindingCount));
   }
   
   
   void DxvkContext::setRasterizerState(const DxvkRasterizerState& rs) {
-    m_state.gp.state.rsDepthClampEnable  = rs.depthClampEnable;
-    m_state.gp.state.rsDepthBiasEnable   = rs.depthBiasEnable;
-    m_state.gp.state.rsPolygonMode       = rs.polygonMode;
-    m_state.gp.state.rsCullMode          = rs.cullMode;
-    m_state.gp.state.rsFrontFace         = rs.frontFace;
-    m_state.gp.state.rsSampleCount       = rs.sampleCount;
+    m_state.gp.state.setRs(DxvkRsInfo(
+      rs.depthClampEnable,
+      rs.depthBiasEnable,
+      rs.polygonMode,
+      rs.cullMode,
+      rs.frontFace,
+      m_state.gp.state.rs.viewportCount(),
+      rs.sampleCount));
 
     m_state.ds.depthBiasConstant = rs.depthBiasConstant;
     m_state.ds.depthBiasClamp    = rs.depthBiasClamp;
@@ -1415,29 +1540,35 @@ namespace dxvk {
   
   
   void DxvkContext::setMultisampleState(const DxvkMultisampleState& ms) {
-    m_state.gp.state.msSampleMask            = ms.sampleMask;
-    m_state.gp.state.msEnableAlphaToCoverage = ms.enableAlphaToCoverage;
-    m_state.gp.state.msEnableAlphaToOne      = ms.enableAlphaToOne;
+    m_state.gp.state.setMs(DxvkMsInfo(
+      m_state.gp.state.ms.sampleCount(),
+      ms.sampleMask,
+      ms.enableAlphaToCoverage,
+      ms.enableAlphaToOne));
     
     m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
   }
   
   
   void DxvkContext::setDepthStencilState(const DxvkDepthStencilState& ds) {
-    m_state.gp.state.dsEnableDepthTest   = ds.enableDepthTest;
-    m_state.gp.state.dsEnableDepthWrite  = ds.enableDepthWrite;
-    m_state.gp.state.dsEnableStencilTest = ds.enableStencilTest;
-    m_state.gp.state.dsDepthCompareOp    = ds.depthCompareOp;
-    m_state.gp.state.dsStencilOpFront    = ds.stencilOpFront;
-    m_state.gp.state.dsStencilOpBack     = ds.stencilOpBack;
+    m_state.gp.state.setDs(DxvkDsInfo(
+      ds.enableDepthTest,
+      ds.enableDepthWrite,
+      ds.enableStencilTest,
+      ds.depthCompareOp));
+    
+    m_state.gp.state.setDsStencilOps(
+      DxvkDsStencilOp(ds.stencilOpFront),
+      DxvkDsStencilOp(ds.stencilOpBack));
     
     m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
   }
   
   
   void DxvkContext::setLogicOpState(const DxvkLogicOpState& lo) {
-    m_state.gp.state.omEnableLogicOp = lo.enableLogicOp;
-    m_state.gp.state.omLogicOp       = lo.logicOp;
+    m_state.gp.state.setOm(DxvkOmInfo(
+      lo.enableLogicOp,
+      lo.logicOp));
     
     m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
   }
@@ -1446,14 +1577,15 @@ namespace dxvk {
   void DxvkContext::setBlendMode(
           uint32_t            attachment,
     const DxvkBlendMode&      blendMode) {
-    m_state.gp.state.omBlendAttachments[attachment].blendEnable         = blendMode.enableBlending;
-    m_state.gp.state.omBlendAttachments[attachment].srcColorBlendFactor = blendMode.colorSrcFactor;
-    m_state.gp.state.omBlendAttachments[attachment].dstColorBlendFactor = blendMode.colorDstFactor;
-    m_state.gp.state.omBlendAttachments[attachment].colorBlendOp        = blendMode.colorBlendOp;
-    m_state.gp.state.omBlendAttachments[attachment].srcAlphaBlendFactor = blendMode.alphaSrcFactor;
-    m_state.gp.state.omBlendAttachments[attachment].dstAlphaBlendFactor = blendMode.alphaDstFactor;
-    m_state.gp.state.omBlendAttachments[attachment].alphaBlendOp        = blendMode.alphaBlendOp;
-    m_state.gp.state.omBlendAttachments[attachment].colorWriteMask      = blendMode.writeMask;
+    m_state.gp.state.setOmBlend(attachment, DxvkOmAttachmentBlend(
+      blendMode.enableBlending,
+      blendMode.colorSrcFactor,
+      blendMode.colorDstFactor,
+      blendMode.colorBlendOp,
+      blendMode.alphaSrcFactor,
+      blendMode.alphaDstFactor,
+      blendMode.alphaBlendOp,
+      blendMode.writeMask));
     
     m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
   }
@@ -2261,7 +2393,10 @@ namespace dxvk {
     if (m_flags.test(DxvkContextFlag::GpDirtyPipeline)) {
       m_flags.clr(DxvkContextFlag::GpDirtyPipeline);
       
-      m_state.gp.state.bsBindingMask.clear();
+      DxvkBindingMask bindMask;
+      bindMask.clear();
+      
+      m_state.gp.state.setBindingMask(bindMask);
       m_state.gp.pipeline = m_pipeMgr->createGraphicsPipeline(
         m_state.gp.vs.shader,
         m_state.gp.tcs.shader, m_state.gp.tes.shader,
@@ -2277,27 +2412,38 @@ namespace dxvk {
     if (m_flags.test(DxvkContextFlag::GpDirtyPipelineState)) {
       m_flags.clr(DxvkContextFlag::GpDirtyPipelineState);
       
-      for (uint32_t i = 0; i < m_state.gp.state.ilBindingCount; i++) {
-        const uint32_t binding = m_state.gp.state.ilBindings[i].binding;
+      for (uint32_t i = 0; i < m_state.gp.state.il.bindingCount(); i++) {
+        const DxvkIlBinding& binding = m_state.gp.state.ilBindings[i];
         
-        m_state.gp.state.ilBindings[i].stride
-          = (m_state.vi.bindingMask & (1u << binding)) != 0
-            ? m_state.vi.vertexStrides[binding]
-            : 0;
+        const uint32_t stride = (m_state.vi.bindingMask & (1u << binding.binding())) != 0
+          ? m_state.vi.vertexStrides[binding.binding()]
+          : 0;
+        
+        if (binding.stride() != stride) {
+          m_state.gp.state.setIlBinding(i, DxvkIlBinding(
+            binding.binding(), stride,
+            binding.inputRate(),
+            binding.divisor()));
+        }
       }
       
-      for (uint32_t i = m_state.gp.state.ilBindingCount; i < MaxNumVertexBindings; i++)
-        m_state.gp.state.ilBindings[i].stride = 0;
-      
       m_gpActivePipeline = m_state.gp.pipeline != nullptr && m_state.om.framebuffer != nullptr
         ? m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
-            m_state.om.framebuffer->getRenderPass())
+            m_state.om.framebuffer->getRenderPass(), true)
         : VK_NULL_HANDLE;
       
       if (m_gpActivePipeline != VK_NULL_HANDLE) {
         m_cmd->cmdBindPipeline(
           VK_PIPELINE_BIND_POINT_GRAPHICS,
           m_gpActivePipeline);
+      } else if (m_state.gp.pipeline != nullptr && m_state.om.framebuffer != nullptr
+              && m_device->config().enableAsync
+              && m_state.gp.pipeline->isPipelinePending(m_state.gp.state,
+                   m_state.om.framebuffer->getRenderPass())) {
+        // The pipeline is still being compiled in the background,
+        // so we need to look it up again on the next draw. Failed
+        // pipelines are not retried and not counted as skipped.
+        m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
       }
 
       m_flags.set(
@@ -2361,10 +2507,13 @@ namespace dxvk {
       && m_state.gp.pipeline->layout()->hasStaticBufferBindings())) {
       m_flags.clr(DxvkContextFlag::GpDirtyResources);
 
+      DxvkBindingMask bindMask = m_state.gp.state.bsBindingMask;
+      
       this->updateShaderResources(
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_state.gp.state.bsBindingMask,
+        VK_PIPELINE_BIND_POINT_GRAPHICS, bindMask,
         m_state.gp.pipeline->layout());
+      
+      m_state.gp.state.setBindingMask(bindMask);
 
       m_flags.set(
         DxvkContextFlag::GpDirtyDescriptorSet,
@@ -2410,6 +2559,10 @@ namespace dxvk {
       const auto& binding = layout->binding(i);
       const auto& res     = m_rc[binding.slot];
       
+      // Clear stale data so that descriptor sets
+      // can be looked up by their raw contents
+      m_descInfos[i] = DxvkDescriptorInfo();
+      
       switch (binding.type) {
         case VK_DESCRIPTOR_TYPE_SAMPLER:
           if (res.sampler != nullptr) {
@@ -2504,11 +2657,10 @@ namespace dxvk {
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 
     if (layout->bindingCount() != 0) {
-      descriptorSet = m_cmd->allocateDescriptorSet(
-        layout->descriptorSetLayout());
-      
-      m_cmd->updateDescriptorSetWithTemplate(
-        descriptorSet, layout->descriptorTemplate(),
+      descriptorSet = m_cmd->getDescriptorSet(
+        layout->descriptorSetLayout(),
+        layout->descriptorTemplate(),
+        layout->bindingCount(),
         m_descInfos.data());
     }
 
@@ -2546,15 +2698,21 @@ namespace dxvk {
       
       auto fb = m_device->createFramebuffer(m_state.om.renderTargets);
       
-      m_state.gp.state.msSampleCount = fb->getSampleCount();
+      const DxvkMsInfo& ms = m_state.gp.state.ms;
+      
+      m_state.gp.state.setMs(DxvkMsInfo(
+        fb->getSampleCount(),
+        ms.sampleMask(),
+        ms.enableAlphaToCoverage(),
+        ms.enableAlphaToOne()));
       m_state.om.framebuffer = fb;
 
       for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
         Rc<DxvkImageView> attachment = fb->getColorTarget(i).view;
 
-        m_state.gp.state.omComponentMapping[i] = attachment != nullptr
-          ? util::invertComponentMapping(attachment->info().swizzle)
-          : VkComponentMapping();
+        m_state.gp.state.setOmSwizzle(i, attachment != nullptr
+          ? DxvkOmAttachmentSwizzle(util::invertComponentMapping(attachment->info().swizzle))
+          : DxvkOmAttachmentSwizzle());
       }
 
       m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
@@ -2595,8 +2753,8 @@ namespace dxvk {
       uint32_t bindingCount = 0;
       uint32_t bindingMask  = 0;
       
-      for (uint32_t i = 0; i < m_state.gp.state.ilBindingCount; i++) {
-        const uint32_t binding = m_state.gp.state.ilBindings[i].binding;
+      for (uint32_t i = 0; i < m_state.gp.state.il.bindingCount(); i++) {
+        const uint32_t binding = m_state.gp.state.ilBindings[i].binding();
         bindingCount = std::max(bindingCount, binding + 1);
         
         if (m_state.vi.vertexBuffers[binding].defined()) {
@@ -2646,7 +2804,7 @@ namespace dxvk {
       return;
     
     if (m_flags.test(DxvkContextFlag::GpDirtyViewport)) {
-      uint32_t viewportCount = m_state.gp.state.rsViewportCount;
+      uint32_t viewportCount = m_state.gp.state.rs.viewportCount();
       m_cmd->cmdSetViewport(0, viewportCount, m_state.vp.viewports.data());
       m_cmd->cmdSetScissor (0, viewportCount, m_state.vp.scissorRects.data());
     }
@@ -2678,8 +2836,14 @@ namespace dxvk {
   
   
   bool DxvkContext::validateGraphicsState() {
-    if (m_gpActivePipeline == VK_NULL_HANDLE)
+    if (m_gpActivePipeline == VK_NULL_HANDLE) {
+      // The pipeline state only remains dirty if
+      // the pipeline is being compiled asynchronously
+      if (m_flags.test(DxvkContextFlag::GpDirtyPipelineState))
+        m_cmd->addStatCtr(DxvkStatCounter::CmdSkippedDrawCalls, 1);
+      
       return false;
+    }
     
     if (!m_flags.test(DxvkContextFlag::GpRenderPassBound))
       return false;
@@ -114,6 +114,20 @@ namespace dxvk {
             uint32_t              slot,
       const DxvkBufferSlice&      buffer);
     
+    /**
+     * \brief Binds a range of buffers as shader resources
+     * 
+     * Equivalent to calling \ref bindResourceBuffer
+     * for each slot in the given range.
+     * \param [in] firstSlot First resource binding slot
+     * \param [in] slotCount Number of slots to bind
+     * \param [in] buffers Buffers to bind
+     */
+    void bindResourceBuffers(
+            uint32_t              firstSlot,
+            uint32_t              slotCount,
+      const DxvkBufferSlice*      buffers);
+    
     /**
      * \brief Binds image or buffer view
      * 
@@ -141,6 +155,20 @@ namespace dxvk {
             uint32_t              slot,
       const Rc<DxvkSampler>&      sampler);
     
+    /**
+     * \brief Binds a range of image samplers
+     * 
+     * Equivalent to calling \ref bindResourceSampler
+     * for each slot in the given range.
+     * \param [in] firstSlot First resource binding slot
+     * \param [in] slotCount Number of slots to bind
+     * \param [in] samplers Samplers to bind
+     */
+    void bindResourceSamplers(
+            uint32_t              firstSlot,
+            uint32_t              slotCount,
+      const Rc<DxvkSampler>*      samplers);
+    
     /**
      * \brief Binds a shader to a given state
      * 
@@ -365,7 +393,8 @@ namespace dxvk {
      * Renames the buffer in case it is currently
      * used by the GPU in order to avoid having to
      * insert barriers before future commands using
-     * the buffer.
+     * the buffer. Skipped if the device's buffer
+     * rename lock is held by another thread.
      * \param [in] buffer The buffer to discard
      */
     void discardBuffer(
@@ -503,6 +532,26 @@ namespace dxvk {
       const Rc<DxvkBuffer>&           buffer,
       const DxvkPhysicalBufferSlice&  slice);
     
+    /**
+     * \brief Moves a buffer to new memory
+     * 
+     * Copies the buffer's contents to a newly allocated
+     * backing resource on the GPU and replaces the old
+     * one, which is freed once the GPU is done with it.
+     * The buffer must support transfer operations.
+     * 
+     * Does nothing if the device's buffer rename lock is
+     * held by another thread, in which case the caller
+     * may try again later.
+     * 
+     * \warning Same restrictions as for \ref invalidateBuffer.
+     * Threads other than the calling thread may only access
+     * the buffer's slice while holding the rename lock.
+     * \param [in] buffer The buffer to move
+     */
+    void relocateBuffer(
+      const Rc<DxvkBuffer>&           buffer);
+    
     /**
      * \brief Resolves a multisampled image resource
      * 
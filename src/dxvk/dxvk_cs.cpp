@@ -12,8 +12,8 @@ namespace dxvk {
   }
   
   
-  void DxvkCsChunk::executeAll(DxvkContext* ctx) {
-    auto cmd = m_head;
+  void DxvkCsChunk::executeAll(DxvkContext* ctx) const {
+    const DxvkCsCmd* cmd = m_head;
     
     while (cmd != nullptr) {
       cmd->exec(ctx);
@@ -72,8 +72,71 @@ namespace dxvk {
   }
   
   
-  DxvkCsThread::DxvkCsThread(const Rc<DxvkContext>& context)
-  : m_context(context), m_thread([this] { threadFunc(); }) {
+  DxvkCsChunkQueue::DxvkCsChunkQueue() {
+    for (uint32_t i = 0; i < Capacity; i++)
+      m_slots[i].seq.store(i, std::memory_order_relaxed);
+  }
+  
+  
+  DxvkCsChunkQueue::~DxvkCsChunkQueue() {
+    
+  }
+  
+  
+  bool DxvkCsChunkQueue::tryPush(DxvkCsChunkRef& chunk) {
+    uint64_t pos = m_pushPos.load(std::memory_order_relaxed);
+    
+    while (true) {
+      Slot& slot = m_slots[pos % Capacity];
+      
+      // The slot sequence number tells us whether the
+      // slot is free for the current push position, if
+      // the queue is full, or if another producer has
+      // claimed the slot in the meantime
+      uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      int64_t diff = int64_t(seq - pos);
+      
+      if (diff == 0) {
+        if (m_pushPos.compare_exchange_weak(pos, pos + 1,
+              std::memory_order_relaxed)) {
+          slot.chunk = std::move(chunk);
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_pushPos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  
+  
+  bool DxvkCsChunkQueue::tryPop(DxvkCsChunkRef& chunk) {
+    Slot& slot = m_slots[m_popPos % Capacity];
+    
+    if (slot.seq.load(std::memory_order_acquire) != m_popPos + 1)
+      return false;
+    
+    chunk = std::move(slot.chunk);
+    slot.seq.store(m_popPos + Capacity, std::memory_order_release);
+    
+    m_popPos += 1;
+    return true;
+  }
+  
+  
+  bool DxvkCsChunkQueue::isEmpty() const {
+    const Slot& slot = m_slots[m_popPos % Capacity];
+    return slot.seq.load(std::memory_order_acquire) != m_popPos + 1;
+  }
+  
+  
+  DxvkCsThread::DxvkCsThread(
+    const Rc<DxvkContext>&      context,
+          DxvkTimingTracker*    timings)
+  : m_context(context), m_timings(timings),
+    m_thread([this] { threadFunc(); }) {
     
   }
   
@@ -89,21 +152,92 @@ namespace dxvk {
   
   
   void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
+    m_chunksDispatched += 1;
+    
+    for (uint32_t i = 0; !m_queue.tryPush(chunk); i++) {
+      if (i < SpinCount) {
+        dxvk::this_thread::yield();
+      } else {
+        // The worker is falling behind, wait until it
+        // has consumed some chunks before trying again
+        std::unique_lock<std::mutex> lock(m_mutex);
+        
+        m_producersWaiting += 1;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        m_condOnFree.wait(lock, [this, &chunk] {
+          return m_queue.tryPush(chunk);
+        });
+        
+        m_producersWaiting -= 1;
+        break;
+      }
     }
     
-    m_condOnAdd.notify_one();
+    // Only wake up the worker if it went to sleep,
+    // which only happens if the queue was empty
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if (m_consumerWaiting.load()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_condOnAdd.notify_one();
+    }
   }
   
   
   void DxvkCsThread::synchronize() {
+    uint64_t chunksDispatched = m_chunksDispatched.load();
+    
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (m_chunksExecuted.load() >= chunksDispatched)
+        return;
+      
+      dxvk::this_thread::yield();
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    m_syncWaiting += 1;
+    
+    m_condOnSync.wait(lock, [this, chunksDispatched] {
+      return m_chunksExecuted.load() >= chunksDispatched;
+    });
+    
+    m_syncWaiting -= 1;
+  }
+  
+  
+  void DxvkCsThread::waitForChunks() {
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (!m_queue.isEmpty() || m_stopped.load())
+        return;
+      
+      dxvk::this_thread::yield();
+    }
+    
+    // Producers check this flag after adding a chunk. Since
+    // both sides use sequentially consistent operations, either
+    // the producer sees the flag, or we see the new chunk.
     std::unique_lock<std::mutex> lock(m_mutex);
     
-    m_condOnSync.wait(lock, [this] {
-      return m_chunksPending == 0;
+    m_consumerWaiting.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    m_condOnAdd.wait(lock, [this] {
+      return !m_queue.isEmpty() || m_stopped.load();
     });
+    
+    m_consumerWaiting.store(false);
+  }
+  
+  
+  void DxvkCsThread::notifySync(uint64_t chunksExecuted) {
+    m_chunksExecuted.store(chunksExecuted);
+    
+    if (m_syncWaiting.load()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_condOnSync.notify_all();
+    }
   }
   
   
@@ -112,31 +246,44 @@ namespace dxvk {
 
     DxvkCsChunkRef chunk;
     
+    uint64_t chunksExecuted = 0;
+    uint32_t chunksInBatch  = 0;
+    
     while (!m_stopped.load()) {
-      { std::unique_lock<std::mutex> lock(m_mutex);
-        if (chunk) {
-          if (--m_chunksPending == 0)
-            m_condOnSync.notify_one();
-          
-          chunk = DxvkCsChunkRef();
+      if (m_queue.tryPop(chunk)) {
+        // Wake up producers that are waiting
+        // for a free slot in the queue
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        if (m_producersWaiting.load()) {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_condOnFree.notify_all();
         }
         
-        if (m_chunksQueued.size() == 0) {
-          m_condOnAdd.wait(lock, [this] {
-            return (m_chunksQueued.size() != 0)
-                || (m_stopped.load());
-          });
+        { DxvkTimingScope timer(m_timings.ptr(), DxvkTimingStage::CsThread);
+          chunk->executeAll(m_context.ptr());
         }
         
-        if (m_chunksQueued.size() != 0) {
-          chunk = std::move(m_chunksQueued.front());
-          m_chunksQueued.pop();
+        chunk = DxvkCsChunkRef();
+        
+        chunksExecuted += 1;
+        
+        // Only update the completion counter once in a while,
+        // the synchronization code only needs it to be accurate
+        // once all chunks currently in the queue are processed
+        if (++chunksInBatch == BatchSize) {
+          notifySync(chunksExecuted);
+          chunksInBatch = 0;
+        }
+      } else {
+        if (chunksInBatch != 0) {
+          notifySync(chunksExecuted);
+          chunksInBatch = 0;
         }
+        
+        waitForChunks();
       }
-      
-      if (chunk)
-        chunk->executeAll(m_context.ptr());
     }
   }
   
-}
\ No newline at end of file
+}
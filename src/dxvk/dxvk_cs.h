@@ -1,12 +1,13 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 
 #include "../util/thread.h"
 #include "dxvk_context.h"
+#include "dxvk_timing.h"
 
 namespace dxvk {
   
@@ -82,6 +83,55 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Typed command with data
+   * 
+   * Stores a function object along with an array of
+   * \c M which is allocated directly after the command
+   * within the chunk, so that commands that operate on
+   * a variable number of elements do not need to carry
+   * a payload of the maximum possible size. The data
+   * is passed to the function object on execution.
+   */
+  template<typename T, typename M>
+  class alignas(16) DxvkCsDataCmd : public DxvkCsCmd {
+    static_assert(alignof(M) <= 16, "Data type over-aligned");
+  public:
+    
+    DxvkCsDataCmd(T&& cmd, size_t count)
+    : m_command(std::move(cmd)), m_count(count) {
+      for (size_t i = 0; i < count; i++)
+        new (data() + i) M();
+    }
+    
+    ~DxvkCsDataCmd() {
+      for (size_t i = 0; i < m_count; i++)
+        data()[i].~M();
+    }
+    
+    DxvkCsDataCmd             (DxvkCsDataCmd&&) = delete;
+    DxvkCsDataCmd& operator = (DxvkCsDataCmd&&) = delete;
+    
+    M* data() {
+      return reinterpret_cast<M*>(this + 1);
+    }
+    
+    const M* data() const {
+      return reinterpret_cast<const M*>(this + 1);
+    }
+    
+    void exec(DxvkContext* ctx) const {
+      m_command(ctx, data(), m_count);
+    }
+    
+  private:
+    
+    T       m_command;
+    size_t  m_count;
+    
+  };
+  
+  
   /**
    * \brief Command chunk
    * 
@@ -136,14 +186,57 @@ namespace dxvk {
       return true;
     }
     
+    /**
+     * \brief Tries to add a command with data to the chunk
+     * 
+     * Same as \ref push, but also allocates an array
+     * of \c count default-constructed elements which
+     * the caller must fill in before the chunk gets
+     * submitted. The command will be called with a
+     * pointer to the array and the element count.
+     * \param [in] command The command to add
+     * \param [in] count Number of data elements
+     * \returns Pointer to the data array, or \c nullptr
+     *          if a new chunk needs to be allocated
+     */
+    template<typename M, typename T>
+    M* pushData(T& command, size_t count) {
+      using FuncType = DxvkCsDataCmd<T, M>;
+      
+      const size_t size = align(
+        sizeof(FuncType) + count * sizeof(M),
+        alignof(FuncType));
+      
+      if (m_commandOffset + size > MaxBlockSize)
+        return nullptr;
+      
+      DxvkCsCmd* tail = m_tail;
+      
+      FuncType* cmd = new (m_data + m_commandOffset)
+        FuncType(std::move(command), count);
+      
+      m_tail = cmd;
+      
+      if (tail != nullptr)
+        tail->setNext(m_tail);
+      else
+        m_head = m_tail;
+      
+      m_commandCount  += 1;
+      m_commandOffset += size;
+      return cmd->data();
+    }
+    
     /**
      * \brief Executes all commands
      * 
-     * This will also reset the chunk
-     * so that it can be reused.
+     * Does not modify the recorded commands, so
+     * that the same chunk can be executed multiple
+     * times, e.g. when a command list gets replayed.
+     * Commands are only destroyed by \ref reset.
      * \param [in] ctx The context
      */
-    void executeAll(DxvkContext* ctx);
+    void executeAll(DxvkContext* ctx) const;
     
     /**
      * \brief Resets chunk
@@ -290,17 +383,90 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Chunk queue
+   * 
+   * Bounded lock-free ring buffer of chunk references.
+   * Any number of threads may push chunks, but only
+   * one thread may pop chunks at any given time.
+   */
+  class DxvkCsChunkQueue {
+    constexpr static uint32_t Capacity = 256;
+  public:
+    
+    DxvkCsChunkQueue();
+    ~DxvkCsChunkQueue();
+    
+    DxvkCsChunkQueue             (const DxvkCsChunkQueue&) = delete;
+    DxvkCsChunkQueue& operator = (const DxvkCsChunkQueue&) = delete;
+    
+    /**
+     * \brief Adds a chunk to the queue
+     * 
+     * \param [in] chunk The chunk. Will not be
+     *    modified if the queue is full.
+     * \returns \c false if the queue is full
+     */
+    bool tryPush(DxvkCsChunkRef& chunk);
+    
+    /**
+     * \brief Removes a chunk from the queue
+     * 
+     * Must only be called from the consumer thread.
+     * \param [out] chunk The chunk
+     * \returns \c false if the queue is empty
+     */
+    bool tryPop(DxvkCsChunkRef& chunk);
+    
+    /**
+     * \brief Checks whether a chunk can be popped
+     * 
+     * Must only be called from the consumer thread.
+     * \returns \c true if the queue is empty
+     */
+    bool isEmpty() const;
+    
+  private:
+    
+    struct Slot {
+      std::atomic<uint64_t> seq;
+      DxvkCsChunkRef        chunk;
+    };
+    
+    std::array<Slot, Capacity>  m_slots;
+    
+    std::atomic<uint64_t>       m_pushPos = { 0ull };
+    uint64_t                    m_popPos  = 0ull;
+    
+  };
+  
+  
   /**
    * \brief Command stream thread
    * 
    * Spawns a thread that will execute
    * commands on a DXVK context. 
+   * 
+   * Chunks are passed to the thread through a lock-free
+   * queue. The mutex and condition variables are only
+   * used when a thread actually needs to go to sleep,
+   * i.e. when the worker runs out of chunks, when the
+   * queue is full, or when synchronizing.
    */
   class DxvkCsThread {
+    /// Number of times a thread checks
+    /// its condition before going to sleep
+    constexpr static uint32_t SpinCount = 64;
     
+    /// Maximum number of chunks to execute
+    /// before updating the completion counter
+    constexpr static uint32_t BatchSize = 16;
   public:
     
-    DxvkCsThread(const Rc<DxvkContext>& context);
+    DxvkCsThread(
+      const Rc<DxvkContext>&      context,
+            DxvkTimingTracker*    timings);
+    
     ~DxvkCsThread();
     
     /**
@@ -325,15 +491,27 @@ namespace dxvk {
   private:
     
     const Rc<DxvkContext>       m_context;
+    const Rc<DxvkTimingTracker> m_timings;
+    
+    DxvkCsChunkQueue            m_queue;
     
     std::atomic<bool>           m_stopped = { false };
+    std::atomic<bool>           m_consumerWaiting = { false };
+    std::atomic<uint32_t>       m_producersWaiting = { 0u };
+    std::atomic<uint32_t>       m_syncWaiting = { 0u };
+    
+    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
+    
     std::mutex                  m_mutex;
     std::condition_variable     m_condOnAdd;
+    std::condition_variable     m_condOnFree;
     std::condition_variable     m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
     dxvk::thread                m_thread;
     
-    uint32_t                    m_chunksPending = 0;
+    void waitForChunks();
+    
+    void notifySync(uint64_t chunksExecuted);
     
     void threadFunc();
     
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "dxvk_descriptor.h"
 
 namespace dxvk {
@@ -91,4 +93,68 @@ namespace dxvk {
     return set;
   }
   
+  
+  VkDescriptorSet DxvkDescriptorSetCache::find(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash) const {
+    auto range = m_entries.equal_range(hash);
+    
+    for (auto e = range.first; e != range.second; e++) {
+      const Entry& entry = e->second;
+      
+      if (entry.layout == layout && entry.count == count
+       && !std::memcmp(&m_infos[entry.offset], infos, count * sizeof(DxvkDescriptorInfo)))
+        return entry.set;
+    }
+    
+    return VK_NULL_HANDLE;
+  }
+  
+  
+  void DxvkDescriptorSetCache::insert(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash,
+          VkDescriptorSet       set) {
+    Entry entry;
+    entry.layout = layout;
+    entry.offset = m_infos.size();
+    entry.count  = count;
+    entry.set    = set;
+    
+    m_infos.insert(m_infos.end(), infos, infos + count);
+    m_entries.insert({ hash, entry });
+  }
+  
+  
+  void DxvkDescriptorSetCache::reset() {
+    m_infos.clear();
+    m_entries.clear();
+  }
+  
+  
+  size_t DxvkDescriptorSetCache::hash(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos) {
+    static_assert(sizeof(DxvkDescriptorInfo) % sizeof(size_t) == 0);
+    
+    DxvkHashState result;
+    result.add(std::hash<VkDescriptorSetLayout>()(layout));
+    
+    auto data = reinterpret_cast<const char*>(infos);
+    auto size = count * sizeof(DxvkDescriptorInfo);
+    
+    for (size_t i = 0; i < size; i += sizeof(size_t)) {
+      size_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      result.add(word);
+    }
+    
+    return result;
+  }
+  
 }
\ No newline at end of file
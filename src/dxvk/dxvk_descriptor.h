@@ -1,7 +1,9 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 
 namespace dxvk {
@@ -68,4 +70,87 @@ namespace dxvk {
     
   };
   
+  
+  /**
+   * \brief Descriptor set cache
+   * 
+   * Maps the contents of descriptor sets to sets that
+   * have already been written with the exact same
+   * descriptors, so that those can be bound again
+   * without allocating and updating a new set. Since
+   * descriptor sets are owned by the allocator of the
+   * command list, the cache must be reset along with
+   * the allocator once the command list completes.
+   */
+  class DxvkDescriptorSetCache {
+    
+  public:
+    
+    /**
+     * \brief Looks up a descriptor set
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash, see \ref hash
+     * \returns The descriptor set, or
+     *    \c VK_NULL_HANDLE if none was found
+     */
+    VkDescriptorSet find(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash) const;
+    
+    /**
+     * \brief Adds a descriptor set to the cache
+     * 
+     * The descriptor set must have been written
+     * with the given descriptors, and must not
+     * be modified until the cache is reset.
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash, see \ref hash
+     * \param [in] set The descriptor set
+     */
+    void insert(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash,
+            VkDescriptorSet       set);
+    
+    /**
+     * \brief Removes all descriptor sets
+     */
+    void reset();
+    
+    /**
+     * \brief Computes descriptor set hash
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \returns Hash of the layout and descriptors
+     */
+    static size_t hash(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos);
+    
+  private:
+    
+    struct Entry {
+      VkDescriptorSetLayout layout;
+      uint32_t              offset;
+      uint32_t              count;
+      VkDescriptorSet       set;
+    };
+    
+    std::vector<DxvkDescriptorInfo>       m_infos;
+    std::unordered_multimap<size_t, Entry> m_entries;
+    
+  };
+  
 }
\ No newline at end of file
@@ -14,8 +14,14 @@ namespace dxvk {
     m_extensions        (extensions),
     m_features          (features),
     m_properties        (adapter->deviceProperties()),
+    m_timings           (new DxvkTimingTracker      ()),
     m_memory            (new DxvkMemoryAllocator    (this)),
+    m_defrag            (new DxvkMemoryDefragmenter (this, m_memory.ptr())),
     m_renderPassPool    (new DxvkRenderPassPool     (vkd)),
+    m_framebufferCache  (new DxvkFramebufferCache   (vkd, m_renderPassPool.ptr(), DxvkFramebufferSize {
+      m_properties.limits.maxFramebufferWidth,
+      m_properties.limits.maxFramebufferHeight,
+      m_properties.limits.maxFramebufferLayers })),
     m_pipelineManager   (new DxvkPipelineManager    (this, m_renderPassPool.ptr())),
     m_metaClearObjects  (new DxvkMetaClearObjects   (vkd)),
     m_metaCopyObjects   (new DxvkMetaCopyObjects    (vkd)),
@@ -33,6 +39,9 @@ namespace dxvk {
     m_vkd->vkGetDeviceQueue(m_vkd->device(),
       m_presentQueue.queueFamily, 0,
       &m_presentQueue.queueHandle);
+    
+    if (env::getEnvVar(L"DXVK_SHADER_CACHE") != "0")
+      m_shaderCache = new DxvkShaderCache();
   }
   
   
@@ -127,16 +136,7 @@ namespace dxvk {
   
   Rc<DxvkFramebuffer> DxvkDevice::createFramebuffer(
     const DxvkRenderTargets& renderTargets) {
-    const DxvkFramebufferSize defaultSize = {
-      m_properties.limits.maxFramebufferWidth,
-      m_properties.limits.maxFramebufferHeight,
-      m_properties.limits.maxFramebufferLayers };
-    
-    auto renderPassFormat = DxvkFramebuffer::getRenderPassFormat(renderTargets);
-    auto renderPassObject = m_renderPassPool->getRenderPass(renderPassFormat);
-    
-    return new DxvkFramebuffer(m_vkd,
-      renderPassObject, renderTargets, defaultSize);
+    return m_framebufferCache->getFramebuffer(renderTargets);
   }
   
   
@@ -201,12 +201,38 @@ namespace dxvk {
   DxvkStatCounters DxvkDevice::getStatCounters() {
     DxvkMemoryStats mem = m_memory->getMemoryStats();
     DxvkPipelineCount pipe = m_pipelineManager->getPipelineCount();
+    DxvkStateCacheStats sc = m_pipelineManager->getStateCacheStats();
+    DxvkFramebufferCacheStats fb = m_framebufferCache->getStats();
+    
+    // Weigh the fragmentation of each chunk by its amount
+    // of free memory, since that is what is affected
+    std::vector<DxvkMemoryChunkStats> chunks = m_memory->getChunkStats();
+    
+    double       fragmentedSize = 0.0;
+    VkDeviceSize freeSize       = 0;
+    
+    for (const auto& chunk : chunks) {
+      VkDeviceSize chunkFreeSize = chunk.ranges.totalSize - chunk.ranges.usedSize;
+      fragmentedSize += chunk.ranges.fragmentation() * double(chunkFreeSize);
+      freeSize       += chunkFreeSize;
+    }
+    
+    uint64_t fragmentation = freeSize != 0
+      ? uint64_t(100.0 * fragmentedSize / double(freeSize))
+      : 0;
     
     DxvkStatCounters result;
-    result.setCtr(DxvkStatCounter::MemoryAllocated,   mem.memoryAllocated);
-    result.setCtr(DxvkStatCounter::MemoryUsed,        mem.memoryUsed);
-    result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
-    result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
+    result.setCtr(DxvkStatCounter::MemoryAllocated,     mem.memoryAllocated);
+    result.setCtr(DxvkStatCounter::MemoryUsed,          mem.memoryUsed);
+    result.setCtr(DxvkStatCounter::MemoryChunkCount,    chunks.size());
+    result.setCtr(DxvkStatCounter::MemoryFragmentation, fragmentation);
+    result.setCtr(DxvkStatCounter::PipeCountGraphics,   pipe.numGraphicsPipelines);
+    result.setCtr(DxvkStatCounter::PipeCountCompute,    pipe.numComputePipelines);
+    result.setCtr(DxvkStatCounter::StateCacheQueued,    sc.numQueued);
+    result.setCtr(DxvkStatCounter::StateCacheCompiled,  sc.numCompiled);
+    result.setCtr(DxvkStatCounter::StateCacheFailed,    sc.numFailed);
+    result.setCtr(DxvkStatCounter::FramebufferCacheHits,   fb.numHits);
+    result.setCtr(DxvkStatCounter::FramebufferCacheMisses, fb.numMisses);
     
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
@@ -229,6 +255,22 @@ namespace dxvk {
   }
   
   
+  Rc<DxvkShader> DxvkDevice::lookupCachedShader(
+    const DxvkShaderCacheKey&     key) {
+    return m_shaderCache != nullptr
+      ? m_shaderCache->lookupShader(key)
+      : nullptr;
+  }
+  
+  
+  void DxvkDevice::storeCachedShader(
+    const DxvkShaderCacheKey&     key,
+    const Rc<DxvkShader>&         shader) {
+    if (m_shaderCache != nullptr)
+      m_shaderCache->storeShader(key, shader);
+  }
+  
+  
   VkResult DxvkDevice::presentSwapImage(
     const VkPresentInfoKHR&         presentInfo) {
     { // Queue submissions are not thread safe
@@ -261,6 +303,8 @@ namespace dxvk {
     VkResult status;
     
     { // Queue submissions are not thread safe
+      DxvkTimingScope timer(m_timings.ptr(), DxvkTimingStage::QueueSubmit);
+      
       std::lock_guard<std::mutex> queueLock(m_submissionLock);
       std::lock_guard<sync::Spinlock> statLock(m_statLock);
       
@@ -9,6 +9,7 @@
 #include "dxvk_framebuffer.h"
 #include "dxvk_image.h"
 #include "dxvk_memory.h"
+#include "dxvk_memory_defrag.h"
 #include "dxvk_meta_clear.h"
 #include "dxvk_options.h"
 #include "dxvk_pipecache.h"
@@ -19,9 +20,11 @@
 #include "dxvk_renderpass.h"
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
+#include "dxvk_shader_cache.h"
 #include "dxvk_stats.h"
 #include "dxvk_swapchain.h"
 #include "dxvk_sync.h"
+#include "dxvk_timing.h"
 #include "dxvk_unbound.h"
 
 namespace dxvk {
@@ -191,7 +194,8 @@ namespace dxvk {
      * \brief Creates framebuffer for a set of render targets
      * 
      * Automatically deduces framebuffer dimensions
-     * from the supplied render target views.
+     * from the supplied render target views. May
+     * return a cached framebuffer object.
      * \param [in] renderTargets Render targets
      * \returns The framebuffer object
      */
@@ -294,6 +298,28 @@ namespace dxvk {
      */
     DxvkStatCounters getStatCounters();
 
+    /**
+     * \brief Timing tracker
+     * 
+     * Collects the time spent in various stages
+     * per frame. Used by the HUD and for traces.
+     * \returns Timing tracker
+     */
+    DxvkTimingTracker* timings() const {
+      return m_timings.ptr();
+    }
+
+    /**
+     * \brief Memory defragmenter
+     * 
+     * Frees unused device memory and, if enabled,
+     * moves buffers out of sparsely used memory.
+     * \returns Memory defragmenter
+     */
+    DxvkMemoryDefragmenter* defragmenter() const {
+      return m_defrag.ptr();
+    }
+
     /**
      * \brief Retreves current frame ID
      * \returns Current frame ID
@@ -316,6 +342,27 @@ namespace dxvk {
     void registerShader(
       const Rc<DxvkShader>&         shader);
     
+    /**
+     * \brief Looks up a shader in the shader cache
+     * 
+     * \param [in] key Shader cache key
+     * \returns The cached shader, or \c nullptr if
+     *    the shader cache is disabled or if no valid
+     *    entry exists for the given key.
+     */
+    Rc<DxvkShader> lookupCachedShader(
+      const DxvkShaderCacheKey&     key);
+    
+    /**
+     * \brief Adds a shader to the shader cache
+     * 
+     * \param [in] key Shader cache key
+     * \param [in] shader Newly compiled shader
+     */
+    void storeCachedShader(
+      const DxvkShaderCacheKey&     key,
+      const Rc<DxvkShader>&         shader);
+    
     /**
      * \brief Presents a swap chain image
      * 
@@ -383,6 +430,48 @@ namespace dxvk {
      */
     void waitForIdle();
     
+    /**
+     * \brief Buffer rename lock
+     * 
+     * Held in shared mode by threads which resolve buffer
+     * slices outside of the CS thread, e.g. when recording
+     * command lists ahead of time. Contexts only rename
+     * buffers through \c discardBuffer or relocation while
+     * holding the lock exclusively, and skip the rename if
+     * the lock is not available. Buffers that get renamed
+     * through mapping must not be used by such threads.
+     * \returns Buffer rename lock
+     */
+    sync::RwSpinlock& bufferRenameLock() {
+      return m_bufferRenameLock;
+    }
+    
+    /**
+     * \brief Number of discarded buffers
+     * 
+     * Counts how often a buffer got new backing storage
+     * through \c discardBuffer or through relocation.
+     * Buffer renames caused by mapping are not counted.
+     * Can be used to check whether buffer slices that
+     * were resolved ahead of time may be out of date.
+     * Only changes while the buffer rename lock is held
+     * in exclusive mode.
+     * \returns Buffer discard count
+     */
+    uint64_t getBufferDiscardCount() const {
+      return m_bufferDiscards.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * \brief Increments buffer discard count
+     * 
+     * Called by contexts after replacing the
+     * backing storage of a discarded buffer.
+     */
+    void notifyBufferDiscard() {
+      m_bufferDiscards.fetch_add(1, std::memory_order_release);
+    }
+    
   private:
     
     DxvkOptions                 m_options;
@@ -394,9 +483,14 @@ namespace dxvk {
     DxvkDeviceFeatures          m_features;
     VkPhysicalDeviceProperties  m_properties;
     
+    Rc<DxvkTimingTracker>       m_timings;
+    
     Rc<DxvkMemoryAllocator>     m_memory;
+    Rc<DxvkMemoryDefragmenter>  m_defrag;
     Rc<DxvkRenderPassPool>      m_renderPassPool;
+    Rc<DxvkFramebufferCache>    m_framebufferCache;
     Rc<DxvkPipelineManager>     m_pipelineManager;
+    Rc<DxvkShaderCache>         m_shaderCache;
 
     Rc<DxvkMetaClearObjects>    m_metaClearObjects;
     Rc<DxvkMetaCopyObjects>     m_metaCopyObjects;
@@ -417,6 +511,9 @@ namespace dxvk {
     
     DxvkSubmissionQueue m_submissionQueue;
     
+    sync::RwSpinlock      m_bufferRenameLock;
+    std::atomic<uint64_t> m_bufferDiscards = { 0ull };
+    
     void recycleCommandList(
       const Rc<DxvkCommandList>& cmdList);
     
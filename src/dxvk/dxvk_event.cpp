@@ -28,6 +28,14 @@ namespace dxvk {
   void DxvkEvent::signal(uint32_t revision) {
     uint64_t expected = pack({ DxvkEventStatus::Reset,    revision });
     uint64_t desired  = pack({ DxvkEventStatus::Signaled, revision });
+    
+    // Store the time stamp before the status changes so
+    // that threads waiting for the event will see it
+    TimePoint now = Clock::now();
+    
+    if (unpack(m_packed.load()).revision == revision)
+      m_signalTime.store(now.time_since_epoch().count());
+    
     m_packed.compare_exchange_strong(expected, desired);
   }
   
@@ -35,6 +43,11 @@ namespace dxvk {
   DxvkEventStatus DxvkEvent::getStatus() const {
     return unpack(m_packed.load()).status;
   }
+  
+  
+  DxvkEvent::TimePoint DxvkEvent::getSignalTime() const {
+    return TimePoint(Clock::duration(m_signalTime.load()));
+  }
 
 
   void DxvkEvent::wait() const {
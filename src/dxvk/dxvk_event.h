@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <mutex>
 
 #include "dxvk_include.h"
@@ -25,6 +26,9 @@ namespace dxvk {
     
   public:
     
+    using Clock     = std::chrono::high_resolution_clock;
+    using TimePoint = typename Clock::time_point;
+    
     DxvkEvent();
     ~DxvkEvent();
     
@@ -46,6 +50,17 @@ namespace dxvk {
      */
     DxvkEventStatus getStatus() const;
     
+    /**
+     * \brief Queries time when the event got signaled
+     * 
+     * Events are signaled by the submission queue as
+     * soon as the GPU has finished executing the command
+     * list, so this can be used to measure GPU completion
+     * times. Only meaningful if the event is signaled.
+     * \returns Time of the most recent \ref signal call
+     */
+    TimePoint getSignalTime() const;
+    
     /**
      * \brief Waits for event to get signaled
      * 
@@ -64,6 +79,9 @@ namespace dxvk {
 
     // Packed status and revision
     std::atomic<uint64_t> m_packed;
+    
+    // Time of the last signal operation
+    std::atomic<typename Clock::rep> m_signalTime = { 0 };
 
     static uint64_t pack(Status info);
     static Status unpack(uint64_t packed);
@@ -0,0 +1,200 @@
+#include "dxvk_frame_pacer.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x2
+#endif
+
+namespace dxvk {
+
+  // Amount of time by which the GPU should finish the
+  // previous frame before the next one gets presented,
+  // in milliseconds. Absorbs timer and scheduling jitter.
+  constexpr double LatencySafetyMargin = 1.0;
+
+  // Maximum number of frames that may be in flight before
+  // we stop tracking them. Only reached if frame events
+  // are never signaled for some reason.
+  constexpr size_t MaxTrackedFrames = 16;
+
+  // Remaining time below which we spin rather than sleep.
+  // The default system timer resolution is 15.6 ms, so
+  // without a high-resolution timer, a sleep may overshoot
+  // by an entire timer period.
+  constexpr auto SpinThresholdHighRes = std::chrono::milliseconds(1);
+  constexpr auto SpinThresholdDefault = std::chrono::microseconds(15625);
+
+
+  DxvkFramePacer::DxvkFramePacer(
+    const DxvkFramePacerOptions&  options)
+  : m_options(options) {
+    if (m_options.maxFrameRate != 0)
+      Logger::info(str::format("DXVK: Limiting frame rate to ", m_options.maxFrameRate, " FPS"));
+
+    if (m_options.lowLatency)
+      Logger::info("DXVK: Low-latency frame pacing enabled");
+
+    if (m_options.maxFrameRate != 0 || m_options.lowLatency) {
+      m_timer = CreateWaitableTimerExW(nullptr, nullptr,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+      if (m_timer == nullptr)
+        Logger::warn("DXVK: High-resolution timers not supported, frame pacing may use more CPU time");
+    }
+
+    m_spinThreshold = m_timer != nullptr
+      ? std::chrono::duration_cast<Clock::duration>(SpinThresholdHighRes)
+      : std::chrono::duration_cast<Clock::duration>(SpinThresholdDefault);
+  }
+
+
+  DxvkFramePacer::~DxvkFramePacer() {
+    if (m_timer != nullptr)
+      CloseHandle(m_timer);
+  }
+
+
+  void DxvkFramePacer::beginPresent(
+    const Rc<DxvkEvent>&          frameEvent) {
+    m_presentTime = Clock::now();
+    m_sleepTime   = 0.0;
+
+    if (m_frameEndTime != TimePoint())
+      updateStat(m_stats.cpuTime, Duration(m_presentTime - m_frameEndTime).count());
+
+    // In low-latency mode, wait for the previous frame to
+    // complete. Since command lists complete in order,
+    // this implies that the given frame event, which is
+    // used to enforce the maximum frame latency, has also
+    // been signaled by the time the wait returns.
+    Rc<DxvkEvent> event = frameEvent;
+
+    if (m_options.lowLatency && m_lastEvent != nullptr)
+      event = m_lastEvent;
+
+    event->wait();
+
+    updateStat(m_stats.waitTime, Duration(Clock::now() - m_presentTime).count());
+
+    this->processCompletion(event);
+    this->limitFrameRate();
+  }
+
+
+  void DxvkFramePacer::endPresent(
+    const Rc<DxvkEvent>&          frameEvent) {
+    if (m_frames.size() >= MaxTrackedFrames)
+      m_frames.erase(m_frames.begin());
+
+    m_frames.push_back({ frameEvent, m_presentTime });
+    m_lastEvent = frameEvent;
+
+    if (m_options.lowLatency && m_latencySleep > 0.0) {
+      m_sleepTime += this->sleepUntil(Clock::now()
+        + std::chrono::duration_cast<Clock::duration>(Duration(m_latencySleep)));
+    }
+
+    updateStat(m_stats.sleepTime, m_sleepTime);
+    m_frameEndTime = Clock::now();
+  }
+
+
+  void DxvkFramePacer::processCompletion(
+    const Rc<DxvkEvent>&          event) {
+    auto frame = m_frames.begin();
+
+    while (frame != m_frames.end() && frame->event != event)
+      frame++;
+
+    if (frame == m_frames.end())
+      return;
+
+    TimePoint completionTime = event->getSignalTime();
+    TimePoint presentTime    = frame->presentTime;
+
+    // Frames complete in order, so any older
+    // frames must have completed as well
+    m_frames.erase(m_frames.begin(), frame + 1);
+
+    if (completionTime > presentTime)
+      updateStat(m_stats.latency, Duration(completionTime - presentTime).count());
+
+    if (m_completionTime != TimePoint() && completionTime > m_completionTime)
+      updateStat(m_stats.gpuTime, Duration(completionTime - m_completionTime).count());
+
+    m_completionTime = completionTime;
+
+    if (m_options.lowLatency) {
+      // Positive if we had to wait for the GPU to finish the
+      // previous frame, negative if the GPU finished it before
+      // the application presented the current frame. Adjust
+      // the delay so that the GPU finishes the previous frame
+      // shortly before the next present call, which keeps the
+      // GPU busy without letting frames queue up.
+      double slack = Duration(completionTime - m_presentTime).count();
+
+      m_latencySleep = std::max(0.0, std::min<double>(m_stats.gpuTime,
+        m_latencySleep + 0.5 * (slack + LatencySafetyMargin)));
+    }
+  }
+
+
+  void DxvkFramePacer::limitFrameRate() {
+    if (m_options.maxFrameRate == 0)
+      return;
+
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / double(m_options.maxFrameRate)));
+
+    // Do not try to catch up if the application
+    // was too slow to meet the frame rate limit
+    TimePoint now = Clock::now();
+
+    if (now < m_nextFrameTime) {
+      m_sleepTime += this->sleepUntil(m_nextFrameTime);
+      m_nextFrameTime += interval;
+    } else {
+      m_nextFrameTime = now + interval;
+    }
+  }
+
+
+  double DxvkFramePacer::sleepUntil(
+          TimePoint               time) {
+    TimePoint start = Clock::now();
+    TimePoint now   = start;
+
+    // Sleeping is not accurate enough, so we need to
+    // spin for the last part of the interval. Relative
+    // due times for the timer are given in 100ns units.
+    while (now < time) {
+      auto remaining = time - now;
+
+      if (remaining > m_spinThreshold) {
+        auto sleepTime = remaining - m_spinThreshold;
+
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -std::max<long long>(1, std::chrono::duration_cast<
+          std::chrono::duration<long long, std::ratio<1, 10000000>>>(sleepTime).count());
+
+        if (m_timer != nullptr && SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE))
+          WaitForSingleObject(m_timer, INFINITE);
+        else
+          dxvk::this_thread::sleep_for(sleepTime);
+      } else {
+        dxvk::this_thread::yield();
+      }
+
+      now = Clock::now();
+    }
+
+    return Duration(now - start).count();
+  }
+
+
+  void DxvkFramePacer::updateStat(
+          float&                  stat,
+          double                  value) {
+    stat = float(0.9 * double(stat) + 0.1 * value);
+  }
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "dxvk_event.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Frame pacer options
+   */
+  struct DxvkFramePacerOptions {
+    /// Maximum number of frames presented per
+    /// second, or zero to disable the limiter.
+    uint32_t maxFrameRate = 0;
+
+    /// Delays the application's next frame so that
+    /// its GPU work is submitted just in time for
+    /// the GPU to process it, rather than letting
+    /// it queue up behind previous frames.
+    bool lowLatency = false;
+  };
+
+
+  /**
+   * \brief Frame pacer statistics
+   *
+   * Averaged over the last few frames.
+   * All times are given in milliseconds.
+   */
+  struct DxvkFramePacerStats {
+    float cpuTime   = 0.0f; ///< Time spent by the application between presents
+    float gpuTime   = 0.0f; ///< Interval between two GPU frame completions
+    float waitTime  = 0.0f; ///< Time spent waiting for the GPU
+    float sleepTime = 0.0f; ///< Time spent sleeping in the pacer
+    float latency   = 0.0f; ///< Time from present call to GPU completion
+  };
+
+
+  /**
+   * \brief Frame pacer
+   *
+   * Controls when the presenter lets the application
+   * continue rendering. Frame completion times are
+   * taken from the frame events, which get signaled
+   * by the submission queue as soon as the GPU has
+   * finished rendering a frame.
+   *
+   * The limiter sleeps before presentation so that
+   * no more than the given number of frames are
+   * presented per second. In low-latency mode, the
+   * pacer also waits for the previous frame before
+   * presenting, and then delays the application
+   * after presentation until the GPU is about to
+   * become idle, so that the GPU queue stays short
+   * and input is sampled as late as possible.
+   *
+   * Sleeps use a high-resolution waitable timer where
+   * available. Otherwise, the pacer spins for up to one
+   * period of the default system timer, since regular
+   * sleeps are not accurate enough for frame pacing.
+   *
+   * Not thread-safe. All methods must be called
+   * from the thread which presents the frames.
+   */
+  class DxvkFramePacer : public RcObject {
+    using Clock     = DxvkEvent::Clock;
+    using TimePoint = DxvkEvent::TimePoint;
+    using Duration  = std::chrono::duration<double, std::milli>;
+  public:
+
+    DxvkFramePacer(
+      const DxvkFramePacerOptions&  options);
+
+    ~DxvkFramePacer();
+
+    /**
+     * \brief Pacer options
+     * \returns Pacer options
+     */
+    const DxvkFramePacerOptions& options() const {
+      return m_options;
+    }
+
+    /**
+     * \brief Pacer statistics
+     * \returns Averaged frame timings
+     */
+    DxvkFramePacerStats stats() const {
+      return m_stats;
+    }
+
+    /**
+     * \brief Waits until a frame can be presented
+     *
+     * Must be called at the start of the present
+     * operation. Waits for the given frame event,
+     * which enforces the maximum frame latency,
+     * and applies the frame rate limit.
+     * \param [in] frameEvent Frame sync event
+     */
+    void beginPresent(
+      const Rc<DxvkEvent>&          frameEvent);
+
+    /**
+     * \brief Finishes presentation
+     *
+     * Must be called after the present command list
+     * for the current frame has been submitted. The
+     * frame event must be signaled by that command
+     * list. In low-latency mode, this will delay the
+     * application by the estimated amount of time
+     * the GPU needs to catch up.
+     * \param [in] frameEvent Frame sync event
+     */
+    void endPresent(
+      const Rc<DxvkEvent>&          frameEvent);
+
+  private:
+
+    struct FrameEntry {
+      Rc<DxvkEvent> event;
+      TimePoint     presentTime;
+    };
+
+    DxvkFramePacerOptions   m_options;
+    DxvkFramePacerStats     m_stats;
+
+    std::vector<FrameEntry> m_frames;
+    Rc<DxvkEvent>           m_lastEvent;
+
+    TimePoint m_presentTime;
+    TimePoint m_frameEndTime;
+    TimePoint m_completionTime;
+    TimePoint m_nextFrameTime;
+
+    double m_latencySleep = 0.0;
+    double m_sleepTime    = 0.0;
+
+    HANDLE          m_timer = nullptr;
+    Clock::duration m_spinThreshold;
+
+    void processCompletion(
+      const Rc<DxvkEvent>&          event);
+
+    void limitFrameRate();
+
+    double sleepUntil(
+            TimePoint               time);
+
+    static void updateStat(
+            float&                  stat,
+            double                  value);
+
+  };
+
+}
@@ -2,15 +2,31 @@
 
 namespace dxvk {
   
+  DxvkFramebufferObject::DxvkFramebufferObject(
+    const Rc<vk::DeviceFn>&         vkd,
+    const VkFramebufferCreateInfo&  info)
+  : m_vkd(vkd) {
+    if (m_vkd->vkCreateFramebuffer(m_vkd->device(), &info, nullptr, &m_handle) != VK_SUCCESS)
+      Logger::err("DxvkFramebuffer: Failed to create framebuffer object");
+  }
+  
+  
+  DxvkFramebufferObject::~DxvkFramebufferObject() {
+    m_vkd->vkDestroyFramebuffer(m_vkd->device(), m_handle, nullptr);
+  }
+  
+  
   DxvkFramebuffer::DxvkFramebuffer(
-    const Rc<vk::DeviceFn>&       vkd,
-    const Rc<DxvkRenderPass>&     renderPass,
-    const DxvkRenderTargets&      renderTargets,
-    const DxvkFramebufferSize&    defaultSize)
+    const Rc<vk::DeviceFn>&           vkd,
+    const Rc<DxvkRenderPass>&         renderPass,
+    const DxvkRenderTargets&          renderTargets,
+    const DxvkFramebufferSize&        defaultSize,
+    const Rc<DxvkFramebufferObject>&  object)
   : m_vkd           (vkd),
     m_renderPass    (renderPass),
     m_renderTargets (renderTargets),
-    m_renderSize    (computeRenderSize(defaultSize)) {
+    m_renderSize    (computeRenderSize(defaultSize)),
+    m_object        (object) {
     std::array<VkImageView, MaxNumRenderTargets + 1> views;
     
     for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
@@ -27,6 +43,9 @@ namespace dxvk {
       m_attachmentCount += 1;
     }
     
+    if (m_object != nullptr)
+      return;
+    
     VkFramebufferCreateInfo info;
     info.sType                = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
     info.pNext                = nullptr;
@@ -38,13 +57,12 @@ namespace dxvk {
     info.height               = m_renderSize.height;
     info.layers               = m_renderSize.layers;
     
-    if (m_vkd->vkCreateFramebuffer(m_vkd->device(), &info, nullptr, &m_handle) != VK_SUCCESS)
-      Logger::err("DxvkFramebuffer: Failed to create framebuffer object");
+    m_object = new DxvkFramebufferObject(m_vkd, info);
   }
   
   
   DxvkFramebuffer::~DxvkFramebuffer() {
-    m_vkd->vkDestroyFramebuffer(m_vkd->device(), m_handle, nullptr);
+    
   }
   
   
@@ -125,4 +143,158 @@ namespace dxvk {
     return DxvkFramebufferSize { extent.width, extent.height, layers };
   }
   
-}
\ No newline at end of file
+  
+  
+  DxvkFramebufferKey::DxvkFramebufferKey(
+    const DxvkRenderTargets&  renderTargets) {
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      const DxvkAttachment& attachment = renderTargets.color[i];
+      
+      views  [i] = attachment.view != nullptr ? attachment.view->cookie() : 0;
+      layouts[i] = attachment.layout;
+    }
+    
+    const DxvkAttachment& depth = renderTargets.depth;
+    
+    views  [MaxNumRenderTargets] = depth.view != nullptr ? depth.view->cookie() : 0;
+    layouts[MaxNumRenderTargets] = depth.layout;
+  }
+  
+  
+  bool DxvkFramebufferKey::hasView(uint64_t cookie) const {
+    for (uint32_t i = 0; i < views.size(); i++) {
+      if (views[i] == cookie)
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
+  bool DxvkFramebufferKey::eq(const DxvkFramebufferKey& other) const {
+    bool eq = true;
+    
+    for (uint32_t i = 0; i < views.size() && eq; i++) {
+      eq &= views  [i] == other.views  [i]
+         && layouts[i] == other.layouts[i];
+    }
+    
+    return eq;
+  }
+  
+  
+  size_t DxvkFramebufferKey::hash() const {
+    std::hash<uint64_t> vhash;
+    
+    DxvkHashState state;
+    
+    for (uint32_t i = 0; i < views.size(); i++) {
+      state.add(vhash(views[i]));
+      state.add(uint32_t(layouts[i]));
+    }
+    
+    return state;
+  }
+  
+  
+  DxvkFramebufferCache::DxvkFramebufferCache(
+    const Rc<vk::DeviceFn>&       vkd,
+          DxvkRenderPassPool*     passPool,
+    const DxvkFramebufferSize&    defaultSize)
+  : m_vkd         (vkd),
+    m_passPool    (passPool),
+    m_defaultSize (defaultSize) {
+    
+  }
+  
+  
+  DxvkFramebufferCache::~DxvkFramebufferCache() {
+    
+  }
+  
+  
+  Rc<DxvkFramebuffer> DxvkFramebufferCache::getFramebuffer(
+    const DxvkRenderTargets&      renderTargets) {
+    DxvkFramebufferKey key(renderTargets);
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto entry = m_framebuffers.find(key);
+    
+    if (entry != m_framebuffers.end()) {
+      m_numHits += 1;
+      entry->second.lastUse = ++m_useCounter;
+      
+      return new DxvkFramebuffer(m_vkd,
+        entry->second.renderPass, renderTargets,
+        m_defaultSize, entry->second.object);
+    }
+    
+    m_numMisses += 1;
+    
+    // Make room for the new entry. Framebuffers that are
+    // in use keep their own reference to the object, so
+    // evicting recently used entries only costs a recreation.
+    if (m_framebuffers.size() >= MaxEntryCount)
+      removeOldestEntries(m_framebuffers.size() - MaxEntryCount / 2);
+    
+    auto renderPassFormat = DxvkFramebuffer::getRenderPassFormat(renderTargets);
+    auto renderPassObject = m_passPool->getRenderPass(renderPassFormat);
+    
+    Rc<DxvkFramebuffer> framebuffer = new DxvkFramebuffer(m_vkd,
+      renderPassObject, renderTargets, m_defaultSize, nullptr);
+    
+    m_framebuffers.insert({ key, { renderPassObject, framebuffer->object(), ++m_useCounter } });
+    
+    // Make sure that the views notify us when they
+    // get destroyed, so that we can remove the entry
+    for (uint32_t i = 0; i < framebuffer->numAttachments(); i++)
+      framebuffer->getAttachment(i).view->m_framebufferCache = this;
+    
+    return framebuffer;
+  }
+  
+  
+  void DxvkFramebufferCache::removeView(
+          uint64_t                cookie) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (auto entry = m_framebuffers.begin(); entry != m_framebuffers.end(); ) {
+      if (entry->first.hasView(cookie))
+        entry = m_framebuffers.erase(entry);
+      else
+        entry++;
+    }
+  }
+  
+  
+  DxvkFramebufferCacheStats DxvkFramebufferCache::getStats() const {
+    DxvkFramebufferCacheStats result;
+    result.numHits   = m_numHits.load();
+    result.numMisses = m_numMisses.load();
+    return result;
+  }
+  
+  
+  void DxvkFramebufferCache::removeOldestEntries(
+          size_t                  count) {
+    std::vector<uint64_t> lastUses;
+    lastUses.reserve(m_framebuffers.size());
+    
+    for (const auto& entry : m_framebuffers)
+      lastUses.push_back(entry.second.lastUse);
+    
+    // Use counters are unique, so this removes exactly
+    // the given number of least recently used entries
+    std::nth_element(lastUses.begin(), lastUses.begin() + (count - 1), lastUses.end());
+    uint64_t maxLastUse = lastUses[count - 1];
+    
+    for (auto entry = m_framebuffers.begin(); entry != m_framebuffers.end(); ) {
+      if (entry->second.lastUse <= maxLastUse)
+        entry = m_framebuffers.erase(entry);
+      else
+        entry++;
+    }
+  }
+  
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
 #include "dxvk_image.h"
 #include "dxvk_renderpass.h"
 
@@ -43,6 +48,40 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Framebuffer object
+   * 
+   * Owns a Vulkan framebuffer object. Unlike \ref
+   * DxvkFramebuffer, this does not keep any of the
+   * attachment views alive, so that it can be cached
+   * without extending the lifetime of the views.
+   */
+  class DxvkFramebufferObject : public RcObject {
+    
+  public:
+    
+    DxvkFramebufferObject(
+      const Rc<vk::DeviceFn>&         vkd,
+      const VkFramebufferCreateInfo&  info);
+    
+    ~DxvkFramebufferObject();
+    
+    /**
+     * \brief Framebuffer handle
+     * \returns Framebuffer handle
+     */
+    VkFramebuffer handle() const {
+      return m_handle;
+    }
+    
+  private:
+    
+    Rc<vk::DeviceFn>  m_vkd;
+    VkFramebuffer     m_handle = VK_NULL_HANDLE;
+    
+  };
+  
+  
   /**
    * \brief Framebuffer
    * 
@@ -54,11 +93,24 @@ namespace dxvk {
     
   public:
     
+    /**
+     * \brief Creates a framebuffer
+     * 
+     * If \c object is \c nullptr, a new Vulkan framebuffer
+     * object is created. Otherwise, the given object must
+     * have been created for the same render targets.
+     * \param [in] vkd Vulkan device functions
+     * \param [in] renderPass Default render pass
+     * \param [in] renderTargets Render targets
+     * \param [in] defaultSize Size if there are no targets
+     * \param [in] object Existing framebuffer object
+     */
     DxvkFramebuffer(
-      const Rc<vk::DeviceFn>&       vkd,
-      const Rc<DxvkRenderPass>&     renderPass,
-      const DxvkRenderTargets&      renderTargets,
-      const DxvkFramebufferSize&    defaultSize);
+      const Rc<vk::DeviceFn>&           vkd,
+      const Rc<DxvkRenderPass>&         renderPass,
+      const DxvkRenderTargets&          renderTargets,
+      const DxvkFramebufferSize&        defaultSize,
+      const Rc<DxvkFramebufferObject>&  object);
     
     ~DxvkFramebuffer();
     
@@ -67,7 +119,15 @@ namespace dxvk {
      * \returns Framebuffer handle
      */
     VkFramebuffer handle() const {
-      return m_handle;
+      return m_object->handle();
+    }
+    
+    /**
+     * \brief Framebuffer object
+     * \returns Framebuffer object
+     */
+    const Rc<DxvkFramebufferObject>& object() const {
+      return m_object;
     }
     
     /**
@@ -200,7 +260,7 @@ namespace dxvk {
     uint32_t                                                   m_attachmentCount = 0;
     std::array<const DxvkAttachment*, MaxNumRenderTargets + 1> m_attachments;
     
-    VkFramebuffer m_handle = VK_NULL_HANDLE;
+    Rc<DxvkFramebufferObject> m_object;
     
     DxvkFramebufferSize computeRenderSize(
       const DxvkFramebufferSize& defaultSize) const;
@@ -210,4 +270,121 @@ namespace dxvk {
     
   };
   
-}
\ No newline at end of file
+  
+  
+  /**
+   * \brief Framebuffer key
+   * 
+   * Identifies a framebuffer by the cookies of its
+   * attachment views and by their layouts. Unused
+   * attachments have a cookie of zero.
+   */
+  struct DxvkFramebufferKey {
+    DxvkFramebufferKey(
+      const DxvkRenderTargets&  renderTargets);
+    
+    std::array<uint64_t,      MaxNumRenderTargets + 1> views;
+    std::array<VkImageLayout, MaxNumRenderTargets + 1> layouts;
+    
+    bool hasView(uint64_t cookie) const;
+    
+    bool eq(const DxvkFramebufferKey& other) const;
+    
+    size_t hash() const;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache statistics
+   */
+  struct DxvkFramebufferCacheStats {
+    uint64_t numHits   = 0;
+    uint64_t numMisses = 0;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache entry
+   */
+  struct DxvkFramebufferCacheEntry {
+    Rc<DxvkRenderPass>        renderPass;
+    Rc<DxvkFramebufferObject> object;
+    uint64_t                  lastUse;
+  };
+  
+  
+  /**
+   * \brief Framebuffer cache
+   * 
+   * Stores framebuffer objects for previously used sets
+   * of render targets, so that rebinding the same render
+   * targets does not create a new Vulkan framebuffer.
+   * Cached objects do not keep their attachment views
+   * alive. Instead, entries are removed when any of
+   * their views gets destroyed. The number of entries
+   * is also limited, since long-lived views may be
+   * used in many different combinations.
+   */
+  class DxvkFramebufferCache : public RcObject {
+    /// Maximum number of cached framebuffers
+    constexpr static size_t MaxEntryCount = 1024;
+  public:
+    
+    DxvkFramebufferCache(
+      const Rc<vk::DeviceFn>&       vkd,
+            DxvkRenderPassPool*     passPool,
+      const DxvkFramebufferSize&    defaultSize);
+    
+    ~DxvkFramebufferCache();
+    
+    /**
+     * \brief Retrieves a framebuffer
+     * 
+     * Looks up a framebuffer for the given render
+     * targets, or creates one if necessary.
+     * \param [in] renderTargets Render targets
+     * \returns Matching framebuffer object
+     */
+    Rc<DxvkFramebuffer> getFramebuffer(
+      const DxvkRenderTargets&      renderTargets);
+    
+    /**
+     * \brief Removes framebuffers for a view
+     * 
+     * Called when an image view that has been
+     * used as a render target gets destroyed.
+     * \param [in] cookie The view's cookie
+     */
+    void removeView(
+            uint64_t                cookie);
+    
+    /**
+     * \brief Retrieves hit and miss counts
+     * \returns Framebuffer cache statistics
+     */
+    DxvkFramebufferCacheStats getStats() const;
+    
+  private:
+    
+    const Rc<vk::DeviceFn>    m_vkd;
+    DxvkRenderPassPool*       m_passPool;
+    DxvkFramebufferSize       m_defaultSize;
+    
+    std::mutex                m_mutex;
+    
+    std::unordered_map<
+      DxvkFramebufferKey,
+      DxvkFramebufferCacheEntry,
+      DxvkHash, DxvkEq>       m_framebuffers;
+    
+    uint64_t                  m_useCounter = 0;
+    
+    std::atomic<uint64_t>     m_numHits   = { 0ull };
+    std::atomic<uint64_t>     m_numMisses = { 0ull };
+    
+    void removeOldestEntries(
+            size_t                  count);
+    
+  };
+  
+}
@@ -3,6 +3,7 @@
 
 #include "dxvk_device.h"
 #include "dxvk_graphics.h"
+#include "dxvk_pipecompiler.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_spec_const.h"
 #include "dxvk_state_cache.h"
@@ -10,30 +11,56 @@
 namespace dxvk {
   
   DxvkGraphicsPipelineStateInfo::DxvkGraphicsPipelineStateInfo() {
-    std::memset(this, 0, sizeof(DxvkGraphicsPipelineStateInfo));
+    std::memset(reinterpret_cast<void*>(this), 0, sizeof(DxvkGraphicsPipelineStateInfo));
+    this->rehash();
   }
   
   
   DxvkGraphicsPipelineStateInfo::DxvkGraphicsPipelineStateInfo(
     const DxvkGraphicsPipelineStateInfo& other) {
-    std::memcpy(this, &other, sizeof(DxvkGraphicsPipelineStateInfo));
+    std::memcpy(reinterpret_cast<void*>(this), &other, sizeof(DxvkGraphicsPipelineStateInfo));
   }
   
   
   DxvkGraphicsPipelineStateInfo& DxvkGraphicsPipelineStateInfo::operator = (
     const DxvkGraphicsPipelineStateInfo& other) {
-    std::memcpy(this, &other, sizeof(DxvkGraphicsPipelineStateInfo));
+    std::memcpy(reinterpret_cast<void*>(this), &other, sizeof(DxvkGraphicsPipelineStateInfo));
     return *this;
   }
   
   
   bool DxvkGraphicsPipelineStateInfo::operator == (const DxvkGraphicsPipelineStateInfo& other) const {
-    return std::memcmp(this, &other, sizeof(DxvkGraphicsPipelineStateInfo)) == 0;
+    return m_hash == other.m_hash
+        && std::memcmp(this, &other, sizeof(DxvkGraphicsPipelineStateInfo)) == 0;
   }
   
   
   bool DxvkGraphicsPipelineStateInfo::operator != (const DxvkGraphicsPipelineStateInfo& other) const {
-    return std::memcmp(this, &other, sizeof(DxvkGraphicsPipelineStateInfo)) != 0;
+    return !this->operator == (other);
+  }
+  
+  
+  void DxvkGraphicsPipelineStateInfo::rehash() {
+    // The state vector is zero-initialized including any
+    // padding, so we can safely hash its raw contents.
+    static_assert(sizeof(DxvkGraphicsPipelineStateInfo) % sizeof(uint32_t) == 0);
+    
+    constexpr uint32_t WordCount = sizeof(DxvkGraphicsPipelineStateInfo) / sizeof(uint32_t);
+    
+    std::array<uint32_t, WordCount> words;
+    std::memcpy(words.data(), this, sizeof(DxvkGraphicsPipelineStateInfo));
+    
+    // Exclude the hash itself from the computation
+    const uint32_t hashIndex = uint32_t(
+      (reinterpret_cast<const char*>(&m_hash)
+     - reinterpret_cast<const char*>(this)) / sizeof(uint32_t));
+    
+    m_hash = 0;
+    
+    for (uint32_t i = 0; i < WordCount; i++) {
+      if (i != hashIndex && i != hashIndex + 1)
+        m_hash ^= hashWord(i, words[i]);
+    }
   }
   
   
@@ -76,22 +103,40 @@ namespace dxvk {
   
   
   DxvkGraphicsPipeline::~DxvkGraphicsPipeline() {
-    for (const auto& instance : m_pipelines)
-      this->destroyPipeline(instance.pipeline());
+    m_pipelines.forEach([this] (const std::unique_ptr<DxvkGraphicsPipelineInstance>& instance) {
+      this->destroyPipeline(instance->pipeline());
+    });
   }
   
   
   VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass&                renderPass) {
+    const DxvkRenderPass&                renderPass,
+          bool                           async) {
     VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    auto         instanceKey      = this->getInstanceKey(state, renderPassHandle);
+    
+    // Fast path, does not require any locking
+    auto instance = this->findInstance(instanceKey);
+    
+    if (instance != nullptr)
+      return instance->pipeline();
+    
+    // A draw is waiting on this pipeline, so any state cache
+    // entries for the same shaders are likely needed soon
+    if (async)
+      this->prioritizeStateCacheEntries();
     
     VkPipeline newPipelineBase   = VK_NULL_HANDLE;
     VkPipeline newPipelineHandle = VK_NULL_HANDLE;
 
+    bool queueCompilation = async && m_pipeMgr->m_compiler != nullptr;
+
     { std::lock_guard<sync::Spinlock> lock(m_mutex);
     
-      auto instance = this->findInstance(state, renderPassHandle);
+      // Another thread may have added the
+      // instance after our initial lookup
+      instance = this->findInstance(instanceKey);
       
       if (instance != nullptr)
         return instance->pipeline();
@@ -101,14 +146,29 @@ namespace dxvk {
       if (!this->validatePipelineState(state))
         return VK_NULL_HANDLE;
       
-      // If no pipeline instance exists with the given state
-      // vector, create a new one and add it to the list.
-      newPipelineBase   = m_basePipeline.load();
-      newPipelineHandle = this->compilePipeline(state, renderPassHandle, newPipelineBase);
+      if (queueCompilation) {
+        // Add a placeholder instance so that subsequent
+        // lookups don't queue the same pipeline again
+        this->insertInstance(instanceKey, VK_NULL_HANDLE);
+      } else {
+        // If no pipeline instance exists with the given state
+        // vector, create a new one and add it to the list.
+        newPipelineBase   = m_basePipeline.load();
+        newPipelineHandle = this->compilePipeline(state, renderPassHandle, newPipelineBase);
 
-      // Add new pipeline to the set
-      m_pipelines.emplace_back(state, renderPassHandle, newPipelineHandle);
-      m_pipeMgr->m_numGraphicsPipelines += 1;
+        // Add new pipeline to the set
+        instance = this->insertInstance(instanceKey, newPipelineHandle);
+        
+        if (newPipelineHandle != VK_NULL_HANDLE)
+          m_pipeMgr->m_numGraphicsPipelines += 1;
+        else
+          instance->setFailed();
+      }
+    }
+    
+    if (queueCompilation) {
+      m_pipeMgr->m_compiler->queueCompilation(this, state, &renderPass);
+      return VK_NULL_HANDLE;
     }
     
     // Use the new pipeline as the base pipeline for derivative pipelines
@@ -122,15 +182,79 @@ namespace dxvk {
   }
   
   
-  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
+  void DxvkGraphicsPipeline::compileInstance(
     const DxvkGraphicsPipelineStateInfo& state,
-          VkRenderPass                   renderPass) const {
-    for (const auto& instance : m_pipelines) {
-      if (instance.isCompatible(state, renderPass))
-        return &instance;
+    const DxvkRenderPass&                renderPass) {
+    VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    auto         instanceKey      = this->getInstanceKey(state, renderPassHandle);
+    
+    VkPipeline newPipelineBase   = m_basePipeline.load();
+    VkPipeline newPipelineHandle = this->compilePipeline(
+      state, renderPassHandle, newPipelineBase);
+    
+    auto instance = this->findInstance(instanceKey);
+    
+    if (newPipelineHandle == VK_NULL_HANDLE) {
+      // Don't keep draws waiting for a pipeline that
+      // will never become available
+      if (instance != nullptr)
+        instance->setFailed();
+      return;
     }
     
-    return nullptr;
+    if (instance != nullptr)
+      instance->setPipeline(newPipelineHandle);
+    
+    m_pipeMgr->m_numGraphicsPipelines += 1;
+    
+    if (newPipelineBase == VK_NULL_HANDLE)
+      m_basePipeline.compare_exchange_strong(newPipelineBase, newPipelineHandle);
+    
+    this->writePipelineStateToCache(state, renderPass.format());
+  }
+  
+  
+  bool DxvkGraphicsPipeline::isPipelinePending(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass&                renderPass) const {
+    VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    auto         instanceKey      = this->getInstanceKey(state, renderPassHandle);
+    
+    auto instance = this->findInstance(instanceKey);
+    return instance != nullptr && instance->isPending();
+  }
+  
+  
+  DxvkGraphicsPipelineInstanceKey DxvkGraphicsPipeline::getInstanceKey(
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass) const {
+    DxvkHashState hash;
+    hash.add(state.hash());
+    hash.add(std::hash<VkRenderPass>()(renderPass));
+    
+    DxvkGraphicsPipelineInstanceKey key;
+    key.stateVector = state;
+    key.renderPass  = renderPass;
+    key.stateHash   = hash;
+    return key;
+  }
+  
+  
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
+    const DxvkGraphicsPipelineInstanceKey& key) const {
+    auto instance = m_pipelines.find(key);
+    
+    return instance != nullptr
+      ? instance->get()
+      : nullptr;
+  }
+  
+  
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::insertInstance(
+    const DxvkGraphicsPipelineInstanceKey& key,
+          VkPipeline                     pipeline) {
+    return m_pipelines.insert(key,
+      std::make_unique<DxvkGraphicsPipelineInstance>(pipeline))->get();
   }
   
   
@@ -154,10 +278,10 @@ namespace dxvk {
     // Figure out the actual sample count to use
     VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
 
-    if (state.msSampleCount)
-      sampleCount = VkSampleCountFlagBits(state.msSampleCount);
-    else if (state.rsSampleCount)
-      sampleCount = VkSampleCountFlagBits(state.rsSampleCount);
+    if (state.ms.sampleCount())
+      sampleCount = VkSampleCountFlagBits(state.ms.sampleCount());
+    else if (state.rs.sampleCount())
+      sampleCount = VkSampleCountFlagBits(state.rs.sampleCount());
     
     // Set up some specialization constants
     DxvkSpecConstantData specData;
@@ -184,27 +308,38 @@ namespace dxvk {
     std::array<VkPipelineColorBlendAttachmentState, MaxNumRenderTargets> omBlendAttachments;
 
     for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-      omBlendAttachments[i] = state.omBlendAttachments[i];
+      const VkComponentMapping mapping = state.omSwizzle[i].mapping();
+      
+      omBlendAttachments[i] = state.omBlend[i].state();
       omBlendAttachments[i].colorWriteMask = util::remapComponentMask(
-        state.omBlendAttachments[i].colorWriteMask,
-        state.omComponentMapping[i]);
+        state.omBlend[i].colorWriteMask(), mapping);
       
-      specData.outputMappings[4 * i + 0] = util::getComponentIndex(state.omComponentMapping[i].r, 0);
-      specData.outputMappings[4 * i + 1] = util::getComponentIndex(state.omComponentMapping[i].g, 1);
-      specData.outputMappings[4 * i + 2] = util::getComponentIndex(state.omComponentMapping[i].b, 2);
-      specData.outputMappings[4 * i + 3] = util::getComponentIndex(state.omComponentMapping[i].a, 3);
+      specData.outputMappings[4 * i + 0] = util::getComponentIndex(mapping.r, 0);
+      specData.outputMappings[4 * i + 1] = util::getComponentIndex(mapping.g, 1);
+      specData.outputMappings[4 * i + 2] = util::getComponentIndex(mapping.b, 2);
+      specData.outputMappings[4 * i + 3] = util::getComponentIndex(mapping.a, 3);
     }
 
+    // Unpack vertex input state
+    std::array<VkVertexInputAttributeDescription, MaxNumVertexAttributes> viAttributes;
+    std::array<VkVertexInputBindingDescription,   MaxNumVertexBindings>   viBindings;
+    
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++)
+      viAttributes[i] = state.ilAttributes[i].description();
+    
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++)
+      viBindings[i] = state.ilBindings[i].description();
+    
     // Generate per-instance attribute divisors
     std::array<VkVertexInputBindingDivisorDescriptionEXT, MaxNumVertexBindings> viDivisorDesc;
     uint32_t                                                                    viDivisorCount = 0;
     
-    for (uint32_t i = 0; i < state.ilBindingCount; i++) {
-      if (state.ilBindings[i].inputRate == VK_VERTEX_INPUT_RATE_INSTANCE) {
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
+      if (state.ilBindings[i].inputRate() == VK_VERTEX_INPUT_RATE_INSTANCE) {
         const uint32_t id = viDivisorCount++;
         
-        viDivisorDesc[id].binding = state.ilBindings[i].binding;
-        viDivisorDesc[id].divisor = state.ilDivisors[i];
+        viDivisorDesc[id].binding = state.ilBindings[i].binding();
+        viDivisorDesc[id].divisor = state.ilBindings[i].divisor();
       }
     }
     
@@ -218,10 +353,10 @@ namespace dxvk {
     viInfo.sType                            = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     viInfo.pNext                            = &viDivisorInfo;
     viInfo.flags                            = 0;
-    viInfo.vertexBindingDescriptionCount    = state.ilBindingCount;
-    viInfo.pVertexBindingDescriptions       = state.ilBindings;
-    viInfo.vertexAttributeDescriptionCount  = state.ilAttributeCount;
-    viInfo.pVertexAttributeDescriptions     = state.ilAttributes;
+    viInfo.vertexBindingDescriptionCount    = state.il.bindingCount();
+    viInfo.pVertexBindingDescriptions       = viBindings.data();
+    viInfo.vertexAttributeDescriptionCount  = state.il.attributeCount();
+    viInfo.pVertexAttributeDescriptions     = viAttributes.data();
     
     if (viDivisorCount == 0)
       viInfo.pNext = viDivisorInfo.pNext;
@@ -234,39 +369,41 @@ namespace dxvk {
     iaInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     iaInfo.pNext                  = nullptr;
     iaInfo.flags                  = 0;
-    iaInfo.topology               = state.iaPrimitiveTopology;
-    iaInfo.primitiveRestartEnable = state.iaPrimitiveRestart;
+    iaInfo.topology               = state.ia.primitiveTopology();
+    iaInfo.primitiveRestartEnable = state.ia.primitiveRestart();
     
     VkPipelineTessellationStateCreateInfo tsInfo;
     tsInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
     tsInfo.pNext                  = nullptr;
     tsInfo.flags                  = 0;
-    tsInfo.patchControlPoints     = state.iaPatchVertexCount;
+    tsInfo.patchControlPoints     = state.ia.patchVertexCount();
     
     VkPipelineViewportStateCreateInfo vpInfo;
     vpInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     vpInfo.pNext                  = nullptr;
     vpInfo.flags                  = 0;
-    vpInfo.viewportCount          = state.rsViewportCount;
+    vpInfo.viewportCount          = state.rs.viewportCount();
     vpInfo.pViewports             = nullptr;
-    vpInfo.scissorCount           = state.rsViewportCount;
+    vpInfo.scissorCount           = state.rs.viewportCount();
     vpInfo.pScissors              = nullptr;
     
     VkPipelineRasterizationStateCreateInfo rsInfo;
     rsInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rsInfo.pNext                  = nullptr;
     rsInfo.flags                  = 0;
-    rsInfo.depthClampEnable       = state.rsDepthClampEnable;
+    rsInfo.depthClampEnable       = state.rs.depthClampEnable();
     rsInfo.rasterizerDiscardEnable= VK_FALSE;
-    rsInfo.polygonMode            = state.rsPolygonMode;
-    rsInfo.cullMode               = state.rsCullMode;
-    rsInfo.frontFace              = state.rsFrontFace;
-    rsInfo.depthBiasEnable        = state.rsDepthBiasEnable;
+    rsInfo.polygonMode            = state.rs.polygonMode();
+    rsInfo.cullMode               = state.rs.cullMode();
+    rsInfo.frontFace              = state.rs.frontFace();
+    rsInfo.depthBiasEnable        = state.rs.depthBiasEnable();
     rsInfo.depthBiasConstantFactor= 0.0f;
     rsInfo.depthBiasClamp         = 0.0f;
     rsInfo.depthBiasSlopeFactor   = 0.0f;
     rsInfo.lineWidth              = 1.0f;
     
+    uint32_t msSampleMask = state.ms.sampleMask();
+    
     VkPipelineMultisampleStateCreateInfo msInfo;
     msInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     msInfo.pNext                  = nullptr;
@@ -274,21 +411,21 @@ namespace dxvk {
     msInfo.rasterizationSamples   = sampleCount;
     msInfo.sampleShadingEnable    = m_common.msSampleShadingEnable;
     msInfo.minSampleShading       = m_common.msSampleShadingFactor;
-    msInfo.pSampleMask            = &state.msSampleMask;
-    msInfo.alphaToCoverageEnable  = state.msEnableAlphaToCoverage;
-    msInfo.alphaToOneEnable       = state.msEnableAlphaToOne;
+    msInfo.pSampleMask            = &msSampleMask;
+    msInfo.alphaToCoverageEnable  = state.ms.enableAlphaToCoverage();
+    msInfo.alphaToOneEnable       = state.ms.enableAlphaToOne();
     
     VkPipelineDepthStencilStateCreateInfo dsInfo;
     dsInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     dsInfo.pNext                  = nullptr;
     dsInfo.flags                  = 0;
-    dsInfo.depthTestEnable        = state.dsEnableDepthTest;
-    dsInfo.depthWriteEnable       = state.dsEnableDepthWrite;
-    dsInfo.depthCompareOp         = state.dsDepthCompareOp;
+    dsInfo.depthTestEnable        = state.ds.enableDepthTest();
+    dsInfo.depthWriteEnable       = state.ds.enableDepthWrite();
+    dsInfo.depthCompareOp         = state.ds.depthCompareOp();
     dsInfo.depthBoundsTestEnable  = VK_FALSE;
-    dsInfo.stencilTestEnable      = state.dsEnableStencilTest;
-    dsInfo.front                  = state.dsStencilOpFront;
-    dsInfo.back                   = state.dsStencilOpBack;
+    dsInfo.stencilTestEnable      = state.ds.enableStencilTest();
+    dsInfo.front                  = state.dsFront.state();
+    dsInfo.back                   = state.dsBack.state();
     dsInfo.minDepthBounds         = 0.0f;
     dsInfo.maxDepthBounds         = 1.0f;
     
@@ -296,8 +433,8 @@ namespace dxvk {
     cbInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     cbInfo.pNext                  = nullptr;
     cbInfo.flags                  = 0;
-    cbInfo.logicOpEnable          = state.omEnableLogicOp;
-    cbInfo.logicOp                = state.omLogicOp;
+    cbInfo.logicOpEnable          = state.om.enableLogicOp();
+    cbInfo.logicOp                = state.om.logicOp();
     cbInfo.attachmentCount        = DxvkLimits::MaxNumRenderTargets;
     cbInfo.pAttachments           = omBlendAttachments.data();
     
@@ -353,6 +490,9 @@ namespace dxvk {
     auto t1 = std::chrono::high_resolution_clock::now();
     auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
     Logger::debug(str::format("DxvkGraphicsPipeline: Finished in ", td.count(), " ms"));
+    
+    m_pipeMgr->m_device->timings()->addTime(
+      DxvkTimingStage::PipelineCompile, t1 - t0);
     return pipeline;
   }
   
@@ -368,20 +508,20 @@ namespace dxvk {
     // vertex shader must be provided by the input layout.
     uint32_t providedVertexInputs = 0;
     
-    for (uint32_t i = 0; i < state.ilAttributeCount; i++)
-      providedVertexInputs |= 1u << state.ilAttributes[i].location;
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++)
+      providedVertexInputs |= 1u << state.ilAttributes[i].location();
     
     if ((providedVertexInputs & m_vsIn) != m_vsIn)
       return false;
     
     // If there are no tessellation shaders, we
     // obviously cannot use tessellation patches.
-    if ((state.iaPatchVertexCount != 0) && (m_tcs == nullptr || m_tes == nullptr))
+    if ((state.ia.patchVertexCount() != 0) && (m_tcs == nullptr || m_tes == nullptr))
       return false;
     
     // Prevent unintended out-of-bounds access to the IL arrays
-    if (state.ilAttributeCount > DxvkLimits::MaxNumVertexAttributes
-     || state.ilBindingCount   > DxvkLimits::MaxNumVertexBindings)
+    if (state.il.attributeCount() > DxvkLimits::MaxNumVertexAttributes
+     || state.il.bindingCount()   > DxvkLimits::MaxNumVertexBindings)
       return false;
     
     // No errors
@@ -389,20 +529,34 @@ namespace dxvk {
   }
   
   
-  void DxvkGraphicsPipeline::writePipelineStateToCache(
-    const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPassFormat&          format) const {
-    if (m_pipeMgr->m_stateCache == nullptr)
-      return;
-    
+  DxvkStateCacheKey DxvkGraphicsPipeline::getStateCacheKey() const {
     DxvkStateCacheKey key;
     if (m_vs  != nullptr) key.vs = m_vs->getShaderKey();
     if (m_tcs != nullptr) key.tcs = m_tcs->getShaderKey();
     if (m_tes != nullptr) key.tes = m_tes->getShaderKey();
     if (m_gs  != nullptr) key.gs = m_gs->getShaderKey();
     if (m_fs  != nullptr) key.fs = m_fs->getShaderKey();
-
-    m_pipeMgr->m_stateCache->addGraphicsPipeline(key, state, format);
+    return key;
+  }
+  
+  
+  void DxvkGraphicsPipeline::prioritizeStateCacheEntries() const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+    
+    m_pipeMgr->m_stateCache->prioritizePipeline(
+      this->getStateCacheKey());
+  }
+  
+  
+  void DxvkGraphicsPipeline::writePipelineStateToCache(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPassFormat&          format) const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+    
+    m_pipeMgr->m_stateCache->addGraphicsPipeline(
+      this->getStateCacheKey(), state, format);
   }
   
   
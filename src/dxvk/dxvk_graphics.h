@@ -1,9 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 
 #include "dxvk_bind_mask.h"
 #include "dxvk_constant_state.h"
+#include "dxvk_graphics_state.h"
+#include "dxvk_hash.h"
 #include "dxvk_pipecache.h"
 #include "dxvk_pipelayout.h"
 #include "dxvk_renderpass.h"
@@ -15,64 +19,7 @@ namespace dxvk {
   
   class DxvkDevice;
   class DxvkPipelineManager;
-  
-  /**
-   * \brief Graphics pipeline state info
-   * 
-   * Stores all information that is required to create
-   * a graphics pipeline, except the shader objects
-   * themselves. Also used to identify pipelines using
-   * the current pipeline state vector.
-   */
-  struct DxvkGraphicsPipelineStateInfo {
-    DxvkGraphicsPipelineStateInfo();
-    DxvkGraphicsPipelineStateInfo(
-      const DxvkGraphicsPipelineStateInfo& other);
-    
-    DxvkGraphicsPipelineStateInfo& operator = (
-      const DxvkGraphicsPipelineStateInfo& other);
-    
-    bool operator == (const DxvkGraphicsPipelineStateInfo& other) const;
-    bool operator != (const DxvkGraphicsPipelineStateInfo& other) const;
-    
-    DxvkBindingMask                     bsBindingMask;
-    
-    VkPrimitiveTopology                 iaPrimitiveTopology;
-    VkBool32                            iaPrimitiveRestart;
-    uint32_t                            iaPatchVertexCount;
-    
-    uint32_t                            ilAttributeCount;
-    uint32_t                            ilBindingCount;
-    VkVertexInputAttributeDescription   ilAttributes[DxvkLimits::MaxNumVertexAttributes];
-    VkVertexInputBindingDescription     ilBindings[DxvkLimits::MaxNumVertexBindings];
-    uint32_t                            ilDivisors[DxvkLimits::MaxNumVertexBindings];
-    
-    VkBool32                            rsDepthClampEnable;
-    VkBool32                            rsDepthBiasEnable;
-    VkPolygonMode                       rsPolygonMode;
-    VkCullModeFlags                     rsCullMode;
-    VkFrontFace                         rsFrontFace;
-    uint32_t                            rsViewportCount;
-    VkSampleCountFlags                  rsSampleCount;
-    
-    VkSampleCountFlags                  msSampleCount;
-    uint32_t                            msSampleMask;
-    VkBool32                            msEnableAlphaToCoverage;
-    VkBool32                            msEnableAlphaToOne;
-    
-    VkBool32                            dsEnableDepthTest;
-    VkBool32                            dsEnableDepthWrite;
-    VkBool32                            dsEnableStencilTest;
-    VkCompareOp                         dsDepthCompareOp;
-    VkStencilOpState                    dsStencilOpFront;
-    VkStencilOpState                    dsStencilOpBack;
-    
-    VkBool32                            omEnableLogicOp;
-    VkLogicOp                           omLogicOp;
-    VkPipelineColorBlendAttachmentState omBlendAttachments[MaxNumRenderTargets];
-    VkComponentMapping                  omComponentMapping[MaxNumRenderTargets];
-  };
-  
+  struct DxvkStateCacheKey;
   
   /**
    * \brief Common graphics pipeline state
@@ -86,52 +33,92 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Graphics pipeline instance key
+   * 
+   * Identifies a pipeline instance by its state
+   * vector and render pass. The hash is computed
+   * once by the pipeline and stored in the key.
+   */
+  struct DxvkGraphicsPipelineInstanceKey {
+    DxvkGraphicsPipelineStateInfo stateVector;
+    VkRenderPass                  renderPass;
+    size_t                        stateHash;
+
+    bool eq(const DxvkGraphicsPipelineInstanceKey& other) const {
+      return stateHash   == other.stateHash
+          && renderPass  == other.renderPass
+          && stateVector == other.stateVector;
+    }
+
+    size_t hash() const {
+      return stateHash;
+    }
+  };
+
+
   /**
    * \brief Graphics pipeline instance
    * 
-   * Stores a state vector and the
-   * corresponding pipeline handle.
+   * Stores the pipeline handle for a given
+   * state vector and render pass.
    */
   class DxvkGraphicsPipelineInstance {
 
   public:
 
-    DxvkGraphicsPipelineInstance() { }
     DxvkGraphicsPipelineInstance(
-      const DxvkGraphicsPipelineStateInfo&  state,
-            VkRenderPass                    rp,
             VkPipeline                      pipe)
-    : m_stateVector (state),
-      m_renderPass  (rp),
-      m_pipeline    (pipe) { }
+    : m_pipeline(pipe) { }
 
     /**
-     * \brief Checks for matching pipeline state
+     * \brief Sets the pipeline handle
      * 
-     * \param [in] stateVector Graphics pipeline state
-     * \param [in] renderPass Render pass handle
-     * \returns \c true if the specialization is compatible
+     * Used to fill in the handle of an instance
+     * that was compiled asynchronously.
+     * \param [in] pipe The pipeline handle
      */
-    bool isCompatible(
-      const DxvkGraphicsPipelineStateInfo&  state,
-            VkRenderPass                    rp) const {
-      return m_stateVector == state
-          && m_renderPass  == rp;
+    void setPipeline(VkPipeline pipe) {
+      m_pipeline.store(pipe, std::memory_order_release);
     }
 
     /**
      * \brief Retrieves pipeline
+     * 
+     * May be \c VK_NULL_HANDLE if the pipeline is
+     * still being compiled asynchronously.
      * \returns The pipeline handle
      */
     VkPipeline pipeline() const {
-      return m_pipeline;
+      return m_pipeline.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Marks the instance as failed
+     * 
+     * Used when the pipeline could not be compiled, so
+     * that draws using this state are no longer treated
+     * as waiting for the pipeline.
+     */
+    void setFailed() {
+      m_failed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * \brief Checks whether the pipeline is pending
+     * 
+     * \returns \c true if the pipeline is still being
+     *          compiled and compilation has not failed
+     */
+    bool isPending() const {
+      return !m_failed.load(std::memory_order_acquire)
+          && this->pipeline() == VK_NULL_HANDLE;
     }
 
   private:
 
-    DxvkGraphicsPipelineStateInfo m_stateVector;
-    VkRenderPass                  m_renderPass;
-    VkPipeline                    m_pipeline;
+    std::atomic<VkPipeline>       m_pipeline;
+    std::atomic<bool>             m_failed = { false };
 
   };
 
@@ -173,14 +160,53 @@ namespace dxvk {
      * 
      * Retrieves a pipeline handle for the given pipeline
      * state. If necessary, a new pipeline will be created.
+     * 
+     * If \c async is set and the device has asynchronous
+     * pipeline compilation enabled, a missing pipeline
+     * will be queued for compilation and this returns
+     * \c VK_NULL_HANDLE until the pipeline is ready.
+     * 
+     * Draw-time lookups pass \c async as \c true. When
+     * such a lookup misses, state cache entries for this
+     * pipeline's shaders are moved to the front of the
+     * state cache compiler queue.
      * \param [in] state Pipeline state vector
      * \param [in] renderPass The render pass
+     * \param [in] async Allow asynchronous compilation
      * \returns Pipeline handle
      */
     VkPipeline getPipelineHandle(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass&                   renderPass,
+            bool                              async);
+    
+    /**
+     * \brief Compiles a queued pipeline instance
+     * 
+     * Called by the asynchronous pipeline compiler
+     * for state vectors that were previously queued
+     * by \ref getPipelineHandle.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     */
+    void compileInstance(
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass&                   renderPass);
     
+    /**
+     * \brief Checks whether a pipeline is pending
+     * 
+     * Used to distinguish pipelines that are still being
+     * compiled asynchronously from pipelines that failed
+     * to compile or have an invalid state vector.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \returns \c true if the pipeline is being compiled
+     */
+    bool isPipelinePending(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass&                   renderPass) const;
+    
   private:
     
     struct PipelineStruct {
@@ -204,17 +230,28 @@ namespace dxvk {
     
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    // List of pipeline instances, shared between threads
+    // Pipeline instances, shared between threads. The
+    // lock is only required when adding new instances.
     alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
-    std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
+    
+    DxvkHashTable<
+      DxvkGraphicsPipelineInstanceKey,
+      std::unique_ptr<DxvkGraphicsPipelineInstance>> m_pipelines;
     
     // Pipeline handles used for derivative pipelines
     std::atomic<VkPipeline> m_basePipeline = { VK_NULL_HANDLE };
     
-    const DxvkGraphicsPipelineInstance* findInstance(
+    DxvkGraphicsPipelineInstanceKey getInstanceKey(
       const DxvkGraphicsPipelineStateInfo& state,
             VkRenderPass                   renderPass) const;
     
+    DxvkGraphicsPipelineInstance* findInstance(
+      const DxvkGraphicsPipelineInstanceKey& key) const;
+    
+    DxvkGraphicsPipelineInstance* insertInstance(
+      const DxvkGraphicsPipelineInstanceKey& key,
+            VkPipeline                     pipeline);
+    
     VkPipeline compilePipeline(
       const DxvkGraphicsPipelineStateInfo& state,
             VkRenderPass                   renderPass,
@@ -226,6 +263,10 @@ namespace dxvk {
     bool validatePipelineState(
       const DxvkGraphicsPipelineStateInfo& state) const;
     
+    DxvkStateCacheKey getStateCacheKey() const;
+    
+    void prioritizeStateCacheEntries() const;
+    
     void writePipelineStateToCache(
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPassFormat&          format) const;
@@ -0,0 +1,752 @@
+#pragma once
+
+#include <cstring>
+
+#include "dxvk_bind_mask.h"
+#include "dxvk_limits.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Packed input assembly state
+   *
+   * Stores the primitive topology, primitive
+   * restart info and patch vertex count.
+   */
+  class DxvkIaInfo {
+
+  public:
+
+    DxvkIaInfo()
+    : m_primitiveTopology (0),
+      m_primitiveRestart  (0),
+      m_patchVertexCount  (0),
+      m_reserved          (0) { }
+
+    DxvkIaInfo(
+            VkPrimitiveTopology primitiveTopology,
+            VkBool32            primitiveRestart,
+            uint32_t            patchVertexCount)
+    : m_primitiveTopology (uint32_t(primitiveTopology)),
+      m_primitiveRestart  (uint32_t(primitiveRestart)),
+      m_patchVertexCount  (patchVertexCount),
+      m_reserved          (0) { }
+
+    VkPrimitiveTopology primitiveTopology() const {
+      return VkPrimitiveTopology(m_primitiveTopology);
+    }
+
+    VkBool32 primitiveRestart() const {
+      return VkBool32(m_primitiveRestart);
+    }
+
+    uint32_t patchVertexCount() const {
+      return m_patchVertexCount;
+    }
+
+  private:
+
+    uint32_t m_primitiveTopology      : 4;
+    uint32_t m_primitiveRestart       : 1;
+    uint32_t m_patchVertexCount       : 6;
+    uint32_t m_reserved               : 21;
+
+  };
+
+
+  /**
+   * \brief Packed input layout info
+   *
+   * Stores the number of active vertex
+   * attributes and vertex bindings.
+   */
+  class DxvkIlInfo {
+
+  public:
+
+    DxvkIlInfo()
+    : m_attributeCount  (0),
+      m_bindingCount    (0),
+      m_reserved        (0) { }
+
+    DxvkIlInfo(
+            uint32_t            attributeCount,
+            uint32_t            bindingCount)
+    : m_attributeCount  (attributeCount),
+      m_bindingCount    (bindingCount),
+      m_reserved        (0) { }
+
+    uint32_t attributeCount() const {
+      return m_attributeCount;
+    }
+
+    uint32_t bindingCount() const {
+      return m_bindingCount;
+    }
+
+  private:
+
+    uint32_t m_attributeCount         : 6;
+    uint32_t m_bindingCount           : 6;
+    uint32_t m_reserved               : 20;
+
+  };
+
+
+  /**
+   * \brief Packed vertex attribute
+   *
+   * Only core vertex formats are supported,
+   * which fit into eight bits.
+   */
+  class DxvkIlAttribute {
+
+  public:
+
+    DxvkIlAttribute()
+    : m_location  (0),
+      m_binding   (0),
+      m_format    (0),
+      m_offset    (0) { }
+
+    DxvkIlAttribute(
+            uint32_t            location,
+            uint32_t            binding,
+            VkFormat            format,
+            uint32_t            offset)
+    : m_location  (location),
+      m_binding   (binding),
+      m_format    (uint32_t(format)),
+      m_offset    (offset) { }
+
+    uint32_t location() const {
+      return m_location;
+    }
+
+    uint32_t binding() const {
+      return m_binding;
+    }
+
+    VkFormat format() const {
+      return VkFormat(m_format);
+    }
+
+    uint32_t offset() const {
+      return m_offset;
+    }
+
+    VkVertexInputAttributeDescription description() const {
+      VkVertexInputAttributeDescription result;
+      result.location = m_location;
+      result.binding  = m_binding;
+      result.format   = VkFormat(m_format);
+      result.offset   = m_offset;
+      return result;
+    }
+
+  private:
+
+    uint32_t m_location               : 5;
+    uint32_t m_binding                : 5;
+    uint32_t m_format                 : 8;
+    uint32_t m_offset                 : 14;
+
+  };
+
+
+  /**
+   * \brief Packed vertex binding
+   *
+   * Stores the binding description as well
+   * as the instance step rate, if any.
+   */
+  class DxvkIlBinding {
+
+  public:
+
+    DxvkIlBinding()
+    : m_binding   (0),
+      m_inputRate (0),
+      m_stride    (0),
+      m_reserved  (0),
+      m_divisor   (0) { }
+
+    DxvkIlBinding(
+            uint32_t            binding,
+            uint32_t            stride,
+            VkVertexInputRate   inputRate,
+            uint32_t            divisor)
+    : m_binding   (binding),
+      m_inputRate (uint32_t(inputRate)),
+      m_stride    (stride),
+      m_reserved  (0),
+      m_divisor   (divisor) { }
+
+    uint32_t binding() const {
+      return m_binding;
+    }
+
+    uint32_t stride() const {
+      return m_stride;
+    }
+
+    VkVertexInputRate inputRate() const {
+      return VkVertexInputRate(m_inputRate);
+    }
+
+    uint32_t divisor() const {
+      return m_divisor;
+    }
+
+    VkVertexInputBindingDescription description() const {
+      VkVertexInputBindingDescription result;
+      result.binding   = m_binding;
+      result.stride    = m_stride;
+      result.inputRate = VkVertexInputRate(m_inputRate);
+      return result;
+    }
+
+  private:
+
+    uint32_t m_binding                : 5;
+    uint32_t m_inputRate              : 1;
+    uint32_t m_stride                 : 14;
+    uint32_t m_reserved               : 12;
+    uint32_t m_divisor;
+
+  };
+
+
+  /**
+   * \brief Packed rasterizer state
+   */
+  class DxvkRsInfo {
+
+  public:
+
+    DxvkRsInfo()
+    : m_depthClampEnable  (0),
+      m_depthBiasEnable   (0),
+      m_polygonMode       (0),
+      m_cullMode          (0),
+      m_frontFace         (0),
+      m_viewportCount     (0),
+      m_sampleCount       (0),
+      m_reserved          (0) { }
+
+    DxvkRsInfo(
+            VkBool32            depthClampEnable,
+            VkBool32            depthBiasEnable,
+            VkPolygonMode       polygonMode,
+            VkCullModeFlags     cullMode,
+            VkFrontFace         frontFace,
+            uint32_t            viewportCount,
+            VkSampleCountFlags  sampleCount)
+    : m_depthClampEnable  (uint32_t(depthClampEnable)),
+      m_depthBiasEnable   (uint32_t(depthBiasEnable)),
+      m_polygonMode       (uint32_t(polygonMode)),
+      m_cullMode          (uint32_t(cullMode)),
+      m_frontFace         (uint32_t(frontFace)),
+      m_viewportCount     (viewportCount),
+      m_sampleCount       (uint32_t(sampleCount)),
+      m_reserved          (0) { }
+
+    VkBool32 depthClampEnable() const {
+      return VkBool32(m_depthClampEnable);
+    }
+
+    VkBool32 depthBiasEnable() const {
+      return VkBool32(m_depthBiasEnable);
+    }
+
+    VkPolygonMode polygonMode() const {
+      return VkPolygonMode(m_polygonMode);
+    }
+
+    VkCullModeFlags cullMode() const {
+      return VkCullModeFlags(m_cullMode);
+    }
+
+    VkFrontFace frontFace() const {
+      return VkFrontFace(m_frontFace);
+    }
+
+    uint32_t viewportCount() const {
+      return m_viewportCount;
+    }
+
+    VkSampleCountFlags sampleCount() const {
+      return VkSampleCountFlags(m_sampleCount);
+    }
+
+  private:
+
+    uint32_t m_depthClampEnable       : 1;
+    uint32_t m_depthBiasEnable        : 1;
+    uint32_t m_polygonMode            : 2;
+    uint32_t m_cullMode               : 2;
+    uint32_t m_frontFace              : 1;
+    uint32_t m_viewportCount          : 5;
+    uint32_t m_sampleCount            : 7;
+    uint32_t m_reserved               : 13;
+
+  };
+
+
+  /**
+   * \brief Packed multisample state
+   */
+  class DxvkMsInfo {
+
+  public:
+
+    DxvkMsInfo()
+    : m_sampleCount           (0),
+      m_enableAlphaToCoverage (0),
+      m_enableAlphaToOne      (0),
+      m_reserved              (0),
+      m_sampleMask            (0) { }
+
+    DxvkMsInfo(
+            VkSampleCountFlags  sampleCount,
+            uint32_t            sampleMask,
+            VkBool32            enableAlphaToCoverage,
+            VkBool32            enableAlphaToOne)
+    : m_sampleCount           (uint32_t(sampleCount)),
+      m_enableAlphaToCoverage (uint32_t(enableAlphaToCoverage)),
+      m_enableAlphaToOne      (uint32_t(enableAlphaToOne)),
+      m_reserved              (0),
+      m_sampleMask            (sampleMask) { }
+
+    VkSampleCountFlags sampleCount() const {
+      return VkSampleCountFlags(m_sampleCount);
+    }
+
+    uint32_t sampleMask() const {
+      return m_sampleMask;
+    }
+
+    VkBool32 enableAlphaToCoverage() const {
+      return VkBool32(m_enableAlphaToCoverage);
+    }
+
+    VkBool32 enableAlphaToOne() const {
+      return VkBool32(m_enableAlphaToOne);
+    }
+
+  private:
+
+    uint32_t m_sampleCount            : 7;
+    uint32_t m_enableAlphaToCoverage  : 1;
+    uint32_t m_enableAlphaToOne       : 1;
+    uint32_t m_reserved               : 23;
+    uint32_t m_sampleMask;
+
+  };
+
+
+  /**
+   * \brief Packed depth test state
+   */
+  class DxvkDsInfo {
+
+  public:
+
+    DxvkDsInfo()
+    : m_enableDepthTest   (0),
+      m_enableDepthWrite  (0),
+      m_enableStencilTest (0),
+      m_depthCompareOp    (0),
+      m_reserved          (0) { }
+
+    DxvkDsInfo(
+            VkBool32            enableDepthTest,
+            VkBool32            enableDepthWrite,
+            VkBool32            enableStencilTest,
+            VkCompareOp         depthCompareOp)
+    : m_enableDepthTest   (uint32_t(enableDepthTest)),
+      m_enableDepthWrite  (uint32_t(enableDepthWrite)),
+      m_enableStencilTest (uint32_t(enableStencilTest)),
+      m_depthCompareOp    (uint32_t(depthCompareOp)),
+      m_reserved          (0) { }
+
+    VkBool32 enableDepthTest() const {
+      return VkBool32(m_enableDepthTest);
+    }
+
+    VkBool32 enableDepthWrite() const {
+      return VkBool32(m_enableDepthWrite);
+    }
+
+    VkBool32 enableStencilTest() const {
+      return VkBool32(m_enableStencilTest);
+    }
+
+    VkCompareOp depthCompareOp() const {
+      return VkCompareOp(m_depthCompareOp);
+    }
+
+  private:
+
+    uint32_t m_enableDepthTest        : 1;
+    uint32_t m_enableDepthWrite       : 1;
+    uint32_t m_enableStencilTest      : 1;
+    uint32_t m_depthCompareOp         : 3;
+    uint32_t m_reserved               : 26;
+
+  };
+
+
+  /**
+   * \brief Packed stencil op
+   *
+   * The stencil reference is dynamic state and
+   * therefore not stored. Compare and write masks
+   * are limited to eight bits.
+   */
+  class DxvkDsStencilOp {
+
+  public:
+
+    DxvkDsStencilOp()
+    : m_failOp      (0),
+      m_passOp      (0),
+      m_depthFailOp (0),
+      m_compareOp   (0),
+      m_compareMask (0),
+      m_writeMask   (0),
+      m_reserved    (0) { }
+
+    DxvkDsStencilOp(
+      const VkStencilOpState&   state)
+    : m_failOp      (uint32_t(state.failOp)),
+      m_passOp      (uint32_t(state.passOp)),
+      m_depthFailOp (uint32_t(state.depthFailOp)),
+      m_compareOp   (uint32_t(state.compareOp)),
+      m_compareMask (state.compareMask),
+      m_writeMask   (state.writeMask),
+      m_reserved    (0) { }
+
+    VkStencilOpState state() const {
+      VkStencilOpState result;
+      result.failOp      = VkStencilOp(m_failOp);
+      result.passOp      = VkStencilOp(m_passOp);
+      result.depthFailOp = VkStencilOp(m_depthFailOp);
+      result.compareOp   = VkCompareOp(m_compareOp);
+      result.compareMask = m_compareMask;
+      result.writeMask   = m_writeMask;
+      result.reference   = 0;
+      return result;
+    }
+
+  private:
+
+    uint32_t m_failOp                 : 3;
+    uint32_t m_passOp                 : 3;
+    uint32_t m_depthFailOp            : 3;
+    uint32_t m_compareOp              : 3;
+    uint32_t m_compareMask            : 8;
+    uint32_t m_writeMask              : 8;
+    uint32_t m_reserved               : 4;
+
+  };
+
+
+  /**
+   * \brief Packed output merger state
+   */
+  class DxvkOmInfo {
+
+  public:
+
+    DxvkOmInfo()
+    : m_enableLogicOp (0),
+      m_logicOp       (0),
+      m_reserved      (0) { }
+
+    DxvkOmInfo(
+            VkBool32            enableLogicOp,
+            VkLogicOp           logicOp)
+    : m_enableLogicOp (uint32_t(enableLogicOp)),
+      m_logicOp       (uint32_t(logicOp)),
+      m_reserved      (0) { }
+
+    VkBool32 enableLogicOp() const {
+      return VkBool32(m_enableLogicOp);
+    }
+
+    VkLogicOp logicOp() const {
+      return VkLogicOp(m_logicOp);
+    }
+
+  private:
+
+    uint32_t m_enableLogicOp          : 1;
+    uint32_t m_logicOp                : 4;
+    uint32_t m_reserved               : 27;
+
+  };
+
+
+  /**
+   * \brief Packed blend state of a render target
+   *
+   * Only core blend factors and blend
+   * operations are supported.
+   */
+  class DxvkOmAttachmentBlend {
+
+  public:
+
+    DxvkOmAttachmentBlend()
+    : m_blendEnable         (0),
+      m_srcColorBlendFactor (0),
+      m_dstColorBlendFactor (0),
+      m_colorBlendOp        (0),
+      m_srcAlphaBlendFactor (0),
+      m_dstAlphaBlendFactor (0),
+      m_alphaBlendOp        (0),
+      m_colorWriteMask      (0),
+      m_reserved            (0) { }
+
+    DxvkOmAttachmentBlend(
+            VkBool32              blendEnable,
+            VkBlendFactor         srcColorBlendFactor,
+            VkBlendFactor         dstColorBlendFactor,
+            VkBlendOp             colorBlendOp,
+            VkBlendFactor         srcAlphaBlendFactor,
+            VkBlendFactor         dstAlphaBlendFactor,
+            VkBlendOp             alphaBlendOp,
+            VkColorComponentFlags colorWriteMask)
+    : m_blendEnable         (uint32_t(blendEnable)),
+      m_srcColorBlendFactor (uint32_t(srcColorBlendFactor)),
+      m_dstColorBlendFactor (uint32_t(dstColorBlendFactor)),
+      m_colorBlendOp        (uint32_t(colorBlendOp)),
+      m_srcAlphaBlendFactor (uint32_t(srcAlphaBlendFactor)),
+      m_dstAlphaBlendFactor (uint32_t(dstAlphaBlendFactor)),
+      m_alphaBlendOp        (uint32_t(alphaBlendOp)),
+      m_colorWriteMask      (uint32_t(colorWriteMask)),
+      m_reserved            (0) { }
+
+    VkColorComponentFlags colorWriteMask() const {
+      return VkColorComponentFlags(m_colorWriteMask);
+    }
+
+    VkPipelineColorBlendAttachmentState state() const {
+      VkPipelineColorBlendAttachmentState result;
+      result.blendEnable         = VkBool32(m_blendEnable);
+      result.srcColorBlendFactor = VkBlendFactor(m_srcColorBlendFactor);
+      result.dstColorBlendFactor = VkBlendFactor(m_dstColorBlendFactor);
+      result.colorBlendOp        = VkBlendOp(m_colorBlendOp);
+      result.srcAlphaBlendFactor = VkBlendFactor(m_srcAlphaBlendFactor);
+      result.dstAlphaBlendFactor = VkBlendFactor(m_dstAlphaBlendFactor);
+      result.alphaBlendOp        = VkBlendOp(m_alphaBlendOp);
+      result.colorWriteMask      = VkColorComponentFlags(m_colorWriteMask);
+      return result;
+    }
+
+  private:
+
+    uint32_t m_blendEnable            : 1;
+    uint32_t m_srcColorBlendFactor    : 5;
+    uint32_t m_dstColorBlendFactor    : 5;
+    uint32_t m_colorBlendOp           : 3;
+    uint32_t m_srcAlphaBlendFactor    : 5;
+    uint32_t m_dstAlphaBlendFactor    : 5;
+    uint32_t m_alphaBlendOp           : 3;
+    uint32_t m_colorWriteMask         : 4;
+    uint32_t m_reserved               : 1;
+
+  };
+
+
+  /**
+   * \brief Packed component mapping of a render target
+   */
+  class DxvkOmAttachmentSwizzle {
+
+  public:
+
+    DxvkOmAttachmentSwizzle()
+    : m_r         (0),
+      m_g         (0),
+      m_b         (0),
+      m_a         (0),
+      m_reserved  (0) { }
+
+    DxvkOmAttachmentSwizzle(
+            VkComponentMapping  mapping)
+    : m_r         (uint32_t(mapping.r)),
+      m_g         (uint32_t(mapping.g)),
+      m_b         (uint32_t(mapping.b)),
+      m_a         (uint32_t(mapping.a)),
+      m_reserved  (0) { }
+
+    VkComponentMapping mapping() const {
+      VkComponentMapping result;
+      result.r = VkComponentSwizzle(m_r);
+      result.g = VkComponentSwizzle(m_g);
+      result.b = VkComponentSwizzle(m_b);
+      result.a = VkComponentSwizzle(m_a);
+      return result;
+    }
+
+  private:
+
+    uint32_t m_r                      : 3;
+    uint32_t m_g                      : 3;
+    uint32_t m_b                      : 3;
+    uint32_t m_a                      : 3;
+    uint32_t m_reserved               : 20;
+
+  };
+
+
+  /**
+   * \brief Graphics pipeline state info
+   *
+   * Stores all information that is required to create
+   * a graphics pipeline, except the shader objects
+   * themselves. Also used to identify pipelines using
+   * the current pipeline state vector.
+   *
+   * State is stored in a packed form and carries a hash
+   * that is updated incrementally whenever a field is
+   * changed. Members must therefore only be modified
+   * through the provided setters. Inactive vertex
+   * attributes and bindings are always zero.
+   */
+  struct DxvkGraphicsPipelineStateInfo {
+    DxvkGraphicsPipelineStateInfo();
+    DxvkGraphicsPipelineStateInfo(
+      const DxvkGraphicsPipelineStateInfo& other);
+
+    DxvkGraphicsPipelineStateInfo& operator = (
+      const DxvkGraphicsPipelineStateInfo& other);
+
+    bool operator == (const DxvkGraphicsPipelineStateInfo& other) const;
+    bool operator != (const DxvkGraphicsPipelineStateInfo& other) const;
+
+    /**
+     * \brief Retrieves state hash
+     * \returns Hash of the entire state vector
+     */
+    size_t hash() const {
+      return size_t(m_hash);
+    }
+
+    /**
+     * \brief Recomputes the state hash
+     *
+     * Only needs to be called if the object was
+     * initialized from raw memory, e.g. when
+     * reading it from a cache file.
+     */
+    void rehash();
+
+    void setBindingMask(const DxvkBindingMask& mask) {
+      this->updateField(bsBindingMask, mask);
+    }
+
+    void setIa(const DxvkIaInfo& info) {
+      this->updateField(ia, info);
+    }
+
+    void setIl(const DxvkIlInfo& info) {
+      this->updateField(il, info);
+    }
+
+    void setIlAttribute(uint32_t index, const DxvkIlAttribute& attribute) {
+      this->updateField(ilAttributes[index], attribute);
+    }
+
+    void setIlBinding(uint32_t index, const DxvkIlBinding& binding) {
+      this->updateField(ilBindings[index], binding);
+    }
+
+    void setRs(const DxvkRsInfo& info) {
+      this->updateField(rs, info);
+    }
+
+    void setMs(const DxvkMsInfo& info) {
+      this->updateField(ms, info);
+    }
+
+    void setDs(const DxvkDsInfo& info) {
+      this->updateField(ds, info);
+    }
+
+    void setDsStencilOps(const DxvkDsStencilOp& front, const DxvkDsStencilOp& back) {
+      this->updateField(dsFront, front);
+      this->updateField(dsBack,  back);
+    }
+
+    void setOm(const DxvkOmInfo& info) {
+      this->updateField(om, info);
+    }
+
+    void setOmBlend(uint32_t index, const DxvkOmAttachmentBlend& blend) {
+      this->updateField(omBlend[index], blend);
+    }
+
+    void setOmSwizzle(uint32_t index, const DxvkOmAttachmentSwizzle& swizzle) {
+      this->updateField(omSwizzle[index], swizzle);
+    }
+
+    DxvkBindingMask         bsBindingMask;
+    DxvkIaInfo              ia;
+    DxvkIlInfo              il;
+    DxvkIlAttribute         ilAttributes[DxvkLimits::MaxNumVertexAttributes];
+    DxvkIlBinding           ilBindings[DxvkLimits::MaxNumVertexBindings];
+    DxvkRsInfo              rs;
+    DxvkMsInfo              ms;
+    DxvkDsInfo              ds;
+    DxvkDsStencilOp         dsFront;
+    DxvkDsStencilOp         dsBack;
+    DxvkOmInfo              om;
+    DxvkOmAttachmentBlend   omBlend[DxvkLimits::MaxNumRenderTargets];
+    DxvkOmAttachmentSwizzle omSwizzle[DxvkLimits::MaxNumRenderTargets];
+
+  private:
+
+    uint64_t                m_hash;
+
+    template<typename T>
+    void updateField(T& field, const T& value) {
+      static_assert(sizeof(T) % sizeof(uint32_t) == 0);
+
+      constexpr uint32_t WordCount = sizeof(T) / sizeof(uint32_t);
+
+      uint32_t oldWords[WordCount];
+      uint32_t newWords[WordCount];
+
+      std::memcpy(oldWords, &field, sizeof(T));
+      std::memcpy(newWords, &value, sizeof(T));
+
+      const uint32_t wordIndex = uint32_t(
+        (reinterpret_cast<const char*>(&field)
+       - reinterpret_cast<const char*>(this)) / sizeof(uint32_t));
+
+      for (uint32_t i = 0; i < WordCount; i++) {
+        if (oldWords[i] != newWords[i]) {
+          m_hash ^= hashWord(wordIndex + i, oldWords[i]);
+          m_hash ^= hashWord(wordIndex + i, newWords[i]);
+        }
+      }
+
+      std::memcpy(&field, &value, sizeof(T));
+    }
+
+    static uint64_t hashWord(uint32_t index, uint32_t word) {
+      uint64_t h = (uint64_t(index) << 32) | word;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ull;
+      h ^= h >> 33;
+      return h;
+    }
+
+  };
+
+}
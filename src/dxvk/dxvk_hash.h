@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 namespace dxvk {
 
@@ -38,4 +41,131 @@ namespace dxvk {
     
   };
 
-}
\ No newline at end of file
+  
+  /**
+   * \brief Hash table with lock-free lookups
+   * 
+   * Open-addressing hash table for objects that are
+   * looked up frequently but rarely added, and never
+   * removed. Lookups do not require any locking, but
+   * insertions must be serialized by the caller.
+   * Entries never move, and replaced slot arrays are
+   * kept alive until the table is destroyed, so that
+   * readers racing with a resize remain valid.
+   */
+  template<typename K, typename V,
+    typename Hash = DxvkHash,
+    typename Eq   = DxvkEq>
+  class DxvkHashTable {
+    
+  public:
+    
+    DxvkHashTable() {
+      m_tables.emplace_back(new Table(16));
+      m_table.store(m_tables.back().get());
+    }
+    
+    DxvkHashTable             (const DxvkHashTable&) = delete;
+    DxvkHashTable& operator = (const DxvkHashTable&) = delete;
+    
+    /**
+     * \brief Looks up an entry
+     * 
+     * Safe to call concurrently with \ref insert.
+     * \param [in] key The key to look up
+     * \returns Pointer to the value, or \c nullptr
+     */
+    const V* find(const K& key) const {
+      const size_t hash  = Hash()(key);
+      const Table* table = m_table.load(std::memory_order_acquire);
+      
+      // The table is never more than half full,
+      // so there will always be an empty slot
+      for (size_t i = hash & table->mask; ; i = (i + 1) & table->mask) {
+        const Entry* entry = table->slots[i].load(std::memory_order_acquire);
+        
+        if (entry == nullptr)
+          return nullptr;
+        
+        if (entry->hash == hash && Eq()(entry->key, key))
+          return &entry->value;
+      }
+    }
+    
+    /**
+     * \brief Adds an entry
+     * 
+     * The key must not already be in the table.
+     * Calls to this function must be serialized.
+     * \param [in] key The key
+     * \param [in] value The value
+     * \returns Pointer to the inserted value
+     */
+    const V* insert(const K& key, V&& value) {
+      m_entries.emplace_back(new Entry { key, Hash()(key), std::move(value) });
+      const Entry* entry = m_entries.back().get();
+      
+      Table* table = m_table.load(std::memory_order_relaxed);
+      
+      if (2 * m_entries.size() > table->mask + 1) {
+        m_tables.emplace_back(new Table(2 * (table->mask + 1)));
+        table = m_tables.back().get();
+        
+        for (const auto& e : m_entries)
+          insertIntoTable(table, e.get());
+        
+        m_table.store(table, std::memory_order_release);
+      } else {
+        insertIntoTable(table, entry);
+      }
+      
+      return &entry->value;
+    }
+    
+    /**
+     * \brief Iterates over all values
+     * 
+     * Must not be called concurrently with \ref insert.
+     * \param [in] fn Function to call for each value
+     */
+    template<typename Fn>
+    void forEach(const Fn& fn) const {
+      for (const auto& e : m_entries)
+        fn(e->value);
+    }
+    
+  private:
+    
+    struct Entry {
+      K       key;
+      size_t  hash;
+      V       value;
+    };
+    
+    struct Table {
+      Table(size_t slotCount)
+      : mask(slotCount - 1), slots(new std::atomic<const Entry*>[slotCount]) {
+        for (size_t i = 0; i < slotCount; i++)
+          slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+      
+      size_t                                      mask;
+      std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+    
+    std::atomic<Table*>                   m_table = { nullptr };
+    std::vector<std::unique_ptr<Table>>   m_tables;
+    std::vector<std::unique_ptr<Entry>>   m_entries;
+    
+    static void insertIntoTable(Table* table, const Entry* entry) {
+      size_t i = entry->hash & table->mask;
+      
+      while (table->slots[i].load(std::memory_order_relaxed) != nullptr)
+        i = (i + 1) & table->mask;
+      
+      table->slots[i].store(entry, std::memory_order_release);
+    }
+    
+  };
+  
+}
@@ -1,3 +1,4 @@
+#include "dxvk_framebuffer.h"
 #include "dxvk_image.h"
 
 namespace dxvk {
@@ -117,11 +118,14 @@ namespace dxvk {
   }
   
   
+  static std::atomic<uint64_t> g_viewCookie = { 0ull };
+  
+  
   DxvkImageView::DxvkImageView(
     const Rc<vk::DeviceFn>&         vkd,
     const Rc<DxvkImage>&            image,
     const DxvkImageViewCreateInfo&  info)
-  : m_vkd(vkd), m_image(image), m_info(info) {
+  : m_vkd(vkd), m_image(image), m_info(info), m_cookie(++g_viewCookie) {
     // Since applications tend to bind views 
     for (uint32_t i = 0; i < ViewCount; i++)
       m_views[i] = VK_NULL_HANDLE;
@@ -166,6 +170,9 @@ namespace dxvk {
   
   
   DxvkImageView::~DxvkImageView() {
+    if (m_framebufferCache != nullptr)
+      m_framebufferCache->removeView(m_cookie);
+    
     for (uint32_t i = 0; i < ViewCount; i++)
       m_vkd->vkDestroyImageView(m_vkd->device(), m_views[i], nullptr);
   }
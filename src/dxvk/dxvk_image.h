@@ -7,6 +7,8 @@
 
 namespace dxvk {
   
+  class DxvkFramebufferCache;
+  
   /**
    * \brief Image create info
    * 
@@ -273,6 +275,7 @@ namespace dxvk {
    * \brief DXVK image view
    */
   class DxvkImageView : public DxvkResource {
+    friend class DxvkFramebufferCache;
     constexpr static uint32_t ViewCount = VK_IMAGE_VIEW_TYPE_CUBE_ARRAY + 1;
   public:
     
@@ -307,6 +310,18 @@ namespace dxvk {
       return m_views[viewType];
     }
     
+    /**
+     * \brief Unique view cookie
+     * 
+     * Identifies the view without keeping it
+     * alive. Cookies are never reused, and zero
+     * is never assigned to a valid view.
+     * \returns View cookie
+     */
+    uint64_t cookie() const {
+      return m_cookie;
+    }
+    
     /**
      * \brief Image view type
      * 
@@ -399,6 +414,9 @@ namespace dxvk {
     
     DxvkImageViewCreateInfo m_info;
     VkImageView             m_views[ViewCount];
+    uint64_t                m_cookie;
+    
+    Rc<DxvkFramebufferCache> m_framebufferCache;
 
     void createView(VkImageViewType type, uint32_t numLayers);
     
@@ -1,8 +1,13 @@
+#include <atomic>
+
 #include "dxvk_lifetime.h"
 
 namespace dxvk {
   
-  DxvkLifetimeTracker:: DxvkLifetimeTracker() { }
+  DxvkLifetimeTracker::DxvkLifetimeTracker()
+  : m_trackingId(allocTrackingId()) { }
+  
+  
   DxvkLifetimeTracker::~DxvkLifetimeTracker() { }
   
   
@@ -10,6 +15,17 @@ namespace dxvk {
     for (const auto& resource : m_resources)
       resource->release();
     m_resources.clear();
+    
+    // Resources may still carry the current ID, so we
+    // need a new one in order to track them again
+    m_trackingId = allocTrackingId();
+  }
+  
+  
+  uint64_t DxvkLifetimeTracker::allocTrackingId() {
+    // Zero is the initial ID of all resources
+    static std::atomic<uint64_t> s_nextId = { 1ull };
+    return s_nextId++;
   }
   
 }
\ No newline at end of file
@@ -23,11 +23,18 @@ namespace dxvk {
     
     /**
      * \brief Adds a resource to track
+     * 
+     * Resources that have already been added since
+     * the last reset are skipped, so that adding a
+     * resource repeatedly is cheap and does not
+     * touch any reference counts.
      * \param [in] rc The resource to track
      */
-    void trackResource(Rc<DxvkResource>&& rc) {
-      rc->acquire();
-      m_resources.emplace_back(std::move(rc));
+    void trackResource(DxvkResource* rc) {
+      if (rc->markTracked(m_trackingId)) {
+        rc->acquire();
+        m_resources.emplace_back(rc);
+      }
     }
     
     /**
@@ -35,13 +42,17 @@ namespace dxvk {
      * 
      * Called automatically by the device when
      * the command list has completed execution.
+     * Assigns a new tracking ID to the tracker.
      */
     void reset();
     
   private:
     
+    uint64_t                      m_trackingId;
     std::vector<Rc<DxvkResource>> m_resources;
     
+    static uint64_t allocTrackingId();
+    
   };
   
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 
 namespace dxvk {
   
+  // Time a chunk has to remain unused before
+  // its device memory is returned to the driver
+  constexpr auto ChunkReleaseDelay = std::chrono::seconds(5);
+  
   DxvkMemory::DxvkMemory() { }
   DxvkMemory::DxvkMemory(
           DxvkMemoryAllocator*  alloc,
@@ -54,20 +58,26 @@ namespace dxvk {
       m_alloc->free(*this);
   }
   
+  
+  bool DxvkMemory::isEvacuating() const {
+    return m_chunk != nullptr
+        && m_chunk->isEvacuating();
+  }
+  
 
   DxvkMemoryChunk::DxvkMemoryChunk(
           DxvkMemoryAllocator*  alloc,
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory)
-  : m_alloc(alloc), m_type(type), m_memory(memory) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory),
+    m_ranges(memory.memSize) {
+    
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
-    // This call is technically not thread-safe, but it
-    // doesn't need to be since we don't free chunks
+    // Chunks are only destroyed with the memory type
+    // locked, or when the allocator itself is destroyed
     m_alloc->freeDeviceMemory(m_type, m_memory);
   }
   
@@ -81,72 +91,27 @@ namespace dxvk {
     if (m_memory.memFlags != flags)
       return DxvkMemory();
     
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
-      return DxvkMemory();
-    
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+    // Pad the allocation to the requested alignment
+    // so that adjacent ranges stay aligned as well
+    size = dxvk::align(size, align);
     
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+    VkDeviceSize offset = m_ranges.alloc(size, align);
     
-    if (allocEnd > sliceEnd)
+    if (offset == DxvkMemoryRangeAllocator::InvalidOffset)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
-    // Create the memory object with the aligned slice
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
+      m_memory.memHandle, offset, size,
+      reinterpret_cast<char*>(m_memory.memPointer) + offset);
   }
   
   
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
+          VkDeviceSize  offset) {
+    m_ranges.free(offset);
     
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+    if (m_ranges.isEmpty())
+      m_emptySince = Clock::now();
   }
   
   
@@ -160,7 +125,8 @@ namespace dxvk {
       
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
       m_memHeaps[i].chunkSize  = pickChunkSize(heapSize);
-      m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
+      m_memHeaps[i].memoryAllocated.store(0);
+      m_memHeaps[i].memoryUsed.store(0);
     }
     
     for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
@@ -168,6 +134,15 @@ namespace dxvk {
       m_memTypes[i].memType    = m_memProps.memoryTypes[i];
       m_memTypes[i].memTypeId  = i;
     }
+    
+    std::string traceFile = env::getEnvVar(L"DXVK_MEMORY_TRACE");
+    
+    if (!traceFile.empty()) {
+      m_traceFile = std::ofstream(traceFile, std::ios_base::trunc);
+      
+      if (!m_traceFile)
+        Logger::err(str::format("DxvkMemoryAllocator: Failed to open trace file ", traceFile));
+    }
   }
   
   
@@ -180,8 +155,6 @@ namespace dxvk {
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
           VkMemoryPropertyFlags             flags) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
     DxvkMemory result = this->tryAlloc(req, dedAllocInfo, flags);
     
     if (!result && (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
@@ -202,19 +175,81 @@ namespace dxvk {
   
   
   DxvkMemoryStats DxvkMemoryAllocator::getMemoryStats() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
     DxvkMemoryStats totalStats;
     
     for (size_t i = 0; i < m_memProps.memoryHeapCount; i++) {
-      totalStats.memoryAllocated += m_memHeaps[i].stats.memoryAllocated;
-      totalStats.memoryUsed      += m_memHeaps[i].stats.memoryUsed;
+      totalStats.memoryAllocated += m_memHeaps[i].memoryAllocated.load();
+      totalStats.memoryUsed      += m_memHeaps[i].memoryUsed.load();
     }
       
     return totalStats;
   }
   
   
+  std::vector<DxvkMemoryChunkStats> DxvkMemoryAllocator::getChunkStats() {
+    std::vector<DxvkMemoryChunkStats> result;
+    
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      std::lock_guard<std::mutex> lock(m_memTypes[i].mutex);
+      
+      for (const auto& chunk : m_memTypes[i].chunks)
+        result.push_back({ i, chunk->getStats() });
+    }
+    
+    return result;
+  }
+  
+  
+  void DxvkMemoryAllocator::compactChunks(
+          bool                  evacuate) {
+    auto now = DxvkMemoryChunk::Clock::now();
+    
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      DxvkMemoryType* type = &m_memTypes[i];
+      std::lock_guard<std::mutex> lock(type->mutex);
+      
+      // Free chunks that have been empty for a while. Memory
+      // objects only reference chunks that they were allocated
+      // from, so empty chunks cannot be referenced anywhere.
+      for (auto chunk = type->chunks.begin(); chunk != type->chunks.end(); ) {
+        if ((*chunk)->isUnused(now, ChunkReleaseDelay)) {
+          Logger::debug(str::format("DxvkMemoryAllocator: Freeing unused chunk on memory type ", i));
+          chunk = type->chunks.erase(chunk);
+        } else {
+          chunk++;
+        }
+      }
+      
+      // Select the least used chunk for evacuation if
+      // the other chunks have enough free space to hold
+      // its allocations even with some fragmentation.
+      DxvkMemoryChunk*     candidate = nullptr;
+      DxvkMemoryRangeStats candidateStats;
+      VkDeviceSize         freeSize  = 0;
+      
+      for (const auto& chunk : type->chunks) {
+        DxvkMemoryRangeStats stats = chunk->getStats();
+        freeSize += stats.totalSize - stats.usedSize;
+        
+        chunk->setEvacuating(false);
+        
+        if (stats.usedSize != 0 && (candidate == nullptr || stats.usedSize < candidateStats.usedSize)) {
+          candidate      = chunk.ptr();
+          candidateStats = stats;
+        }
+      }
+      
+      if (evacuate && candidate != nullptr && type->chunks.size() > 1) {
+        const VkDeviceSize candidateFree = candidateStats.totalSize - candidateStats.usedSize;
+        
+        if (candidateStats.usedSize <= candidateStats.totalSize / 4
+         && candidateStats.usedSize * 2 <= freeSize - candidateFree)
+          candidate->setEvacuating(true);
+      }
+    }
+  }
+  
+  
   DxvkMemory DxvkMemoryAllocator::tryAlloc(
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
@@ -250,8 +285,19 @@ namespace dxvk {
       if (devMem.memHandle != VK_NULL_HANDLE)
         memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
     } else {
-      for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
-        memory = type->chunks[i]->alloc(flags, size, align);
+      std::lock_guard<std::mutex> lock(type->mutex);
+      
+      // Avoid chunks that are being evacuated unless
+      // the allocation does not fit anywhere else
+      for (uint32_t i = 0; i < type->chunks.size() && !memory; i++) {
+        if (!type->chunks[i]->isEvacuating())
+          memory = type->chunks[i]->alloc(flags, size, align);
+      }
+      
+      for (uint32_t i = 0; i < type->chunks.size() && !memory; i++) {
+        if (type->chunks[i]->isEvacuating())
+          memory = type->chunks[i]->alloc(flags, size, align);
+      }
       
       if (!memory) {
         DxvkDeviceMemory devMem = tryAllocDeviceMemory(
@@ -265,10 +311,13 @@ namespace dxvk {
 
         type->chunks.push_back(std::move(chunk));
       }
+      
+      if (memory && m_traceFile.is_open())
+        this->traceAlloc(memory, align);
     }
 
     if (memory)
-      type->heap->stats.memoryUsed += memory.m_length;
+      type->heap->memoryUsed += memory.m_length;
 
     return memory;
   }
@@ -279,10 +328,16 @@ namespace dxvk {
           VkMemoryPropertyFlags             flags,
           VkDeviceSize                      size,
     const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo) {
+    // Reserve the memory up front, since other memory
+    // types on the same heap may allocate concurrently
+    VkDeviceSize heapAllocated = type->heap->memoryAllocated.fetch_add(size) + size;
+    
     if ((type->memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-     && (type->heap->stats.memoryAllocated + size > type->heap->properties.size)
-     && (!m_allowOvercommit))
+     && (heapAllocated > type->heap->properties.size)
+     && (!m_allowOvercommit)) {
+      type->heap->memoryAllocated -= size;
       return DxvkDeviceMemory();
+    }
     
     DxvkDeviceMemory result;
     result.memSize  = size;
@@ -294,34 +349,32 @@ namespace dxvk {
     info.allocationSize   = size;
     info.memoryTypeIndex  = type->memTypeId;
 
-    if (m_vkd->vkAllocateMemory(m_vkd->device(), &info, nullptr, &result.memHandle) != VK_SUCCESS)
+    if (m_vkd->vkAllocateMemory(m_vkd->device(), &info, nullptr, &result.memHandle) != VK_SUCCESS) {
+      type->heap->memoryAllocated -= size;
       return DxvkDeviceMemory();
+    }
     
     if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
       VkResult status = m_vkd->vkMapMemory(m_vkd->device(), result.memHandle, 0, VK_WHOLE_SIZE, 0, &result.memPointer);
 
       if (status != VK_SUCCESS) {
         Logger::err(str::format("DxvkMemoryAllocator: Mapping memory failed with ", status));
+        m_vkd->vkFreeMemory(m_vkd->device(), result.memHandle, nullptr);
+        type->heap->memoryAllocated -= size;
         return DxvkDeviceMemory();
       }
     }
 
-    type->heap->stats.memoryAllocated += size;
     return result;
   }
 
 
   void DxvkMemoryAllocator::free(
     const DxvkMemory&           memory) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    memory.m_type->heap->stats.memoryUsed -= memory.m_length;
+    memory.m_type->heap->memoryUsed -= memory.m_length;
 
     if (memory.m_chunk != nullptr) {
-      this->freeChunkMemory(
-        memory.m_type,
-        memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+      this->freeChunkMemory(memory);
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -333,11 +386,13 @@ namespace dxvk {
 
   
   void DxvkMemoryAllocator::freeChunkMemory(
-          DxvkMemoryType*       type,
-          DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+    const DxvkMemory&           memory) {
+    std::lock_guard<std::mutex> lock(memory.m_type->mutex);
+    
+    if (m_traceFile.is_open())
+      this->traceFree(memory);
+    
+    memory.m_chunk->free(memory.m_offset);
   }
   
 
@@ -345,7 +400,7 @@ namespace dxvk {
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory) {
     m_vkd->vkFreeMemory(m_vkd->device(), memory.memHandle, nullptr);
-    type->heap->stats.memoryAllocated -= memory.memSize;
+    type->heap->memoryAllocated -= memory.memSize;
   }
 
 
@@ -359,4 +414,25 @@ namespace dxvk {
     return std::min(heapSize / MinChunkCount, MaxChunkSize);
   }
   
+
+  
+  void DxvkMemoryAllocator::traceAlloc(
+    const DxvkMemory&           memory,
+          VkDeviceSize          align) {
+    // Allocations are identified by their memory object and offset,
+    // see tests/dxvk/test_memory_alloc.cpp for the replay tool.
+    std::lock_guard<std::mutex> lock(m_traceMutex);
+    m_traceFile << "a " << memory.m_memory << ":" << memory.m_offset
+                << " " << memory.m_type->memTypeId
+                << " " << memory.m_length
+                << " " << align << "\n";
+  }
+  
+  
+  void DxvkMemoryAllocator::traceFree(
+    const DxvkMemory&           memory) {
+    std::lock_guard<std::mutex> lock(m_traceMutex);
+    m_traceFile << "f " << memory.m_memory << ":" << memory.m_offset << "\n";
+  }
+  
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <fstream>
+
 #include "dxvk_adapter.h"
+#include "dxvk_memory_range.h"
 
 namespace dxvk {
   
@@ -19,6 +23,18 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Memory chunk stats
+   * 
+   * Reports usage and fragmentation
+   * of a single memory chunk.
+   */
+  struct DxvkMemoryChunkStats {
+    uint32_t              memTypeId;
+    DxvkMemoryRangeStats  ranges;
+  };
+  
+  
   /**
    * \brief Device memory object
    * 
@@ -39,11 +55,14 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory heap and stores
    * its properties as well as allocation statistics.
+   * Statistics are updated atomically since multiple
+   * memory types may share the same heap.
    */
   struct DxvkMemoryHeap {
-    VkMemoryHeap      properties;
-    VkDeviceSize      chunkSize;
-    DxvkMemoryStats   stats;
+    VkMemoryHeap              properties;
+    VkDeviceSize              chunkSize;
+    std::atomic<VkDeviceSize> memoryAllocated;
+    std::atomic<VkDeviceSize> memoryUsed;
   };
 
 
@@ -52,7 +71,7 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory type and stores
    * memory chunks used to sub-allocate memory on
-   * this memory type.
+   * this memory type. The lock protects the chunks.
    */
   struct DxvkMemoryType {
     DxvkMemoryHeap*   heap;
@@ -60,6 +79,7 @@ namespace dxvk {
     VkMemoryType      memType;
     uint32_t          memTypeId;
 
+    std::mutex                       mutex;
     std::vector<Rc<DxvkMemoryChunk>> chunks;
   };
   
@@ -129,6 +149,17 @@ namespace dxvk {
       return m_memory != VK_NULL_HANDLE;
     }
     
+    /**
+     * \brief Checks whether the memory should be moved
+     * 
+     * If this returns \c true, the memory was allocated
+     * from a sparsely used chunk that the allocator is
+     * trying to free, and the resource using it should
+     * be moved to a new allocation if possible.
+     * \returns \c true if the memory should be moved
+     */
+    bool isEvacuating() const;
+    
   private:
     
     DxvkMemoryAllocator*  m_alloc  = nullptr;
@@ -148,12 +179,16 @@ namespace dxvk {
    * \brief Memory chunk
    * 
    * A single chunk of memory that provides a
-   * sub-allocator. This is not thread-safe.
+   * sub-allocator. This is not thread-safe, the
+   * allocator locks the chunk's memory type.
    */
   class DxvkMemoryChunk : public RcObject {
     
   public:
     
+    using Clock     = std::chrono::high_resolution_clock;
+    using TimePoint = typename Clock::time_point;
+    
     DxvkMemoryChunk(
             DxvkMemoryAllocator*  alloc,
             DxvkMemoryType*       type,
@@ -183,24 +218,70 @@ namespace dxvk {
      * Called automatically when a memory
      * slice runs out of scope.
      * \param [in] offset Slice offset
-     * \param [in] length Slice length
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            VkDeviceSize  offset);
     
-  private:
+    /**
+     * \brief Queries chunk stats
+     * \returns Usage and fragmentation stats
+     */
+    DxvkMemoryRangeStats getStats() const {
+      return m_ranges.getStats();
+    }
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
+    /**
+     * \brief Number of bytes in use
+     * \returns Used size, in bytes
+     */
+    VkDeviceSize usedSize() const {
+      return m_ranges.usedSize();
+    }
+    
+    /**
+     * \brief Checks whether the chunk is unused
+     * 
+     * \param [in] now Current time
+     * \param [in] delay Minimum time without allocations
+     * \returns \c true if the chunk has been empty
+     *          for at least the given amount of time
+     */
+    bool isUnused(
+            TimePoint             now,
+            Clock::duration       delay) const {
+      return m_ranges.isEmpty() && now - m_emptySince >= delay;
+    }
+    
+    /**
+     * \brief Checks whether the chunk is being evacuated
+     * 
+     * Allocations from an evacuating chunk should be moved
+     * elsewhere, and new allocations only use the chunk if
+     * no other chunk can satisfy them.
+     * \returns \c true if the chunk is being evacuated
+     */
+    bool isEvacuating() const {
+      return m_evacuating.load();
+    }
+    
+    /**
+     * \brief Starts or stops evacuating the chunk
+     * \param [in] evacuating Whether to evacuate the chunk
+     */
+    void setEvacuating(bool evacuating) {
+      m_evacuating.store(evacuating);
+    }
+    
+  private:
     
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkMemoryRangeAllocator m_ranges;
+    
+    TimePoint             m_emptySince = Clock::now();
+    std::atomic<bool>     m_evacuating = { false };
     
   };
   
@@ -252,6 +333,30 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats();
     
+    /**
+     * \brief Queries chunk stats
+     * 
+     * Returns usage and fragmentation stats
+     * for every memory chunk, which can be
+     * used to judge how well memory is used.
+     * \returns Stats for each memory chunk
+     */
+    std::vector<DxvkMemoryChunkStats> getChunkStats();
+    
+    /**
+     * \brief Compacts memory chunks
+     * 
+     * Frees chunks that have not been used for a few
+     * seconds. If requested, also picks the least used
+     * chunk of each memory type for evacuation if its
+     * allocations fit into the remaining chunks, so that
+     * it can be freed once its resources have been moved.
+     * \param [in] evacuate Whether to select chunks
+     *        for evacuation
+     */
+    void compactChunks(
+            bool                  evacuate);
+    
   private:
 
     const Rc<vk::DeviceFn>                 m_vkd;
@@ -259,10 +364,12 @@ namespace dxvk {
     const VkPhysicalDeviceMemoryProperties m_memProps;
     const bool                             m_allowOvercommit;
     
-    std::mutex                                      m_mutex;
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
     
+    std::mutex                                      m_traceMutex;
+    std::ofstream                                   m_traceFile;
+    
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
@@ -285,10 +392,7 @@ namespace dxvk {
       const DxvkMemory&           memory);
     
     void freeChunkMemory(
-            DxvkMemoryType*       type,
-            DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+      const DxvkMemory&           memory);
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
@@ -296,6 +400,13 @@ namespace dxvk {
     
     VkDeviceSize pickChunkSize(
             VkDeviceSize          heapSize) const;
+    
+    void traceAlloc(
+      const DxvkMemory&           memory,
+            VkDeviceSize          align);
+    
+    void traceFree(
+      const DxvkMemory&           memory);
 
   };
   
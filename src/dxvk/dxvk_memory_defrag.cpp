@@ -0,0 +1,111 @@
+#include "dxvk_context.h"
+#include "dxvk_device.h"
+#include "dxvk_memory_defrag.h"
+
+namespace dxvk {
+
+  DxvkMemoryDefragmenter::DxvkMemoryDefragmenter(
+          DxvkDevice*             device,
+          DxvkMemoryAllocator*    memAlloc)
+  : m_memAlloc        (memAlloc),
+    m_enableRelocation(device->config().enableMemoryDefrag) {
+    if (m_enableRelocation)
+      Logger::info("DXVK: Memory defragmentation enabled");
+  }
+
+
+  DxvkMemoryDefragmenter::~DxvkMemoryDefragmenter() {
+
+  }
+
+
+  void DxvkMemoryDefragmenter::disableRelocation() {
+    if (m_enableRelocation.exchange(false))
+      Logger::warn("DXVK: Memory defragmentation disabled");
+  }
+
+
+  void DxvkMemoryDefragmenter::registerBuffer(
+          DxvkBuffer*             buffer) {
+    const VkBufferUsageFlags requiredUsage
+      = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+      | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    if (!m_enableRelocation
+     || (buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+     || (buffer->info().usage & requiredUsage) != requiredUsage)
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer->m_defragIndex = uint32_t(m_buffers.size());
+    m_buffers.push_back(buffer);
+  }
+
+
+  void DxvkMemoryDefragmenter::unregisterBuffer(
+          DxvkBuffer*             buffer) {
+    if (buffer->m_defragIndex == ~0u)
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    DxvkBuffer* last = m_buffers.back();
+    last->m_defragIndex = buffer->m_defragIndex;
+
+    m_buffers[buffer->m_defragIndex] = last;
+    m_buffers.pop_back();
+
+    buffer->m_defragIndex = ~0u;
+  }
+
+
+  void DxvkMemoryDefragmenter::run(
+          DxvkContext*            ctx) {
+    auto now = Clock::now();
+    bool enableRelocation = m_enableRelocation;
+
+    if (now - m_lastCompaction >= CompactionInterval) {
+      m_memAlloc->compactChunks(enableRelocation);
+      m_lastCompaction = now;
+    }
+
+    if (!enableRelocation)
+      return;
+
+    for (const auto& buffer : getEvacuatingBuffers())
+      ctx->relocateBuffer(buffer);
+  }
+
+
+  std::vector<Rc<DxvkBuffer>> DxvkMemoryDefragmenter::getEvacuatingBuffers() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Rc<DxvkBuffer>> result;
+    VkDeviceSize bytesMoved = 0;
+
+    uint32_t checkCount = uint32_t(std::min<size_t>(m_buffers.size(), MaxBuffersChecked));
+
+    for (uint32_t i = 0; i < checkCount && result.size() < MaxBuffersMoved; i++) {
+      if (m_nextBuffer >= m_buffers.size())
+        m_nextBuffer = 0;
+
+      DxvkBuffer* buffer = m_buffers[m_nextBuffer++];
+
+      if (!buffer->isEvacuating()
+       || bytesMoved + buffer->info().size > MaxBytesMoved)
+        continue;
+
+      // The buffer may be in the process of being destroyed,
+      // in which case its destructor is waiting for the lock.
+      if (buffer->tryIncRef()) {
+        result.push_back(buffer);
+        buffer->decRef();
+
+        bytesMoved += buffer->info().size;
+      }
+    }
+
+    return result;
+  }
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "dxvk_buffer.h"
+
+namespace dxvk {
+
+  class DxvkContext;
+  class DxvkDevice;
+
+  /**
+   * \brief Memory defragmenter
+   *
+   * Periodically frees memory chunks that are no longer
+   * used. If enabled, also moves buffers out of sparsely
+   * used chunks with GPU copies, so that those chunks can
+   * be freed as well. The amount of data copied per call
+   * is limited in order to avoid stutter.
+   *
+   * Only buffers that are not host-visible and can be
+   * used for transfer operations can be moved, since
+   * their memory cannot be accessed by the application
+   * directly. Images are never moved.
+   * 
+   * Relocation replaces a buffer's backing slice on the
+   * thread that calls \ref run, so registered buffers
+   * must not have their slices resolved on any other
+   * thread, e.g. by initialization contexts.
+   */
+  class DxvkMemoryDefragmenter : public RcObject {
+    /// Minimum time between two compaction passes
+    constexpr static auto CompactionInterval = std::chrono::seconds(1);
+
+    /// Maximum number of buffers to check per call
+    constexpr static uint32_t MaxBuffersChecked = 1024;
+
+    /// Maximum number of buffers to move per call
+    constexpr static uint32_t MaxBuffersMoved = 64;
+
+    /// Maximum number of bytes to move per call
+    constexpr static VkDeviceSize MaxBytesMoved = 8 << 20;
+  public:
+
+    DxvkMemoryDefragmenter(
+            DxvkDevice*             device,
+            DxvkMemoryAllocator*    memAlloc);
+
+    ~DxvkMemoryDefragmenter();
+
+    /**
+     * \brief Disables buffer relocation
+     *
+     * Used by front-ends which resolve buffer slices on
+     * application threads. Unused memory chunks are still
+     * freed. Must be called before any buffers are
+     * registered.
+     */
+    void disableRelocation();
+
+    /**
+     * \brief Registers a buffer
+     *
+     * Adds the buffer to the list of buffers that may
+     * be moved, if the buffer is eligible. Must only be
+     * called once all commands that initialize the buffer
+     * on other threads have been submitted.
+     * \param [in] buffer The buffer
+     */
+    void registerBuffer(
+            DxvkBuffer*             buffer);
+
+    /**
+     * \brief Unregisters a buffer
+     *
+     * Called when the buffer is destroyed. Does
+     * nothing if the buffer was not registered.
+     * \param [in] buffer The buffer
+     */
+    void unregisterBuffer(
+            DxvkBuffer*             buffer);
+
+    /**
+     * \brief Runs defragmentation
+     *
+     * Should be called once per frame. Frees unused
+     * memory chunks, and records copies for buffers
+     * that need to be moved into the given context.
+     * \param [in] ctx Context to record copies into
+     */
+    void run(
+            DxvkContext*            ctx);
+
+  private:
+
+    using Clock     = std::chrono::high_resolution_clock;
+    using TimePoint = typename Clock::time_point;
+
+    DxvkMemoryAllocator*      m_memAlloc;
+    std::atomic<bool>         m_enableRelocation;
+
+    TimePoint                 m_lastCompaction = Clock::now();
+
+    std::mutex                m_mutex;
+    std::vector<DxvkBuffer*>  m_buffers;
+    size_t                    m_nextBuffer = 0;
+
+    std::vector<Rc<DxvkBuffer>> getEvacuatingBuffers();
+
+  };
+
+}
@@ -0,0 +1,320 @@
+#include "dxvk_memory_range.h"
+
+namespace dxvk {
+
+  DxvkMemoryRangeAllocator::DxvkMemoryRangeAllocator(
+          VkDeviceSize          size)
+  : m_totalSize(size) {
+    m_slMasks.fill(0);
+    m_freeLists.fill(Invalid);
+
+    // Mark the entire address space as free
+    insertFreeBlock(createBlock(0, size, Invalid, Invalid));
+  }
+
+
+  DxvkMemoryRangeAllocator::~DxvkMemoryRangeAllocator() {
+
+  }
+
+
+  VkDeviceSize DxvkMemoryRangeAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align) {
+    uint32_t block = findFreeBlock(size, align);
+
+    if (block == Invalid)
+      return InvalidOffset;
+
+    removeFreeBlock(block);
+
+    // Do not hold references to blocks here, since
+    // creating new blocks may reallocate the array
+    const VkDeviceSize blockStart = m_blocks[block].offset;
+    const VkDeviceSize blockEnd   = m_blocks[block].offset + m_blocks[block].length;
+
+    const VkDeviceSize allocStart = dxvk::align(blockStart, align);
+    const VkDeviceSize allocEnd   = allocStart + size;
+
+    // Return the unused parts of the block to the free lists.
+    // Adjacent blocks are never free, so there is no need to
+    // try and merge them.
+    if (allocStart != blockStart) {
+      uint32_t prev = m_blocks[block].prevPhys;
+      uint32_t head = createBlock(blockStart, allocStart - blockStart, prev, block);
+
+      if (prev != Invalid)
+        m_blocks[prev].nextPhys = head;
+
+      m_blocks[block].prevPhys = head;
+      insertFreeBlock(head);
+    }
+
+    if (allocEnd != blockEnd) {
+      uint32_t next = m_blocks[block].nextPhys;
+      uint32_t tail = createBlock(allocEnd, blockEnd - allocEnd, block, next);
+
+      if (next != Invalid)
+        m_blocks[next].prevPhys = tail;
+
+      m_blocks[block].nextPhys = tail;
+      insertFreeBlock(tail);
+    }
+
+    m_blocks[block].offset = allocStart;
+    m_blocks[block].length = size;
+
+    m_allocated.insert({ allocStart, block });
+    m_usedSize += size;
+    return allocStart;
+  }
+
+
+  void DxvkMemoryRangeAllocator::free(
+          VkDeviceSize          offset) {
+    auto entry = m_allocated.find(offset);
+
+    if (entry == m_allocated.end()) {
+      Logger::err(str::format("DxvkMemoryRangeAllocator: Invalid offset ", offset));
+      return;
+    }
+
+    uint32_t block = entry->second;
+    m_allocated.erase(entry);
+    m_usedSize -= m_blocks[block].length;
+
+    // Merge the block with free neighbours so
+    // that it can be used for larger allocations
+    uint32_t prev = m_blocks[block].prevPhys;
+
+    if (prev != Invalid && m_blocks[prev].isFree) {
+      removeFreeBlock(prev);
+
+      uint32_t next = m_blocks[block].nextPhys;
+
+      if (next != Invalid)
+        m_blocks[next].prevPhys = prev;
+
+      m_blocks[prev].length  += m_blocks[block].length;
+      m_blocks[prev].nextPhys = next;
+
+      destroyBlock(block);
+      block = prev;
+    }
+
+    uint32_t next = m_blocks[block].nextPhys;
+
+    if (next != Invalid && m_blocks[next].isFree) {
+      removeFreeBlock(next);
+
+      uint32_t nextNext = m_blocks[next].nextPhys;
+
+      if (nextNext != Invalid)
+        m_blocks[nextNext].prevPhys = block;
+
+      m_blocks[block].length  += m_blocks[next].length;
+      m_blocks[block].nextPhys = nextNext;
+
+      destroyBlock(next);
+    }
+
+    insertFreeBlock(block);
+  }
+
+
+  DxvkMemoryRangeStats DxvkMemoryRangeAllocator::getStats() const {
+    DxvkMemoryRangeStats stats;
+    stats.totalSize       = m_totalSize;
+    stats.usedSize        = m_usedSize;
+    stats.allocationCount = uint32_t(m_allocated.size());
+    stats.freeRangeCount  = m_freeRangeCount;
+
+    // The largest free range is in the highest non-empty size
+    // class, but that class may contain smaller ranges as well
+    if (m_flMask != 0) {
+      uint32_t fl = bit::bsr(m_flMask);
+      uint32_t sl = bit::bsr(m_slMasks[fl]);
+
+      for (uint32_t block = m_freeLists[fl * SlCount + sl]; block != Invalid; block = m_blocks[block].nextFree)
+        stats.largestFreeRange = std::max(stats.largestFreeRange, m_blocks[block].length);
+    }
+
+    return stats;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::createBlock(
+          VkDeviceSize          offset,
+          VkDeviceSize          length,
+          uint32_t              prevPhys,
+          uint32_t              nextPhys) {
+    uint32_t block;
+
+    if (m_unusedBlocks.size() != 0) {
+      block = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+    } else {
+      block = uint32_t(m_blocks.size());
+      m_blocks.emplace_back();
+    }
+
+    Block& info = m_blocks[block];
+    info.offset   = offset;
+    info.length   = length;
+    info.prevPhys = prevPhys;
+    info.nextPhys = nextPhys;
+    info.prevFree = Invalid;
+    info.nextFree = Invalid;
+    info.isFree   = false;
+    return block;
+  }
+
+
+  void DxvkMemoryRangeAllocator::destroyBlock(
+          uint32_t              block) {
+    m_unusedBlocks.push_back(block);
+  }
+
+
+  void DxvkMemoryRangeAllocator::insertFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    uint32_t  list = fl * SlCount + sl;
+    uint32_t  head = m_freeLists[list];
+
+    m_blocks[block].isFree   = true;
+    m_blocks[block].prevFree = Invalid;
+    m_blocks[block].nextFree = head;
+
+    if (head != Invalid)
+      m_blocks[head].prevFree = block;
+
+    m_freeLists[list] = block;
+    m_slMasks[fl] |= 1u << sl;
+    m_flMask      |= 1u << fl;
+    m_freeRangeCount += 1;
+  }
+
+
+  void DxvkMemoryRangeAllocator::removeFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    uint32_t prev = m_blocks[block].prevFree;
+    uint32_t next = m_blocks[block].nextFree;
+
+    if (next != Invalid)
+      m_blocks[next].prevFree = prev;
+
+    if (prev != Invalid) {
+      m_blocks[prev].nextFree = next;
+    } else {
+      m_freeLists[fl * SlCount + sl] = next;
+
+      if (next == Invalid) {
+        m_slMasks[fl] &= ~(1u << sl);
+
+        if (m_slMasks[fl] == 0)
+          m_flMask &= ~(1u << fl);
+      }
+    }
+
+    m_blocks[block].isFree = false;
+    m_freeRangeCount -= 1;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::findFreeBlock(
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    // Round the size up to the next size class, so that
+    // any free block in the class that we find is large
+    // enough. If alignment gets in the way, try again with
+    // the worst-case padding added to the requested size.
+    const std::array<VkDeviceSize, 2> searchSizes = {{ size, size + align - 1 }};
+
+    for (VkDeviceSize searchSize : searchSizes) {
+      searchSize += searchSize >= SmallSize
+        ? (VkDeviceSize(1) << (bit::bsr(searchSize) - SlShift)) - 1
+        : (SmallSize / SlCount) - 1;
+
+      uint32_t fl, sl;
+      mapSize(searchSize, fl, sl);
+
+      uint32_t block = findFreeList(fl, sl);
+
+      if (block != Invalid && blockFits(block, size, align))
+        return block;
+    }
+
+    // The size class containing the requested size
+    // may still have a block that is large enough
+    uint32_t fl, sl;
+    mapSize(size, fl, sl);
+
+    for (uint32_t block = m_freeLists[fl * SlCount + sl]; block != Invalid; block = m_blocks[block].nextFree) {
+      if (blockFits(block, size, align))
+        return block;
+    }
+
+    return Invalid;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::findFreeList(
+          uint32_t              fl,
+          uint32_t              sl) const {
+    uint32_t slMask = m_slMasks[fl] & (~0u << sl);
+
+    if (slMask == 0) {
+      uint32_t flMask = fl + 1 < FlCount
+        ? m_flMask & (~0u << (fl + 1))
+        : 0u;
+
+      if (flMask == 0)
+        return Invalid;
+
+      fl     = bit::tzcnt(flMask);
+      slMask = m_slMasks[fl];
+    }
+
+    sl = bit::tzcnt(slMask);
+    return m_freeLists[fl * SlCount + sl];
+  }
+
+
+  bool DxvkMemoryRangeAllocator::blockFits(
+          uint32_t              block,
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    const VkDeviceSize blockStart = m_blocks[block].offset;
+    const VkDeviceSize blockEnd   = m_blocks[block].offset + m_blocks[block].length;
+
+    return dxvk::align(blockStart, align) + size <= blockEnd;
+  }
+
+
+  void DxvkMemoryRangeAllocator::mapSize(
+          VkDeviceSize          size,
+          uint32_t&             fl,
+          uint32_t&             sl) {
+    if (size < SmallSize) {
+      fl = 0;
+      sl = uint32_t(size / (SmallSize / SlCount));
+    } else {
+      uint32_t msb = bit::bsr(size);
+
+      fl = msb - SmallShift + 1;
+      sl = uint32_t(size >> (msb - SlShift)) - SlCount;
+
+      if (fl >= FlCount) {
+        fl = FlCount - 1;
+        sl = SlCount - 1;
+      }
+    }
+  }
+
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Range allocator statistics
+   *
+   * Used to estimate how fragmented a
+   * memory chunk is. All sizes in bytes.
+   */
+  struct DxvkMemoryRangeStats {
+    VkDeviceSize totalSize        = 0;
+    VkDeviceSize usedSize         = 0;
+    VkDeviceSize largestFreeRange = 0;
+    uint32_t     allocationCount  = 0;
+    uint32_t     freeRangeCount   = 0;
+
+    /**
+     * \brief Fragmentation
+     *
+     * Zero if all free memory is contiguous, and
+     * approaches one if the free memory is split
+     * into many small ranges.
+     * \returns Fragmentation, between 0 and 1
+     */
+    double fragmentation() const {
+      const VkDeviceSize freeSize = totalSize - usedSize;
+
+      return freeSize != 0
+        ? 1.0 - double(largestFreeRange) / double(freeSize)
+        : 0.0;
+    }
+  };
+
+
+  /**
+   * \brief Range allocator
+   *
+   * Sub-allocates ranges from a linear address space
+   * using a two-level segregated fit scheme. Free ranges
+   * are sorted into size classes, each of which covers
+   * a power-of-two size interval split into sixteen
+   * linear steps, and non-empty classes are tracked in
+   * bit masks. Allocation and freeing both run in
+   * constant time. Not thread-safe.
+   */
+  class DxvkMemoryRangeAllocator {
+    constexpr static uint32_t Invalid     = ~0u;
+
+    constexpr static uint32_t SlShift     = 4;
+    constexpr static uint32_t SlCount     = 1u << SlShift;
+    constexpr static uint32_t SmallShift  = 8;
+    constexpr static uint32_t SmallSize   = 1u << SmallShift;
+    constexpr static uint32_t FlCount     = 32;
+  public:
+
+    /// Offset returned on allocation failure
+    constexpr static VkDeviceSize InvalidOffset = ~VkDeviceSize(0);
+
+    DxvkMemoryRangeAllocator(
+            VkDeviceSize          size);
+
+    ~DxvkMemoryRangeAllocator();
+
+    /**
+     * \brief Total size of the address space
+     * \returns Total size, in bytes
+     */
+    VkDeviceSize totalSize() const {
+      return m_totalSize;
+    }
+
+    /**
+     * \brief Number of bytes allocated
+     * \returns Used size, in bytes
+     */
+    VkDeviceSize usedSize() const {
+      return m_usedSize;
+    }
+
+    /**
+     * \brief Checks whether any ranges are allocated
+     * \returns \c true if no ranges are allocated
+     */
+    bool isEmpty() const {
+      return m_allocated.empty();
+    }
+
+    /**
+     * \brief Allocates a range
+     *
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment, must
+     *        be a power of two
+     * \returns Offset of the allocated range, or
+     *          \c InvalidOffset if the allocation
+     *          could not be satisfied.
+     */
+    VkDeviceSize alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align);
+
+    /**
+     * \brief Frees a range
+     *
+     * \param [in] offset Offset of a range
+     *        previously returned by \c alloc
+     */
+    void free(
+            VkDeviceSize          offset);
+
+    /**
+     * \brief Queries statistics
+     *
+     * Runs in linear time with respect to the number
+     * of free ranges in the largest size class.
+     * \returns Allocator statistics
+     */
+    DxvkMemoryRangeStats getStats() const;
+
+  private:
+
+    struct Block {
+      VkDeviceSize  offset;
+      VkDeviceSize  length;
+      uint32_t      prevPhys;
+      uint32_t      nextPhys;
+      uint32_t      prevFree;
+      uint32_t      nextFree;
+      bool          isFree;
+    };
+
+    VkDeviceSize m_totalSize;
+    VkDeviceSize m_usedSize = 0;
+
+    std::vector<Block>    m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+
+    std::unordered_map<VkDeviceSize, uint32_t> m_allocated;
+
+    uint32_t                                  m_flMask = 0;
+    std::array<uint32_t, FlCount>             m_slMasks;
+    std::array<uint32_t, FlCount * SlCount>   m_freeLists;
+    uint32_t                                  m_freeRangeCount = 0;
+
+    uint32_t createBlock(
+            VkDeviceSize          offset,
+            VkDeviceSize          length,
+            uint32_t              prevPhys,
+            uint32_t              nextPhys);
+
+    void destroyBlock(
+            uint32_t              block);
+
+    void insertFreeBlock(
+            uint32_t              block);
+
+    void removeFreeBlock(
+            uint32_t              block);
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    uint32_t findFreeList(
+            uint32_t              fl,
+            uint32_t              sl) const;
+
+    bool blockFits(
+            uint32_t              block,
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    static void mapSize(
+            VkDeviceSize          size,
+            uint32_t&             fl,
+            uint32_t&             sl);
+
+  };
+
+}
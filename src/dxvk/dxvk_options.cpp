@@ -4,6 +4,9 @@ namespace dxvk {
 
   DxvkOptions::DxvkOptions(const Config& config) {
     allowMemoryOvercommit = config.getOption<bool>("dxvk.allowMemoryOvercommit", false);
+    enableAsync           = config.getOption<bool>("dxvk.enableAsync",           false);
+    enableMemoryDefrag    = config.getOption<bool>("dxvk.enableMemoryDefrag",    false);
+    optimizeSpirv         = config.getOption<bool>("dxvk.optimizeSpirv",         false);
   }
 
 }
\ No newline at end of file
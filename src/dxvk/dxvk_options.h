@@ -10,6 +10,18 @@ namespace dxvk {
     /// Allow allocating more memory from
     /// a heap than the device supports.
     bool allowMemoryOvercommit;
+
+    /// Compile graphics pipelines asynchronously
+    /// and skip draws until they become available.
+    bool enableAsync;
+
+    /// Move buffers out of sparsely used memory
+    /// chunks so that the chunks can be freed.
+    bool enableMemoryDefrag;
+
+    /// Run SPIR-V optimization passes
+    /// on shaders compiled from DXBC.
+    bool optimizeSpirv;
   };
 
 }
\ No newline at end of file
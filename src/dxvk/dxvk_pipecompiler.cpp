@@ -0,0 +1,68 @@
+#include "dxvk_pipecompiler.h"
+
+namespace dxvk {
+
+  DxvkPipelineCompiler::DxvkPipelineCompiler() {
+    // Leave some room for the application and CS
+    // threads, as well as the state cache workers
+    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
+    uint32_t numWorkers  = numCpuCores / 2;
+
+    if (numWorkers < 1) numWorkers = 1;
+    if (numWorkers > 8) numWorkers = 8;
+
+    Logger::info(str::format("DXVK: Using ", numWorkers, " async compiler threads"));
+
+    for (uint32_t i = 0; i < numWorkers; i++)
+      m_compilerThreads.emplace_back([this] () { runCompilerThread(); });
+  }
+
+
+  DxvkPipelineCompiler::~DxvkPipelineCompiler() {
+    { std::lock_guard<std::mutex> lock(m_compilerLock);
+      m_compilerStop.store(true);
+    }
+
+    m_compilerCond.notify_all();
+
+    for (auto& thread : m_compilerThreads)
+      thread.join();
+  }
+
+
+  void DxvkPipelineCompiler::queueCompilation(
+    const Rc<DxvkGraphicsPipeline>&       pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 renderPass) {
+    std::lock_guard<std::mutex> lock(m_compilerLock);
+    m_compilerQueue.push({ pipeline, state, renderPass });
+    m_compilerCond.notify_one();
+  }
+
+
+  void DxvkPipelineCompiler::runCompilerThread() {
+    env::setThreadName(L"dxvk-pcompiler");
+
+    while (!m_compilerStop.load()) {
+      PipelineEntry entry;
+
+      { std::unique_lock<std::mutex> lock(m_compilerLock);
+
+        m_compilerCond.wait(lock, [this] {
+          return m_compilerStop.load()
+              || m_compilerQueue.size() != 0;
+        });
+
+        if (m_compilerStop.load())
+          break;
+
+        entry = std::move(m_compilerQueue.front());
+        m_compilerQueue.pop();
+      }
+
+      entry.pipeline->compileInstance(
+        entry.state, *entry.renderPass);
+    }
+  }
+
+}
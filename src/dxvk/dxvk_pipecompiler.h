@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "dxvk_graphics.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Asynchronous pipeline compiler
+   *
+   * Compiles graphics pipelines on a set of worker
+   * threads so that the thread recording rendering
+   * commands does not have to wait for the driver.
+   * Used when \c dxvk.enableAsync is set.
+   */
+  class DxvkPipelineCompiler : public RcObject {
+
+  public:
+
+    DxvkPipelineCompiler();
+    ~DxvkPipelineCompiler();
+
+    /**
+     * \brief Queues a pipeline for compilation
+     *
+     * The pipeline object must have registered a
+     * placeholder instance for the given state
+     * vector, which will be filled in with the
+     * actual pipeline handle once compiled.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass. Must
+     *    remain valid until the device is destroyed.
+     */
+    void queueCompilation(
+      const Rc<DxvkGraphicsPipeline>&       pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 renderPass);
+
+  private:
+
+    struct PipelineEntry {
+      Rc<DxvkGraphicsPipeline>      pipeline;
+      DxvkGraphicsPipelineStateInfo state;
+      const DxvkRenderPass*         renderPass;
+    };
+
+    std::atomic<bool>             m_compilerStop = { false };
+    std::mutex                    m_compilerLock;
+    std::condition_variable       m_compilerCond;
+    std::queue<PipelineEntry>     m_compilerQueue;
+    std::vector<dxvk::thread>     m_compilerThreads;
+
+    void runCompilerThread();
+
+  };
+
+}
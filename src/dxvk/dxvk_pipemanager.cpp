@@ -1,4 +1,5 @@
 #include "dxvk_device.h"
+#include "dxvk_pipecompiler.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
 
@@ -48,6 +49,9 @@ namespace dxvk {
     
     if (useStateCache != "0")
       m_stateCache = new DxvkStateCache(this, passManager);
+    
+    if (device->config().enableAsync)
+      m_compiler = new DxvkPipelineCompiler();
   }
   
   
@@ -121,5 +125,12 @@ namespace dxvk {
     result.numGraphicsPipelines = m_numGraphicsPipelines.load();
     return result;
   }
+
+  
+  DxvkStateCacheStats DxvkPipelineManager::getStateCacheStats() const {
+    return m_stateCache != nullptr
+      ? m_stateCache->getStats()
+      : DxvkStateCacheStats();
+  }
   
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 namespace dxvk {
 
   class DxvkStateCache;
+  class DxvkPipelineCompiler;
 
   /**
    * \brief Pipeline count
@@ -21,6 +22,19 @@ namespace dxvk {
     uint32_t numComputePipelines;
   };
   
+  /**
+   * \brief State cache statistics
+   * 
+   * Stores the number of state cache entries
+   * queued for compilation, and how many of
+   * those have been compiled or have failed.
+   */
+  struct DxvkStateCacheStats {
+    uint32_t numQueued   = 0;
+    uint32_t numCompiled = 0;
+    uint32_t numFailed   = 0;
+  };
+  
   /**
    * \brief Compute pipeline key
    * 
@@ -127,6 +141,15 @@ namespace dxvk {
      * \returns Number of compute/graphics pipelines
      */
     DxvkPipelineCount getPipelineCount() const;
+    
+    /**
+     * \brief Retrieves state cache statistics
+     * 
+     * All counts are zero if the state cache is disabled.
+     * \returns State cache compiler progress
+     */
+    DxvkStateCacheStats getStateCacheStats() const;
+    
   private:
     
     const DxvkDevice*         m_device;
@@ -150,6 +173,10 @@ namespace dxvk {
       DxvkPipelineKeyHash,
       DxvkPipelineKeyEq> m_graphicsPipelines;
     
+    // Must be destroyed first since its worker
+    // threads may still access pipeline objects
+    Rc<DxvkPipelineCompiler>  m_compiler;
+    
   };
   
 }
\ No newline at end of file
@@ -21,6 +21,8 @@ namespace dxvk {
   
   
   void DxvkSubmissionQueue::submit(const Rc<DxvkCommandList>& cmdList) {
+    auto submitTime = DxvkTimingTracker::Clock::now();
+    
     { std::unique_lock<std::mutex> lock(m_mutex);
       
       m_condOnTake.wait(lock, [this] {
@@ -28,7 +30,7 @@ namespace dxvk {
       });
       
       m_submits += 1;
-      m_entries.push(cmdList);
+      m_entries.push({ cmdList, submitTime });
       m_condOnAdd.notify_one();
     }
   }
@@ -39,6 +41,7 @@ namespace dxvk {
 
     while (!m_stopped.load()) {
       Rc<DxvkCommandList> cmdList;
+      DxvkTimingTracker::TimePoint submitTime;
       
       { std::unique_lock<std::mutex> lock(m_mutex);
         
@@ -47,7 +50,8 @@ namespace dxvk {
         });
         
         if (m_entries.size() != 0) {
-          cmdList = std::move(m_entries.front());
+          cmdList    = std::move(m_entries.front().cmdList);
+          submitTime = m_entries.front().submitTime;
           m_entries.pop();
         }
         
@@ -58,6 +62,20 @@ namespace dxvk {
         VkResult status = cmdList->synchronize();
         
         if (status == VK_SUCCESS) {
+          // The GPU starts executing the command list once it is
+          // submitted and the previous one has completed. This is
+          // only an estimate, since we may notice completion late.
+          auto completionTime = DxvkTimingTracker::Clock::now();
+          auto startTime      = std::max(submitTime, m_lastCompletion);
+          
+          if (completionTime > startTime) {
+            m_device->timings()->addTime(
+              DxvkTimingStage::GpuExecution,
+              completionTime - startTime);
+          }
+          
+          m_lastCompletion = completionTime;
+          
           cmdList->writeQueryData();
           cmdList->signalEvents();
           cmdList->reset();
@@ -7,6 +7,7 @@
 #include "../util/thread.h"
 #include "dxvk_cmdlist.h"
 #include "dxvk_sync.h"
+#include "dxvk_timing.h"
 
 namespace dxvk {
   
@@ -47,6 +48,11 @@ namespace dxvk {
     
   private:
     
+    struct Entry {
+      Rc<DxvkCommandList>         cmdList;
+      DxvkTimingTracker::TimePoint submitTime;
+    };
+    
     DxvkDevice*             m_device;
     
     std::atomic<bool>       m_stopped = { false };
@@ -55,9 +61,11 @@ namespace dxvk {
     std::mutex              m_mutex;
     std::condition_variable m_condOnAdd;
     std::condition_variable m_condOnTake;
-    std::queue<Rc<DxvkCommandList>> m_entries;
+    std::queue<Entry>       m_entries;
     dxvk::thread             m_thread;
     
+    DxvkTimingTracker::TimePoint m_lastCompletion;
+    
     void threadFunc();
     
   };
@@ -19,6 +19,60 @@ namespace dxvk {
   }
   
   
+  size_t DxvkRenderPassFormat::hash() const {
+    DxvkHashState state;
+    state.add(uint32_t(sampleCount));
+    state.add(uint32_t(depth.format));
+    state.add(uint32_t(depth.layout));
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      state.add(uint32_t(color[i].format));
+      state.add(uint32_t(color[i].layout));
+    }
+    
+    return state;
+  }
+  
+  
+  bool DxvkRenderPassOps::eq(const DxvkRenderPassOps& ops) const {
+    bool eq = depthOps.loadOpD     == ops.depthOps.loadOpD
+           && depthOps.loadOpS     == ops.depthOps.loadOpS
+           && depthOps.loadLayout  == ops.depthOps.loadLayout
+           && depthOps.storeOpD    == ops.depthOps.storeOpD
+           && depthOps.storeOpS    == ops.depthOps.storeOpS
+           && depthOps.storeLayout == ops.depthOps.storeLayout;
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets && eq; i++) {
+      eq &= colorOps[i].loadOp      == ops.colorOps[i].loadOp
+         && colorOps[i].loadLayout  == ops.colorOps[i].loadLayout
+         && colorOps[i].storeOp     == ops.colorOps[i].storeOp
+         && colorOps[i].storeLayout == ops.colorOps[i].storeLayout;
+    }
+    
+    return eq;
+  }
+  
+  
+  size_t DxvkRenderPassOps::hash() const {
+    DxvkHashState state;
+    state.add(uint32_t(depthOps.loadOpD));
+    state.add(uint32_t(depthOps.loadOpS));
+    state.add(uint32_t(depthOps.loadLayout));
+    state.add(uint32_t(depthOps.storeOpD));
+    state.add(uint32_t(depthOps.storeOpS));
+    state.add(uint32_t(depthOps.storeLayout));
+    
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      state.add(uint32_t(colorOps[i].loadOp));
+      state.add(uint32_t(colorOps[i].loadLayout));
+      state.add(uint32_t(colorOps[i].storeOp));
+      state.add(uint32_t(colorOps[i].storeLayout));
+    }
+    
+    return state;
+  }
+  
+  
   DxvkRenderPass::DxvkRenderPass(
     const Rc<vk::DeviceFn>&       vkd,
     const DxvkRenderPassFormat&   fmt)
@@ -31,10 +85,10 @@ namespace dxvk {
   DxvkRenderPass::~DxvkRenderPass() {
     m_vkd->vkDestroyRenderPass(m_vkd->device(), m_default, nullptr);
     
-    for (const auto& i : m_instances) {
+    m_instances.forEach([this] (VkRenderPass handle) {
       m_vkd->vkDestroyRenderPass(
-        m_vkd->device(), i.handle, nullptr);
-    }
+        m_vkd->device(), handle, nullptr);
+    });
   }
   
   
@@ -44,16 +98,22 @@ namespace dxvk {
   
   
   VkRenderPass DxvkRenderPass::getHandle(const DxvkRenderPassOps& ops) {
+    // Fast path, does not require any locking
+    const VkRenderPass* handle = m_instances.find(ops);
+    
+    if (handle != nullptr)
+      return *handle;
+    
     std::lock_guard<sync::Spinlock> lock(m_mutex);
     
-    for (const auto& i : m_instances) {
-      if (compareOps(i.ops, ops))
-        return i.handle;
-    }
+    // Another thread may have created the
+    // render pass after our initial lookup
+    handle = m_instances.find(ops);
+    
+    if (handle == nullptr)
+      handle = m_instances.insert(ops, this->createRenderPass(ops));
     
-    VkRenderPass handle = this->createRenderPass(ops);
-    m_instances.push_back({ ops, handle });
-    return handle;
+    return *handle;
   }
   
   
@@ -169,27 +229,6 @@ namespace dxvk {
   }
   
   
-  bool DxvkRenderPass::compareOps(
-    const DxvkRenderPassOps& a,
-    const DxvkRenderPassOps& b) {
-    bool eq = a.depthOps.loadOpD     == b.depthOps.loadOpD
-           && a.depthOps.loadOpS     == b.depthOps.loadOpS
-           && a.depthOps.loadLayout  == b.depthOps.loadLayout
-           && a.depthOps.storeOpD    == b.depthOps.storeOpD
-           && a.depthOps.storeOpS    == b.depthOps.storeOpS
-           && a.depthOps.storeLayout == b.depthOps.storeLayout;
-    
-    for (uint32_t i = 0; i < MaxNumRenderTargets && eq; i++) {
-      eq &= a.colorOps[i].loadOp      == b.colorOps[i].loadOp
-         && a.colorOps[i].loadLayout  == b.colorOps[i].loadLayout
-         && a.colorOps[i].storeOp     == b.colorOps[i].storeOp
-         && a.colorOps[i].storeLayout == b.colorOps[i].storeLayout;
-    }
-    
-    return eq;
-  }
-  
-  
   DxvkRenderPassPool::DxvkRenderPassPool(const Rc<vk::DeviceFn>& vkd)
   : m_vkd(vkd) {
     
@@ -202,16 +241,22 @@ namespace dxvk {
   
   
   Rc<DxvkRenderPass> DxvkRenderPassPool::getRenderPass(const DxvkRenderPassFormat& fmt) {
+    // Fast path, does not require any locking
+    const Rc<DxvkRenderPass>* rp = m_renderPasses.find(fmt);
+    
+    if (rp != nullptr)
+      return *rp;
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    for (const auto& r : m_renderPasses) {
-      if (r->hasCompatibleFormat(fmt))
-        return r;
-    }
+    // Another thread may have created the
+    // render pass after our initial lookup
+    rp = m_renderPasses.find(fmt);
+    
+    if (rp == nullptr)
+      rp = m_renderPasses.insert(fmt, new DxvkRenderPass(m_vkd, fmt));
     
-    Rc<DxvkRenderPass> rp = new DxvkRenderPass(m_vkd, fmt);
-    m_renderPasses.push_back(rp);
-    return rp;
+    return *rp;
   }
   
 }
\ No newline at end of file
@@ -33,6 +33,12 @@ namespace dxvk {
     DxvkAttachmentFormat  color[MaxNumRenderTargets];
     
     bool matches(const DxvkRenderPassFormat& fmt) const;
+    
+    bool eq(const DxvkRenderPassFormat& fmt) const {
+      return matches(fmt);
+    }
+    
+    size_t hash() const;
   };
   
   
@@ -76,6 +82,10 @@ namespace dxvk {
   struct DxvkRenderPassOps {
     DxvkDepthAttachmentOps depthOps;
     DxvkColorAttachmentOps colorOps[MaxNumRenderTargets];
+    
+    bool eq(const DxvkRenderPassOps& ops) const;
+    
+    size_t hash() const;
   };
   
   
@@ -152,25 +162,19 @@ namespace dxvk {
     
   private:
     
-    struct Instance {
-      DxvkRenderPassOps ops;
-      VkRenderPass      handle;
-    };
-    
     Rc<vk::DeviceFn>        m_vkd;
     DxvkRenderPassFormat    m_format;
     VkRenderPass            m_default;
     
     sync::Spinlock          m_mutex;
-    std::vector<Instance>   m_instances;
+    
+    DxvkHashTable<
+      DxvkRenderPassOps,
+      VkRenderPass>         m_instances;
     
     VkRenderPass createRenderPass(
       const DxvkRenderPassOps& ops);
     
-    static bool compareOps(
-      const DxvkRenderPassOps& a,
-      const DxvkRenderPassOps& b);
-    
   };
   
   
@@ -204,7 +208,10 @@ namespace dxvk {
     const Rc<vk::DeviceFn> m_vkd;
     
     std::mutex                      m_mutex;
-    std::vector<Rc<DxvkRenderPass>> m_renderPasses;
+    
+    DxvkHashTable<
+      DxvkRenderPassFormat,
+      Rc<DxvkRenderPass>>           m_renderPasses;
     
   };
   
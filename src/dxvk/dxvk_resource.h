@@ -31,9 +31,31 @@ namespace dxvk {
     void acquire() { m_useCount += 1; }
     void release() { m_useCount -= 1; }
     
+    /**
+     * \brief Marks resource as tracked
+     * 
+     * Stores the ID of the lifetime tracker that last
+     * tracked the resource, so that the same tracker
+     * does not need to track the resource again. If
+     * multiple trackers use the resource at the same
+     * time, it may get tracked more than once, which
+     * is harmless.
+     * \param [in] trackingId Tracker ID
+     * \returns \c true if the resource needs
+     *    to be added to the given tracker
+     */
+    bool markTracked(uint64_t trackingId) {
+      if (m_trackingId.load(std::memory_order_relaxed) == trackingId)
+        return false;
+      
+      m_trackingId.store(trackingId, std::memory_order_relaxed);
+      return true;
+    }
+    
   private:
     
-    std::atomic<uint32_t> m_useCount = { 0u };
+    std::atomic<uint32_t> m_useCount   = { 0u };
+    std::atomic<uint64_t> m_trackingId = { 0ull };
     
   };
   
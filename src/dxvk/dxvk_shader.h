@@ -98,7 +98,7 @@ namespace dxvk {
    * needs to be created from he shader object.
    */
   class DxvkShader : public RcObject {
-    
+    friend class DxvkShaderCache;
   public:
     
     DxvkShader(
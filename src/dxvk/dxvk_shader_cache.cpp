@@ -0,0 +1,271 @@
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  bool DxvkShaderCacheKey::eq(const DxvkShaderCacheKey& key) const {
+    return shader.eq(key.shader)
+        && options == key.options;
+  }
+
+
+  size_t DxvkShaderCacheKey::hash() const {
+    DxvkHashState result;
+    result.add(shader.hash());
+
+    for (uint32_t i = 0; i < 4; i++)
+      result.add(options.dword(i));
+
+    return result;
+  }
+
+
+  DxvkShaderCache::DxvkShaderCache() {
+    size_t validSize = readCacheFile();
+
+    // Discard outdated files and anything after the
+    // first invalid entry, which may have been left
+    // behind if the application crashed while writing
+    if (validSize == 0 || validSize != m_mapping.size()) {
+      rewriteCacheFile(validSize);
+      readCacheFile();
+    }
+
+    Logger::info(str::format("DXVK: Read ", m_entries.size(), " cached shaders"));
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::lookupShader(
+    const DxvkShaderCacheKey&     key) {
+    // The index and the mapped view do not change
+    // after the cache is created, so no locking
+    // is required in order to read entries.
+    auto entry = m_entries.find(key);
+
+    if (entry == m_entries.end())
+      return nullptr;
+
+    auto data = reinterpret_cast<const char*>(m_mapping.data()) + entry->second;
+
+    DxvkShaderCacheEntryHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    // Verify the check sum over a copy of the entry, so that
+    // we don't have to parse the mapped data more than once
+    std::vector<char> buffer(data, data + getEntrySize(header));
+    std::memset(buffer.data() + offsetof(DxvkShaderCacheEntryHeader, hash), 0, sizeof(Sha1Hash));
+
+    Sha1Hash hash = Sha1Hash::compute(
+      reinterpret_cast<const uint8_t*>(buffer.data()),
+      buffer.size());
+
+    if (!(hash == header.hash)) {
+      Logger::warn(str::format("DXVK: Invalid shader cache entry for ", key.shader.toString()));
+      return nullptr;
+    }
+
+    size_t offset = sizeof(header);
+
+    std::vector<DxvkResourceSlot> slots(header.slotCount);
+    std::memcpy(slots.data(), buffer.data() + offset, header.slotCount * sizeof(DxvkResourceSlot));
+    offset += header.slotCount * sizeof(DxvkResourceSlot);
+
+    SpirvCodeBuffer code(header.codeSize,
+      reinterpret_cast<const uint32_t*>(buffer.data() + offset));
+    offset += header.codeSize * sizeof(uint32_t);
+
+    DxvkShaderConstData constData;
+
+    if (header.constSize != 0) {
+      constData = DxvkShaderConstData(header.constSize,
+        reinterpret_cast<const uint32_t*>(buffer.data() + offset));
+    }
+
+    DxvkInterfaceSlots iface;
+    iface.inputSlots  = header.inputSlots;
+    iface.outputSlots = header.outputSlots;
+
+    return new DxvkShader(
+      VkShaderStageFlagBits(header.stage),
+      slots.size(), slots.data(), iface,
+      code, std::move(constData));
+  }
+
+
+  void DxvkShaderCache::storeShader(
+    const DxvkShaderCacheKey&     key,
+    const Rc<DxvkShader>&         shader) {
+    DxvkShaderCacheEntryHeader header;
+    header.key          = key;
+    header.hash         = Sha1Hash(Sha1Digest());
+    header.stage        = shader->m_stage;
+    header.slotCount    = shader->m_slots.size();
+    header.inputSlots   = shader->m_interface.inputSlots;
+    header.outputSlots  = shader->m_interface.outputSlots;
+    header.codeSize     = shader->m_code.size() / sizeof(uint32_t);
+    header.constSize    = shader->m_constData.sizeInBytes() / sizeof(uint32_t);
+
+    // Serialize the entire entry so that we can
+    // compute the check sum and write it at once
+    std::vector<char> buffer(getEntrySize(header));
+    size_t offset = sizeof(header);
+
+    std::memcpy(buffer.data() + offset, shader->m_slots.data(), header.slotCount * sizeof(DxvkResourceSlot));
+    offset += header.slotCount * sizeof(DxvkResourceSlot);
+
+    std::memcpy(buffer.data() + offset, shader->m_code.data(), shader->m_code.size());
+    offset += shader->m_code.size();
+
+    if (header.constSize != 0)
+      std::memcpy(buffer.data() + offset, shader->m_constData.data(), shader->m_constData.sizeInBytes());
+
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    header.hash = Sha1Hash::compute(
+      reinterpret_cast<const uint8_t*>(buffer.data()),
+      buffer.size());
+
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_writerFile.is_open()) {
+      m_writerFile = std::ofstream(getCacheFileName(),
+        std::ios_base::binary |
+        std::ios_base::app);
+    }
+
+    m_writerFile.write(buffer.data(), buffer.size());
+    m_writerFile.flush();
+  }
+
+
+  size_t DxvkShaderCache::readCacheFile() {
+    m_entries.clear();
+
+    if (!m_mapping.open(getCacheFileName())) {
+      Logger::warn("DXVK: No shader cache file found");
+      return 0;
+    }
+
+    auto data = reinterpret_cast<const char*>(m_mapping.data());
+    auto size = m_mapping.size();
+
+    DxvkShaderCacheHeader expected;
+    DxvkShaderCacheHeader actual;
+
+    if (size < sizeof(actual))
+      return 0;
+
+    std::memcpy(&actual, data, sizeof(actual));
+
+    if (std::memcmp(expected.magic, actual.magic, sizeof(actual.magic))
+     || expected.version != actual.version) {
+      Logger::warn("DXVK: Shader cache out of date");
+      return 0;
+    }
+
+    // Only read the entry headers here, the entries
+    // themselves are verified when they are used.
+    // Later entries take precedence over earlier
+    // ones, in case an entry had to be replaced.
+    size_t offset = sizeof(actual);
+
+    while (offset < size) {
+      DxvkShaderCacheEntryHeader header;
+
+      if (!readCacheEntryHeader(data + offset, size - offset, header)) {
+        Logger::warn("DXVK: Invalid shader cache entry");
+        break;
+      }
+
+      m_entries[header.key] = offset;
+      offset += getEntrySize(header);
+    }
+
+    return offset;
+  }
+
+
+  void DxvkShaderCache::rewriteCacheFile(
+          size_t                    validSize) {
+    // Copy the valid part of the file before
+    // unmapping it, since we need to truncate it
+    std::vector<char> data;
+
+    if (validSize != 0) {
+      auto mapped = reinterpret_cast<const char*>(m_mapping.data());
+      data.insert(data.end(), mapped, mapped + validSize);
+    }
+
+    m_entries.clear();
+    m_mapping.close();
+
+    std::ofstream file(getCacheFileName(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (data.empty()) {
+      DxvkShaderCacheHeader header;
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    } else {
+      file.write(data.data(), data.size());
+    }
+  }
+
+
+  bool DxvkShaderCache::readCacheEntryHeader(
+    const char*                     data,
+          size_t                    size,
+          DxvkShaderCacheEntryHeader& header) {
+    if (size < sizeof(header))
+      return false;
+
+    std::memcpy(&header, data, sizeof(header));
+
+    // Use 64-bit math so that corrupted
+    // size fields cannot cause overflows
+    uint64_t entrySize = sizeof(header)
+      + uint64_t(header.slotCount) * sizeof(DxvkResourceSlot)
+      + uint64_t(header.codeSize)  * sizeof(uint32_t)
+      + uint64_t(header.constSize) * sizeof(uint32_t);
+
+    return header.codeSize != 0
+        && entrySize <= size;
+  }
+
+
+  size_t DxvkShaderCache::getEntrySize(
+    const DxvkShaderCacheEntryHeader& header) {
+    return sizeof(header)
+      + header.slotCount * sizeof(DxvkResourceSlot)
+      + header.codeSize  * sizeof(uint32_t)
+      + header.constSize * sizeof(uint32_t);
+  }
+
+
+  std::string DxvkShaderCache::getCacheFileName() const {
+    std::string path = env::getEnvVar(L"DXVK_STATE_CACHE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    std::string exeName = env::getExeName();
+    auto extp = exeName.find_last_of('.');
+
+    if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
+      exeName.erase(extp);
+
+    path += exeName + ".dxvk-shaders";
+    return path;
+  }
+
+}
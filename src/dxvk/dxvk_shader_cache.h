@@ -0,0 +1,138 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "dxvk_shader.h"
+
+#include "../util/util_file_map.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Shader cache key
+   *
+   * Identifies a compiled shader by the key of the
+   * original shader code, and a hash of everything
+   * else that affects code generation, such as the
+   * compiler options and the compiler version.
+   */
+  struct DxvkShaderCacheKey {
+    DxvkShaderKey shader;
+    Sha1Hash      options;
+
+    bool eq(const DxvkShaderCacheKey& key) const;
+
+    size_t hash() const;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheKey) == 44);
+
+
+  /**
+   * \brief Shader cache header
+   *
+   * Stores the shader cache format version. If an
+   * existing cache file is incompatible to the
+   * current version, it will be discarded.
+   */
+  struct DxvkShaderCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'S', 'C' };
+    uint32_t version    = 1;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheHeader) == 8);
+
+
+  /**
+   * \brief Shader cache entry header
+   *
+   * Each entry consists of this header, followed by
+   * the resource slot infos, the SPIR-V code, and the
+   * shader constant data. The check sum is computed
+   * over the entire entry, with the check sum field
+   * itself set to zero.
+   */
+  struct DxvkShaderCacheEntryHeader {
+    DxvkShaderCacheKey  key;
+    Sha1Hash            hash;
+    uint32_t            stage;
+    uint32_t            slotCount;
+    uint32_t            inputSlots;
+    uint32_t            outputSlots;
+    uint32_t            codeSize;
+    uint32_t            constSize;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheEntryHeader) == 88);
+
+
+  /**
+   * \brief Shader cache
+   *
+   * Stores compiled shaders along with their resource
+   * slots, interface slots and constant data in a file,
+   * so that shaders do not have to be recompiled every
+   * time the application starts. The file is mapped
+   * into memory, and entries are only read and verified
+   * when they are looked up.
+   */
+  class DxvkShaderCache : public RcObject {
+
+  public:
+
+    DxvkShaderCache();
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Looks up a cached shader
+     *
+     * \param [in] key Shader cache key
+     * \returns The shader, or \c nullptr if the
+     *    shader is not cached or the entry is invalid
+     */
+    Rc<DxvkShader> lookupShader(
+      const DxvkShaderCacheKey&     key);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Appends the shader to the cache file. Shaders
+     * added this way can only be looked up after the
+     * cache file has been reloaded.
+     * \param [in] key Shader cache key
+     * \param [in] shader The compiled shader
+     */
+    void storeShader(
+      const DxvkShaderCacheKey&     key,
+      const Rc<DxvkShader>&         shader);
+
+  private:
+
+    std::mutex                    m_mutex;
+    FileMapping                   m_mapping;
+    std::ofstream                 m_writerFile;
+
+    std::unordered_map<
+      DxvkShaderCacheKey, size_t,
+      DxvkHash, DxvkEq>           m_entries;
+
+    size_t readCacheFile();
+
+    void rewriteCacheFile(
+            size_t                    validSize);
+
+    static bool readCacheEntryHeader(
+      const char*                     data,
+            size_t                    size,
+            DxvkShaderCacheEntryHeader& header);
+
+    static size_t getEntrySize(
+      const DxvkShaderCacheEntryHeader& header);
+
+    std::string getCacheFileName() const;
+
+  };
+
+}
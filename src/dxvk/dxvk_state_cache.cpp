@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
 
@@ -6,6 +10,38 @@ namespace dxvk {
   static const Sha1Hash       g_nullHash      = Sha1Hash::compute(nullptr, 0);
   static const DxvkShaderKey  g_nullShaderKey = DxvkShaderKey();
 
+  // Rewrite the file once the number of entries appended
+  // to it exceeds this fraction of the indexed entries
+  static constexpr size_t     g_maxUnindexedRatio = 16;
+
+  /* Index tables are sorted by the raw bytes of their
+   * keys, which is stable across builds and platforms */
+  static int compareShaderKeys(
+    const DxvkShaderKey&      a,
+    const DxvkShaderKey&      b) {
+    return std::memcmp(&a, &b, sizeof(DxvkShaderKey));
+  }
+
+  static int comparePipelineKeys(
+    const DxvkStateCacheKey&  a,
+    const DxvkStateCacheKey&  b) {
+    return std::memcmp(&a, &b, sizeof(DxvkStateCacheKey));
+  }
+
+  struct DxvkStateCacheIndexLess {
+    bool operator () (const DxvkStateCachePipelineIndex& a, const DxvkStateCacheKey& b) const {
+      return comparePipelineKeys(a.shaders, b) < 0;
+    }
+
+    bool operator () (const DxvkStateCacheShaderIndex& a, const DxvkShaderKey& b) const {
+      return compareShaderKeys(a.shader, b) < 0;
+    }
+
+    bool operator () (const DxvkShaderKey& a, const DxvkStateCacheShaderIndex& b) const {
+      return compareShaderKeys(a, b.shader) < 0;
+    }
+  };
+
   bool DxvkStateCacheKey::eq(const DxvkStateCacheKey& key) const {
     return this->vs.eq(key.vs)
         && this->tcs.eq(key.tcs)
@@ -33,38 +69,20 @@ namespace dxvk {
           DxvkRenderPassPool*   passManager)
   : m_pipeManager(pipeManager),
     m_passManager(passManager) {
-    bool newFile = !readCacheFile();
-
-    // Open cache file for writing
-    std::ios_base::openmode mode = std::ios_base::binary;
+    // Rewrite the file if it uses an older format, if it
+    // contains invalid entries, or if too many entries
+    // have been appended since the index was written
+    if (!readCacheFile())
+      writeCacheFile();
 
-    mode |= newFile
-      ? std::ios_base::trunc
-      : std::ios_base::app;
-    
-    m_writerFile = std::ofstream(getCacheFileName(), mode);
+    // Open cache file for appending new entries
+    m_writerFile = std::ofstream(getCacheFileName(),
+      std::ios_base::binary | std::ios_base::app);
 
     if (!m_writerFile) {
       // We can't write to the file, but we might still
       // use cache entries previously read from the file
       Logger::warn("DXVK: Failed to open state cache file");
-    } else if (newFile) {
-      Logger::warn("DXVK: Creating new state cache file");
-
-      // Write header with the current version number
-      DxvkStateCacheHeader header;
-
-      auto data = reinterpret_cast<const char*>(&header);
-      auto size = sizeof(header);
-
-      m_writerFile.write(data, size);
-
-      // Write all valid entries to the cache file in
-      // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(m_writerFile, e);
-
-      m_writerFile.flush();
     }
 
     // Use half the available CPU cores for pipeline compilation
@@ -120,6 +138,17 @@ namespace dxvk {
         return;
     }
 
+    auto index = findMappedPipeline(shaders);
+
+    if (index != nullptr) {
+      for (uint32_t i = 0; i < index->entryCount; i++) {
+        const DxvkStateCacheEntry& entry = m_mappedEntries[index->entryIndex + i];
+
+        if (entry.format.matches(format) && entry.gpState == state)
+          return;
+      }
+    }
+
     // Queue a job to write this pipeline to the cache
     std::unique_lock<std::mutex> lock(m_writerLock);
 
@@ -144,6 +173,15 @@ namespace dxvk {
         return;
     }
 
+    auto index = findMappedPipeline(shaders);
+
+    if (index != nullptr) {
+      for (uint32_t i = 0; i < index->entryCount; i++) {
+        if (m_mappedEntries[index->entryIndex + i].cpState == state)
+          return;
+      }
+    }
+
     // Queue a job to write this pipeline to the cache
     std::unique_lock<std::mutex> lock(m_writerLock);
 
@@ -169,28 +207,45 @@ namespace dxvk {
 
     auto pipelines = m_pipelineMap.equal_range(key);
 
-    for (auto p = pipelines.first; p != pipelines.second; p++) {
-      WorkerItem item;
+    for (auto p = pipelines.first; p != pipelines.second; p++)
+      queuePipeline(p->second, workerLock);
 
-      if (!getShaderByKey(p->second.vs,  item.vs)
-       || !getShaderByKey(p->second.tcs, item.tcs)
-       || !getShaderByKey(p->second.tes, item.tes)
-       || !getShaderByKey(p->second.gs,  item.gs)
-       || !getShaderByKey(p->second.fs,  item.fs)
-       || !getShaderByKey(p->second.cs,  item.cs))
-        continue;
-      
-      if (!workerLock)
-        workerLock = std::unique_lock<std::mutex>(m_workerLock);
-      
-      m_workerQueue.push(item);
-    }
+    auto shaders = std::equal_range(m_mappedShaders,
+      m_mappedShaders + m_mappedIndex.shaderCount,
+      key, DxvkStateCacheIndexLess());
+
+    for (auto s = shaders.first; s != shaders.second; s++)
+      queuePipeline(m_mappedPipelines[s->pipelineIndex].shaders, workerLock);
 
     if (workerLock)
       m_workerCond.notify_all();
   }
 
 
+  void DxvkStateCache::prioritizePipeline(
+    const DxvkStateCacheKey&              shaders) {
+    // This is called on every pipeline lookup miss in the
+    // draw path, so avoid taking the lock if there is no
+    // queued work that could possibly be prioritized
+    if (m_numPendingItems.load(std::memory_order_acquire) == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock(m_workerLock);
+
+    if (m_workerItems.find(shaders) != m_workerItems.end())
+      m_workerQueue.push({ UrgentPriority | m_workerSeq++, shaders });
+  }
+
+
+  DxvkStateCacheStats DxvkStateCache::getStats() const {
+    DxvkStateCacheStats result;
+    result.numQueued   = m_numQueued.load();
+    result.numCompiled = m_numCompiled.load();
+    result.numFailed   = m_numFailed.load();
+    return result;
+  }
+
+
   DxvkShaderKey DxvkStateCache::getShaderKey(const Rc<DxvkShader>& shader) const {
     return shader != nullptr ? shader->getShaderKey() : g_nullShaderKey;
   }
@@ -226,6 +281,84 @@ namespace dxvk {
   }
 
 
+  void DxvkStateCache::queuePipeline(
+    const DxvkStateCacheKey&        key,
+          std::unique_lock<std::mutex>& workerLock) {
+    WorkerItem item;
+
+    if (!getShaderByKey(key.vs,  item.vs)
+     || !getShaderByKey(key.tcs, item.tcs)
+     || !getShaderByKey(key.tes, item.tes)
+     || !getShaderByKey(key.gs,  item.gs)
+     || !getShaderByKey(key.fs,  item.fs)
+     || !getShaderByKey(key.cs,  item.cs))
+      return;
+    
+    if (!workerLock)
+      workerLock = std::unique_lock<std::mutex>(m_workerLock);
+    
+    // The pipeline map stores one pair per cache entry,
+    // so the same pipeline may get queued multiple times
+    if (!m_workerItems.insert({ key, item }).second)
+      return;
+    
+    m_numPendingItems += 1;
+    m_numQueued += getEntryCount(key);
+    m_workerQueue.push({ m_workerSeq++, key });
+  }
+
+
+  const DxvkStateCachePipelineIndex* DxvkStateCache::findMappedPipeline(
+    const DxvkStateCacheKey&        key) const {
+    auto end   = m_mappedPipelines + m_mappedIndex.pipelineCount;
+    auto index = std::lower_bound(m_mappedPipelines, end, key, DxvkStateCacheIndexLess());
+
+    if (index == end || comparePipelineKeys(index->shaders, key))
+      return nullptr;
+    
+    return index;
+  }
+
+
+  uint32_t DxvkStateCache::getEntryCount(
+    const DxvkStateCacheKey&        key) const {
+    uint32_t count = m_entryMap.count(key);
+
+    auto index = findMappedPipeline(key);
+
+    if (index != nullptr)
+      count += index->entryCount;
+    
+    return count;
+  }
+
+
+  void DxvkStateCache::getEntries(
+    const DxvkStateCacheKey&        key,
+          std::vector<DxvkStateCacheEntry>& entries) {
+    auto range = m_entryMap.equal_range(key);
+
+    for (auto e = range.first; e != range.second; e++)
+      entries.push_back(m_entries[e->second]);
+    
+    // Mapped entries have not been verified yet
+    auto index = findMappedPipeline(key);
+
+    if (index != nullptr) {
+      for (uint32_t i = 0; i < index->entryCount; i++) {
+        DxvkStateCacheEntry entry = m_mappedEntries[index->entryIndex + i];
+
+        if (verifyCacheEntry(entry)) {
+          entries.push_back(entry);
+        } else {
+          Logger::warn("DXVK: Skipping invalid state cache entry");
+          m_numFailed += 1;
+        }
+      }
+    }
+  }
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
     DxvkStateCacheKey key;
     key.vs  = getShaderKey(item.vs);
@@ -235,54 +368,158 @@ namespace dxvk {
     key.fs  = getShaderKey(item.fs);
     key.cs  = getShaderKey(item.cs);
 
+    std::vector<DxvkStateCacheEntry> entries;
+    getEntries(key, entries);
+
     if (item.cs == nullptr) {
       auto pipeline = m_pipeManager->createGraphicsPipeline(
         item.vs, item.tcs, item.tes, item.gs, item.fs);
-      auto entries = m_entryMap.equal_range(key);
-
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
 
+      for (const auto& entry : entries) {
         auto rp = m_passManager->getRenderPass(entry.format);
-        pipeline->getPipelineHandle(entry.gpState, *rp);
+        
+        // This also counts pipelines that are still being compiled
+        // asynchronously for the draw path as failed, which is rare
+        countPipeline(pipeline->getPipelineHandle(
+          entry.gpState, *rp, false) != VK_NULL_HANDLE);
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cs);
-      auto entries = m_entryMap.equal_range(key);
 
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
-        pipeline->getPipelineHandle(entry.cpState);
+      for (const auto& entry : entries) {
+        countPipeline(pipeline->getPipelineHandle(
+          entry.cpState) != VK_NULL_HANDLE);
       }
     }
   }
 
 
-  bool DxvkStateCache::readCacheFile() {
-    // Open state file and just fail if it doesn't exist
-    std::ifstream ifile(getCacheFileName(), std::ios_base::binary);
+  void DxvkStateCache::countPipeline(bool success) {
+    if (success)
+      m_numCompiled += 1;
+    else
+      m_numFailed += 1;
+  }
+
 
-    if (!ifile) {
+  bool DxvkStateCache::readCacheFile() {
+    // Map state file and just fail if it doesn't exist
+    if (!m_mapping.open(getCacheFileName())) {
       Logger::warn("DXVK: No state cache file found");
       return false;
     }
 
+    auto data = reinterpret_cast<const char*>(m_mapping.data());
+    auto size = m_mapping.size();
+
     // The header stores the state cache version,
     // we need to regenerate it if it's outdated
-    if (!readCacheHeader(ifile)) {
+    DxvkStateCacheHeader expected;
+    DxvkStateCacheHeader actual;
+
+    if (size < sizeof(actual)) {
       Logger::warn("DXVK: State cache out of date");
       return false;
     }
 
-    // Read actual cache entries from the file.
+    std::memcpy(&actual, data, sizeof(actual));
+
+    if (std::memcmp(expected.magic, actual.magic, sizeof(actual.magic))
+     || (actual.version != 2 && actual.version != expected.version)
+     || getEntrySize(actual.version) != actual.entrySize) {
+      Logger::warn("DXVK: State cache out of date");
+      return false;
+    }
+
+    size_t offset = sizeof(actual);
+
+    // Version 3 files store an index which we use to
+    // look up entries lazily, rather than parsing and
+    // verifying all entries up front
+    if (actual.version == expected.version && !readCacheIndex(data, size, offset)) {
+      Logger::warn("DXVK: Invalid state cache index");
+      return false;
+    }
+
+    // Read entries that are not indexed. In version 2
+    // files, this includes all entries in the file.
+    bool validEntries = readCacheEntries(actual.version, data + offset, size - offset);
+
+    Logger::info(str::format(
+      "DXVK: Read ", m_mappedIndex.entryCount, " indexed and ",
+      m_entries.size(), " unindexed state cache entries"));
+    
+    if (actual.version != expected.version)
+      Logger::warn("DXVK: Converting state cache to new format");
+    
+    return validEntries
+        && actual.version == expected.version
+        && m_entries.size() * g_maxUnindexedRatio <= m_mappedIndex.entryCount;
+  }
+
+
+  bool DxvkStateCache::readCacheIndex(
+    const char*                     data,
+          size_t                    size,
+          size_t&                   offset) {
+    DxvkStateCacheIndexHeader index;
+
+    if (size - offset < sizeof(index))
+      return false;
+    
+    std::memcpy(&index, data + offset, sizeof(index));
+    offset += sizeof(index);
+
+    // Make sure that the index tables and all
+    // indexed entries are actually in the file
+    uint64_t pipelineSize = uint64_t(index.pipelineCount) * sizeof(DxvkStateCachePipelineIndex);
+    uint64_t shaderSize   = uint64_t(index.shaderCount)   * sizeof(DxvkStateCacheShaderIndex);
+    uint64_t entrySize    = uint64_t(index.entryCount)    * sizeof(DxvkStateCacheEntry);
+
+    if (pipelineSize + shaderSize + entrySize > size - offset)
+      return false;
+    
+    auto pipelines = reinterpret_cast<const DxvkStateCachePipelineIndex*>(data + offset);
+    auto shaders   = reinterpret_cast<const DxvkStateCacheShaderIndex*>  (data + offset + pipelineSize);
+    auto entries   = reinterpret_cast<const DxvkStateCacheEntry*>        (data + offset + pipelineSize + shaderSize);
+
+    // Validate index ranges so that lookups
+    // won't read past the end of the mapping
+    for (uint32_t i = 0; i < index.pipelineCount; i++) {
+      if (pipelines[i].entryIndex > index.entryCount
+       || pipelines[i].entryCount > index.entryCount - pipelines[i].entryIndex)
+        return false;
+    }
+
+    for (uint32_t i = 0; i < index.shaderCount; i++) {
+      if (shaders[i].pipelineIndex >= index.pipelineCount)
+        return false;
+    }
+
+    m_mappedIndex     = index;
+    m_mappedPipelines = pipelines;
+    m_mappedShaders   = shaders;
+    m_mappedEntries   = entries;
+
+    offset += pipelineSize + shaderSize + entrySize;
+    return true;
+  }
+
+
+  bool DxvkStateCache::readCacheEntries(
+          uint32_t                  version,
+    const char*                     data,
+          size_t                    size) {
     // If we encounter invalid entries, we should
     // regenerate the entire state cache file.
     uint32_t numInvalidEntries = 0;
 
-    while (ifile) {
+    size_t entrySize = getEntrySize(version);
+
+    for (size_t offset = 0; offset + entrySize <= size; offset += entrySize) {
       DxvkStateCacheEntry entry;
 
-      if (readCacheEntry(ifile, entry)) {
+      if (readCacheEntry(version, data + offset, entry)) {
         size_t entryId = m_entries.size();
         m_entries.push_back(entry);
 
@@ -294,14 +531,14 @@ namespace dxvk {
         mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
         mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
         mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
-      } else if (ifile) {
+      } else {
         numInvalidEntries += 1;
       }
     }
 
-    Logger::info(str::format(
-      "DXVK: Read ", m_entries.size(),
-      " valid state cache entries"));
+    // Partially written entry at the end of the file
+    if (size % entrySize)
+      numInvalidEntries += 1;
 
     if (numInvalidEntries) {
       Logger::warn(str::format(
@@ -313,39 +550,266 @@ namespace dxvk {
   }
 
 
-  bool DxvkStateCache::readCacheHeader(
-          std::istream&             stream) const {
-    DxvkStateCacheHeader expected;
-    DxvkStateCacheHeader actual;
+  bool DxvkStateCache::readCacheEntry(
+          uint32_t                  version,
+    const char*                     data,
+          DxvkStateCacheEntry&      entry) {
+    if (version == 2) {
+      DxvkStateCacheEntryV2 oldEntry;
+      std::memcpy(&oldEntry, data, sizeof(oldEntry));
+      return convertCacheEntry(oldEntry, entry);
+    }
+
+    std::memcpy(reinterpret_cast<void*>(&entry), data, sizeof(entry));
+    return verifyCacheEntry(entry);
+  }
+
 
-    auto data = reinterpret_cast<char*>(&actual);
-    auto size = sizeof(actual);
+  bool DxvkStateCache::verifyCacheEntry(
+          DxvkStateCacheEntry&      entry) {
+    Sha1Hash expectedHash = std::exchange(entry.hash, g_nullHash);
+    Sha1Hash computedHash = Sha1Hash::compute(entry);
 
-    if (!stream.read(data, size))
+    if (!(expectedHash == computedHash))
       return false;
     
-    for (uint32_t i = 0; i < 4; i++) {
-      if (expected.magic[i] != actual.magic[i])
-        return false;
+    // The cached state vector hash is not part of the
+    // file format contract, so recompute it on load
+    entry.gpState.rehash();
+    return true;
+  }
+
+
+  bool DxvkStateCache::convertCacheEntry(
+    const DxvkStateCacheEntryV2&    oldEntry,
+          DxvkStateCacheEntry&      newEntry) {
+    DxvkStateCacheEntryV2 copy = oldEntry;
+
+    Sha1Hash expectedHash = std::exchange(copy.hash, g_nullHash);
+    Sha1Hash computedHash = Sha1Hash::compute(copy);
+
+    if (!(expectedHash == computedHash))
+      return false;
+    
+    const DxvkGraphicsPipelineStateInfoV2& oldState = oldEntry.gpState;
+
+    if (oldState.ilAttributeCount > DxvkLimits::MaxNumVertexAttributes
+     || oldState.ilBindingCount   > DxvkLimits::MaxNumVertexBindings)
+      return false;
+
+    DxvkGraphicsPipelineStateInfo state;
+    state.setBindingMask(oldState.bsBindingMask);
+
+    state.setIa(DxvkIaInfo(
+      oldState.iaPrimitiveTopology,
+      oldState.iaPrimitiveRestart,
+      oldState.iaPatchVertexCount));
+    
+    for (uint32_t i = 0; i < oldState.ilAttributeCount; i++) {
+      state.setIlAttribute(i, DxvkIlAttribute(
+        oldState.ilAttributes[i].location,
+        oldState.ilAttributes[i].binding,
+        oldState.ilAttributes[i].format,
+        oldState.ilAttributes[i].offset));
+    }
+
+    for (uint32_t i = 0; i < oldState.ilBindingCount; i++) {
+      state.setIlBinding(i, DxvkIlBinding(
+        oldState.ilBindings[i].binding,
+        oldState.ilBindings[i].stride,
+        oldState.ilBindings[i].inputRate,
+        oldState.ilDivisors[i]));
     }
+
+    state.setIl(DxvkIlInfo(
+      oldState.ilAttributeCount,
+      oldState.ilBindingCount));
     
-    return expected.version   == actual.version
-        && expected.entrySize == actual.entrySize;
-  }
+    state.setRs(DxvkRsInfo(
+      oldState.rsDepthClampEnable,
+      oldState.rsDepthBiasEnable,
+      oldState.rsPolygonMode,
+      oldState.rsCullMode,
+      oldState.rsFrontFace,
+      oldState.rsViewportCount,
+      oldState.rsSampleCount));
+    
+    state.setMs(DxvkMsInfo(
+      oldState.msSampleCount,
+      oldState.msSampleMask,
+      oldState.msEnableAlphaToCoverage,
+      oldState.msEnableAlphaToOne));
+    
+    state.setDs(DxvkDsInfo(
+      oldState.dsEnableDepthTest,
+      oldState.dsEnableDepthWrite,
+      oldState.dsEnableStencilTest,
+      oldState.dsDepthCompareOp));
+    
+    state.setDsStencilOps(
+      DxvkDsStencilOp(oldState.dsStencilOpFront),
+      DxvkDsStencilOp(oldState.dsStencilOpBack));
+    
+    state.setOm(DxvkOmInfo(
+      oldState.omEnableLogicOp,
+      oldState.omLogicOp));
+    
+    for (uint32_t i = 0; i < DxvkLimits::MaxNumRenderTargets; i++) {
+      const VkPipelineColorBlendAttachmentState& blend = oldState.omBlendAttachments[i];
+
+      state.setOmBlend(i, DxvkOmAttachmentBlend(
+        blend.blendEnable,
+        blend.srcColorBlendFactor,
+        blend.dstColorBlendFactor,
+        blend.colorBlendOp,
+        blend.srcAlphaBlendFactor,
+        blend.dstAlphaBlendFactor,
+        blend.alphaBlendOp,
+        blend.colorWriteMask));
+      
+      state.setOmSwizzle(i, DxvkOmAttachmentSwizzle(
+        oldState.omComponentMapping[i]));
+    }
 
+    // The packed state only supports a subset of Vulkan
+    // enums and limits, so drop entries that do not fit.
+    // Stencil references are dynamic and not compared.
+    bool valid = state.ia.primitiveTopology() == oldState.iaPrimitiveTopology
+              && state.ia.primitiveRestart()  == oldState.iaPrimitiveRestart
+              && state.ia.patchVertexCount()  == oldState.iaPatchVertexCount
+              && state.rs.depthClampEnable()  == oldState.rsDepthClampEnable
+              && state.rs.depthBiasEnable()   == oldState.rsDepthBiasEnable
+              && state.rs.polygonMode()       == oldState.rsPolygonMode
+              && state.rs.cullMode()          == oldState.rsCullMode
+              && state.rs.frontFace()         == oldState.rsFrontFace
+              && state.rs.viewportCount()     == oldState.rsViewportCount
+              && state.rs.sampleCount()       == oldState.rsSampleCount
+              && state.ms.sampleCount()       == oldState.msSampleCount
+              && state.ms.enableAlphaToCoverage() == oldState.msEnableAlphaToCoverage
+              && state.ms.enableAlphaToOne()  == oldState.msEnableAlphaToOne
+              && state.ds.enableDepthTest()   == oldState.dsEnableDepthTest
+              && state.ds.enableDepthWrite()  == oldState.dsEnableDepthWrite
+              && state.ds.enableStencilTest() == oldState.dsEnableStencilTest
+              && state.ds.depthCompareOp()    == oldState.dsDepthCompareOp
+              && state.om.enableLogicOp()     == oldState.omEnableLogicOp
+              && state.om.logicOp()           == oldState.omLogicOp;
+    
+    for (uint32_t i = 0; i < oldState.ilAttributeCount && valid; i++) {
+      VkVertexInputAttributeDescription attribute = state.ilAttributes[i].description();
+      valid = !std::memcmp(&attribute, &oldState.ilAttributes[i], sizeof(attribute));
+    }
 
-  bool DxvkStateCache::readCacheEntry(
-          std::istream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
-    auto data = reinterpret_cast<char*>(&entry);
-    auto size = sizeof(DxvkStateCacheEntry);
+    for (uint32_t i = 0; i < oldState.ilBindingCount && valid; i++) {
+      VkVertexInputBindingDescription binding = state.ilBindings[i].description();
+      valid = !std::memcmp(&binding, &oldState.ilBindings[i], sizeof(binding));
+    }
+
+    VkStencilOpState stencilOps[2] = {
+      oldState.dsStencilOpFront,
+      oldState.dsStencilOpBack };
+    
+    stencilOps[0].reference = 0;
+    stencilOps[1].reference = 0;
 
-    if (!stream.read(data, size))
+    VkStencilOpState front = state.dsFront.state();
+    VkStencilOpState back  = state.dsBack.state();
+
+    valid &= !std::memcmp(&front, &stencilOps[0], sizeof(front))
+          && !std::memcmp(&back,  &stencilOps[1], sizeof(back));
+    
+    for (uint32_t i = 0; i < DxvkLimits::MaxNumRenderTargets && valid; i++) {
+      VkPipelineColorBlendAttachmentState blend   = state.omBlend[i].state();
+      VkComponentMapping                  swizzle = state.omSwizzle[i].mapping();
+
+      valid = !std::memcmp(&blend,   &oldState.omBlendAttachments[i], sizeof(blend))
+           && !std::memcmp(&swizzle, &oldState.omComponentMapping[i], sizeof(swizzle));
+    }
+
+    if (!valid)
       return false;
     
-    Sha1Hash expectedHash = std::exchange(entry.hash, g_nullHash);
-    Sha1Hash computedHash = Sha1Hash::compute(entry);
-    return expectedHash == computedHash;
+    newEntry.shaders = oldEntry.shaders;
+    newEntry.gpState = state;
+    newEntry.cpState = oldEntry.cpState;
+    newEntry.format  = oldEntry.format;
+    newEntry.hash    = g_nullHash;
+    return true;
+  }
+
+
+  size_t DxvkStateCache::getEntrySize(
+          uint32_t                  version) {
+    return version == 2
+      ? sizeof(DxvkStateCacheEntryV2)
+      : sizeof(DxvkStateCacheEntry);
+  }
+
+
+  void DxvkStateCache::writeCacheFile() {
+    // Gather all entries that we know of. Mapped entries have
+    // not been verified yet, so check a copy and write the
+    // original, which retains its checksum. In-memory entries
+    // need to have their checksum computed, since it gets
+    // cleared on verification.
+    std::vector<DxvkStateCacheEntry> entries;
+    entries.reserve(m_mappedIndex.entryCount + m_entries.size());
+
+    uint32_t numInvalidEntries = 0;
+
+    for (uint32_t i = 0; i < m_mappedIndex.entryCount; i++) {
+      DxvkStateCacheEntry copy = m_mappedEntries[i];
+
+      if (verifyCacheEntry(copy))
+        entries.push_back(m_mappedEntries[i]);
+      else
+        numInvalidEntries += 1;
+    }
+
+    if (numInvalidEntries) {
+      Logger::warn(str::format(
+        "DXVK: Removed ", numInvalidEntries,
+        " invalid state cache entries"));
+    }
+
+    for (DxvkStateCacheEntry entry : m_entries) {
+      entry.hash = Sha1Hash::compute(entry);
+      entries.push_back(entry);
+    }
+
+    size_t numDuplicates = compactEntries(entries);
+
+    // The file must not be mapped while truncating it
+    clearCacheEntries();
+
+    std::ofstream file(getCacheFileName(),
+      std::ios_base::binary | std::ios_base::trunc);
+    
+    if (!file || !writeEntries(file, entries)) {
+      Logger::warn("DXVK: Failed to write state cache file");
+    } else {
+      Logger::info(str::format("DXVK: Wrote ", entries.size(),
+        " state cache entries, removed ", numDuplicates, " duplicates"));
+    }
+
+    file.close();
+
+    // Map the new file. If writing failed, this will
+    // restore whatever entries are still available.
+    readCacheFile();
+  }
+
+
+  void DxvkStateCache::clearCacheEntries() {
+    m_mapping.close();
+
+    m_mappedIndex     = DxvkStateCacheIndexHeader();
+    m_mappedPipelines = nullptr;
+    m_mappedShaders   = nullptr;
+    m_mappedEntries   = nullptr;
+
+    m_entries.clear();
+    m_entryMap.clear();
+    m_pipelineMap.clear();
   }
 
 
@@ -378,8 +842,19 @@ namespace dxvk {
         if (m_workerQueue.size() == 0)
           break;
         
-        item = m_workerQueue.front();
+        WorkerEntry entry = m_workerQueue.top();
         m_workerQueue.pop();
+
+        // Skip entries for items that have already
+        // been processed after getting prioritized
+        auto pos = m_workerItems.find(entry.key);
+
+        if (pos == m_workerItems.end())
+          continue;
+        
+        item = std::move(pos->second);
+        m_workerItems.erase(pos);
+        m_numPendingItems -= 1;
       }
 
       compilePipelines(item);
@@ -412,6 +887,150 @@ namespace dxvk {
   }
 
 
+  bool DxvkStateCache::readEntries(
+          std::istream&             stream,
+          std::vector<DxvkStateCacheEntry>& entries) {
+    DxvkStateCacheHeader expected;
+    DxvkStateCacheHeader actual;
+
+    if (!stream.read(reinterpret_cast<char*>(&actual), sizeof(actual))
+     || std::memcmp(expected.magic, actual.magic, sizeof(actual.magic))
+     || (actual.version != 2 && actual.version != expected.version)
+     || getEntrySize(actual.version) != actual.entrySize)
+      return false;
+    
+    // Skip the index, indexed entries and appended
+    // entries are stored consecutively in the file
+    if (actual.version == expected.version) {
+      DxvkStateCacheIndexHeader index;
+
+      if (!stream.read(reinterpret_cast<char*>(&index), sizeof(index)))
+        return false;
+      
+      stream.ignore(std::streamsize(
+        uint64_t(index.pipelineCount) * sizeof(DxvkStateCachePipelineIndex) +
+        uint64_t(index.shaderCount)   * sizeof(DxvkStateCacheShaderIndex)));
+    }
+
+    std::vector<char> data(actual.entrySize);
+    uint32_t numInvalidEntries = 0;
+
+    while (stream) {
+      if (!stream.read(data.data(), data.size())) {
+        numInvalidEntries += stream.gcount() != 0;
+        break;
+      }
+
+      DxvkStateCacheEntry entry;
+
+      if (!readCacheEntry(actual.version, data.data(), entry)) {
+        numInvalidEntries += 1;
+        continue;
+      }
+
+      // Verification clears the checksum. Current entries
+      // retain their original one, converted entries need
+      // a new one.
+      if (actual.version == expected.version)
+        std::memcpy(reinterpret_cast<void*>(&entry), data.data(), sizeof(entry));
+      else
+        entry.hash = Sha1Hash::compute(entry);
+      
+      entries.push_back(entry);
+    }
+
+    if (numInvalidEntries) {
+      Logger::warn(str::format(
+        "DXVK: Skipped ", numInvalidEntries,
+        " invalid state cache entries"));
+    }
+
+    return true;
+  }
+
+
+  size_t DxvkStateCache::compactEntries(
+          std::vector<DxvkStateCacheEntry>& entries) {
+    // Sort by pipeline first, so that entries for the same
+    // shaders end up next to each other, and by checksum
+    // second so that duplicate entries are adjacent.
+    std::vector<uint32_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    std::stable_sort(order.begin(), order.end(),
+      [&entries] (uint32_t a, uint32_t b) {
+        int cmp = comparePipelineKeys(entries[a].shaders, entries[b].shaders);
+
+        if (cmp == 0)
+          cmp = std::memcmp(&entries[a].hash, &entries[b].hash, sizeof(Sha1Hash));
+
+        return cmp < 0;
+      });
+    
+    std::vector<DxvkStateCacheEntry> result;
+    result.reserve(entries.size());
+
+    for (uint32_t entryId : order) {
+      if (result.empty() || !(result.back().hash == entries[entryId].hash))
+        result.push_back(entries[entryId]);
+    }
+
+    size_t numDuplicates = entries.size() - result.size();
+    entries = std::move(result);
+    return numDuplicates;
+  }
+
+
+  bool DxvkStateCache::writeEntries(
+          std::ostream&             stream,
+    const std::vector<DxvkStateCacheEntry>& entries) {
+    std::vector<DxvkStateCachePipelineIndex> pipelines;
+
+    for (uint32_t i = 0; i < entries.size(); i++) {
+      const DxvkStateCacheKey& key = entries[i].shaders;
+
+      if (pipelines.empty() || comparePipelineKeys(pipelines.back().shaders, key))
+        pipelines.push_back({ key, i, 0 });
+      
+      pipelines.back().entryCount += 1;
+    }
+
+    std::vector<DxvkStateCacheShaderIndex> shaders;
+
+    for (uint32_t i = 0; i < pipelines.size(); i++) {
+      const DxvkStateCacheKey& key = pipelines[i].shaders;
+
+      for (const DxvkShaderKey* shader : { &key.vs, &key.tcs, &key.tes, &key.gs, &key.fs, &key.cs }) {
+        if (!shader->eq(g_nullShaderKey))
+          shaders.push_back({ *shader, i, 0 });
+      }
+    }
+
+    std::stable_sort(shaders.begin(), shaders.end(),
+      [] (const DxvkStateCacheShaderIndex& a, const DxvkStateCacheShaderIndex& b) {
+        return compareShaderKeys(a.shader, b.shader) < 0;
+      });
+    
+    DxvkStateCacheHeader      header;
+    DxvkStateCacheIndexHeader index;
+    index.pipelineCount = pipelines.size();
+    index.shaderCount   = shaders.size();
+    index.entryCount    = entries.size();
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&index),  sizeof(index));
+
+    stream.write(reinterpret_cast<const char*>(pipelines.data()),
+      pipelines.size() * sizeof(DxvkStateCachePipelineIndex));
+    stream.write(reinterpret_cast<const char*>(shaders.data()),
+      shaders.size() * sizeof(DxvkStateCacheShaderIndex));
+    stream.write(reinterpret_cast<const char*>(entries.data()),
+      entries.size() * sizeof(DxvkStateCacheEntry));
+    
+    return bool(stream.flush());
+  }
+
+
   std::string DxvkStateCache::getCacheFileName() const {
     std::string path = env::getEnvVar(L"DXVK_STATE_CACHE_PATH");
 
@@ -11,6 +11,8 @@
 #include "dxvk_pipemanager.h"
 #include "dxvk_renderpass.h"
 
+#include "../util/util_file_map.h"
+
 namespace dxvk {
 
   /**
@@ -51,22 +53,138 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Legacy graphics pipeline state info
+   * 
+   * Graphics pipeline state vector as stored in
+   * version 2 cache files, before it was packed.
+   * Only used to convert old cache files.
+   */
+  struct DxvkGraphicsPipelineStateInfoV2 {
+    DxvkBindingMask                     bsBindingMask;
+    
+    VkPrimitiveTopology                 iaPrimitiveTopology;
+    VkBool32                            iaPrimitiveRestart;
+    uint32_t                            iaPatchVertexCount;
+    
+    uint32_t                            ilAttributeCount;
+    uint32_t                            ilBindingCount;
+    VkVertexInputAttributeDescription   ilAttributes[DxvkLimits::MaxNumVertexAttributes];
+    VkVertexInputBindingDescription     ilBindings[DxvkLimits::MaxNumVertexBindings];
+    uint32_t                            ilDivisors[DxvkLimits::MaxNumVertexBindings];
+    
+    VkBool32                            rsDepthClampEnable;
+    VkBool32                            rsDepthBiasEnable;
+    VkPolygonMode                       rsPolygonMode;
+    VkCullModeFlags                     rsCullMode;
+    VkFrontFace                         rsFrontFace;
+    uint32_t                            rsViewportCount;
+    VkSampleCountFlags                  rsSampleCount;
+    
+    VkSampleCountFlags                  msSampleCount;
+    uint32_t                            msSampleMask;
+    VkBool32                            msEnableAlphaToCoverage;
+    VkBool32                            msEnableAlphaToOne;
+    
+    VkBool32                            dsEnableDepthTest;
+    VkBool32                            dsEnableDepthWrite;
+    VkBool32                            dsEnableStencilTest;
+    VkCompareOp                         dsDepthCompareOp;
+    VkStencilOpState                    dsStencilOpFront;
+    VkStencilOpState                    dsStencilOpBack;
+    
+    VkBool32                            omEnableLogicOp;
+    VkLogicOp                           omLogicOp;
+    VkPipelineColorBlendAttachmentState omBlendAttachments[DxvkLimits::MaxNumRenderTargets];
+    VkComponentMapping                  omComponentMapping[DxvkLimits::MaxNumRenderTargets];
+  };
+
+
+  /**
+   * \brief Legacy state entry
+   * 
+   * Entry layout of version 2 cache files. Entries
+   * get converted to the current layout on load.
+   */
+  struct DxvkStateCacheEntryV2 {
+    DxvkStateCacheKey               shaders;
+    DxvkGraphicsPipelineStateInfoV2 gpState;
+    DxvkComputePipelineStateInfo    cpState;
+    DxvkRenderPassFormat            format;
+    Sha1Hash                        hash;
+  };
+
+
   /**
    * \brief State cache header
    * 
    * Stores the state cache format version. If an
    * existing cache file is incompatible to the
    * current version, it will be discarded.
+   * 
+   * Version 2 files store a plain list of entries,
+   * which are converted to the current format.
+   * Version 3 files store an index header, followed
+   * by the pipeline index, the shader index, all
+   * indexed entries grouped by pipeline, and then
+   * any entries that were appended since the index
+   * was last written.
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 2;
+    uint32_t version    = 3;
     uint32_t entrySize  = sizeof(DxvkStateCacheEntry);
   };
 
   static_assert(sizeof(DxvkStateCacheHeader) == 12);
 
 
+  /**
+   * \brief State cache index header
+   * 
+   * Follows the file header in version 3 files
+   * and stores the size of the index tables.
+   */
+  struct DxvkStateCacheIndexHeader {
+    uint32_t pipelineCount  = 0;
+    uint32_t shaderCount    = 0;
+    uint32_t entryCount     = 0;
+  };
+
+  static_assert(sizeof(DxvkStateCacheIndexHeader) == 12);
+
+
+  /**
+   * \brief Pipeline index entry
+   * 
+   * Maps a set of shader keys to a range of
+   * consecutive entries. Sorted by shader keys
+   * in byte order, so that it can be searched.
+   */
+  struct DxvkStateCachePipelineIndex {
+    DxvkStateCacheKey shaders;
+    uint32_t          entryIndex;
+    uint32_t          entryCount;
+  };
+
+  static_assert(sizeof(DxvkStateCachePipelineIndex) == 152);
+
+
+  /**
+   * \brief Shader index entry
+   * 
+   * Maps a shader key to a pipeline that uses the
+   * shader. Sorted by shader key in byte order.
+   */
+  struct DxvkStateCacheShaderIndex {
+    DxvkShaderKey     shader;
+    uint32_t          pipelineIndex;
+    uint32_t          reserved;
+  };
+
+  static_assert(sizeof(DxvkStateCacheShaderIndex) == 32);
+
+
   /**
    * \brief State cache
    * 
@@ -123,6 +241,71 @@ namespace dxvk {
     void registerShader(
       const Rc<DxvkShader>&                 shader);
 
+    /**
+     * \brief Prioritizes pipelines for a shader set
+     * 
+     * Moves any queued pipelines using the given set
+     * of shaders to the front of the compiler queue.
+     * Used when a draw is waiting on a pipeline that
+     * has not been compiled yet.
+     * \param [in] shaders Shader keys
+     */
+    void prioritizePipeline(
+      const DxvkStateCacheKey&              shaders);
+
+    /**
+     * \brief Queries compiler progress
+     * 
+     * Counts are in state cache entries. Once the sum
+     * of compiled and failed entries reaches the number
+     * of queued entries, all pipelines for which shaders
+     * are currently available have been compiled.
+     * \returns State cache compiler statistics
+     */
+    DxvkStateCacheStats getStats() const;
+
+    /**
+     * \brief Reads all entries from a cache file
+     * 
+     * Supports both version 2 and version 3 files.
+     * Entries that fail verification are skipped.
+     * Returned entries retain their checksum, except
+     * for converted version 2 entries, which get a
+     * new checksum.
+     * \param [in] stream Input stream
+     * \param [out] entries Valid cache entries
+     * \returns \c false if the file header is invalid
+     */
+    static bool readEntries(
+            std::istream&                     stream,
+            std::vector<DxvkStateCacheEntry>& entries);
+
+    /**
+     * \brief Compacts a list of cache entries
+     * 
+     * Sorts entries by their shader keys, so that all
+     * entries for a pipeline are adjacent, and removes
+     * entries with identical checksums. Entries must
+     * have valid checksums.
+     * \param [in,out] entries Cache entries
+     * \returns Number of duplicate entries removed
+     */
+    static size_t compactEntries(
+            std::vector<DxvkStateCacheEntry>& entries);
+
+    /**
+     * \brief Writes an indexed cache file
+     * 
+     * Writes a version 3 cache file, including the index.
+     * Entries must have been compacted before this call.
+     * \param [in] stream Output stream
+     * \param [in] entries Compacted cache entries
+     * \returns \c true on success
+     */
+    static bool writeEntries(
+            std::ostream&                     stream,
+      const std::vector<DxvkStateCacheEntry>& entries);
+
   private:
 
     using WriterItem = DxvkStateCacheEntry;
@@ -136,9 +319,38 @@ namespace dxvk {
       Rc<DxvkShader> cs;
     };
 
+    /* Items are processed in order of decreasing priority.
+     * The priority is a sequence number, so that pipelines
+     * for recently registered shaders run first, and
+     * pipelines that a draw is waiting on get the top bit
+     * set. Bumping an item pushes another queue entry for
+     * it, stale entries are skipped by the workers. */
+    struct WorkerEntry {
+      uint64_t          priority;
+      DxvkStateCacheKey key;
+
+      bool operator < (const WorkerEntry& other) const {
+        return priority < other.priority;
+      }
+    };
+
+    static constexpr uint64_t UrgentPriority = 1ull << 63;
+
     DxvkPipelineManager*              m_pipeManager;
     DxvkRenderPassPool*               m_passManager;
 
+    /* Index and entries of a version 3 cache file.
+     * The mapped data is immutable and therefore
+     * does not require any locking. Entries get
+     * verified when they are used. */
+    FileMapping                         m_mapping;
+    const DxvkStateCachePipelineIndex*  m_mappedPipelines = nullptr;
+    const DxvkStateCacheShaderIndex*    m_mappedShaders   = nullptr;
+    const DxvkStateCacheEntry*          m_mappedEntries   = nullptr;
+    DxvkStateCacheIndexHeader           m_mappedIndex;
+
+    /* Entries that are not part of the index,
+     * such as entries appended to the file. */
     std::vector<DxvkStateCacheEntry>  m_entries;
     std::atomic<bool>                 m_stopThreads = { false };
 
@@ -158,9 +370,19 @@ namespace dxvk {
 
     std::mutex                        m_workerLock;
     std::condition_variable           m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
+    std::priority_queue<WorkerEntry>  m_workerQueue;
+    uint64_t                          m_workerSeq = 0;
     std::vector<dxvk::thread>         m_workerThreads;
 
+    std::unordered_map<
+      DxvkStateCacheKey, WorkerItem,
+      DxvkHash, DxvkEq> m_workerItems;
+    std::atomic<uint32_t>             m_numPendingItems = { 0 };
+
+    std::atomic<uint32_t>             m_numQueued   = { 0 };
+    std::atomic<uint32_t>             m_numCompiled = { 0 };
+    std::atomic<uint32_t>             m_numFailed   = { 0 };
+
     std::mutex                        m_writerLock;
     std::condition_variable           m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
@@ -182,17 +404,56 @@ namespace dxvk {
       const DxvkShaderKey&            shader,
       const DxvkStateCacheKey&        key);
 
+    void queuePipeline(
+      const DxvkStateCacheKey&        key,
+            std::unique_lock<std::mutex>& workerLock);
+
+    const DxvkStateCachePipelineIndex* findMappedPipeline(
+      const DxvkStateCacheKey&        key) const;
+
+    uint32_t getEntryCount(
+      const DxvkStateCacheKey&        key) const;
+
+    void getEntries(
+      const DxvkStateCacheKey&        key,
+            std::vector<DxvkStateCacheEntry>& entries);
+
     void compilePipelines(
       const WorkerItem&               item);
 
+    void countPipeline(
+            bool                      success);
+
     bool readCacheFile();
 
-    bool readCacheHeader(
-            std::istream&             stream) const;
+    bool readCacheIndex(
+      const char*                     data,
+            size_t                    size,
+            size_t&                   offset);
 
-    bool readCacheEntry(
-            std::istream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
+    bool readCacheEntries(
+            uint32_t                  version,
+      const char*                     data,
+            size_t                    size);
+
+    static bool readCacheEntry(
+            uint32_t                  version,
+      const char*                     data,
+            DxvkStateCacheEntry&      entry);
+
+    static bool verifyCacheEntry(
+            DxvkStateCacheEntry&      entry);
+
+    static bool convertCacheEntry(
+      const DxvkStateCacheEntryV2&    oldEntry,
+            DxvkStateCacheEntry&      newEntry);
+
+    static size_t getEntrySize(
+            uint32_t                  version);
+
+    void writeCacheFile();
+    
+    void clearCacheEntries();
     
     void writeCacheEntry(
             std::ostream&             stream, 
@@ -14,11 +14,20 @@ namespace dxvk {
     CmdDrawCalls,             ///< Number of draw calls
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
+    CmdSkippedDrawCalls,      ///< Number of draws skipped due to pending pipelines
+    CmdBarrierCount,          ///< Number of buffer and image barriers
     MemoryAllocationCount,    ///< Number of memory allocations
     MemoryAllocated,          ///< Amount of memory allocated
     MemoryUsed,               ///< Amount of memory used
+    MemoryChunkCount,         ///< Number of device memory chunks
+    MemoryFragmentation,      ///< Fragmentation of free chunk memory, in percent
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
+    StateCacheQueued,         ///< Number of state cache entries queued for compilation
+    StateCacheCompiled,       ///< Number of state cache entries compiled
+    StateCacheFailed,         ///< Number of state cache entries that failed to compile
+    FramebufferCacheHits,     ///< Number of framebuffers found in the framebuffer cache
+    FramebufferCacheMisses,   ///< Number of framebuffers created by the framebuffer cache
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     NumCounters,              ///< Number of counters available
@@ -0,0 +1,120 @@
+#include "dxvk_timing.h"
+
+namespace dxvk {
+
+  const std::array<const char*, uint32_t(DxvkTimingStage::NumStages)> g_timingStageNames = {{
+    "app_us",
+    "present_us",
+    "cs_us",
+    "pipeline_us",
+    "submit_us",
+    "gpu_us",
+  }};
+
+
+  DxvkTimingTracker::DxvkTimingTracker()
+  : m_frameEnd(Clock::now()) {
+    for (auto& stage : m_stages)
+      stage.store(0);
+
+    std::string traceFile = env::getEnvVar(L"DXVK_TIMING_TRACE");
+
+    if (!traceFile.empty())
+      this->openTraceFile(traceFile);
+  }
+
+
+  DxvkTimingTracker::~DxvkTimingTracker() {
+
+  }
+
+
+  void DxvkTimingTracker::endFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    TimePoint now = Clock::now();
+
+    DxvkFrameTiming timing;
+    timing.frameId   = m_frameCount;
+    timing.frameTime = std::chrono::duration_cast<std::chrono::microseconds>(now - m_frameEnd).count();
+
+    for (uint32_t i = 0; i < timing.stages.size(); i++)
+      timing.stages[i] = m_stages[i].exchange(0, std::memory_order_relaxed) / 1000;
+
+    // The application's own time is not measured directly,
+    // but everything outside the present call counts as such
+    uint64_t& appTime     = timing.stages[uint32_t(DxvkTimingStage::AppThread)];
+    uint64_t  presentTime = timing.getStage(DxvkTimingStage::Present);
+
+    appTime += timing.frameTime > presentTime
+      ? timing.frameTime - presentTime
+      : 0;
+
+    m_frames[m_frameCount % MaxFrames] = timing;
+    m_frameCount += 1;
+    m_frameEnd    = now;
+
+    if (m_traceFile.is_open())
+      this->writeTrace(timing);
+  }
+
+
+  uint32_t DxvkTimingTracker::getFrameTimings(
+          uint32_t                count,
+          DxvkFrameTiming*        timings) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    count = uint32_t(std::min<uint64_t>(count, std::min<uint64_t>(m_frameCount, MaxFrames)));
+
+    for (uint32_t i = 0; i < count; i++)
+      timings[i] = m_frames[(m_frameCount - count + i) % MaxFrames];
+
+    return count;
+  }
+
+
+  void DxvkTimingTracker::openTraceFile(
+    const std::string&            fileName) {
+    m_traceBinary = fileName.size() >= 4
+      && fileName.compare(fileName.size() - 4, 4, ".bin") == 0;
+
+    m_traceFile = std::ofstream(fileName, m_traceBinary
+      ? std::ios_base::binary | std::ios_base::trunc
+      : std::ios_base::trunc);
+
+    if (!m_traceFile) {
+      Logger::err(str::format("DXVK: Failed to open timing trace file ", fileName));
+      return;
+    }
+
+    Logger::info(str::format("DXVK: Writing timing trace to ", fileName));
+
+    if (m_traceBinary) {
+      DxvkTimingTraceHeader header;
+      m_traceFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    } else {
+      m_traceFile << "frame,frame_us";
+
+      for (const char* name : g_timingStageNames)
+        m_traceFile << "," << name;
+
+      m_traceFile << "\n";
+    }
+  }
+
+
+  void DxvkTimingTracker::writeTrace(
+    const DxvkFrameTiming&        timing) {
+    if (m_traceBinary) {
+      m_traceFile.write(reinterpret_cast<const char*>(&timing), sizeof(timing));
+    } else {
+      m_traceFile << timing.frameId << "," << timing.frameTime;
+
+      for (uint64_t stage : timing.stages)
+        m_traceFile << "," << stage;
+
+      m_traceFile << "\n";
+    }
+  }
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Timing stages
+   *
+   * Enumerates the stages for which the time spent
+   * per frame is tracked. Stages may run in parallel
+   * on different threads, so their sum does not have
+   * to match the total frame time.
+   */
+  enum class DxvkTimingStage : uint32_t {
+    AppThread,                ///< Application time between present calls
+    Present,                  ///< Time spent in the present call, including frame pacing
+    CsThread,                 ///< Time spent executing commands on the CS thread
+    PipelineCompile,          ///< Time spent compiling pipelines, on any thread
+    QueueSubmit,              ///< Time spent submitting command buffers
+    GpuExecution,             ///< Estimated time the GPU spent executing command buffers
+    NumStages,                ///< Number of stages
+  };
+
+
+  /**
+   * \brief Frame timing
+   *
+   * Timings for a single frame. All
+   * times are given in microseconds.
+   */
+  struct DxvkFrameTiming {
+    uint64_t frameId   = 0;
+    uint64_t frameTime = 0;
+    std::array<uint64_t, uint32_t(DxvkTimingStage::NumStages)> stages = { };
+
+    uint64_t getStage(DxvkTimingStage stage) const {
+      return stages[uint32_t(stage)];
+    }
+  };
+
+
+  /**
+   * \brief Binary timing trace header
+   *
+   * Binary trace files consist of this header,
+   * followed by one \ref DxvkFrameTiming per frame.
+   */
+  struct DxvkTimingTraceHeader {
+    char     magic[4]   = { 'D', 'X', 'T', 'T' };
+    uint32_t version    = 1;
+    uint32_t stageCount = uint32_t(DxvkTimingStage::NumStages);
+    uint32_t reserved   = 0;
+  };
+
+
+  /**
+   * \brief Timing tracker
+   *
+   * Accumulates the time spent in each stage from any
+   * thread, and stores per-frame timings in a ring buffer
+   * whenever a frame is presented. If \c DXVK_TIMING_TRACE
+   * is set to a file name, frame timings are also written
+   * to that file, as CSV or, if the file name ends with
+   * \c .bin, in a binary format.
+   */
+  class DxvkTimingTracker : public RcObject {
+
+  public:
+
+    using Clock     = std::chrono::high_resolution_clock;
+    using TimePoint = typename Clock::time_point;
+
+    constexpr static uint32_t MaxFrames = 256;
+
+    DxvkTimingTracker();
+    ~DxvkTimingTracker();
+
+    /**
+     * \brief Adds time to a stage
+     *
+     * Thread-safe. The time will be added
+     * to the frame that is currently active.
+     * \param [in] stage The stage
+     * \param [in] duration Time spent in the stage
+     */
+    void addTime(
+            DxvkTimingStage         stage,
+            Clock::duration         duration) {
+      m_stages[uint32_t(stage)].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+        std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Finishes the current frame
+     *
+     * Stores the times accumulated since the previous
+     * call in the ring buffer and writes them to the
+     * trace file. Should be called once per present,
+     * after the present stage has been recorded.
+     */
+    void endFrame();
+
+    /**
+     * \brief Retrieves recent frame timings
+     *
+     * \param [in] count Maximum number of frames
+     * \param [out] timings Frame timings, oldest first
+     * \returns Number of frames written to \c timings
+     */
+    uint32_t getFrameTimings(
+            uint32_t                count,
+            DxvkFrameTiming*        timings) const;
+
+  private:
+
+    // Accumulated in nanoseconds, so that short
+    // samples are not truncated to zero
+    std::array<std::atomic<uint64_t>,
+      uint32_t(DxvkTimingStage::NumStages)> m_stages;
+
+    mutable std::mutex  m_mutex;
+
+    std::array<DxvkFrameTiming, MaxFrames> m_frames;
+    uint64_t            m_frameCount = 0;
+    TimePoint           m_frameEnd;
+
+    std::ofstream       m_traceFile;
+    bool                m_traceBinary = false;
+
+    void openTraceFile(
+      const std::string&            fileName);
+
+    void writeTrace(
+      const DxvkFrameTiming&        timing);
+
+  };
+
+
+  /**
+   * \brief Scoped stage timer
+   *
+   * Adds the time between construction and
+   * destruction of the object to the stage.
+   */
+  class DxvkTimingScope {
+
+  public:
+
+    DxvkTimingScope(
+            DxvkTimingTracker*      tracker,
+            DxvkTimingStage         stage)
+    : m_tracker (tracker),
+      m_stage   (stage),
+      m_start   (DxvkTimingTracker::Clock::now()) { }
+
+    ~DxvkTimingScope() {
+      m_tracker->addTime(m_stage,
+        DxvkTimingTracker::Clock::now() - m_start);
+    }
+
+    DxvkTimingScope             (const DxvkTimingScope&) = delete;
+    DxvkTimingScope& operator = (const DxvkTimingScope&) = delete;
+
+  private:
+
+    DxvkTimingTracker*              m_tracker;
+    DxvkTimingStage                 m_stage;
+    DxvkTimingTracker::TimePoint    m_start;
+
+  };
+
+}
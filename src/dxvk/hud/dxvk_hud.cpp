@@ -14,7 +14,9 @@ namespace dxvk::hud {
     m_renderer      (device),
     m_hudDeviceInfo (device),
     m_hudFramerate  (config.elements),
-    m_hudStats      (config.elements) {
+    m_hudStats      (config.elements),
+    m_hudPacing     (config.elements),
+    m_hudTimings    (config.elements) {
     // Set up constant state
     m_rsState.polygonMode        = VK_POLYGON_MODE_FILL;
     m_rsState.cullMode           = VK_CULL_MODE_BACK_BIT;
@@ -47,6 +49,13 @@ namespace dxvk::hud {
   void Hud::update() {
     m_hudFramerate.update();
     m_hudStats.update(m_device);
+    m_hudPacing.update(m_pacer);
+    m_hudTimings.update(m_device);
+  }
+  
+  
+  void Hud::setFramePacer(const Rc<DxvkFramePacer>& pacer) {
+    m_pacer = pacer;
   }
   
   
@@ -99,6 +108,8 @@ namespace dxvk::hud {
     
     position = m_hudFramerate.render(ctx, m_renderer, position);
     position = m_hudStats    .render(ctx, m_renderer, position);
+    position = m_hudPacing   .render(ctx, m_renderer, position);
+    position = m_hudTimings  .render(ctx, m_renderer, position);
   }
   
   
@@ -7,8 +7,10 @@
 #include "dxvk_hud_config.h"
 #include "dxvk_hud_devinfo.h"
 #include "dxvk_hud_fps.h"
+#include "dxvk_hud_pacing.h"
 #include "dxvk_hud_renderer.h"
 #include "dxvk_hud_stats.h"
+#include "dxvk_hud_timings.h"
 
 namespace dxvk::hud {
   
@@ -44,6 +46,17 @@ namespace dxvk::hud {
      */
     void update();
 
+    /**
+     * \brief Sets frame pacer
+     * 
+     * The frame pacer's statistics will be
+     * displayed if the \c pacing element
+     * is enabled.
+     * \param [in] pacer Frame pacer
+     */
+    void setFramePacer(
+      const Rc<DxvkFramePacer>& pacer);
+
     /**
      * \brief Render HUD
      * 
@@ -70,6 +83,7 @@ namespace dxvk::hud {
     
     const HudConfig       m_config;
     const Rc<DxvkDevice>  m_device;
+    Rc<DxvkFramePacer>    m_pacer;
     
     Rc<DxvkBuffer>        m_uniformBuffer;
 
@@ -80,6 +94,8 @@ namespace dxvk::hud {
     HudDeviceInfo         m_hudDeviceInfo;
     HudFps                m_hudFramerate;
     HudStats              m_hudStats;
+    HudFramePacing        m_hudPacing;
+    HudTimings            m_hudTimings;
 
     void setupRendererState(
       const Rc<DxvkContext>&  ctx);
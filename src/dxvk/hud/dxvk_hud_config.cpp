@@ -13,6 +13,8 @@ namespace dxvk::hud {
     { "pipelines",    HudElement::StatPipelines     },
     { "memory",       HudElement::StatMemory        },
     { "version",      HudElement::DxvkVersion       },
+    { "pacing",       HudElement::FramePacing       },
+    { "timings",      HudElement::Timings           },
   }};
   
   
@@ -19,6 +19,8 @@ namespace dxvk::hud {
     StatPipelines     = 5,
     StatMemory        = 6,
     DxvkVersion       = 7,
+    FramePacing       = 8,
+    Timings           = 9,
   };
   
   using HudElements = Flags<HudElement>;
@@ -0,0 +1,63 @@
+#include "dxvk_hud_pacing.h"
+
+namespace dxvk::hud {
+  
+  HudFramePacing::HudFramePacing(HudElements elements)
+  : m_elements(elements) { }
+  
+  
+  HudFramePacing::~HudFramePacing() {
+    
+  }
+  
+  
+  void HudFramePacing::update(const Rc<DxvkFramePacer>& pacer) {
+    m_enabled = m_elements.test(HudElement::FramePacing)
+             && pacer != nullptr;
+    
+    if (m_enabled) {
+      m_options = pacer->options();
+      m_stats   = pacer->stats();
+    }
+  }
+  
+  
+  HudPos HudFramePacing::render(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    if (!m_enabled)
+      return position;
+    
+    const std::string strLimit = m_options.maxFrameRate != 0
+      ? str::format("Frame limit:   ", m_options.maxFrameRate, " FPS")
+      : str::format("Frame limit:   none");
+    
+    const std::string strMode     = str::format("Low latency:   ", m_options.lowLatency ? "on" : "off");
+    const std::string strCpuTime  = str::format("CPU time:      ", formatTime(m_stats.cpuTime));
+    const std::string strGpuTime  = str::format("GPU time:      ", formatTime(m_stats.gpuTime));
+    const std::string strWaitTime = str::format("Wait / sleep:  ", formatTime(m_stats.waitTime), " / ", formatTime(m_stats.sleepTime));
+    const std::string strLatency  = str::format("GPU latency:   ", formatTime(m_stats.latency));
+    
+    const std::array<const std::string*, 6> lines = {{
+      &strLimit, &strMode, &strCpuTime,
+      &strGpuTime, &strWaitTime, &strLatency,
+    }};
+    
+    for (size_t i = 0; i < lines.size(); i++) {
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + 20.0f * float(i) },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        *lines[i]);
+    }
+    
+    return { position.x, position.y + 20.0f * float(lines.size()) + 4.0f };
+  }
+  
+  
+  std::string HudFramePacing::formatTime(float ms) {
+    const int64_t value = int64_t(ms * 10.0f + 0.5f);
+    return str::format(value / 10, ".", value % 10, " ms");
+  }
+  
+}
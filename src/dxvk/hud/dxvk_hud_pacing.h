@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../dxvk_frame_pacer.h"
+
+#include "dxvk_hud_config.h"
+#include "dxvk_hud_renderer.h"
+
+namespace dxvk::hud {
+  
+  /**
+   * \brief Frame pacing display for the HUD
+   * 
+   * Displays the frame rate limit and latency
+   * mode, as well as the CPU and GPU frame times
+   * and the latency measured by the frame pacer.
+   */
+  class HudFramePacing {
+    
+  public:
+    
+    HudFramePacing(HudElements elements);
+    ~HudFramePacing();
+    
+    void update(
+      const Rc<DxvkFramePacer>& pacer);
+    
+    HudPos render(
+      const Rc<DxvkContext>&  context,
+            HudRenderer&      renderer,
+            HudPos            position);
+    
+  private:
+    
+    const HudElements     m_elements;
+    
+    bool                  m_enabled = false;
+    DxvkFramePacerOptions m_options;
+    DxvkFramePacerStats   m_stats;
+    
+    static std::string formatTime(float ms);
+    
+  };
+  
+}
@@ -20,6 +20,8 @@ namespace dxvk::hud {
     DxvkStatCounters nextCounters = device->getStatCounters();
     m_diffCounters = nextCounters.diff(m_prevCounters);
     m_prevCounters = nextCounters;
+    
+    m_asyncEnabled = device->config().enableAsync;
   }
   
   
@@ -52,10 +54,12 @@ namespace dxvk::hud {
     const uint64_t gpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdDrawCalls)       / frameCount;
     const uint64_t cpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdDispatchCalls)   / frameCount;
     const uint64_t rpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdRenderPassCount) / frameCount;
+    const uint64_t barriers = m_diffCounters.getCtr(DxvkStatCounter::CmdBarrierCount)   / frameCount;
     
     const std::string strDrawCalls      = str::format("Draw calls:     ", gpCalls);
     const std::string strDispatchCalls  = str::format("Dispatch calls: ", cpCalls);
     const std::string strRenderPasses   = str::format("Render passes:  ", rpCalls);
+    const std::string strBarriers       = str::format("Barriers:       ", barriers);
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -72,7 +76,12 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strRenderPasses);
     
-    return { position.x, position.y + 64 };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 60.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strBarriers);
+    
+    return { position.x, position.y + 84 };
   }
   
   
@@ -114,7 +123,43 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strCpCount);
     
-    return { position.x, position.y + 44.0f };
+    float y = position.y + 40.0f;
+    
+    if (m_asyncEnabled) {
+      const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
+      const uint64_t skipCount  = m_diffCounters.getCtr(DxvkStatCounter::CmdSkippedDrawCalls) / frameCount;
+      
+      const std::string strSkipCount = str::format("Skipped draws:      ", skipCount);
+      
+      renderer.drawText(context, 16.0f,
+        { position.x, y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strSkipCount);
+      
+      y += 20.0f;
+    }
+    
+    // Only show state cache progress while pipelines are
+    // being compiled, or if some of them failed to compile
+    const uint64_t scQueued   = m_prevCounters.getCtr(DxvkStatCounter::StateCacheQueued);
+    const uint64_t scCompiled = m_prevCounters.getCtr(DxvkStatCounter::StateCacheCompiled);
+    const uint64_t scFailed   = m_prevCounters.getCtr(DxvkStatCounter::StateCacheFailed);
+    
+    if (scQueued > scCompiled + scFailed || scFailed) {
+      std::string strStateCache = str::format("State cache:        ", scCompiled + scFailed, " / ", scQueued);
+      
+      if (scFailed)
+        strStateCache += str::format(" (", scFailed, " failed)");
+      
+      renderer.drawText(context, 16.0f,
+        { position.x, y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strStateCache);
+      
+      y += 20.0f;
+    }
+    
+    return { position.x, y + 4.0f };
   }
   
   
@@ -127,8 +172,12 @@ namespace dxvk::hud {
     const uint64_t memAllocated = m_prevCounters.getCtr(DxvkStatCounter::MemoryAllocated);
     const uint64_t memUsed      = m_prevCounters.getCtr(DxvkStatCounter::MemoryUsed);
     
+    const uint64_t memChunks    = m_prevCounters.getCtr(DxvkStatCounter::MemoryChunkCount);
+    const uint64_t memFragment  = m_prevCounters.getCtr(DxvkStatCounter::MemoryFragmentation);
+    
     const std::string strMemAllocated = str::format("Memory allocated: ", memAllocated / mib, " MB");
     const std::string strMemUsed      = str::format("Memory used:      ", memUsed      / mib, " MB");
+    const std::string strMemChunks    = str::format("Memory chunks:    ", memChunks, " (", memFragment, "% fragmented)");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -140,7 +189,12 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strMemUsed);
     
-    return { position.x, position.y + 44.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strMemChunks);
+    
+    return { position.x, position.y + 64.0f };
   }
   
   
@@ -36,6 +36,8 @@ namespace dxvk::hud {
     DxvkStatCounters  m_prevCounters;
     DxvkStatCounters  m_diffCounters;
     
+    bool              m_asyncEnabled = false;
+    
     HudPos printDrawCallStats(
       const Rc<DxvkContext>&  context,
             HudRenderer&      renderer,
@@ -0,0 +1,86 @@
+#include "dxvk_hud_timings.h"
+
+namespace dxvk::hud {
+  
+  const std::array<const char*, uint32_t(DxvkTimingStage::NumStages)> g_hudStageNames = {{
+    "App:        ",
+    "Present:    ",
+    "CS thread:  ",
+    "Pipelines:  ",
+    "Submission: ",
+    "GPU:        ",
+  }};
+  
+  
+  HudTimings::HudTimings(HudElements elements)
+  : m_elements(elements) { }
+  
+  
+  HudTimings::~HudTimings() {
+    
+  }
+  
+  
+  void HudTimings::update(const Rc<DxvkDevice>& device) {
+    if (!m_elements.test(HudElement::Timings))
+      return;
+    
+    std::array<DxvkFrameTiming, NumFrames> frames;
+    uint32_t frameCount = device->timings()->getFrameTimings(NumFrames, frames.data());
+    
+    m_average      = DxvkFrameTiming();
+    m_maxFrameTime = 0;
+    
+    if (frameCount == 0)
+      return;
+    
+    for (uint32_t i = 0; i < frameCount; i++) {
+      m_average.frameTime += frames[i].frameTime;
+      m_maxFrameTime = std::max(m_maxFrameTime, frames[i].frameTime);
+      
+      for (uint32_t j = 0; j < m_average.stages.size(); j++)
+        m_average.stages[j] += frames[i].stages[j];
+    }
+    
+    m_average.frameTime /= frameCount;
+    
+    for (uint32_t j = 0; j < m_average.stages.size(); j++)
+      m_average.stages[j] /= frameCount;
+  }
+  
+  
+  HudPos HudTimings::render(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    if (!m_elements.test(HudElement::Timings))
+      return position;
+    
+    const std::string strFrameTime = str::format("Frame:      ",
+      formatTime(m_average.frameTime), " (max ", formatTime(m_maxFrameTime), ")");
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strFrameTime);
+    
+    for (uint32_t i = 0; i < m_average.stages.size(); i++) {
+      const std::string strStage = str::format(
+        g_hudStageNames[i], formatTime(m_average.stages[i]));
+      
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + 20.0f * float(i + 1) },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strStage);
+    }
+    
+    return { position.x, position.y + 20.0f * float(m_average.stages.size() + 1) + 4.0f };
+  }
+  
+  
+  std::string HudTimings::formatTime(uint64_t us) {
+    const uint64_t value = (us + 50) / 100;
+    return str::format(value / 10, ".", value % 10, " ms");
+  }
+  
+}
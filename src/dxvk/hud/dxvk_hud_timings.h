@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../dxvk_timing.h"
+
+#include "dxvk_hud_config.h"
+#include "dxvk_hud_renderer.h"
+
+namespace dxvk::hud {
+  
+  /**
+   * \brief Timing display for the HUD
+   * 
+   * Displays the average time per frame spent
+   * in each stage, as well as the average and
+   * maximum frame time over recent frames.
+   */
+  class HudTimings {
+    constexpr static uint32_t NumFrames = 64;
+  public:
+    
+    HudTimings(HudElements elements);
+    ~HudTimings();
+    
+    void update(
+      const Rc<DxvkDevice>&   device);
+    
+    HudPos render(
+      const Rc<DxvkContext>&  context,
+            HudRenderer&      renderer,
+            HudPos            position);
+    
+  private:
+    
+    const HudElements m_elements;
+    
+    DxvkFrameTiming   m_average;
+    uint64_t          m_maxFrameTime = 0;
+    
+    static std::string formatTime(uint64_t us);
+    
+  };
+  
+}
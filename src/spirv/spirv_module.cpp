@@ -4,6 +4,16 @@
 
 namespace dxvk {
   
+  size_t SpirvTypeConstKeyHash::operator () (const SpirvTypeConstKey& key) const {
+    size_t hash = uint32_t(key.op);
+    
+    for (uint32_t arg : key.args)
+      hash ^= arg + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    
+    return hash;
+  }
+  
+  
   SpirvModule:: SpirvModule() {
     this->instImportGlsl450();
   }
@@ -39,12 +49,9 @@ namespace dxvk {
   
   void SpirvModule::enableCapability(
           spv::Capability         capability) {
-    // Scan the generated instructions to check
-    // whether we already enabled the capability.
-    for (auto ins : m_capabilities) {
-      if (ins.opCode() == spv::OpCapability && ins.arg(1) == capability)
-        return;
-    }
+    // Check whether we already enabled the capability
+    if (!m_capabilitySet.insert(capability).second)
+      return;
     
     m_capabilities.putIns (spv::OpCapability, 2);
     m_capabilities.putWord(capability);
@@ -53,6 +60,9 @@ namespace dxvk {
   
   void SpirvModule::enableExtension(
     const char*                   extensionName) {
+    if (!m_extensionSet.insert(extensionName).second)
+      return;
+    
     m_extensions.putIns (spv::OpExtension, 1 + m_extensions.strLen(extensionName));
     m_extensions.putStr (extensionName);
   }
@@ -336,6 +346,8 @@ namespace dxvk {
     m_typeConstDefs.putIns  (op, 3);
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
+    
+    this->mapTypeConst(op, { typeId }, resultId);
     return resultId;
   }
     
@@ -349,6 +361,8 @@ namespace dxvk {
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
     m_typeConstDefs.putWord (value);
+    
+    this->mapTypeConst(spv::OpSpecConstant, { typeId, value }, resultId);
     return resultId;
   }
   
@@ -531,6 +545,8 @@ namespace dxvk {
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
     m_typeConstDefs.putWord(length);
+    
+    this->mapTypeConst(spv::OpTypeArray, { typeId, length }, resultId);
     return resultId;
   }
   
@@ -551,6 +567,8 @@ namespace dxvk {
     m_typeConstDefs.putIns (spv::OpTypeRuntimeArray, 3);
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
+    
+    this->mapTypeConst(spv::OpTypeRuntimeArray, { typeId }, resultId);
     return resultId;
   }
   
@@ -588,6 +606,10 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < memberCount; i++)
       m_typeConstDefs.putWord(memberTypes[i]);
+    
+    this->mapTypeConst(spv::OpTypeStruct,
+      std::vector<uint32_t>(memberTypes, memberTypes + memberCount),
+      resultId);
     return resultId;
   }
   
@@ -2947,23 +2969,28 @@ namespace dxvk {
   }
   
   
+  void SpirvModule::mapTypeConst(
+          spv::Op                 op,
+          std::vector<uint32_t>&& args,
+          uint32_t                resultId) {
+    // Unique declarations may match an existing one. Only
+    // keep the first, since that is what the linear search
+    // over the code buffer used to return.
+    m_typeConstIds.insert({ { op, std::move(args) }, resultId });
+  }
+  
+  
   uint32_t SpirvModule::defType(
           spv::Op                 op, 
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Since the type info is stored in the code buffer,
-    // we can use the code buffer to look up type IDs as
-    // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 2 + argCount;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(2 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(1);
-    }
+    SpirvTypeConstKey key = { op,
+      std::vector<uint32_t>(argIds, argIds + argCount) };
+    
+    auto entry = m_typeConstIds.find(key);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Type not yet declared, create a new one.
     uint32_t resultId = this->allocateId();
@@ -2972,6 +2999,8 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    m_typeConstIds.insert({ std::move(key), resultId });
     return resultId;
   }
   
@@ -2981,18 +3010,14 @@ namespace dxvk {
           uint32_t                typeId,
           uint32_t                argCount,
     const uint32_t*               argIds) {
+    SpirvTypeConstKey key = { op, { typeId } };
+    key.args.insert(key.args.end(), argIds, argIds + argCount);
+    
     // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 3 + argCount
-                && ins.arg(1)   == typeId;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(3 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(2);
-    }
+    auto entry = m_typeConstIds.find(key);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Constant not yet declared, make a new one
     uint32_t resultId = this->allocateId();
@@ -3002,6 +3027,8 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    m_typeConstIds.insert({ std::move(key), resultId });
     return resultId;
   }
   
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "spirv_code_buffer.h"
 
 namespace dxvk {
@@ -27,6 +32,26 @@ namespace dxvk {
     uint32_t sMinLod       = 0;
   };
   
+  /**
+   * \brief Type or constant declaration key
+   * 
+   * Stores the opcode and all operands of a type or
+   * constant declaration except for the result ID.
+   * For constants, the first operand is the type ID.
+   */
+  struct SpirvTypeConstKey {
+    spv::Op               op;
+    std::vector<uint32_t> args;
+    
+    bool operator == (const SpirvTypeConstKey& other) const {
+      return op == other.op && args == other.args;
+    }
+  };
+  
+  struct SpirvTypeConstKeyHash {
+    size_t operator () (const SpirvTypeConstKey& key) const;
+  };
+  
   /**
    * \brief SPIR-V module
    * 
@@ -1043,6 +1068,21 @@ namespace dxvk {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
     
+    // Lookup tables for declarations that must not be
+    // emitted more than once. Types and constants map
+    // to the ID of the first matching declaration.
+    std::unordered_set<uint32_t>    m_capabilitySet;
+    std::unordered_set<std::string> m_extensionSet;
+    
+    std::unordered_map<
+      SpirvTypeConstKey, uint32_t,
+      SpirvTypeConstKeyHash> m_typeConstIds;
+    
+    void mapTypeConst(
+            spv::Op                 op,
+            std::vector<uint32_t>&& args,
+            uint32_t                resultId);
+    
     uint32_t defType(
             spv::Op                 op, 
             uint32_t                argCount,
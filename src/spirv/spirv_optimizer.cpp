@@ -0,0 +1,2124 @@
+#include <algorithm>
+#include <cstring>
+
+#include "spirv_optimizer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Instruction layout info
+   *
+   * Describes which operands of an instruction are IDs,
+   * and whether the instruction can be removed if its
+   * result is unused. Instructions with a result store
+   * the result type ID in the first operand and the
+   * result ID in the second operand.
+   */
+  struct SpirvOpInfo {
+    bool      known     = true;
+    bool      pure      = false;
+    bool      hasResult = false;
+    uint32_t  idBegin   = 0;
+    uint32_t  idEnd     = 0;
+    uint32_t  maskIndex = 0;
+  };
+
+
+  static SpirvOpInfo getOpInfo(spv::Op op) {
+    SpirvOpInfo info;
+
+    auto setIds = [&info] (uint32_t begin, uint32_t end) {
+      info.idBegin = begin;
+      info.idEnd   = end;
+    };
+
+    auto setPure = [&info, &setIds] (uint32_t begin, uint32_t end) {
+      info.pure      = true;
+      info.hasResult = true;
+      setIds(begin, end);
+    };
+
+    auto setImage = [&info] (uint32_t begin, uint32_t mask) {
+      info.pure      = true;
+      info.hasResult = true;
+      info.idBegin   = begin;
+      info.idEnd     = ~0u;
+      info.maskIndex = mask;
+    };
+
+    switch (op) {
+      case spv::OpNop:
+      case spv::OpKill:
+      case spv::OpReturn:
+      case spv::OpUnreachable:
+      case spv::OpBranch:
+      case spv::OpSelectionMerge:
+      case spv::OpLoopMerge:
+      case spv::OpEmitVertex:
+      case spv::OpEndPrimitive:
+        break;
+
+      case spv::OpReturnValue:
+      case spv::OpBranchConditional:
+      case spv::OpSwitch:
+      case spv::OpEmitStreamVertex:
+      case spv::OpEndStreamPrimitive:
+        setIds(1, 2);
+        break;
+
+      case spv::OpStore:
+        setIds(1, 3);
+        break;
+
+      case spv::OpControlBarrier:
+      case spv::OpMemoryBarrier:
+      case spv::OpAtomicStore:
+        setIds(1, ~0u);
+        break;
+
+      case spv::OpImageWrite:
+        info.idBegin   = 1;
+        info.idEnd     = ~0u;
+        info.maskIndex = 4;
+        break;
+
+      case spv::OpFunctionCall:
+        info.hasResult = true;
+        setIds(4, ~0u);
+        break;
+
+      case spv::OpAtomicLoad:
+      case spv::OpAtomicExchange:
+      case spv::OpAtomicCompareExchange:
+      case spv::OpAtomicIIncrement:
+      case spv::OpAtomicIDecrement:
+      case spv::OpAtomicIAdd:
+      case spv::OpAtomicISub:
+      case spv::OpAtomicSMin:
+      case spv::OpAtomicUMin:
+      case spv::OpAtomicSMax:
+      case spv::OpAtomicUMax:
+      case spv::OpAtomicAnd:
+      case spv::OpAtomicOr:
+      case spv::OpAtomicXor:
+        info.hasResult = true;
+        setIds(3, ~0u);
+        break;
+
+      case spv::OpVariable:
+        setPure(4, ~0u);
+        break;
+
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+        setPure(3, 4);
+        break;
+
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        setPure(3, 5);
+        break;
+
+      case spv::OpExtInst:
+        setPure(5, ~0u);
+        break;
+
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageSampleProjImplicitLod:
+      case spv::OpImageSampleProjExplicitLod:
+      case spv::OpImageFetch:
+      case spv::OpImageRead:
+        setImage(3, 5);
+        break;
+
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod:
+      case spv::OpImageSampleProjDrefImplicitLod:
+      case spv::OpImageSampleProjDrefExplicitLod:
+      case spv::OpImageGather:
+      case spv::OpImageDrefGather:
+        setImage(3, 6);
+        break;
+
+      case spv::OpPhi:
+      case spv::OpUndef:
+      case spv::OpCopyObject:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpSampledImage:
+      case spv::OpImage:
+      case spv::OpImageQuerySizeLod:
+      case spv::OpImageQuerySize:
+      case spv::OpImageQueryLod:
+      case spv::OpImageQueryLevels:
+      case spv::OpImageQuerySamples:
+      case spv::OpImageTexelPointer:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpUConvert:
+      case spv::OpSConvert:
+      case spv::OpFConvert:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpDot:
+      case spv::OpIAddCarry:
+      case spv::OpISubBorrow:
+      case spv::OpUMulExtended:
+      case spv::OpSMulExtended:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+      case spv::OpDPdx:
+      case spv::OpDPdy:
+      case spv::OpFwidth:
+      case spv::OpDPdxFine:
+      case spv::OpDPdyFine:
+      case spv::OpFwidthFine:
+      case spv::OpDPdxCoarse:
+      case spv::OpDPdyCoarse:
+      case spv::OpFwidthCoarse:
+      case spv::OpCompositeConstruct:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpVectorInsertDynamic:
+        setPure(3, ~0u);
+        break;
+
+      default:
+        info.known = false;
+    }
+
+    return info;
+  }
+
+
+  static bool isTerminator(spv::Op op) {
+    return op == spv::OpBranch
+        || op == spv::OpBranchConditional
+        || op == spv::OpSwitch
+        || op == spv::OpReturn
+        || op == spv::OpReturnValue
+        || op == spv::OpKill
+        || op == spv::OpUnreachable;
+  }
+
+
+  SpirvOptimizer:: SpirvOptimizer() { }
+  SpirvOptimizer::~SpirvOptimizer() { }
+
+
+  SpirvCodeBuffer SpirvOptimizer::optimize(
+          SpirvCodeBuffer         code) {
+    *this = SpirvOptimizer();
+
+    if (!this->parseModule(code))
+      return code;
+
+    for (auto& fn : m_functions) {
+      if (!this->buildCfg(fn))
+        return code;
+
+      this->computeDominators(fn);
+    }
+
+    this->analyzeCalls();
+    this->analyzeVariables();
+
+    for (uint32_t i = 0; i < m_functions.size(); i++)
+      this->promoteVariables(i);
+
+    this->foldInstructions();
+    this->eliminateDeadCode();
+    this->eliminateDeadStores();
+    this->eliminateDeadCode();
+    this->eliminateUnusedGlobals();
+
+    // If we produced anything invalid, use the
+    // original code rather than breaking the shader
+    if (!this->validateModule()) {
+      Logger::warn("SpirvOptimizer: Validation failed, using unoptimized code");
+      return code;
+    }
+
+    return this->buildModule();
+  }
+
+
+  bool SpirvOptimizer::parseModule(
+          SpirvCodeBuffer&        code) {
+    const uint32_t* data  = code.data();
+    const uint32_t  count = code.size() / sizeof(uint32_t);
+
+    if (count < 5 || data[0] != spv::MagicNumber)
+      return false;
+
+    std::memcpy(m_header, data, sizeof(m_header));
+    m_words.assign(data, data + count);
+
+    const uint32_t bound = m_header[3];
+    m_defs    .resize(bound, Invalid);
+    m_replace .resize(bound, 0);
+    m_varIndex.resize(bound, Invalid);
+
+    Function* fn    = nullptr;
+    Block*    block = nullptr;
+
+    for (uint32_t offset = 5; offset < count; ) {
+      const uint32_t len = m_words[offset] >> spv::WordCountShift;
+
+      if (len == 0 || offset + len > count)
+        return false;
+
+      const uint32_t ins = m_ins.size();
+      m_ins.push_back({ offset, len, false });
+      offset += len;
+
+      const spv::Op opCode = op(ins);
+      uint32_t resultId = 0;
+
+      if (fn == nullptr) {
+        if (opCode == spv::OpFunction) {
+          m_functions.emplace_back();
+          fn = &m_functions.back();
+          fn->id = word(ins, 2);
+          fn->header.push_back(ins);
+          resultId = fn->id;
+        } else {
+          m_globals.push_back(ins);
+
+          switch (opCode) {
+            case spv::OpExtInstImport:
+            case spv::OpString:
+            case spv::OpTypeVoid:
+            case spv::OpTypeBool:
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeImage:
+            case spv::OpTypeSampler:
+            case spv::OpTypeSampledImage:
+            case spv::OpTypeArray:
+            case spv::OpTypeRuntimeArray:
+            case spv::OpTypeStruct:
+            case spv::OpTypePointer:
+            case spv::OpTypeFunction:
+              resultId = word(ins, 1);
+              break;
+
+            case spv::OpConstantTrue:
+            case spv::OpConstantFalse:
+            case spv::OpConstant:
+            case spv::OpConstantComposite:
+            case spv::OpConstantNull:
+            case spv::OpSpecConstantTrue:
+            case spv::OpSpecConstantFalse:
+            case spv::OpSpecConstant:
+            case spv::OpSpecConstantComposite:
+            case spv::OpSpecConstantOp:
+            case spv::OpVariable:
+            case spv::OpUndef:
+              resultId = word(ins, 2);
+              break;
+
+            case spv::OpEntryPoint:
+              m_entryPoints.push_back(word(ins, 2));
+              break;
+
+            default:
+              break;
+          }
+        }
+      } else if (block == nullptr) {
+        if (opCode == spv::OpFunctionParameter) {
+          fn->header.push_back(ins);
+          resultId = word(ins, 2);
+        } else if (opCode == spv::OpLabel) {
+          fn->blocks.emplace_back();
+          block = &fn->blocks.back();
+          block->labelId = word(ins, 1);
+          block->label   = ins;
+          resultId = block->labelId;
+        } else if (opCode == spv::OpFunctionEnd) {
+          fn->end = ins;
+          fn = nullptr;
+        } else {
+          return false;
+        }
+      } else {
+        const SpirvOpInfo info = getOpInfo(opCode);
+
+        if (!info.known)
+          return false;
+
+        block->code.push_back(ins);
+
+        if (info.hasResult)
+          resultId = word(ins, 2);
+
+        if (isTerminator(opCode))
+          block = nullptr;
+      }
+
+      if (resultId != 0) {
+        if (resultId >= bound || m_defs[resultId] != Invalid)
+          return false;
+
+        m_defs[resultId] = ins;
+      }
+    }
+
+    if (fn != nullptr)
+      return false;
+
+    // Register existing constants so that
+    // folding can reuse them where possible
+    for (uint32_t ins : m_globals) {
+      switch (op(ins)) {
+        case spv::OpConstantTrue:
+        case spv::OpConstantFalse:
+          m_scalarConsts.insert({ (uint64_t(word(ins, 1)) << 32)
+            | (op(ins) == spv::OpConstantTrue ? 1 : 0), word(ins, 2) });
+          break;
+
+        case spv::OpConstant:
+          if (length(ins) == 4 && isScalar32(word(ins, 1)))
+            m_scalarConsts.insert({ (uint64_t(word(ins, 1)) << 32) | word(ins, 3), word(ins, 2) });
+          break;
+
+        case spv::OpConstantComposite: {
+          std::vector<uint32_t> key(length(ins) - 2);
+          key[0] = word(ins, 1);
+
+          for (uint32_t i = 3; i < length(ins); i++)
+            key[i - 2] = word(ins, i);
+
+          m_compositeConsts.insert({ std::string(
+            reinterpret_cast<const char*>(key.data()),
+            key.size() * sizeof(uint32_t)), word(ins, 2) });
+        } break;
+
+        case spv::OpUndef:
+          m_undefs.insert({ word(ins, 1), word(ins, 2) });
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    return true;
+  }
+
+
+  bool SpirvOptimizer::buildCfg(
+          Function&               fn) {
+    std::unordered_map<uint32_t, uint32_t> blockIds;
+
+    for (uint32_t i = 0; i < fn.blocks.size(); i++)
+      blockIds.insert({ fn.blocks[i].labelId, i });
+
+    for (uint32_t i = 0; i < fn.blocks.size(); i++) {
+      const uint32_t term = fn.blocks[i].code.back();
+
+      std::vector<uint32_t> targets;
+
+      switch (op(term)) {
+        case spv::OpBranch:
+          targets.push_back(word(term, 1));
+          break;
+
+        case spv::OpBranchConditional:
+          targets.push_back(word(term, 2));
+          targets.push_back(word(term, 3));
+          break;
+
+        case spv::OpSwitch:
+          targets.push_back(word(term, 2));
+
+          for (uint32_t j = 4; j < length(term); j += 2)
+            targets.push_back(word(term, j));
+          break;
+
+        default:
+          break;
+      }
+
+      for (uint32_t target : targets) {
+        auto entry = blockIds.find(target);
+
+        if (entry == blockIds.end())
+          return false;
+
+        Block& succ = fn.blocks[entry->second];
+
+        if (std::find(succ.preds.begin(), succ.preds.end(), i) == succ.preds.end()) {
+          succ.preds.push_back(i);
+          fn.blocks[i].succs.push_back(entry->second);
+        }
+      }
+
+      for (uint32_t ins : fn.blocks[i].code)
+        fn.hasLoops |= op(ins) == spv::OpLoopMerge;
+    }
+
+    return true;
+  }
+
+
+  void SpirvOptimizer::computeDominators(
+          Function&               fn) {
+    for (auto& block : fn.blocks) {
+      block.idom  = Invalid;
+      block.order = Invalid;
+    }
+
+    // Compute reverse post-order of all reachable blocks
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    std::vector<bool> visited(fn.blocks.size(), false);
+    std::vector<uint32_t> postOrder;
+
+    stack.push_back({ 0, 0 });
+    visited[0] = true;
+
+    while (!stack.empty()) {
+      auto& top = stack.back();
+      const Block& block = fn.blocks[top.first];
+
+      if (top.second < block.succs.size()) {
+        uint32_t succ = block.succs[top.second++];
+
+        if (!visited[succ]) {
+          visited[succ] = true;
+          stack.push_back({ succ, 0 });
+        }
+      } else {
+        postOrder.push_back(top.first);
+        stack.pop_back();
+      }
+    }
+
+    fn.rpo.assign(postOrder.rbegin(), postOrder.rend());
+
+    for (uint32_t i = 0; i < fn.rpo.size(); i++)
+      fn.blocks[fn.rpo[i]].order = i;
+
+    // Compute immediate dominators, using the algorithm from
+    // "A Simple, Fast Dominance Algorithm" by Cooper et al.
+    auto intersect = [&fn] (uint32_t a, uint32_t b) {
+      while (a != b) {
+        while (fn.blocks[a].order > fn.blocks[b].order) a = fn.blocks[a].idom;
+        while (fn.blocks[b].order > fn.blocks[a].order) b = fn.blocks[b].idom;
+      }
+      return a;
+    };
+
+    fn.blocks[0].idom = 0;
+
+    for (bool changed = true; changed; ) {
+      changed = false;
+
+      for (uint32_t i = 1; i < fn.rpo.size(); i++) {
+        Block& block = fn.blocks[fn.rpo[i]];
+        uint32_t idom = Invalid;
+
+        for (uint32_t pred : block.preds) {
+          if (fn.blocks[pred].idom == Invalid)
+            continue;
+
+          idom = idom == Invalid ? pred : intersect(pred, idom);
+        }
+
+        if (block.idom != idom) {
+          block.idom = idom;
+          changed = true;
+        }
+      }
+    }
+
+    // Build dominator tree and dominance frontiers
+    for (uint32_t i = 1; i < fn.rpo.size(); i++) {
+      uint32_t b = fn.rpo[i];
+      fn.blocks[fn.blocks[b].idom].children.push_back(b);
+
+      if (fn.blocks[b].preds.size() < 2)
+        continue;
+
+      for (uint32_t pred : fn.blocks[b].preds) {
+        if (fn.blocks[pred].order == Invalid)
+          continue;
+
+        for (uint32_t r = pred; r != fn.blocks[b].idom; r = fn.blocks[r].idom) {
+          auto& frontier = fn.blocks[r].frontier;
+
+          if (std::find(frontier.begin(), frontier.end(), b) == frontier.end())
+            frontier.push_back(b);
+        }
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::analyzeCalls() {
+    std::unordered_map<uint32_t, uint32_t> fnIndices;
+
+    for (uint32_t i = 0; i < m_functions.size(); i++)
+      fnIndices.insert({ m_functions[i].id, i });
+
+    for (uint32_t i = 0; i < m_functions.size(); i++) {
+      for (const auto& block : m_functions[i].blocks) {
+        for (uint32_t ins : block.code) {
+          if (op(ins) != spv::OpFunctionCall)
+            continue;
+
+          auto callee = fnIndices.find(word(ins, 3));
+
+          if (callee != fnIndices.end()) {
+            m_functions[callee->second].callCount += 1;
+            m_functions[callee->second].caller     = i;
+          }
+        }
+      }
+    }
+
+    // A function runs at most once per invocation if it is
+    // the entry point, or if it is called exactly once from
+    // a function that runs once and has no loops. Private
+    // variables cannot carry values between calls to such
+    // a function, so their initial value is undefined.
+    for (bool changed = true; changed; ) {
+      changed = false;
+
+      for (auto& fn : m_functions) {
+        if (fn.runsOnce)
+          continue;
+
+        bool isEntryPoint = std::find(m_entryPoints.begin(),
+          m_entryPoints.end(), fn.id) != m_entryPoints.end();
+
+        fn.runsOnce = isEntryPoint || (fn.callCount == 1
+          && m_functions[fn.caller].runsOnce
+          && !m_functions[fn.caller].hasLoops);
+
+        changed |= fn.runsOnce;
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::analyzeVariables() {
+    auto addVariable = [this] (uint32_t ins, uint32_t function) {
+      uint32_t ptrType = getDef(word(ins, 1));
+
+      if (length(ins) != 4 || ptrType == Invalid || op(ptrType) != spv::OpTypePointer)
+        return;
+
+      Variable var;
+      var.id          = word(ins, 2);
+      var.typeId      = word(ptrType, 3);
+      var.function    = function;
+      var.isPrivate   = function == Invalid;
+      var.promotable  = true;
+
+      m_varIndex[var.id] = m_vars.size();
+      m_vars.push_back(var);
+    };
+
+    for (uint32_t ins : m_globals) {
+      if (op(ins) == spv::OpVariable && word(ins, 3) == spv::StorageClassPrivate)
+        addVariable(ins, Invalid);
+    }
+
+    for (uint32_t i = 0; i < m_functions.size(); i++) {
+      for (uint32_t ins : m_functions[i].blocks[0].code) {
+        if (op(ins) == spv::OpVariable && word(ins, 3) == spv::StorageClassFunction)
+          addVariable(ins, i);
+      }
+    }
+
+    // Variables can only be promoted if they are accessed
+    // through plain loads and stores within one function
+    for (uint32_t ins : m_globals) {
+      if (op(ins) != spv::OpEntryPoint)
+        continue;
+
+      for (uint32_t i = 3; i < length(ins); i++) {
+        if (word(ins, i) < m_varIndex.size() && m_varIndex[word(ins, i)] != Invalid)
+          m_vars[m_varIndex[word(ins, i)]].promotable = false;
+      }
+    }
+
+    for (uint32_t i = 0; i < m_functions.size(); i++) {
+      for (const auto& block : m_functions[i].blocks) {
+        for (uint32_t ins : block.code) {
+          const spv::Op opCode = op(ins);
+
+          this->forEachIdOperand(ins, [this, i, opCode] (uint32_t& id, uint32_t idx) {
+            if (id >= m_varIndex.size() || m_varIndex[id] == Invalid)
+              return;
+
+            Variable& var = m_vars[m_varIndex[id]];
+
+            if ((opCode != spv::OpLoad  || idx != 3)
+             && (opCode != spv::OpStore || idx != 1))
+              var.promotable = false;
+
+            if (var.function == Invalid)
+              var.function = i;
+            else if (var.function != i)
+              var.promotable = false;
+          });
+        }
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::promoteVariables(
+          uint32_t                fnId) {
+    Function& fn = m_functions[fnId];
+
+    std::vector<uint32_t> vars;
+    std::vector<uint32_t> slots(m_vars.size(), Invalid);
+
+    for (uint32_t i = 0; i < m_vars.size(); i++) {
+      if (m_vars[i].promotable && m_vars[i].function == fnId) {
+        slots[i] = vars.size();
+        vars.push_back(i);
+      }
+    }
+
+    if (vars.empty())
+      return;
+
+    auto getSlot = [this, &slots] (uint32_t ptr) {
+      return ptr < m_varIndex.size() && m_varIndex[ptr] != Invalid
+        ? slots[m_varIndex[ptr]] : Invalid;
+    };
+
+    // Private variables in functions that may run multiple
+    // times need to be loaded on entry and written back on
+    // return, since they may carry values between calls.
+    std::vector<uint32_t> initial(vars.size());
+    std::vector<uint32_t> writeback;
+
+    auto& entryCode = fn.blocks[0].code;
+    auto  entryPos  = std::find_if(entryCode.begin(), entryCode.end(),
+      [this] (uint32_t ins) { return op(ins) != spv::OpVariable; });
+    uint32_t insertPos = entryPos - entryCode.begin();
+
+    for (uint32_t i = 0; i < vars.size(); i++) {
+      const Variable& var = m_vars[vars[i]];
+
+      if (var.isPrivate && !fn.runsOnce) {
+        initial[i] = this->allocateId();
+
+        uint32_t ins = this->addInstruction(spv::OpLoad, { var.typeId, initial[i], var.id });
+        m_defs[initial[i]] = ins;
+
+        entryCode.insert(entryCode.begin() + insertPos++, ins);
+        writeback.push_back(i);
+      } else {
+        initial[i] = this->defUndef(var.typeId);
+      }
+    }
+
+    // Insert phis at the iterated dominance frontier
+    // of all blocks that store to a given variable
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> blockPhis(fn.blocks.size());
+    std::vector<std::vector<uint32_t>> defBlocks(vars.size());
+
+    for (uint32_t b = 0; b < fn.blocks.size(); b++) {
+      if (fn.blocks[b].order == Invalid)
+        continue;
+
+      for (uint32_t ins : fn.blocks[b].code) {
+        if (op(ins) != spv::OpStore)
+          continue;
+
+        uint32_t slot = getSlot(word(ins, 1));
+
+        if (slot != Invalid && (defBlocks[slot].empty() || defBlocks[slot].back() != b))
+          defBlocks[slot].push_back(b);
+      }
+    }
+
+    for (uint32_t i = 0; i < vars.size(); i++) {
+      std::vector<bool> hasPhi(fn.blocks.size(), false);
+      std::vector<bool> queued(fn.blocks.size(), false);
+      std::vector<uint32_t> worklist = defBlocks[i];
+
+      for (uint32_t b : worklist)
+        queued[b] = true;
+
+      while (!worklist.empty()) {
+        uint32_t b = worklist.back();
+        worklist.pop_back();
+
+        for (uint32_t d : fn.blocks[b].frontier) {
+          if (hasPhi[d])
+            continue;
+
+          std::vector<uint32_t> args = { m_vars[vars[i]].typeId, this->allocateId() };
+
+          for (uint32_t pred : fn.blocks[d].preds) {
+            args.push_back(0);
+            args.push_back(fn.blocks[pred].labelId);
+          }
+
+          uint32_t phi = this->addInstruction(spv::OpPhi, std::move(args));
+          m_defs[word(phi, 2)] = phi;
+
+          fn.blocks[d].phis.push_back(phi);
+          blockPhis[d].push_back({ i, phi });
+          hasPhi[d] = true;
+
+          if (!queued[d]) {
+            queued[d] = true;
+            worklist.push_back(d);
+          }
+        }
+      }
+    }
+
+    auto setPhiOperands = [this, &fn, &blockPhis] (uint32_t b, const std::vector<uint32_t>& values) {
+      for (uint32_t s : fn.blocks[b].succs) {
+        uint32_t predIndex = std::find(fn.blocks[s].preds.begin(),
+          fn.blocks[s].preds.end(), b) - fn.blocks[s].preds.begin();
+
+        for (const auto& phi : blockPhis[s])
+          word(phi.second, 3 + 2 * predIndex) = values[phi.first];
+      }
+    };
+
+    // Rename loads and stores while walking the dominator tree
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> stack;
+    stack.push_back({ 0, initial });
+
+    while (!stack.empty()) {
+      uint32_t b = stack.back().first;
+      std::vector<uint32_t> values = std::move(stack.back().second);
+      stack.pop_back();
+
+      Block& block = fn.blocks[b];
+
+      for (const auto& phi : blockPhis[b])
+        values[phi.first] = word(phi.second, 2);
+
+      for (uint32_t ins : block.code) {
+        if (op(ins) == spv::OpLoad) {
+          uint32_t slot = getSlot(word(ins, 3));
+
+          if (slot != Invalid)
+            this->replace(ins, values[slot]);
+        } else if (op(ins) == spv::OpStore) {
+          uint32_t slot = getSlot(word(ins, 1));
+
+          if (slot != Invalid) {
+            values[slot] = word(ins, 2);
+            m_ins[ins].removed = true;
+          }
+        }
+      }
+
+      const spv::Op term = op(block.code.back());
+
+      if (term == spv::OpReturn || term == spv::OpReturnValue) {
+        for (uint32_t slot : writeback) {
+          uint32_t ins = this->addInstruction(spv::OpStore,
+            { m_vars[vars[slot]].id, values[slot] });
+          block.code.insert(block.code.end() - 1, ins);
+        }
+      }
+
+      setPhiOperands(b, values);
+
+      for (uint32_t child : block.children)
+        stack.push_back({ child, values });
+    }
+
+    // Accesses in unreachable blocks can be replaced
+    // with undefined values without further analysis
+    std::vector<uint32_t> undefs(vars.size());
+
+    for (uint32_t i = 0; i < vars.size(); i++)
+      undefs[i] = this->defUndef(m_vars[vars[i]].typeId);
+
+    for (uint32_t b = 0; b < fn.blocks.size(); b++) {
+      if (fn.blocks[b].order != Invalid)
+        continue;
+
+      for (uint32_t ins : fn.blocks[b].code) {
+        if (op(ins) == spv::OpLoad) {
+          uint32_t slot = getSlot(word(ins, 3));
+
+          if (slot != Invalid)
+            this->replace(ins, undefs[slot]);
+        } else if (op(ins) == spv::OpStore) {
+          if (getSlot(word(ins, 1)) != Invalid)
+            m_ins[ins].removed = true;
+        }
+      }
+
+      setPhiOperands(b, undefs);
+    }
+  }
+
+
+  void SpirvOptimizer::foldInstructions() {
+    for (uint32_t iter = 0; iter < 4; iter++) {
+      bool progress = false;
+
+      for (auto& fn : m_functions) {
+        for (uint32_t b : fn.rpo) {
+          auto foldBlockInstruction = [this, &progress] (uint32_t ins) {
+            if (m_ins[ins].removed)
+              return;
+
+            this->forEachIdOperand(ins, [this] (uint32_t& id, uint32_t) {
+              id = this->resolve(id);
+            });
+
+            while (!m_ins[ins].removed && this->foldInstruction(ins))
+              progress = true;
+          };
+
+          for (uint32_t ins : fn.blocks[b].phis)
+            foldBlockInstruction(ins);
+
+          for (uint32_t ins : fn.blocks[b].code)
+            foldBlockInstruction(ins);
+        }
+      }
+
+      if (!progress)
+        break;
+    }
+  }
+
+
+  bool SpirvOptimizer::foldInstruction(
+          uint32_t                ins) {
+    switch (op(ins)) {
+      case spv::OpCopyObject:
+        this->replace(ins, word(ins, 3));
+        return true;
+
+      case spv::OpCompositeExtract:
+        return this->foldCompositeExtract(ins);
+
+      case spv::OpVectorShuffle:
+        return this->foldVectorShuffle(ins);
+
+      case spv::OpCompositeConstruct:
+        return this->foldCompositeConstruct(ins);
+
+      case spv::OpBitcast:
+        return this->foldBitcast(ins);
+
+      case spv::OpIAdd:
+      case spv::OpISub:
+      case spv::OpIMul:
+      case spv::OpBitwiseAnd:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpShiftLeftLogical:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpNot:
+      case spv::OpSNegate:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+        return this->foldIntOp(ins);
+
+      case spv::OpLogicalNot:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+        return this->foldLogicalOp(ins);
+
+      case spv::OpSelect:
+        return this->foldSelect(ins);
+
+      case spv::OpPhi:
+        return this->foldPhi(ins);
+
+      default:
+        return false;
+    }
+  }
+
+
+  bool SpirvOptimizer::foldCompositeExtract(
+          uint32_t                ins) {
+    if (length(ins) != 5)
+      return false;
+
+    uint32_t src = getDef(word(ins, 3));
+    uint32_t idx = word(ins, 4);
+
+    if (src == Invalid)
+      return false;
+
+    switch (op(src)) {
+      case spv::OpConstantComposite: {
+        if (3 + idx >= length(src))
+          return false;
+
+        this->replace(ins, word(src, 3 + idx));
+        return true;
+      }
+
+      case spv::OpCompositeConstruct: {
+        // Vectors can be constructed from a mix of scalars
+        // and vectors, other composites are constructed
+        // from exactly one value per member.
+        if (getComponentCount(word(src, 1)) < 2) {
+          if (3 + idx >= length(src))
+            return false;
+
+          this->replace(ins, word(src, 3 + idx));
+          return true;
+        }
+
+        for (uint32_t i = 3; i < length(src); i++) {
+          uint32_t part  = word(src, i);
+          uint32_t count = getComponentCount(getType(part));
+
+          if (count == 0)
+            return false;
+
+          if (idx < count) {
+            if (count == 1) {
+              this->replace(ins, part);
+            } else {
+              word(ins, 3) = part;
+              word(ins, 4) = idx;
+            }
+
+            return true;
+          }
+
+          idx -= count;
+        }
+
+        return false;
+      }
+
+      case spv::OpCompositeInsert: {
+        if (length(src) != 6)
+          return false;
+
+        if (word(src, 5) == idx)
+          this->replace(ins, word(src, 3));
+        else
+          word(ins, 3) = word(src, 4);
+
+        return true;
+      }
+
+      case spv::OpVectorShuffle: {
+        if (5 + idx >= length(src) || word(src, 5 + idx) == ~0u)
+          return false;
+
+        uint32_t component = word(src, 5 + idx);
+        uint32_t count     = getComponentCount(getType(word(src, 3)));
+
+        if (count == 0)
+          return false;
+
+        if (component < count) {
+          word(ins, 3) = word(src, 3);
+          word(ins, 4) = component;
+        } else {
+          word(ins, 3) = word(src, 4);
+          word(ins, 4) = component - count;
+        }
+
+        return true;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+
+  bool SpirvOptimizer::foldVectorShuffle(
+          uint32_t                ins) {
+    const uint32_t count = length(ins) - 5;
+
+    uint32_t a = word(ins, 3);
+    uint32_t b = word(ins, 4);
+
+    uint32_t aCount = getComponentCount(getType(a));
+    uint32_t bCount = getComponentCount(getType(b));
+
+    if (aCount == 0 || bCount == 0)
+      return false;
+
+    bool usesA    = false;
+    bool usesB    = false;
+    bool hasUndef = false;
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t c = word(ins, 5 + i);
+
+      if (c == ~0u)
+        hasUndef = true;
+      else if (c < aCount)
+        usesA = true;
+      else
+        usesB = true;
+    }
+
+    // Make sure that only the first operand is used if
+    // possible, so that the second one may become dead
+    if (usesB && !usesA) {
+      for (uint32_t i = 0; i < count; i++) {
+        if (word(ins, 5 + i) != ~0u)
+          word(ins, 5 + i) -= aCount;
+      }
+
+      word(ins, 3) = b;
+      return true;
+    }
+
+    if (usesB && a == b) {
+      for (uint32_t i = 0; i < count; i++) {
+        if (word(ins, 5 + i) != ~0u && word(ins, 5 + i) >= aCount)
+          word(ins, 5 + i) -= aCount;
+      }
+
+      return true;
+    }
+
+    if (!usesB && b != a) {
+      word(ins, 4) = a;
+      return true;
+    }
+
+    if (!hasUndef) {
+      bool isIdentity = count == aCount;
+
+      for (uint32_t i = 0; i < count && isIdentity; i++)
+        isIdentity = word(ins, 5 + i) == i;
+
+      if (isIdentity && usesA && !usesB) {
+        this->replace(ins, a);
+        return true;
+      }
+
+      std::vector<uint32_t> aConsts;
+      std::vector<uint32_t> bConsts;
+
+      if (getConstComponents(a, aConsts)
+       && getConstComponents(b, bConsts)) {
+        std::vector<uint32_t> components(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+          uint32_t c = word(ins, 5 + i);
+          components[i] = c < aCount ? aConsts[c] : bConsts[c - aCount];
+        }
+
+        this->replace(ins, this->defCompositeConst(word(ins, 1), components));
+        return true;
+      }
+    }
+
+    // Shuffle of a shuffle, select from the original vectors
+    uint32_t src = getDef(a);
+
+    if (usesA && !usesB && src != Invalid && op(src) == spv::OpVectorShuffle) {
+      for (uint32_t i = 0; i < count; i++) {
+        if (word(ins, 5 + i) != ~0u)
+          word(ins, 5 + i) = word(src, 5 + word(ins, 5 + i));
+      }
+
+      word(ins, 3) = word(src, 3);
+      word(ins, 4) = word(src, 4);
+      return true;
+    }
+
+    return false;
+  }
+
+
+  bool SpirvOptimizer::foldCompositeConstruct(
+          uint32_t                ins) {
+    const uint32_t typeId = word(ins, 1);
+    const uint32_t count  = getComponentCount(typeId);
+
+    if (count < 2)
+      return false;
+
+    std::vector<uint32_t> components;
+    bool isConstant = true;
+
+    for (uint32_t i = 3; i < length(ins) && isConstant; i++)
+      isConstant = getConstComponents(word(ins, i), components);
+
+    if (isConstant && components.size() == count) {
+      this->replace(ins, this->defCompositeConst(typeId, components));
+      return true;
+    }
+
+    // Vector that is reassembled from its components
+    if (length(ins) - 3 != count)
+      return false;
+
+    uint32_t vector = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t src = getDef(word(ins, 3 + i));
+
+      if (src == Invalid
+       || op(src) != spv::OpCompositeExtract
+       || length(src) != 5 || word(src, 4) != i)
+        return false;
+
+      if (i != 0 && word(src, 3) != vector)
+        return false;
+
+      vector = word(src, 3);
+    }
+
+    if (getType(vector) != typeId)
+      return false;
+
+    this->replace(ins, vector);
+    return true;
+  }
+
+
+  bool SpirvOptimizer::foldBitcast(
+          uint32_t                ins) {
+    const uint32_t typeId = word(ins, 1);
+    const uint32_t src    = word(ins, 3);
+
+    if (getType(src) == typeId) {
+      this->replace(ins, src);
+      return true;
+    }
+
+    uint32_t def = getDef(src);
+
+    if (def != Invalid && op(def) == spv::OpBitcast) {
+      word(ins, 3) = word(def, 3);
+      return true;
+    }
+
+    std::vector<uint32_t> components;
+
+    const uint32_t count    = getComponentCount(typeId);
+    const uint32_t compType = getComponentType(typeId);
+
+    if (!isScalar32(compType)
+     || !getConstComponents(src, components)
+     || components.size() != count)
+      return false;
+
+    for (uint32_t& c : components) {
+      uint32_t value;
+
+      if (!isScalar32(getType(c)) || !getScalarConst(c, value))
+        return false;
+
+      c = this->defScalarConst(compType, value);
+    }
+
+    this->replace(ins, count == 1 ? components[0]
+      : this->defCompositeConst(typeId, components));
+    return true;
+  }
+
+
+  bool SpirvOptimizer::foldIntOp(
+          uint32_t                ins) {
+    const spv::Op  opCode = op(ins);
+    const uint32_t typeId = word(ins, 1);
+
+    const bool isUnary = opCode == spv::OpNot
+                      || opCode == spv::OpSNegate;
+
+    const uint32_t a = word(ins, 3);
+    const uint32_t b = isUnary ? a : word(ins, 4);
+
+    std::vector<uint32_t> aConsts;
+    std::vector<uint32_t> bConsts;
+
+    const bool aConst = getConstComponents(a, aConsts);
+    const bool bConst = getConstComponents(b, bConsts);
+
+    auto isSplat = [this] (const std::vector<uint32_t>& consts, bool isConst, uint32_t value) {
+      uint32_t v;
+      bool result = isConst;
+
+      for (uint32_t i = 0; i < consts.size() && result; i++)
+        result = getScalarConst(consts[i], v) && v == value;
+
+      return result;
+    };
+
+    // DXBC comparisons return ~0 or 0, which is then compared
+    // against zero when used as a condition. Use the original
+    // boolean in that case.
+    if (opCode == spv::OpIEqual || opCode == spv::OpINotEqual) {
+      uint32_t sel = getDef(a);
+      std::vector<uint32_t> refConsts = bConsts;
+
+      if (sel == Invalid || op(sel) != spv::OpSelect) {
+        sel = getDef(b);
+        refConsts = aConsts;
+      }
+
+      std::vector<uint32_t> xConsts;
+      std::vector<uint32_t> yConsts;
+
+      if (sel != Invalid && op(sel) == spv::OpSelect
+       && getType(word(sel, 3)) == typeId
+       && getConstComponents(word(sel, 4), xConsts)
+       && getConstComponents(word(sel, 5), yConsts)
+       && xConsts.size() == refConsts.size()
+       && yConsts.size() == refConsts.size()) {
+        bool isCond    = true;
+        bool isNotCond = true;
+
+        for (uint32_t i = 0; i < refConsts.size(); i++) {
+          uint32_t x, y, r;
+
+          if (!getScalarConst(xConsts[i], x)
+           || !getScalarConst(yConsts[i], y)
+           || !getScalarConst(refConsts[i], r))
+            return false;
+
+          bool xTrue = (x == r) != (opCode == spv::OpINotEqual);
+          bool yTrue = (y == r) != (opCode == spv::OpINotEqual);
+
+          isCond    &= xTrue && !yTrue;
+          isNotCond &= yTrue && !xTrue;
+        }
+
+        if (isCond) {
+          this->replace(ins, word(sel, 3));
+          return true;
+        }
+
+        if (isNotCond) {
+          std::vector<uint32_t> falseConsts(refConsts.size(),
+            this->defScalarConst(getComponentType(typeId), 0));
+
+          word(ins, 0) = (5 << spv::WordCountShift) | spv::OpLogicalEqual;
+          word(ins, 3) = word(sel, 3);
+          word(ins, 4) = falseConsts.size() == 1 ? falseConsts[0]
+            : this->defCompositeConst(typeId, falseConsts);
+          return true;
+        }
+      }
+    }
+
+    // Operations that return one of their operands
+    if (!isUnary) {
+      uint32_t result = 0;
+
+      switch (opCode) {
+        case spv::OpIAdd:
+        case spv::OpBitwiseOr:
+        case spv::OpBitwiseXor:
+          if (isSplat(bConsts, bConst, 0)) result = a;
+          if (isSplat(aConsts, aConst, 0)) result = b;
+          break;
+
+        case spv::OpISub:
+        case spv::OpShiftLeftLogical:
+        case spv::OpShiftRightLogical:
+        case spv::OpShiftRightArithmetic:
+          if (isSplat(bConsts, bConst, 0)) result = a;
+          break;
+
+        case spv::OpBitwiseAnd:
+          if (isSplat(bConsts, bConst, ~0u)) result = a;
+          if (isSplat(aConsts, aConst, ~0u)) result = b;
+          break;
+
+        case spv::OpIMul:
+          if (isSplat(bConsts, bConst, 1)) result = a;
+          if (isSplat(aConsts, aConst, 1)) result = b;
+          break;
+
+        default:
+          break;
+      }
+
+      if (result != 0 && getType(result) == typeId) {
+        this->replace(ins, result);
+        return true;
+      }
+    }
+
+    if (!aConst || !bConst || aConsts.size() != bConsts.size())
+      return false;
+
+    const uint32_t compType = getComponentType(typeId);
+    std::vector<uint32_t> components(aConsts.size());
+
+    for (uint32_t i = 0; i < components.size(); i++) {
+      uint32_t x, y;
+
+      if (!isScalar32(getType(aConsts[i])) || !getScalarConst(aConsts[i], x)
+       || !isScalar32(getType(bConsts[i])) || !getScalarConst(bConsts[i], y))
+        return false;
+
+      uint32_t r;
+
+      switch (opCode) {
+        case spv::OpIAdd:                 r = x + y; break;
+        case spv::OpISub:                 r = x - y; break;
+        case spv::OpIMul:                 r = x * y; break;
+        case spv::OpBitwiseAnd:           r = x & y; break;
+        case spv::OpBitwiseOr:            r = x | y; break;
+        case spv::OpBitwiseXor:           r = x ^ y; break;
+        case spv::OpNot:                  r = ~x;    break;
+        case spv::OpSNegate:              r = 0u - x; break;
+        case spv::OpIEqual:               r = x == y; break;
+        case spv::OpINotEqual:            r = x != y; break;
+        case spv::OpUGreaterThan:         r = x >  y; break;
+        case spv::OpUGreaterThanEqual:    r = x >= y; break;
+        case spv::OpULessThan:            r = x <  y; break;
+        case spv::OpULessThanEqual:       r = x <= y; break;
+        case spv::OpSGreaterThan:         r = int32_t(x) >  int32_t(y); break;
+        case spv::OpSGreaterThanEqual:    r = int32_t(x) >= int32_t(y); break;
+        case spv::OpSLessThan:            r = int32_t(x) <  int32_t(y); break;
+        case spv::OpSLessThanEqual:       r = int32_t(x) <= int32_t(y); break;
+
+        // Shifts by 32 or more bits are undefined
+        case spv::OpShiftLeftLogical:
+          if (y >= 32) return false;
+          r = x << y;
+          break;
+
+        case spv::OpShiftRightLogical:
+          if (y >= 32) return false;
+          r = x >> y;
+          break;
+
+        case spv::OpShiftRightArithmetic:
+          if (y >= 32) return false;
+          r = uint32_t(int32_t(x) >> y);
+          break;
+
+        default:
+          return false;
+      }
+
+      components[i] = this->defScalarConst(compType, r);
+    }
+
+    this->replace(ins, components.size() == 1 ? components[0]
+      : this->defCompositeConst(typeId, components));
+    return true;
+  }
+
+
+  bool SpirvOptimizer::foldLogicalOp(
+          uint32_t                ins) {
+    const spv::Op  opCode = op(ins);
+    const uint32_t typeId = word(ins, 1);
+
+    const bool isUnary = opCode == spv::OpLogicalNot;
+
+    const uint32_t a = word(ins, 3);
+    const uint32_t b = isUnary ? a : word(ins, 4);
+
+    std::vector<uint32_t> aConsts;
+    std::vector<uint32_t> bConsts;
+
+    if (!getConstComponents(a, aConsts)
+     || !getConstComponents(b, bConsts)
+     || aConsts.size() != bConsts.size())
+      return false;
+
+    const uint32_t compType = getComponentType(typeId);
+    std::vector<uint32_t> components(aConsts.size());
+
+    for (uint32_t i = 0; i < components.size(); i++) {
+      uint32_t x, y;
+
+      if (!getScalarConst(aConsts[i], x)
+       || !getScalarConst(bConsts[i], y))
+        return false;
+
+      uint32_t r;
+
+      switch (opCode) {
+        case spv::OpLogicalNot:       r = !x;     break;
+        case spv::OpLogicalAnd:       r = x && y; break;
+        case spv::OpLogicalOr:        r = x || y; break;
+        case spv::OpLogicalEqual:     r = x == y; break;
+        case spv::OpLogicalNotEqual:  r = x != y; break;
+        default: return false;
+      }
+
+      components[i] = this->defScalarConst(compType, r);
+    }
+
+    this->replace(ins, components.size() == 1 ? components[0]
+      : this->defCompositeConst(typeId, components));
+    return true;
+  }
+
+
+  bool SpirvOptimizer::foldSelect(
+          uint32_t                ins) {
+    const uint32_t cond = word(ins, 3);
+    const uint32_t a    = word(ins, 4);
+    const uint32_t b    = word(ins, 5);
+
+    if (a == b) {
+      this->replace(ins, a);
+      return true;
+    }
+
+    std::vector<uint32_t> conds;
+
+    if (!getConstComponents(cond, conds))
+      return false;
+
+    bool allTrue  = true;
+    bool allFalse = true;
+
+    for (uint32_t c : conds) {
+      uint32_t value;
+
+      if (!getScalarConst(c, value))
+        return false;
+
+      allTrue  &= value != 0;
+      allFalse &= value == 0;
+    }
+
+    if (!allTrue && !allFalse)
+      return false;
+
+    this->replace(ins, allTrue ? a : b);
+    return true;
+  }
+
+
+  bool SpirvOptimizer::foldPhi(
+          uint32_t                ins) {
+    const uint32_t result = word(ins, 2);
+    uint32_t value = 0;
+
+    for (uint32_t i = 3; i < length(ins); i += 2) {
+      uint32_t v = word(ins, i);
+
+      if (v == result || v == value)
+        continue;
+
+      if (value != 0)
+        return false;
+
+      value = v;
+    }
+
+    if (value == 0)
+      return false;
+
+    this->replace(ins, value);
+    return true;
+  }
+
+
+  void SpirvOptimizer::eliminateDeadStores() {
+    // Find all pointers that point into a variable
+    std::vector<uint32_t> roots(m_defs.size(), Invalid);
+    std::vector<bool>     isRead(m_vars.size(), false);
+
+    for (uint32_t i = 0; i < m_vars.size(); i++)
+      roots[m_vars[i].id] = i;
+
+    for (uint32_t ins : m_globals) {
+      if (op(ins) != spv::OpEntryPoint)
+        continue;
+
+      for (uint32_t i = 3; i < length(ins); i++) {
+        if (word(ins, i) < roots.size() && roots[word(ins, i)] != Invalid)
+          isRead[roots[word(ins, i)]] = true;
+      }
+    }
+
+    this->forEachInstruction([this, &roots, &isRead] (uint32_t ins) {
+      const spv::Op opCode = op(ins);
+
+      const bool isAccessChain = opCode == spv::OpAccessChain
+                              || opCode == spv::OpInBoundsAccessChain;
+
+      this->forEachIdOperand(ins, [this, &roots, &isRead, opCode, isAccessChain] (uint32_t& id, uint32_t idx) {
+        uint32_t root = roots[this->resolve(id)];
+
+        if (root == Invalid)
+          return;
+
+        if ((opCode != spv::OpStore || idx != 1)
+         && (!isAccessChain || idx != 3))
+          isRead[root] = true;
+      });
+
+      if (isAccessChain)
+        roots[word(ins, 2)] = roots[this->resolve(word(ins, 3))];
+    });
+
+    // Remove stores to variables that are never read
+    this->forEachInstruction([this, &roots, &isRead] (uint32_t ins) {
+      if (op(ins) != spv::OpStore)
+        return;
+
+      uint32_t root = roots[this->resolve(word(ins, 1))];
+
+      if (root != Invalid && !isRead[root])
+        m_ins[ins].removed = true;
+    });
+  }
+
+
+  void SpirvOptimizer::eliminateDeadCode() {
+    std::vector<bool>     live(m_ins.size(), false);
+    std::vector<uint32_t> worklist;
+
+    auto mark = [&live, &worklist] (uint32_t ins) {
+      if (!live[ins]) {
+        live[ins] = true;
+        worklist.push_back(ins);
+      }
+    };
+
+    this->forEachInstruction([this, &mark] (uint32_t ins) {
+      if (!getOpInfo(op(ins)).pure)
+        mark(ins);
+    });
+
+    while (!worklist.empty()) {
+      uint32_t ins = worklist.back();
+      worklist.pop_back();
+
+      this->forEachIdOperand(ins, [this, &mark] (uint32_t& id, uint32_t) {
+        uint32_t def = getDef(this->resolve(id));
+
+        if (def != Invalid)
+          mark(def);
+      });
+    }
+
+    this->forEachInstruction([this, &live] (uint32_t ins) {
+      if (!live[ins])
+        m_ins[ins].removed = true;
+    });
+  }
+
+
+  void SpirvOptimizer::eliminateUnusedGlobals() {
+    std::vector<bool> used(m_defs.size(), false);
+
+    this->forEachInstruction([this, &used] (uint32_t ins) {
+      this->forEachIdOperand(ins, [this, &used] (uint32_t& id, uint32_t) {
+        used[this->resolve(id)] = true;
+      });
+    });
+
+    // Walk global declarations backwards so that constants
+    // and variables are only kept if any live instruction
+    // or declaration uses them. Literal operands of other
+    // declarations are treated as IDs, which is safe.
+    std::vector<uint32_t> globals = m_globals;
+    globals.insert(globals.end(), m_newGlobals.begin(), m_newGlobals.end());
+
+    for (auto g = globals.rbegin(); g != globals.rend(); g++) {
+      const uint32_t ins = *g;
+
+      switch (op(ins)) {
+        case spv::OpName:
+        case spv::OpMemberName:
+        case spv::OpDecorate:
+        case spv::OpMemberDecorate:
+          continue;
+
+        case spv::OpConstantTrue:
+        case spv::OpConstantFalse:
+        case spv::OpConstant:
+        case spv::OpConstantComposite:
+        case spv::OpConstantNull:
+        case spv::OpUndef:
+          if (!used[word(ins, 2)]) {
+            m_ins[ins].removed = true;
+            continue;
+          } break;
+
+        case spv::OpVariable:
+          if (word(ins, 3) == spv::StorageClassPrivate && !used[word(ins, 2)]) {
+            m_ins[ins].removed = true;
+            continue;
+          } break;
+
+        default:
+          break;
+      }
+
+      for (uint32_t i = 1; i < length(ins); i++) {
+        if (word(ins, i) < used.size())
+          used[word(ins, i)] = true;
+      }
+    }
+
+    // Remove debug names and decorations of removed objects
+    for (uint32_t ins : m_globals) {
+      switch (op(ins)) {
+        case spv::OpName:
+        case spv::OpMemberName:
+        case spv::OpDecorate:
+        case spv::OpMemberDecorate: {
+          uint32_t def = getDef(word(ins, 1));
+
+          if (def != Invalid && m_ins[def].removed)
+            m_ins[ins].removed = true;
+        } break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+
+  bool SpirvOptimizer::validateModule() {
+    bool valid = true;
+
+    this->forEachInstruction([this, &valid] (uint32_t ins) {
+      this->forEachIdOperand(ins, [this, &valid] (uint32_t& id, uint32_t) {
+        uint32_t def = getDef(this->resolve(id));
+        valid &= def != Invalid && !m_ins[def].removed;
+      });
+    });
+
+    return valid;
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::buildModule() {
+    std::vector<uint32_t> code(m_header, m_header + 5);
+    code.reserve(m_words.size());
+
+    auto emit = [this, &code] (uint32_t ins) {
+      if (m_ins[ins].removed)
+        return;
+
+      const uint32_t* words = &m_words[m_ins[ins].offset];
+      code.insert(code.end(), words, words + m_ins[ins].length);
+    };
+
+    auto emitResolved = [this, &emit] (uint32_t ins) {
+      this->forEachIdOperand(ins, [this] (uint32_t& id, uint32_t) {
+        id = this->resolve(id);
+      });
+
+      emit(ins);
+    };
+
+    for (uint32_t ins : m_globals)
+      emit(ins);
+
+    for (uint32_t ins : m_newGlobals)
+      emit(ins);
+
+    for (const auto& fn : m_functions) {
+      for (uint32_t ins : fn.header)
+        emit(ins);
+
+      for (const auto& block : fn.blocks) {
+        emit(block.label);
+
+        for (uint32_t ins : block.phis)
+          emitResolved(ins);
+
+        for (uint32_t ins : block.code)
+          emitResolved(ins);
+      }
+
+      emit(fn.end);
+    }
+
+    return SpirvCodeBuffer(code.size(), code.data());
+  }
+
+
+  uint32_t SpirvOptimizer::addInstruction(
+          spv::Op                 op,
+          std::vector<uint32_t>   args) {
+    const uint32_t length = args.size() + 1;
+
+    Instruction ins;
+    ins.offset  = m_words.size();
+    ins.length  = length;
+    ins.removed = false;
+
+    m_words.push_back((length << spv::WordCountShift) | op);
+    m_words.insert(m_words.end(), args.begin(), args.end());
+
+    m_ins.push_back(ins);
+    return m_ins.size() - 1;
+  }
+
+
+  uint32_t SpirvOptimizer::allocateId() {
+    m_defs    .push_back(Invalid);
+    m_replace .push_back(0);
+    m_varIndex.push_back(Invalid);
+    return m_header[3]++;
+  }
+
+
+  uint32_t SpirvOptimizer::resolve(
+          uint32_t                id) {
+    uint32_t result = id;
+
+    while (m_replace[result] != 0)
+      result = m_replace[result];
+
+    // Shorten the chain for subsequent lookups
+    while (m_replace[id] != 0) {
+      uint32_t next = m_replace[id];
+      m_replace[id] = result;
+      id = next;
+    }
+
+    return result;
+  }
+
+
+  void SpirvOptimizer::replace(
+          uint32_t                ins,
+          uint32_t                id) {
+    const uint32_t result = word(ins, 2);
+
+    if (this->resolve(id) != result) {
+      m_replace[result]  = id;
+      m_ins[ins].removed = true;
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::getDef(
+          uint32_t                id) const {
+    return id < m_defs.size() ? m_defs[id] : Invalid;
+  }
+
+
+  uint32_t SpirvOptimizer::getType(
+          uint32_t                id) const {
+    uint32_t def = getDef(id);
+
+    if (def == Invalid)
+      return 0;
+
+    switch (op(def)) {
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantComposite:
+      case spv::OpConstantNull:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      case spv::OpSpecConstant:
+      case spv::OpSpecConstantComposite:
+      case spv::OpSpecConstantOp:
+      case spv::OpFunctionParameter:
+        return word(def, 1);
+
+      default:
+        return getOpInfo(op(def)).hasResult ? word(def, 1) : 0;
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::getComponentCount(
+          uint32_t                typeId) const {
+    uint32_t def = getDef(typeId);
+
+    if (def == Invalid)
+      return 0;
+
+    switch (op(def)) {
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+        return 1;
+
+      case spv::OpTypeVector:
+        return word(def, 3);
+
+      default:
+        return 0;
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::getComponentType(
+          uint32_t                typeId) const {
+    uint32_t def = getDef(typeId);
+
+    if (def != Invalid && op(def) == spv::OpTypeVector)
+      return word(def, 2);
+
+    return typeId;
+  }
+
+
+  bool SpirvOptimizer::isScalar32(
+          uint32_t                typeId) const {
+    uint32_t def = getDef(typeId);
+
+    return def != Invalid
+        && (op(def) == spv::OpTypeInt || op(def) == spv::OpTypeFloat)
+        && word(def, 2) == 32;
+  }
+
+
+  bool SpirvOptimizer::getScalarConst(
+          uint32_t                id,
+          uint32_t&               value) const {
+    uint32_t def = getDef(id);
+
+    if (def == Invalid)
+      return false;
+
+    switch (op(def)) {
+      case spv::OpConstant:
+        value = word(def, 3);
+        return length(def) == 4;
+
+      case spv::OpConstantTrue:
+        value = 1;
+        return true;
+
+      case spv::OpConstantFalse:
+        value = 0;
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+
+  bool SpirvOptimizer::getConstComponents(
+          uint32_t                id,
+          std::vector<uint32_t>&  components) const {
+    uint32_t def = getDef(id);
+    uint32_t value;
+
+    if (def == Invalid)
+      return false;
+
+    if (getScalarConst(id, value)) {
+      components.push_back(id);
+      return true;
+    }
+
+    if (op(def) != spv::OpConstantComposite
+     || getComponentCount(word(def, 1)) < 2)
+      return false;
+
+    for (uint32_t i = 3; i < length(def); i++)
+      components.push_back(word(def, i));
+
+    return true;
+  }
+
+
+  uint32_t SpirvOptimizer::defScalarConst(
+          uint32_t                typeId,
+          uint32_t                value) {
+    uint32_t def = getDef(typeId);
+
+    if (def != Invalid && op(def) == spv::OpTypeBool)
+      value = value ? 1 : 0;
+
+    const uint64_t key = (uint64_t(typeId) << 32) | value;
+    auto entry = m_scalarConsts.find(key);
+
+    if (entry != m_scalarConsts.end())
+      return entry->second;
+
+    const uint32_t id = this->allocateId();
+    uint32_t ins;
+
+    if (def != Invalid && op(def) == spv::OpTypeBool)
+      ins = this->addInstruction(value ? spv::OpConstantTrue : spv::OpConstantFalse, { typeId, id });
+    else
+      ins = this->addInstruction(spv::OpConstant, { typeId, id, value });
+
+    m_defs[id] = ins;
+    m_newGlobals.push_back(ins);
+    m_scalarConsts.insert({ key, id });
+    return id;
+  }
+
+
+  uint32_t SpirvOptimizer::defCompositeConst(
+          uint32_t                typeId,
+    const std::vector<uint32_t>&  components) {
+    std::vector<uint32_t> args = { typeId };
+    args.insert(args.end(), components.begin(), components.end());
+
+    std::string key(reinterpret_cast<const char*>(args.data()),
+      args.size() * sizeof(uint32_t));
+
+    auto entry = m_compositeConsts.find(key);
+
+    if (entry != m_compositeConsts.end())
+      return entry->second;
+
+    const uint32_t id = this->allocateId();
+    args.insert(args.begin() + 1, id);
+
+    uint32_t ins = this->addInstruction(spv::OpConstantComposite, std::move(args));
+    m_defs[id] = ins;
+    m_newGlobals.push_back(ins);
+    m_compositeConsts.insert({ key, id });
+    return id;
+  }
+
+
+  uint32_t SpirvOptimizer::defUndef(
+          uint32_t                typeId) {
+    auto entry = m_undefs.find(typeId);
+
+    if (entry != m_undefs.end())
+      return entry->second;
+
+    const uint32_t id = this->allocateId();
+
+    uint32_t ins = this->addInstruction(spv::OpUndef, { typeId, id });
+    m_defs[id] = ins;
+    m_newGlobals.push_back(ins);
+    m_undefs.insert({ typeId, id });
+    return id;
+  }
+
+
+  template<typename Fn>
+  void SpirvOptimizer::forEachIdOperand(
+          uint32_t                ins,
+    const Fn&                     fn) {
+    const spv::Op  opCode = op(ins);
+    const uint32_t len    = length(ins);
+
+    // Phi operands alternate between values and labels
+    if (opCode == spv::OpPhi) {
+      for (uint32_t i = 3; i < len; i += 2)
+        fn(word(ins, i), i);
+      return;
+    }
+
+    const SpirvOpInfo info = getOpInfo(opCode);
+
+    const uint32_t end = std::min(info.maskIndex
+      ? info.maskIndex : info.idEnd, len);
+
+    for (uint32_t i = info.idBegin; i < end; i++)
+      fn(word(ins, i), i);
+
+    if (info.maskIndex) {
+      for (uint32_t i = info.maskIndex + 1; i < len; i++)
+        fn(word(ins, i), i);
+    }
+  }
+
+
+  template<typename Fn>
+  void SpirvOptimizer::forEachInstruction(
+    const Fn&                     fn) {
+    for (const auto& func : m_functions) {
+      for (const auto& block : func.blocks) {
+        for (uint32_t ins : block.phis) {
+          if (!m_ins[ins].removed)
+            fn(ins);
+        }
+
+        for (uint32_t ins : block.code) {
+          if (!m_ins[ins].removed)
+            fn(ins);
+        }
+      }
+    }
+  }
+
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V optimizer
+   *
+   * Runs a small set of optimization passes on a
+   * SPIR-V module, in order to reduce the amount of
+   * work drivers have to do when compiling pipelines:
+   *
+   * - Promotion of private and function variables that
+   *   are only accessed via loads and stores within a
+   *   single function to SSA values
+   * - Folding of composite operations, bitcasts, and
+   *   integer and boolean operations on constants
+   * - Removal of instructions whose results are unused,
+   *   and of stores to variables that are never read
+   *
+   * Floating point operations are not folded since the
+   * result may depend on the driver's rounding and
+   * denorm behaviour. If the module contains any
+   * instruction that the optimizer does not know
+   * about, the module is returned unmodified.
+   */
+  class SpirvOptimizer {
+
+  public:
+
+    SpirvOptimizer();
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Optimizes a module
+     *
+     * \param [in] code The module to optimize
+     * \returns Optimized module, or the original
+     *          module if it cannot be optimized
+     */
+    SpirvCodeBuffer optimize(
+            SpirvCodeBuffer         code);
+
+  private:
+
+    constexpr static uint32_t Invalid = ~0u;
+
+    struct Instruction {
+      uint32_t offset;
+      uint32_t length;
+      bool     removed;
+    };
+
+    struct Block {
+      uint32_t              labelId;
+      uint32_t              label;
+      std::vector<uint32_t> phis;
+      std::vector<uint32_t> code;
+      std::vector<uint32_t> preds;
+      std::vector<uint32_t> succs;
+      std::vector<uint32_t> children;
+      std::vector<uint32_t> frontier;
+      uint32_t              idom;
+      uint32_t              order;
+    };
+
+    struct Function {
+      uint32_t              id;
+      std::vector<uint32_t> header;
+      std::vector<Block>    blocks;
+      std::vector<uint32_t> rpo;
+      uint32_t              end;
+      uint32_t              callCount = 0;
+      uint32_t              caller    = Invalid;
+      bool                  hasLoops  = false;
+      bool                  runsOnce  = false;
+    };
+
+    struct Variable {
+      uint32_t              id;
+      uint32_t              typeId;
+      uint32_t              function;
+      bool                  isPrivate;
+      bool                  promotable;
+    };
+
+    uint32_t                  m_header[5];
+    std::vector<uint32_t>     m_words;
+    std::vector<Instruction>  m_ins;
+
+    std::vector<uint32_t>     m_globals;
+    std::vector<uint32_t>     m_newGlobals;
+    std::vector<Function>     m_functions;
+
+    std::vector<uint32_t>     m_defs;
+    std::vector<uint32_t>     m_replace;
+    std::vector<uint32_t>     m_varIndex;
+    std::vector<Variable>     m_vars;
+    std::vector<uint32_t>     m_entryPoints;
+
+    std::unordered_map<uint64_t,    uint32_t> m_scalarConsts;
+    std::unordered_map<std::string, uint32_t> m_compositeConsts;
+    std::unordered_map<uint32_t,    uint32_t> m_undefs;
+
+    bool parseModule(
+            SpirvCodeBuffer&        code);
+
+    bool buildCfg(
+            Function&               fn);
+
+    void computeDominators(
+            Function&               fn);
+
+    void analyzeCalls();
+
+    void analyzeVariables();
+
+    void promoteVariables(
+            uint32_t                fnId);
+
+    void foldInstructions();
+
+    bool foldInstruction(
+            uint32_t                ins);
+
+    bool foldCompositeExtract(
+            uint32_t                ins);
+
+    bool foldVectorShuffle(
+            uint32_t                ins);
+
+    bool foldCompositeConstruct(
+            uint32_t                ins);
+
+    bool foldBitcast(
+            uint32_t                ins);
+
+    bool foldIntOp(
+            uint32_t                ins);
+
+    bool foldLogicalOp(
+            uint32_t                ins);
+
+    bool foldSelect(
+            uint32_t                ins);
+
+    bool foldPhi(
+            uint32_t                ins);
+
+    void eliminateDeadStores();
+
+    void eliminateDeadCode();
+
+    void eliminateUnusedGlobals();
+
+    bool validateModule();
+
+    SpirvCodeBuffer buildModule();
+
+    spv::Op op(uint32_t ins) const {
+      return spv::Op(m_words[m_ins[ins].offset] & spv::OpCodeMask);
+    }
+
+    uint32_t length(uint32_t ins) const {
+      return m_ins[ins].length;
+    }
+
+    uint32_t& word(uint32_t ins, uint32_t idx) {
+      return m_words[m_ins[ins].offset + idx];
+    }
+
+    uint32_t word(uint32_t ins, uint32_t idx) const {
+      return m_words[m_ins[ins].offset + idx];
+    }
+
+    uint32_t addInstruction(
+            spv::Op                 op,
+            std::vector<uint32_t>   args);
+
+    uint32_t allocateId();
+
+    uint32_t resolve(
+            uint32_t                id);
+
+    void replace(
+            uint32_t                ins,
+            uint32_t                id);
+
+    uint32_t getDef(
+            uint32_t                id) const;
+
+    uint32_t getType(
+            uint32_t                id) const;
+
+    uint32_t getComponentCount(
+            uint32_t                typeId) const;
+
+    uint32_t getComponentType(
+            uint32_t                typeId) const;
+
+    bool isScalar32(
+            uint32_t                typeId) const;
+
+    bool getScalarConst(
+            uint32_t                id,
+            uint32_t&               value) const;
+
+    bool getConstComponents(
+            uint32_t                id,
+            std::vector<uint32_t>&  components) const;
+
+    uint32_t defScalarConst(
+            uint32_t                typeId,
+            uint32_t                value);
+
+    uint32_t defCompositeConst(
+            uint32_t                typeId,
+      const std::vector<uint32_t>&  components);
+
+    uint32_t defUndef(
+            uint32_t                typeId);
+
+    template<typename Fn>
+    void forEachIdOperand(
+            uint32_t                ins,
+      const Fn&                     fn);
+
+    template<typename Fn>
+    void forEachInstruction(
+      const Fn&                     fn);
+
+  };
+
+}
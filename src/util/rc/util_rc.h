@@ -19,6 +19,24 @@ namespace dxvk {
       return ++m_refCount;
     }
     
+    /**
+     * \brief Increments reference count if non-zero
+     * 
+     * Used to safely acquire a reference to an object
+     * that may be in the process of being destroyed.
+     * \returns \c true if a reference was acquired
+     */
+    bool tryIncRef() {
+      uint32_t refCount = m_refCount.load();
+      
+      while (refCount != 0) {
+        if (m_refCount.compare_exchange_weak(refCount, refCount + 1))
+          return true;
+      }
+      
+      return false;
+    }
+    
     /**
      * \brief Decrements reference count
      * \returns New reference count
@@ -27,6 +45,17 @@ namespace dxvk {
       return --m_refCount;
     }
     
+    /**
+     * \brief Queries reference count
+     * 
+     * The result may be outdated immediately if
+     * other threads create or release references.
+     * \returns Current reference count
+     */
+    uint32_t getRefCount() const {
+      return m_refCount.load();
+    }
+    
   private:
     
     std::atomic<uint32_t> m_refCount = { 0u };
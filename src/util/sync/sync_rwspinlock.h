@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include "../thread.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Read-write spin lock
+   *
+   * Spin lock that can be held by any number of
+   * readers, or by a single writer. Writers are
+   * not prioritized, so they should only use
+   * \c try_lock if readers hold the lock for
+   * long periods of time.
+   */
+  class RwSpinlock {
+    constexpr static uint32_t WriteBit = 1u << 31;
+  public:
+
+    RwSpinlock() { }
+    ~RwSpinlock() { }
+
+    RwSpinlock             (const RwSpinlock&) = delete;
+    RwSpinlock& operator = (const RwSpinlock&) = delete;
+
+    void lock() {
+      while (!this->try_lock())
+        dxvk::this_thread::yield();
+    }
+
+    void unlock() {
+      m_lock.store(0, std::memory_order_release);
+    }
+
+    bool try_lock() {
+      uint32_t expected = 0;
+      return m_lock.compare_exchange_strong(expected, WriteBit,
+        std::memory_order_acquire,
+        std::memory_order_relaxed);
+    }
+
+    void lock_shared() {
+      while (!this->try_lock_shared())
+        dxvk::this_thread::yield();
+    }
+
+    void unlock_shared() {
+      m_lock.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool try_lock_shared() {
+      uint32_t expected = m_lock.load(std::memory_order_relaxed);
+      return !(expected & WriteBit)
+        && m_lock.compare_exchange_strong(expected, expected + 1,
+             std::memory_order_acquire,
+             std::memory_order_relaxed);
+    }
+
+  private:
+
+    std::atomic<uint32_t> m_lock = { 0 };
+
+  };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 
 #include "util_error.h"
@@ -124,5 +125,10 @@ namespace dxvk {
     inline void yield() {
       Sleep(0);
     }
+    
+    template<typename Rep, typename Period>
+    inline void sleep_for(const std::chrono::duration<Rep, Period>& duration) {
+      Sleep(DWORD(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()));
+    }
   }
 }
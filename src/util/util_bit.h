@@ -47,4 +47,19 @@ namespace dxvk::bit {
     #endif
   }
   
+  inline uint32_t bsr(uint64_t n) {
+    #if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long res;
+    _BitScanReverse64(&res, n);
+    return uint32_t(res);
+    #elif defined(__GNUC__)
+    return 63 - uint32_t(__builtin_clzll(n));
+    #else
+    uint32_t r = 0;
+    while (n >>= 1)
+      r += 1;
+    return r;
+    #endif
+  }
+  
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "util_file_map.h"
+
+namespace dxvk {
+  
+  FileMapping::FileMapping() { }
+  
+  
+  FileMapping::~FileMapping() {
+    this->close();
+  }
+  
+  
+  bool FileMapping::open(const std::string& path) {
+    this->close();
+    
+    // Allow other handles to append to the file
+    // while it is mapped, as well as replacing it
+    m_file = ::CreateFileA(path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    
+    if (m_file == INVALID_HANDLE_VALUE)
+      return false;
+    
+    LARGE_INTEGER fileSize;
+    
+    if (!::GetFileSizeEx(m_file, &fileSize)
+     || fileSize.QuadPart <= 0
+     || uint64_t(fileSize.QuadPart) > uint64_t(SIZE_MAX)) {
+      this->close();
+      return false;
+    }
+    
+    m_mapping = ::CreateFileMappingA(m_file,
+      nullptr, PAGE_READONLY, 0, 0, nullptr);
+    
+    if (m_mapping == nullptr) {
+      this->close();
+      return false;
+    }
+    
+    m_data = ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    m_size = size_t(fileSize.QuadPart);
+    
+    if (m_data == nullptr) {
+      this->close();
+      return false;
+    }
+    
+    return true;
+  }
+  
+  
+  void FileMapping::close() {
+    if (m_data != nullptr)
+      ::UnmapViewOfFile(m_data);
+    
+    if (m_mapping != nullptr)
+      ::CloseHandle(m_mapping);
+    
+    if (m_file != INVALID_HANDLE_VALUE)
+      ::CloseHandle(m_file);
+    
+    m_file    = INVALID_HANDLE_VALUE;
+    m_mapping = nullptr;
+    m_data    = nullptr;
+    m_size    = 0;
+  }
+  
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+
+#include "./com/com_include.h"
+
+namespace dxvk {
+  
+  /**
+   * \brief Read-only file mapping
+   * 
+   * Maps an entire file into the address space of
+   * the process. Other handles to the file may still
+   * write to or append to it while it is mapped, but
+   * the mapped view will keep the size it had when
+   * the file was opened.
+   */
+  class FileMapping {
+    
+  public:
+    
+    FileMapping();
+    ~FileMapping();
+    
+    FileMapping             (const FileMapping&) = delete;
+    FileMapping& operator = (const FileMapping&) = delete;
+    
+    /**
+     * \brief Maps a file
+     * 
+     * Unmaps any previously mapped file. Fails if the
+     * file does not exist or if it is empty.
+     * \param [in] path Path to the file
+     * \returns \c true on success
+     */
+    bool open(const std::string& path);
+    
+    /**
+     * \brief Unmaps the file
+     * 
+     * Invalidates all pointers into the mapped view.
+     * Must be called before truncating the file.
+     */
+    void close();
+    
+    /**
+     * \brief Pointer to mapped data
+     * \returns Start of the mapped view
+     */
+    const void* data() const {
+      return m_data;
+    }
+    
+    /**
+     * \brief Size of the mapped view
+     * \returns Mapped size, in bytes
+     */
+    size_t size() const {
+      return m_size;
+    }
+    
+  private:
+    
+    HANDLE      m_file    = INVALID_HANDLE_VALUE;
+    HANDLE      m_mapping = nullptr;
+    const void* m_data    = nullptr;
+    size_t      m_size    = 0;
+    
+  };
+  
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <dxbc_module.h>
+#include <dxvk_shader.h>
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-opt-bench.log");
+}
+
+using namespace dxvk;
+
+constexpr uint32_t IterationCount = 5;
+
+const char* ValidatorFile = "dxbc-opt-bench.spv";
+
+struct CompileResult {
+  double        ms    = 0.0;
+  size_t        size  = 0;
+  bool          valid = true;
+};
+
+
+bool hasValidator() {
+  return std::system("spirv-val --version > NUL 2>&1") == 0;
+}
+
+
+bool validateShader(const std::string& code) {
+  std::ofstream file(ValidatorFile, std::ios::binary | std::ios::trunc);
+  file.write(code.data(), code.size());
+  file.close();
+
+  return std::system(str::format("spirv-val ", ValidatorFile).c_str()) == 0;
+}
+
+
+std::vector<std::string> listShaders(const WCHAR* directory) {
+  std::vector<std::string> result;
+
+  WIN32_FIND_DATAW findData;
+  HANDLE handle = FindFirstFileW(
+    (std::wstring(directory) + L"\\*.dxbc").c_str(), &findData);
+
+  if (handle == INVALID_HANDLE_VALUE)
+    return result;
+
+  do {
+    result.push_back(str::fromws(directory) + "\\" + str::fromws(findData.cFileName));
+  } while (FindNextFileW(handle, &findData));
+
+  FindClose(handle);
+  return result;
+}
+
+
+std::vector<char> readFile(const std::string& fileName) {
+  std::ifstream file(fileName, std::ios::binary);
+  return std::vector<char>(
+    std::istreambuf_iterator<char>(file),
+    std::istreambuf_iterator<char>());
+}
+
+
+CompileResult compileShader(
+        DxbcModule&         module,
+  const std::string&        fileName,
+        DxbcOptions         options,
+        bool                validate) {
+  CompileResult result;
+
+  DxbcModuleInfo moduleInfo;
+  moduleInfo.options = options;
+
+  // Take the fastest run in order to reduce noise
+  for (uint32_t i = 0; i < IterationCount; i++) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Rc<DxvkShader> shader = module.compile(moduleInfo, fileName);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    if (i == 0 || ms < result.ms)
+      result.ms = ms;
+
+    if (i == 0) {
+      std::stringstream stream;
+      shader->dump(stream);
+      result.size = stream.str().size();
+
+      if (validate)
+        result.valid = validateShader(stream.str());
+    }
+  }
+
+  return result;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxbc-opt-bench <directory with .dxbc files>");
+    return 1;
+  }
+
+  std::vector<std::string> files = listShaders(argv[1]);
+
+  if (files.empty()) {
+    Logger::err("No .dxbc files found");
+    return 1;
+  }
+
+  DxbcOptions baseOptions;
+  baseOptions.set(DxbcOption::DeferKill);
+
+  DxbcOptions optOptions = baseOptions;
+  optOptions.set(DxbcOption::OptimizeSpirv);
+
+  // Without a validator, only the size and compile
+  // time of the optimized shaders can be compared
+  bool validate = hasValidator();
+
+  if (!validate)
+    Logger::warn("spirv-val not found, skipping validation");
+
+  CompileResult baseTotal;
+  CompileResult optTotal;
+  uint32_t      shaderCount = 0;
+  uint32_t      errorCount  = 0;
+
+  for (const auto& fileName : files) {
+    try {
+      std::vector<char> code = readFile(fileName);
+
+      DxbcReader reader(code.data(), code.size());
+      DxbcModule module(reader);
+
+      CompileResult base = compileShader(module, fileName, baseOptions, validate);
+      CompileResult opt  = compileShader(module, fileName, optOptions,  validate);
+
+      if (!base.valid || !opt.valid) {
+        Logger::err(str::format(fileName, ": Validation failed for ",
+          base.valid ? "optimized" : (opt.valid ? "unoptimized" : "both"), " shader"));
+        errorCount += 1;
+      }
+
+      Logger::info(str::format(fileName, ": ",
+        base.size, " -> ", opt.size, " bytes, ",
+        base.ms, " -> ", opt.ms, " ms"));
+
+      baseTotal.size += base.size;
+      baseTotal.ms   += base.ms;
+      optTotal.size  += opt.size;
+      optTotal.ms    += opt.ms;
+      shaderCount    += 1;
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(fileName, ": ", e.message()));
+      errorCount += 1;
+    }
+  }
+
+  Logger::info(str::format("Compiled ", shaderCount, " shaders:",
+    "\n  Size:         ", baseTotal.size, " -> ", optTotal.size, " bytes (",
+      100.0 * double(optTotal.size) / double(std::max<size_t>(baseTotal.size, 1)), "%)",
+    "\n  Compile time: ", baseTotal.ms, " -> ", optTotal.ms, " ms"));
+
+  if (errorCount) {
+    Logger::err(str::format(errorCount, " shaders failed to compile or validate"));
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,369 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#include <dxvk_memory_range.h>
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("memory-alloc-bench.log");
+}
+
+using namespace dxvk;
+
+constexpr VkDeviceSize InvalidOffset = DxvkMemoryRangeAllocator::InvalidOffset;
+
+struct TraceOp {
+  bool          isAlloc;
+  uint32_t      id;
+  uint32_t      type;
+  VkDeviceSize  size;
+  VkDeviceSize  align;
+};
+
+struct Allocation {
+  uint32_t      type;
+  uint32_t      chunk;
+  VkDeviceSize  offset;
+  VkDeviceSize  length;
+};
+
+struct ReplayResult {
+  double        nsPerOp        = 0.0;
+  uint32_t      chunkCount     = 0;
+  uint32_t      failedAllocs   = 0;
+  double        fragmentation  = 0.0;
+};
+
+
+/**
+ * \brief Worst-fit free list
+ *
+ * The previous chunk sub-allocator, kept
+ * around as a baseline for comparisons.
+ */
+class LegacyChunk {
+
+public:
+
+  LegacyChunk(VkDeviceSize size) {
+    m_freeList.push_back({ 0, size });
+  }
+
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align) {
+    if (m_freeList.size() == 0)
+      return InvalidOffset;
+
+    auto bestSlice = m_freeList.begin();
+
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    const VkDeviceSize sliceStart = bestSlice->offset;
+    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+
+    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+
+    if (allocEnd > sliceEnd)
+      return InvalidOffset;
+
+    m_freeList.erase(bestSlice);
+
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+    return allocStart;
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length) {
+    auto curr = m_freeList.begin();
+
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    m_freeList.push_back({ offset, length });
+  }
+
+  double fragmentation() const {
+    VkDeviceSize freeSize    = 0;
+    VkDeviceSize largestFree = 0;
+
+    for (const auto& slice : m_freeList) {
+      freeSize   += slice.length;
+      largestFree = std::max(largestFree, slice.length);
+    }
+
+    return freeSize != 0
+      ? 1.0 - double(largestFree) / double(freeSize)
+      : 0.0;
+  }
+
+private:
+
+  struct FreeSlice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+
+  std::vector<FreeSlice> m_freeList;
+
+};
+
+
+/**
+ * \brief Segregated-fit allocator
+ */
+class RangeChunk {
+
+public:
+
+  RangeChunk(VkDeviceSize size)
+  : m_ranges(size) { }
+
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align) {
+    return m_ranges.alloc(dxvk::align(size, align), align);
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length) {
+    m_ranges.free(offset);
+  }
+
+  double fragmentation() const {
+    return m_ranges.getStats().fragmentation();
+  }
+
+private:
+
+  DxvkMemoryRangeAllocator m_ranges;
+
+};
+
+
+template<typename Chunk>
+ReplayResult replayTrace(
+  const std::vector<TraceOp>& ops,
+        uint32_t              idCount,
+        VkDeviceSize          chunkSize) {
+  std::vector<std::vector<Chunk>> types;
+  std::vector<Allocation> allocations(idCount);
+
+  ReplayResult result;
+
+  auto t0 = std::chrono::high_resolution_clock::now();
+
+  for (const TraceOp& op : ops) {
+    if (op.isAlloc) {
+      if (op.type >= types.size())
+        types.resize(op.type + 1);
+
+      auto& chunks = types[op.type];
+
+      Allocation alloc = { op.type, 0, InvalidOffset, dxvk::align(op.size, op.align) };
+
+      for (uint32_t i = 0; i < chunks.size() && alloc.offset == InvalidOffset; i++) {
+        alloc.chunk  = i;
+        alloc.offset = chunks[i].alloc(op.size, op.align);
+      }
+
+      if (alloc.offset == InvalidOffset) {
+        chunks.emplace_back(std::max(chunkSize, alloc.length));
+        alloc.chunk  = chunks.size() - 1;
+        alloc.offset = chunks.back().alloc(op.size, op.align);
+      }
+
+      if (alloc.offset == InvalidOffset)
+        result.failedAllocs += 1;
+
+      allocations[op.id] = alloc;
+    } else {
+      const Allocation& alloc = allocations[op.id];
+
+      if (alloc.offset != InvalidOffset)
+        types[alloc.type][alloc.chunk].free(alloc.offset, alloc.length);
+    }
+  }
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+
+  result.nsPerOp = double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count())
+                 / double(std::max<size_t>(ops.size(), 1));
+
+  for (const auto& chunks : types) {
+    for (const auto& chunk : chunks) {
+      result.chunkCount    += 1;
+      result.fragmentation += chunk.fragmentation();
+    }
+  }
+
+  if (result.chunkCount != 0)
+    result.fragmentation /= double(result.chunkCount);
+
+  return result;
+}
+
+
+/**
+ * \brief Reads a trace recorded with DXVK_MEMORY_TRACE
+ *
+ * Each line is either "a <key> <type> <size> <align>"
+ * for an allocation, or "f <key>" for a free.
+ */
+bool readTrace(
+  const std::string&          fileName,
+        std::vector<TraceOp>& ops,
+        uint32_t&             idCount) {
+  std::ifstream file(fileName);
+
+  if (!file)
+    return false;
+
+  std::unordered_map<std::string, uint32_t> liveIds;
+  std::string line;
+
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+
+    std::string cmd;
+    std::string key;
+    stream >> cmd >> key;
+
+    TraceOp op = { };
+
+    if (cmd == "a") {
+      op.isAlloc = true;
+      op.id      = idCount++;
+      stream >> op.type >> op.size >> op.align;
+
+      liveIds[key] = op.id;
+    } else if (cmd == "f") {
+      auto entry = liveIds.find(key);
+
+      if (entry == liveIds.end())
+        continue;
+
+      op.isAlloc = false;
+      op.id      = entry->second;
+
+      liveIds.erase(entry);
+    } else {
+      continue;
+    }
+
+    ops.push_back(op);
+  }
+
+  return true;
+}
+
+
+/**
+ * \brief Generates a synthetic trace
+ *
+ * Mostly small allocations with a long tail of
+ * larger ones, freed in random order, roughly
+ * resembling resource churn in a game.
+ */
+void generateTrace(
+        std::vector<TraceOp>& ops,
+        uint32_t&             idCount) {
+  std::mt19937 rng(0x44585643);
+  std::uniform_real_distribution<double> sizeDist(8.0, 20.0);
+  std::uniform_int_distribution<uint32_t> opDist(0, 99);
+
+  std::vector<uint32_t> live;
+
+  for (uint32_t i = 0; i < 1000000; i++) {
+    TraceOp op = { };
+
+    if (live.empty() || opDist(rng) < (live.size() < 16384 ? 60 : 40)) {
+      op.isAlloc = true;
+      op.id      = idCount++;
+      op.type    = 0;
+      op.size    = VkDeviceSize(std::exp2(sizeDist(rng)));
+      op.align   = op.size >= 65536 ? 65536 : 256;
+      live.push_back(op.id);
+    } else {
+      uint32_t index = std::uniform_int_distribution<uint32_t>(0, live.size() - 1)(rng);
+
+      op.isAlloc = false;
+      op.id      = live[index];
+
+      live[index] = live.back();
+      live.pop_back();
+    }
+
+    ops.push_back(op);
+  }
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  std::vector<TraceOp> ops;
+  uint32_t idCount = 0;
+
+  VkDeviceSize chunkSize = 64 << 20;
+
+  if (argc > 2)
+    chunkSize = VkDeviceSize(std::stoull(str::fromws(argv[2]))) << 20;
+
+  if (argc > 1) {
+    std::string fileName = str::fromws(argv[1]);
+
+    if (!readTrace(fileName, ops, idCount)) {
+      Logger::err(str::format("Failed to read ", fileName));
+      Logger::err("Usage: memory-alloc-bench [trace.txt] [chunk size in MB]");
+      return 1;
+    }
+  } else {
+    generateTrace(ops, idCount);
+  }
+
+  Logger::info(str::format("Replaying ", ops.size(), " operations, chunk size ", chunkSize >> 20, " MB"));
+
+  std::array<std::pair<const char*, ReplayResult>, 2> results = {{
+    { "worst-fit",      replayTrace<LegacyChunk>(ops, idCount, chunkSize) },
+    { "segregated-fit", replayTrace<RangeChunk> (ops, idCount, chunkSize) },
+  }};
+
+  for (const auto& result : results) {
+    Logger::info(str::format(result.first, ":",
+      "\n  Time:          ", result.second.nsPerOp, " ns/op",
+      "\n  Chunks:        ", result.second.chunkCount,
+      "\n  Fragmentation: ", result.second.fragmentation,
+      "\n  Failed:        ", result.second.failedAllocs));
+  }
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <fstream>
+
+#include <dxvk_state_cache.h>
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("state-cache-merge.log");
+}
+
+using namespace dxvk;
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+  
+  if (argc < 3) {
+    Logger::err("Usage: state-cache-merge output.dxvk-cache input.dxvk-cache...");
+    Logger::err("Inputs may be version 2 or 3 files, the output is written as version 3.");
+    return 1;
+  }
+  
+  // Read all input files first, so that the
+  // output file may also be one of the inputs
+  std::vector<DxvkStateCacheEntry> entries;
+  
+  for (int i = 2; i < argc; i++) {
+    std::string ifileName = str::fromws(argv[i]);
+    std::ifstream ifile(ifileName, std::ios_base::binary);
+    
+    size_t entryCount = entries.size();
+    
+    if (!ifile || !DxvkStateCache::readEntries(ifile, entries)) {
+      Logger::warn(str::format("Skipping invalid or unsupported file ", ifileName));
+      continue;
+    }
+    
+    Logger::info(str::format("Read ", entries.size() - entryCount, " entries from ", ifileName));
+  }
+  
+  size_t numDuplicates = DxvkStateCache::compactEntries(entries);
+  
+  std::string ofileName = str::fromws(argv[1]);
+  std::ofstream ofile(ofileName, std::ios_base::binary | std::ios_base::trunc);
+  
+  if (!ofile || !DxvkStateCache::writeEntries(ofile, entries)) {
+    Logger::err(str::format("Failed to write ", ofileName));
+    return 1;
+  }
+  
+  Logger::info(str::format("Wrote ", entries.size(), " entries to ", ofileName,
+    ", removed ", numDuplicates, " duplicates"));
+  return 0;
+}
@@ -0,0 +1,310 @@
+#include <algorithm>
+
+#include "../../src/spirv/spirv_module.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-module.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Reference output
+ * 
+ * Generated by \ref buildModule with the implementation
+ * that looked up types and constants by scanning the
+ * declarations. Declaration lookups must still return
+ * the same IDs, so the output must not change.
+ */
+const uint32_t g_referenceCode[] = {
+  0x07230203, 0x00010000, 0x00000000, 0x000000b4, 0x00000000, 0x00020011, 0x00000001, 0x00020011,
+  0x00000032, 0x0009000a, 0x5f565053, 0x5f52484b, 0x64616873, 0x645f7265, 0x5f776172, 0x61726170,
+  0x6574656d, 0x00007372, 0x0006000b, 0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000,
+  0x0003000e, 0x00000000, 0x00000001, 0x0006000f, 0x00000005, 0x00000002, 0x6e69616d, 0x00000000,
+  0x00000012, 0x00060010, 0x00000002, 0x00000011, 0x00000040, 0x00000001, 0x00000001, 0x00030005,
+  0x00000004, 0x00000074, 0x00030005, 0x00000006, 0x00000074, 0x00030005, 0x00000008, 0x00000074,
+  0x00030005, 0x0000000a, 0x00000074, 0x00030005, 0x00000009, 0x00000074, 0x00030005, 0x0000000c,
+  0x00000074, 0x00030005, 0x0000000d, 0x00000074, 0x00030005, 0x0000000f, 0x00000074, 0x00030005,
+  0x00000010, 0x00000074, 0x00030005, 0x0000000f, 0x00000074, 0x00030005, 0x0000000c, 0x00000074,
+  0x00040047, 0x00000008, 0x00000006, 0x00000004, 0x00030047, 0x00000009, 0x00000002, 0x00050048,
+  0x00000009, 0x00000000, 0x00000023, 0x00000000, 0x00040047, 0x00000012, 0x00000022, 0x00000000,
+  0x00040047, 0x00000012, 0x00000021, 0x00000000, 0x00040047, 0x00000018, 0x00000001, 0x00000000,
+  0x00040047, 0x00000019, 0x00000001, 0x00000001, 0x00020013, 0x00000003, 0x00020014, 0x00000004,
+  0x00030016, 0x00000005, 0x00000020, 0x00040015, 0x00000006, 0x00000020, 0x00000001, 0x00040015,
+  0x00000007, 0x00000020, 0x00000000, 0x0003001d, 0x00000008, 0x00000007, 0x0003001e, 0x00000009,
+  0x00000008, 0x0003001e, 0x0000000a, 0x00000008, 0x0004002b, 0x00000007, 0x0000000b, 0x00000010,
+  0x0004001c, 0x0000000c, 0x00000005, 0x0000000b, 0x0004001c, 0x0000000d, 0x00000005, 0x0000000b,
+  0x0004002b, 0x00000007, 0x0000000e, 0x00000011, 0x0004001c, 0x0000000f, 0x00000005, 0x0000000e,
+  0x0004001c, 0x00000010, 0x00000005, 0x0000000e, 0x00040020, 0x00000011, 0x00000002, 0x00000009,
+  0x00090019, 0x00000013, 0x00000005, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+  0x00000000, 0x0003001b, 0x00000014, 0x00000013, 0x0002001a, 0x00000015, 0x00090019, 0x00000016,
+  0x00000005, 0x00000001, 0x00000000, 0x00000001, 0x00000000, 0x00000001, 0x00000000, 0x0003001b,
+  0x00000017, 0x00000016, 0x00030030, 0x00000004, 0x00000018, 0x00040032, 0x00000007, 0x00000019,
+  0x00000007, 0x00030021, 0x0000001a, 0x00000003, 0x00040017, 0x0000001c, 0x00000005, 0x00000004,
+  0x00040020, 0x0000001d, 0x00000006, 0x0000001c, 0x0004002b, 0x00000005, 0x0000001f, 0x00000000,
+  0x0007002c, 0x0000001c, 0x00000020, 0x0000001f, 0x0000001f, 0x0000001f, 0x0000001f, 0x0004002b,
+  0x00000006, 0x00000021, 0x00000001, 0x0003002a, 0x00000004, 0x00000022, 0x0004002b, 0x00000007,
+  0x00000023, 0x00000004, 0x0004001c, 0x00000024, 0x00000007, 0x00000023, 0x0004002b, 0x00000007,
+  0x00000025, 0x00000000, 0x0004002b, 0x00000007, 0x00000026, 0x00000001, 0x0004002b, 0x00000007,
+  0x00000027, 0x00000002, 0x00040017, 0x00000028, 0x00000007, 0x00000002, 0x0005002c, 0x00000028,
+  0x00000029, 0x00000025, 0x00000027, 0x0004001c, 0x0000002a, 0x00000007, 0x00000027, 0x0004002b,
+  0x00000005, 0x0000002b, 0x3f800000, 0x0007002c, 0x0000001c, 0x0000002c, 0x0000002b, 0x0000002b,
+  0x0000001f, 0x0000002b, 0x0004002b, 0x00000007, 0x0000002e, 0x0000000b, 0x0004002b, 0x00000007,
+  0x0000002f, 0x00000006, 0x0004002b, 0x00000007, 0x00000030, 0x00000003, 0x0005002c, 0x00000028,
+  0x00000031, 0x00000030, 0x00000025, 0x0004002b, 0x00000006, 0x00000032, 0x00000005, 0x00030029,
+  0x00000004, 0x00000033, 0x0007002c, 0x0000001c, 0x00000034, 0x0000002b, 0x0000001f, 0x0000001f,
+  0x0000002b, 0x0004002b, 0x00000006, 0x00000036, 0x00000003, 0x0004001c, 0x00000037, 0x00000007,
+  0x00000030, 0x0005002c, 0x00000028, 0x00000038, 0x00000026, 0x00000026, 0x00040017, 0x00000039,
+  0x00000005, 0x00000001, 0x00040020, 0x0000003a, 0x00000007, 0x00000039, 0x00040017, 0x0000003b,
+  0x00000006, 0x00000002, 0x00040020, 0x0000003c, 0x00000006, 0x0000003b, 0x0005002c, 0x00000028,
+  0x0000003d, 0x00000026, 0x00000025, 0x00040020, 0x0000003e, 0x00000007, 0x0000003b, 0x0004002b,
+  0x00000006, 0x0000003f, 0xfffffffb, 0x0004002b, 0x00000007, 0x00000040, 0x00000008, 0x0004002b,
+  0x00000005, 0x00000041, 0x3fc00000, 0x0004001c, 0x00000042, 0x00000006, 0x00000027, 0x0007002c,
+  0x0000001c, 0x00000043, 0x0000002b, 0x0000001f, 0x0000002b, 0x0000002b, 0x0004001c, 0x00000045,
+  0x00000005, 0x00000026, 0x00040017, 0x00000046, 0x00000007, 0x00000004, 0x00040020, 0x00000047,
+  0x00000007, 0x00000046, 0x00040017, 0x00000048, 0x00000006, 0x00000004, 0x00040020, 0x00000049,
+  0x00000007, 0x00000048, 0x0007002c, 0x0000001c, 0x0000004a, 0x0000001f, 0x0000002b, 0x0000001f,
+  0x0000002b, 0x00040017, 0x0000004c, 0x00000006, 0x00000001, 0x00040020, 0x0000004d, 0x00000006,
+  0x0000004c, 0x0005002c, 0x00000028, 0x0000004f, 0x00000027, 0x00000030, 0x0004001c, 0x00000050,
+  0x00000006, 0x00000030, 0x0004002b, 0x00000005, 0x00000052, 0x3f000000, 0x0005002c, 0x00000028,
+  0x00000053, 0x00000027, 0x00000027, 0x0004001c, 0x00000054, 0x00000005, 0x00000030, 0x0004002b,
+  0x00000005, 0x00000055, 0x40200000, 0x0007002c, 0x0000001c, 0x00000056, 0x0000001f, 0x0000002b,
+  0x0000002b, 0x0000002b, 0x00040020, 0x00000059, 0x00000006, 0x00000028, 0x0004002b, 0x00000006,
+  0x0000005a, 0xfffffffa, 0x0004002b, 0x00000007, 0x0000005b, 0x00000009, 0x0004002b, 0x00000007,
+  0x0000005c, 0x0000000a, 0x0004001c, 0x0000005d, 0x00000005, 0x00000027, 0x00040017, 0x0000005e,
+  0x00000007, 0x00000003, 0x00040020, 0x0000005f, 0x00000007, 0x0000005e, 0x00040017, 0x00000060,
+  0x00000007, 0x00000001, 0x00040020, 0x00000061, 0x00000006, 0x00000060, 0x00040017, 0x00000062,
+  0x00000005, 0x00000003, 0x00040020, 0x00000063, 0x00000006, 0x00000062, 0x0004002b, 0x00000006,
+  0x00000064, 0x00000000, 0x0004002b, 0x00000005, 0x00000065, 0x40600000, 0x0005002c, 0x00000028,
+  0x00000067, 0x00000030, 0x00000026, 0x00040020, 0x00000068, 0x00000007, 0x00000060, 0x0004002b,
+  0x00000006, 0x0000006a, 0xffffffff, 0x00040017, 0x0000006b, 0x00000006, 0x00000003, 0x00040020,
+  0x0000006c, 0x00000006, 0x0000006b, 0x00040020, 0x0000006d, 0x00000006, 0x00000046, 0x0004002b,
+  0x00000005, 0x0000006e, 0x40000000, 0x0005002c, 0x00000028, 0x0000006f, 0x00000025, 0x00000025,
+  0x0005002c, 0x00000028, 0x00000070, 0x00000027, 0x00000026, 0x0004002b, 0x00000007, 0x00000071,
+  0x00000005, 0x0004001c, 0x00000072, 0x00000005, 0x00000023, 0x0007002c, 0x0000001c, 0x00000073,
+  0x0000002b, 0x0000002b, 0x0000002b, 0x0000002b, 0x0005002c, 0x00000028, 0x00000076, 0x00000026,
+  0x00000030, 0x0004001c, 0x00000077, 0x00000006, 0x00000023, 0x00040020, 0x00000078, 0x00000007,
+  0x00000062, 0x0004002b, 0x00000005, 0x00000079, 0x40400000, 0x00040020, 0x0000007b, 0x00000007,
+  0x0000001c, 0x0004002b, 0x00000006, 0x0000007d, 0xfffffffe, 0x0005002c, 0x00000028, 0x0000007e,
+  0x00000025, 0x00000026, 0x00040020, 0x0000007f, 0x00000006, 0x00000039, 0x00040020, 0x00000080,
+  0x00000007, 0x0000004c, 0x0004002b, 0x00000006, 0x00000081, 0xfffffffd, 0x00040020, 0x00000082,
+  0x00000007, 0x0000006b, 0x0007002c, 0x0000001c, 0x00000083, 0x0000001f, 0x0000001f, 0x0000001f,
+  0x0000002b, 0x00040017, 0x00000086, 0x00000005, 0x00000002, 0x00040020, 0x00000087, 0x00000006,
+  0x00000086, 0x00040020, 0x00000088, 0x00000007, 0x00000028, 0x0004002b, 0x00000006, 0x00000089,
+  0xfffffffc, 0x0005002c, 0x00000028, 0x0000008a, 0x00000026, 0x00000027, 0x0004002b, 0x00000006,
+  0x0000008b, 0x00000002, 0x0004001c, 0x00000090, 0x00000006, 0x00000026, 0x0004002b, 0x00000006,
+  0x00000092, 0x00000004, 0x0005002c, 0x00000028, 0x00000093, 0x00000027, 0x00000025, 0x0007002c,
+  0x0000001c, 0x00000094, 0x0000001f, 0x0000001f, 0x0000002b, 0x0000002b, 0x0004001c, 0x00000098,
+  0x00000007, 0x00000026, 0x00040020, 0x00000099, 0x00000006, 0x0000005e, 0x0004002b, 0x00000007,
+  0x0000009f, 0x00000007, 0x0005002c, 0x00000028, 0x000000a5, 0x00000025, 0x00000030, 0x0005002c,
+  0x00000028, 0x000000a9, 0x00000030, 0x00000027, 0x0005002c, 0x00000028, 0x000000ae, 0x00000030,
+  0x00000030, 0x00040020, 0x000000b2, 0x00000006, 0x00000048, 0x0004003b, 0x00000011, 0x00000012,
+  0x00000002, 0x0004003b, 0x0000001d, 0x0000001e, 0x00000006, 0x00050036, 0x00000003, 0x00000002,
+  0x00000000, 0x0000001a, 0x000200f8, 0x0000001b, 0x00050081, 0x0000001c, 0x0000002d, 0x00000020,
+  0x0000002c, 0x00050081, 0x0000001c, 0x00000035, 0x0000002d, 0x00000034, 0x00050081, 0x0000001c,
+  0x00000044, 0x00000035, 0x00000043, 0x00050081, 0x0000001c, 0x0000004b, 0x00000044, 0x0000004a,
+  0x00050081, 0x0000001c, 0x0000004e, 0x0000004b, 0x0000002c, 0x00050081, 0x0000001c, 0x00000051,
+  0x0000004e, 0x0000002c, 0x00050081, 0x0000001c, 0x00000057, 0x00000051, 0x00000056, 0x00050081,
+  0x0000001c, 0x00000058, 0x00000057, 0x0000004a, 0x00050081, 0x0000001c, 0x00000066, 0x00000058,
+  0x0000004a, 0x00050081, 0x0000001c, 0x00000069, 0x00000066, 0x0000004a, 0x00050081, 0x0000001c,
+  0x00000074, 0x00000069, 0x00000073, 0x00050081, 0x0000001c, 0x00000075, 0x00000074, 0x00000034,
+  0x00050081, 0x0000001c, 0x0000007a, 0x00000075, 0x00000034, 0x00050081, 0x0000001c, 0x0000007c,
+  0x0000007a, 0x00000043, 0x00050081, 0x0000001c, 0x00000084, 0x0000007c, 0x00000083, 0x00050081,
+  0x0000001c, 0x00000085, 0x00000084, 0x00000056, 0x00050081, 0x0000001c, 0x0000008c, 0x00000085,
+  0x00000056, 0x00050081, 0x0000001c, 0x0000008d, 0x0000008c, 0x00000056, 0x00050081, 0x0000001c,
+  0x0000008e, 0x0000008d, 0x0000002c, 0x00050081, 0x0000001c, 0x0000008f, 0x0000008e, 0x0000004a,
+  0x00050081, 0x0000001c, 0x00000091, 0x0000008f, 0x00000073, 0x00050081, 0x0000001c, 0x00000095,
+  0x00000091, 0x00000094, 0x00050081, 0x0000001c, 0x00000096, 0x00000095, 0x00000034, 0x00050081,
+  0x0000001c, 0x00000097, 0x00000096, 0x0000002c, 0x00050081, 0x0000001c, 0x0000009a, 0x00000097,
+  0x00000056, 0x00050081, 0x0000001c, 0x0000009b, 0x0000009a, 0x00000043, 0x00050081, 0x0000001c,
+  0x0000009c, 0x0000009b, 0x00000083, 0x00050081, 0x0000001c, 0x0000009d, 0x0000009c, 0x00000073,
+  0x00050081, 0x0000001c, 0x0000009e, 0x0000009d, 0x0000002c, 0x00050081, 0x0000001c, 0x000000a0,
+  0x0000009e, 0x0000002c, 0x00050081, 0x0000001c, 0x000000a1, 0x000000a0, 0x00000034, 0x00050081,
+  0x0000001c, 0x000000a2, 0x000000a1, 0x00000083, 0x00050081, 0x0000001c, 0x000000a3, 0x000000a2,
+  0x0000004a, 0x00050081, 0x0000001c, 0x000000a4, 0x000000a3, 0x0000004a, 0x00050081, 0x0000001c,
+  0x000000a6, 0x000000a4, 0x00000083, 0x00050081, 0x0000001c, 0x000000a7, 0x000000a6, 0x00000034,
+  0x00050081, 0x0000001c, 0x000000a8, 0x000000a7, 0x00000073, 0x00050081, 0x0000001c, 0x000000aa,
+  0x000000a8, 0x00000083, 0x00050081, 0x0000001c, 0x000000ab, 0x000000aa, 0x00000056, 0x00050081,
+  0x0000001c, 0x000000ac, 0x000000ab, 0x00000056, 0x00050081, 0x0000001c, 0x000000ad, 0x000000ac,
+  0x0000002c, 0x00050081, 0x0000001c, 0x000000af, 0x000000ad, 0x00000043, 0x00050081, 0x0000001c,
+  0x000000b0, 0x000000af, 0x00000056, 0x00050081, 0x0000001c, 0x000000b1, 0x000000b0, 0x00000043,
+  0x00050081, 0x0000001c, 0x000000b3, 0x000000b1, 0x0000002c, 0x0003003e, 0x0000001e, 0x000000b3,
+  0x000100fd, 0x00010038
+};
+
+
+/**
+ * \brief Builds the test module
+ * 
+ * Declares types and constants in the way the DXBC
+ * compiler does, i.e. with many repeated requests,
+ * and mixes in unique declarations which must not
+ * affect the IDs returned for later lookups.
+ */
+SpirvCodeBuffer buildModule() {
+  SpirvModule m;
+  
+  m.enableCapability(spv::CapabilityShader);
+  m.enableCapability(spv::CapabilityImageQuery);
+  m.enableCapability(spv::CapabilityShader);
+  m.enableExtension("SPV_KHR_shader_draw_parameters");
+  m.setMemoryModel(spv::AddressingModelLogical, spv::MemoryModelGLSL450);
+  
+  uint32_t entryPointId = m.allocateId();
+  
+  const uint32_t tVoid  = m.defVoidType();
+  const uint32_t tBool  = m.defBoolType();
+  const uint32_t tF32   = m.defFloatType(32);
+  const uint32_t tS32   = m.defIntType(32, 1);
+  const uint32_t tU32   = m.defIntType(32, 0);
+  const uint32_t tScalars[3] = { tF32, tS32, tU32 };
+  
+  // Unique declarations before and after regular ones
+  // with identical operands, as used for buffer blocks
+  uint32_t tRtArray = m.defRuntimeArrayTypeUnique(tU32);
+  m.decorateArrayStride(tRtArray, 4);
+  
+  uint32_t tBlock = m.defStructTypeUnique(1, &tRtArray);
+  m.decorateBlock(tBlock);
+  m.memberDecorateOffset(tBlock, 0, 0);
+  
+  uint32_t tBlock2   = m.defStructTypeUnique(1, &tRtArray);
+  uint32_t tRtArray2 = m.defRuntimeArrayType(tU32);
+  uint32_t tBlock3   = m.defStructType(1, &tRtArray2);
+  
+  uint32_t tArray    = m.defArrayType(tF32, m.constu32(16));
+  uint32_t tArrayU   = m.defArrayTypeUnique(tF32, m.constu32(16));
+  uint32_t tArrayU2  = m.defArrayTypeUnique(tF32, m.constu32(17));
+  uint32_t tArrayU3  = m.defArrayTypeUnique(tF32, m.constu32(17));
+  uint32_t tArray2   = m.defArrayType(tF32, m.constu32(17));
+  uint32_t tArray3   = m.defArrayType(tF32, m.constu32(16));
+  
+  uint32_t blockVar = m.newVar(
+    m.defPointerType(tBlock, spv::StorageClassUniform),
+    spv::StorageClassUniform);
+  m.decorateDescriptorSet(blockVar, 0);
+  m.decorateBinding(blockVar, 0);
+  
+  // Images and samplers, requested repeatedly
+  for (uint32_t i = 0; i < 2; i++) {
+    uint32_t tImage = m.defImageType(tF32, spv::Dim2D,
+      0, i, 0, 1, spv::ImageFormatUnknown);
+    m.defSampledImageType(tImage);
+    m.defSamplerType();
+    m.defImageType(tF32, spv::Dim2D,
+      0, i, 0, 1, spv::ImageFormatUnknown);
+  }
+  
+  // Specialization constants are never deduplicated, and
+  // must not be returned for regular constant lookups
+  uint32_t specBool = m.specConstBool(true);
+  uint32_t specU32  = m.specConst32(tU32, 7);
+  m.decorateSpecId(specBool, 0);
+  m.decorateSpecId(specU32,  1);
+  
+  uint32_t tFunc = m.defFunctionType(tVoid, 0, nullptr);
+  
+  m.functionBegin(tVoid, entryPointId, tFunc, spv::FunctionControlMaskNone);
+  m.opLabel(m.allocateId());
+  
+  uint32_t tVec4F = m.defVectorType(tF32, 4);
+  uint32_t tempVar = m.newVar(
+    m.defPointerType(tVec4F, spv::StorageClassPrivate),
+    spv::StorageClassPrivate);
+  
+  // Pseudo-random sequence of lookups with a small value
+  // range, so that most requests hit existing entries
+  uint32_t state = 0x2545f491u;
+  
+  auto next = [&state] (uint32_t range) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % range;
+  };
+  
+  uint32_t sum = m.constvec4f32(0.0f, 0.0f, 0.0f, 0.0f);
+  
+  for (uint32_t i = 0; i < 400; i++) {
+    switch (next(8)) {
+      case 0: {
+        uint32_t type = m.defVectorType(tScalars[next(3)], 1 + next(4));
+        m.defPointerType(type, next(2)
+          ? spv::StorageClassPrivate
+          : spv::StorageClassFunction);
+      } break;
+      
+      case 1: m.constu32(next(12)); break;
+      case 2: m.consti32(int32_t(next(12)) - 6); break;
+      case 3: m.constf32(float(next(8)) * 0.5f); break;
+      case 4: m.constBool(next(2) != 0); break;
+      
+      case 5: {
+        uint32_t value = m.constvec4f32(
+          float(next(2)), float(next(2)),
+          float(next(2)), 1.0f);
+        sum = m.opFAdd(tVec4F, sum, value);
+      } break;
+      
+      case 6: {
+        uint32_t values[2] = { m.constu32(next(4)), m.constu32(next(4)) };
+        m.constComposite(m.defVectorType(tU32, 2), 2, values);
+      } break;
+      
+      case 7: {
+        uint32_t length = m.constu32(1 + next(4));
+        m.defArrayType(tScalars[next(3)], length);
+      } break;
+    }
+  }
+  
+  m.opStore(tempVar, sum);
+  m.opReturn();
+  m.functionEnd();
+  
+  uint32_t interfaces[1] = { blockVar };
+  m.addEntryPoint(entryPointId, spv::ExecutionModelGLCompute, "main", 1, interfaces);
+  m.setLocalSize(entryPointId, 64, 1, 1);
+  
+  // Keep the IDs returned for the lookups above
+  // in the output, so that they are compared too
+  uint32_t ids[] = {
+    tBool, tS32, tRtArray2, tBlock2, tBlock3,
+    tArray, tArrayU, tArrayU2, tArrayU3,
+    tArray2, tArray3 };
+  
+  for (uint32_t id : ids)
+    m.setDebugName(id, "t");
+  
+  return m.compile();
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  SpirvCodeBuffer code = buildModule();
+  
+  const uint32_t* words     = code.data();
+  const size_t    wordCount = code.size() / sizeof(uint32_t);
+  const size_t    refCount  = sizeof(g_referenceCode) / sizeof(uint32_t);
+  
+  for (size_t i = 0; i < std::min(wordCount, refCount); i++) {
+    if (words[i] != g_referenceCode[i]) {
+      Logger::err(str::format("Mismatch at word ", i,
+        ": expected ", g_referenceCode[i], ", got ", words[i]));
+      return 1;
+    }
+  }
+  
+  if (wordCount != refCount) {
+    Logger::err(str::format("Expected ", refCount, " words, got ", wordCount));
+    return 1;
+  }
+  
+  Logger::info(str::format("Output matches reference, ", wordCount, " words"));
+  return 0;
+}